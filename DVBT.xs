@@ -24,6 +24,7 @@ INCLUDE: xs/DVBT-scan.c
 INCLUDE: xs/DVBT-tuning.c
 INCLUDE: xs/DVBT-epg.c
 INCLUDE: xs/DVBT-record.c
+INCLUDE: xs/DVBT-ts.c
 
 
  # /*---------------------------------------------------------------------------------------------------*/
@@ -26,9 +26,11 @@
 #include "dvb_error.h"
 
 #include "ts_parse.h"
+#include "ts_sync.h"
 
 // Added for EIT decoding
 #include "tables/parse_si_eit.h"
+#include "tables/si_view.h"
 
 
 /*=============================================================================================*/
@@ -281,13 +283,14 @@ unsigned done ;
 //=======================================================================================================================
 
 //---------------------------------------------------------------------------------------------------------------------------
-static void eit_handler(struct TS_reader *tsreader, struct TS_state *tsstate, struct Section *section, void *user_data)
+// Only needs the event ids and running status so reads them straight from the section (no decode)
+static void eit_handler(struct TS_reader *tsreader, struct TS_state *tsstate, const struct TS_section_view *view, void *user_data)
 {
 struct Timeslip_data *timeslip_data = (struct Timeslip_data *)user_data ;
-struct Section_event_information *eit = (struct Section_event_information *)section ;
+unsigned service_id = si_view_eit_service_id(view) ;
 unsigned pid_index ;
 
-	dvbstream_dbg_prt(3, ("Called eit_handler with : 0x%02x TSID %d\n", eit->table_id, eit->transport_stream_id)) ;
+	dvbstream_dbg_prt(3, ("Called eit_handler with : 0x%02x TSID %d\n", si_view_table_id(view), si_view_eit_transport_stream_id(view))) ;
 
 	// expect there to be only one currently running & one pending program per channel (service_id)
 
@@ -298,41 +301,43 @@ unsigned pid_index ;
 		if (timeslip_data->pid_list[pid_index].event_id >= 0)
 		{
 			dvbstream_dbg_prt(3, ("EV: check service id %d : list id = %d\n",
-				eit->service_id,
+				service_id,
 				timeslip_data->pid_list[pid_index].pnr)) ;
 
 			// match program number
-			if (timeslip_data->pid_list[pid_index].pnr == eit->service_id)
+			if (timeslip_data->pid_list[pid_index].pnr == service_id)
 			{
 				// find the event
-				struct list_head  *item, *safe;
-				struct EIT_entry  *eit_entry;
+				struct SI_loop events ;
+				const uint8_t *event ;
 
-				list_for_each_safe(item,safe,&eit->eit_array) {
-					eit_entry = list_entry(item, struct EIT_entry, next);
+				si_view_eit_events(view, &events) ;
+				while ((event = si_view_eit_next(&events))) {
+					int event_id = si_view_eit_event_id(event) ;
+					unsigned running_status = si_view_eit_running_status(event) ;
 
 					if (dvb_debug >= 1)
 						dvbstream_fprintf(stderr, "EV: check event id %d, running = %d: list event id = %d\n",
-							eit_entry->event_id,
-							eit_entry->running_status,
+							event_id,
+							running_status,
 							timeslip_data->pid_list[pid_index].event_id
 							) ;
 
-					if (eit_entry->event_id == timeslip_data->pid_list[pid_index].event_id)
+					if (event_id == timeslip_data->pid_list[pid_index].event_id)
 					{
-						timeslip_data->pid_list[pid_index].running_status = eit_entry->running_status ;
+						timeslip_data->pid_list[pid_index].running_status = running_status ;
 
 						dvbstream_dbg_prt(3, ("EVENT + PID %d : pnr %d event %d - running = %d\n",
 							tsstate->pidinfo.pid,
-							eit->service_id,
-							eit_entry->event_id,
-							eit_entry->running_status
+							service_id,
+							event_id,
+							running_status
 							)) ;
 					}
 					else
 					{
 						// if another service is running, then this one can't be
-						if (eit_entry->running_status == RUNNING_STATUS_RUNNING)
+						if (running_status == RUNNING_STATUS_RUNNING)
 						{
 							if (timeslip_data->pid_list[pid_index].running_status == RUNNING_STATUS_RUNNING)
 							{
@@ -368,18 +373,18 @@ unsigned pid_index ;
 					//
 
 					// track the current running/pending events
-					if (eit_entry->running_status == RUNNING_STATUS_RUNNING)
+					if (running_status == RUNNING_STATUS_RUNNING)
 					{
-						timeslip_data->pid_list[pid_index].running_event_id = eit_entry->event_id ;
+						timeslip_data->pid_list[pid_index].running_event_id = event_id ;
 						timeslip_data->pid_list[pid_index].got_eit = 1 ;
 					}
-					else if (eit_entry->running_status == RUNNING_STATUS_PENDING)
+					else if (running_status == RUNNING_STATUS_PENDING)
 					{
-						timeslip_data->pid_list[pid_index].pending_event_id = eit_entry->event_id ;
+						timeslip_data->pid_list[pid_index].pending_event_id = event_id ;
 						timeslip_data->pid_list[pid_index].got_eit = 1 ;
 					}
 
-				};
+				}
 			}
 		}
 	}
@@ -400,16 +405,16 @@ int running ;
 unsigned running_timeslip ;
 int buffer_len ;
 int bytes_read ;
+unsigned sync_skip ;
 char debugstr[1024] ;
 
 struct TS_reader *tsreader ;
 struct Timeslip_data timeslip_data ;
-struct Section_decode_flags flags ;
+struct Section_decode_flags flags = SECTION_DECODE_FLAGS_INIT ;
 
 	// Initialise the TS parser
 	running_timeslip = 0 ;
 	tsreader = tsreader_new_nofile() ;
-	tsreader_data_start(tsreader) ;
 
 	timeslip_data.num_entries = num_entries ;
 	timeslip_data.pid_list = pid_list ;
@@ -490,14 +495,16 @@ time_t bins_time ;
 	// Only add the overhead of parsing the EITs if something requires timeslip
 	if (running_timeslip)
 	{
-	    // register an interest
-	    flags.decode_descriptor = 0 ;
-	    int num_added = tsreader_register_section(tsreader,
+	    // register an interest (every copy, no descriptors decoded)
+	    int num_added = tsreader_register_section_view(tsreader,
 	    		SECTION_EIT_NOW_ACTUAL, 0xff,
 	    		eit_handler, flags) ;
 
 	}
 
+	// start the parser now that debug and the handlers are set (the packet loop is chosen from them)
+	tsreader_data_start(tsreader) ;
+
 
     // main loop
     running = num_entries ;
@@ -564,13 +571,14 @@ time_t bins_time ;
 		ts_pid = NULL_PID ;
 
 		// check sync byte
-		while ( (bptr[0] != SYNC_BYTE) && (buffer_len > 0) )
+		if ( (buffer_len > 0) && (bptr[0] != SYNC_BYTE) )
 		{
 			if (dvb_debug >= 10)
 				dvbstream_fprintf(stderr, "! Searching for sync : 0x%02x (bptr @ %p) len=%d\n", buffer_len?bptr[0]:0, bptr, buffer_len) ;
 
-			++bptr ;
-			--buffer_len ;
+			sync_skip = ts_sync_find((const uint8_t *)bptr, buffer_len, buffer_len, TS_SYNC_CONFIRM, TS_PACKET_LEN) ;
+			bptr += sync_skip ;
+			buffer_len -= sync_skip ;
 		}
 
 		// only process if we have a packet's worth
@@ -8,6 +8,16 @@ OBJS-libdvb_ts_lib := \
 	$(libdvb_ts_lib)/ts_split.o \
 	$(libdvb_ts_lib)/ts_cut.o \
 	$(libdvb_ts_lib)/ts_bits.o \
+	$(libdvb_ts_lib)/ts_readahead.o \
+	$(libdvb_ts_lib)/ts_sync.o \
+	$(libdvb_ts_lib)/ts_pool.o \
+	$(libdvb_ts_lib)/ts_parallel.o \
+	$(libdvb_ts_lib)/ts_timing.o \
+	$(libdvb_ts_lib)/ts_index.o \
+	$(libdvb_ts_lib)/ts_follow.o \
+	$(libdvb_ts_lib)/ts_fanout.o \
+	$(libdvb_ts_lib)/ts_crc32.o \
+	$(libdvb_ts_lib)/ts_arena.o \
 	$(libdvb_ts_lib)/shared/dvb_error.o \
 	$(libdvb_ts_lib)/dvbsnoop/crc32.o \
 	$(libdvb_ts_lib)/tables/parse_si_eit.o\
@@ -25,6 +35,7 @@ OBJS-libdvb_ts_lib := \
 	$(libdvb_ts_lib)/tables/parse_si_dit.o\
 	$(libdvb_ts_lib)/tables/parse_si_sit.o\
 	$(libdvb_ts_lib)/tables/parse_si.o\
+	$(libdvb_ts_lib)/tables/si_view.o\
 	\
 	$(libdvb_ts_lib)/descriptors/parse_desc_network_name.o \
 	$(libdvb_ts_lib)/descriptors/parse_desc_service_list.o \
@@ -88,6 +88,10 @@ enum TS_descriptor_ids {
 	DESC_MAX									= 0xFF
 };
 
+// Set in the descriptor_tag of a descriptor that has been kept undecoded (a struct Descriptor with descriptor_data
+// pointing to its descriptor_length bytes)
+#define DESC_RAW							0x100
+
 /*=============================================================================================*/
 // MACROS
 /*=============================================================================================*/
@@ -96,7 +100,8 @@ enum TS_descriptor_ids {
 // STRUCTS
 /*=============================================================================================*/
 
-// A generic descriptor - all descriptors start like this (with the addition of linked list)
+// A generic descriptor - all descriptors start like this (with the addition of linked list). Only undecoded (DESC_RAW)
+// descriptors have descriptor_data
 struct Descriptor {
 	// linked list
 	struct list_head next ;
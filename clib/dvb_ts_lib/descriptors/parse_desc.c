@@ -23,6 +23,7 @@
 
 #include "parse_desc.h"
 #include "ts_bits.h"
+#include "tables/si_structs.h"
 
 // Descriptors:
 #include "parse_desc_network_name.h"  /* 0x40 */
@@ -119,6 +120,13 @@ void print_desc_list(struct list_head *descriptors_array, int level)
 // Free this descriptor
 void free_desc(struct Descriptor *descriptor)
 {
+	// undecoded descriptor and its data are a single allocation
+	if (descriptor->descriptor_tag & DESC_RAW)
+	{
+		free(descriptor) ;
+		return ;
+	}
+
 	switch (descriptor->descriptor_tag)
 	{
 	case DESC_NETWORK_NAME:
@@ -331,6 +339,19 @@ void free_desc(struct Descriptor *descriptor)
 // Dump out this descriptor
 void print_desc(struct Descriptor *descriptor, int level)
 {
+unsigned byte ;
+
+	if (descriptor->descriptor_tag & DESC_RAW)
+	{
+		printf("    Descriptor:  raw [0x%02x]\n", descriptor->descriptor_tag & 0xff) ;
+		printf("    Length: %d\n", descriptor->descriptor_length) ;
+		printf("    data =") ;
+		for (byte=0; byte < descriptor->descriptor_length; ++byte)
+			printf(" %02x", ((uint8_t *)descriptor->descriptor_data)[byte]) ;
+		printf("\n") ;
+		return ;
+	}
+
 	switch (descriptor->descriptor_tag)
 	{
 	case DESC_NETWORK_NAME:
@@ -539,246 +560,290 @@ void print_desc(struct Descriptor *descriptor, int level)
 }
 
 /* ----------------------------------------------------------------------- */
-//
-//descriptor(){
-//descriptor_tag 8 uimsbf
-//descriptor_length 8 uimsbf
-//...
-//}
-//
-enum TS_descriptor_ids parse_desc(struct list_head *descriptors_array, struct TS_bits *bits, unsigned decode_descriptor)
+// Decode the descriptor (tag and length already read). Returns NULL, with nothing read, if there is no decoder for
+// this tag
+static struct Descriptor *decode_desc(struct TS_bits *bits, unsigned tag, unsigned len)
 {
-	// common
-	unsigned tag = bits_get(bits, 8) ;
-	unsigned len = bits_get(bits, 8) ;
-
-	//== Only decode descriptor if required to ==
-	if (decode_descriptor)
-	{
 int expected_buff_len = bits->buff_len+2-(len+2) ;
 printf(" + parse_desc() Tag 0x%02x Len %d (Total=%d) [Buff=%d -> will be %d]\n", tag, len, len+2, bits->buff_len+2, expected_buff_len) ;
 
-		// parse it
-		struct Descriptor *descriptor = 0 ;
+	// parse it
+	struct Descriptor *descriptor = 0 ;
 
-		switch (tag)
-		{
-		case DESC_NETWORK_NAME:
-			descriptor = (struct Descriptor *)parse_network_name(bits, tag, len) ;
-			break ;
+	switch (tag)
+	{
+	case DESC_NETWORK_NAME:
+		descriptor = (struct Descriptor *)parse_network_name(bits, tag, len) ;
+		break ;
 
-		case DESC_SERVICE_LIST:
-			descriptor = (struct Descriptor *)parse_service_list(bits, tag, len) ;
-			break ;
+	case DESC_SERVICE_LIST:
+		descriptor = (struct Descriptor *)parse_service_list(bits, tag, len) ;
+		break ;
 
-		case DESC_STUFFING:
-			descriptor = (struct Descriptor *)parse_stuffing(bits, tag, len) ;
-			break ;
+	case DESC_STUFFING:
+		descriptor = (struct Descriptor *)parse_stuffing(bits, tag, len) ;
+		break ;
 
-		case DESC_SATELLITE_DELIVERY_SYSTEM:
-			descriptor = (struct Descriptor *)parse_satellite_delivery_system(bits, tag, len) ;
-			break ;
+	case DESC_SATELLITE_DELIVERY_SYSTEM:
+		descriptor = (struct Descriptor *)parse_satellite_delivery_system(bits, tag, len) ;
+		break ;
 
-		case DESC_CABLE_DELIVERY_SYSTEM:
-			descriptor = (struct Descriptor *)parse_cable_delivery_system(bits, tag, len) ;
-			break ;
+	case DESC_CABLE_DELIVERY_SYSTEM:
+		descriptor = (struct Descriptor *)parse_cable_delivery_system(bits, tag, len) ;
+		break ;
 
-		case DESC_VBI_DATA:
-			descriptor = (struct Descriptor *)parse_vbi_data(bits, tag, len) ;
-			break ;
+	case DESC_VBI_DATA:
+		descriptor = (struct Descriptor *)parse_vbi_data(bits, tag, len) ;
+		break ;
 
-		case DESC_VBI_TELETEXT:
-			descriptor = (struct Descriptor *)parse_vbi_teletext(bits, tag, len) ;
-			break ;
+	case DESC_VBI_TELETEXT:
+		descriptor = (struct Descriptor *)parse_vbi_teletext(bits, tag, len) ;
+		break ;
 
-		case DESC_BOUQUET_NAME:
-			descriptor = (struct Descriptor *)parse_bouquet_name(bits, tag, len) ;
-			break ;
+	case DESC_BOUQUET_NAME:
+		descriptor = (struct Descriptor *)parse_bouquet_name(bits, tag, len) ;
+		break ;
 
-		case DESC_SERVICE:
-			descriptor = (struct Descriptor *)parse_service(bits, tag, len) ;
-			break ;
+	case DESC_SERVICE:
+		descriptor = (struct Descriptor *)parse_service(bits, tag, len) ;
+		break ;
 
-		case DESC_COUNTRY_AVAILABILITY:
-			descriptor = (struct Descriptor *)parse_country_availability(bits, tag, len) ;
-			break ;
+	case DESC_COUNTRY_AVAILABILITY:
+		descriptor = (struct Descriptor *)parse_country_availability(bits, tag, len) ;
+		break ;
 
-		case DESC_LINKAGE:
-			descriptor = (struct Descriptor *)parse_linkage(bits, tag, len) ;
-			break ;
+	case DESC_LINKAGE:
+		descriptor = (struct Descriptor *)parse_linkage(bits, tag, len) ;
+		break ;
 
-		case DESC_NVOD_REFERENCE:
-			descriptor = (struct Descriptor *)parse_nvod_reference(bits, tag, len) ;
-			break ;
+	case DESC_NVOD_REFERENCE:
+		descriptor = (struct Descriptor *)parse_nvod_reference(bits, tag, len) ;
+		break ;
 
-		case DESC_TIME_SHIFTED_SERVICE:
-			descriptor = (struct Descriptor *)parse_time_shifted_service(bits, tag, len) ;
-			break ;
+	case DESC_TIME_SHIFTED_SERVICE:
+		descriptor = (struct Descriptor *)parse_time_shifted_service(bits, tag, len) ;
+		break ;
 
-		case DESC_SHORT_EVENT:
-			descriptor = (struct Descriptor *)parse_short_event(bits, tag, len) ;
-			break ;
+	case DESC_SHORT_EVENT:
+		descriptor = (struct Descriptor *)parse_short_event(bits, tag, len) ;
+		break ;
 
-		case DESC_EXTENDED_EVENT:
-			descriptor = (struct Descriptor *)parse_extended_event(bits, tag, len) ;
-			break ;
+	case DESC_EXTENDED_EVENT:
+		descriptor = (struct Descriptor *)parse_extended_event(bits, tag, len) ;
+		break ;
 
-		case DESC_TIME_SHIFTED_EVENT:
-			descriptor = (struct Descriptor *)parse_time_shifted_event(bits, tag, len) ;
-			break ;
+	case DESC_TIME_SHIFTED_EVENT:
+		descriptor = (struct Descriptor *)parse_time_shifted_event(bits, tag, len) ;
+		break ;
 
-		case DESC_COMPONENT:
-			descriptor = (struct Descriptor *)parse_component(bits, tag, len) ;
-			break ;
+	case DESC_COMPONENT:
+		descriptor = (struct Descriptor *)parse_component(bits, tag, len) ;
+		break ;
 
-		case DESC_MOSAIC:
-			descriptor = (struct Descriptor *)parse_mosaic(bits, tag, len) ;
-			break ;
+	case DESC_MOSAIC:
+		descriptor = (struct Descriptor *)parse_mosaic(bits, tag, len) ;
+		break ;
 
-		case DESC_STREAM_IDENTIFIER:
-			descriptor = (struct Descriptor *)parse_stream_identifier(bits, tag, len) ;
-			break ;
+	case DESC_STREAM_IDENTIFIER:
+		descriptor = (struct Descriptor *)parse_stream_identifier(bits, tag, len) ;
+		break ;
 
-		case DESC_CA_IDENTIFIER:
-			descriptor = (struct Descriptor *)parse_ca_identifier(bits, tag, len) ;
-			break ;
+	case DESC_CA_IDENTIFIER:
+		descriptor = (struct Descriptor *)parse_ca_identifier(bits, tag, len) ;
+		break ;
 
-		case DESC_CONTENT:
-			descriptor = (struct Descriptor *)parse_content(bits, tag, len) ;
-			break ;
+	case DESC_CONTENT:
+		descriptor = (struct Descriptor *)parse_content(bits, tag, len) ;
+		break ;
 
-		case DESC_PARENTAL_RATING:
-			descriptor = (struct Descriptor *)parse_parental_rating(bits, tag, len) ;
-			break ;
+	case DESC_PARENTAL_RATING:
+		descriptor = (struct Descriptor *)parse_parental_rating(bits, tag, len) ;
+		break ;
 
-		case DESC_TELETEXT:
-			descriptor = (struct Descriptor *)parse_teletext(bits, tag, len) ;
-			break ;
+	case DESC_TELETEXT:
+		descriptor = (struct Descriptor *)parse_teletext(bits, tag, len) ;
+		break ;
 
-		case DESC_TELEPHONE:
-			descriptor = (struct Descriptor *)parse_telephone(bits, tag, len) ;
-			break ;
+	case DESC_TELEPHONE:
+		descriptor = (struct Descriptor *)parse_telephone(bits, tag, len) ;
+		break ;
 
-		case DESC_LOCAL_TIME_OFFSET:
-			descriptor = (struct Descriptor *)parse_local_time_offset(bits, tag, len) ;
-			break ;
+	case DESC_LOCAL_TIME_OFFSET:
+		descriptor = (struct Descriptor *)parse_local_time_offset(bits, tag, len) ;
+		break ;
 
-		case DESC_SUBTITLING:
-			descriptor = (struct Descriptor *)parse_subtitling(bits, tag, len) ;
-			break ;
+	case DESC_SUBTITLING:
+		descriptor = (struct Descriptor *)parse_subtitling(bits, tag, len) ;
+		break ;
 
-		case DESC_TERRESTRIAL_DELIVERY_SYSTEM:
-			descriptor = (struct Descriptor *)parse_terrestrial_delivery_system(bits, tag, len) ;
-			break ;
+	case DESC_TERRESTRIAL_DELIVERY_SYSTEM:
+		descriptor = (struct Descriptor *)parse_terrestrial_delivery_system(bits, tag, len) ;
+		break ;
 
-		case DESC_MULTILINGUAL_NETWORK_NAME:
-			descriptor = (struct Descriptor *)parse_multilingual_network_name(bits, tag, len) ;
-			break ;
+	case DESC_MULTILINGUAL_NETWORK_NAME:
+		descriptor = (struct Descriptor *)parse_multilingual_network_name(bits, tag, len) ;
+		break ;
 
-		case DESC_MULTILINGUAL_BOUQUET_NAME:
-			descriptor = (struct Descriptor *)parse_multilingual_bouquet_name(bits, tag, len) ;
-			break ;
+	case DESC_MULTILINGUAL_BOUQUET_NAME:
+		descriptor = (struct Descriptor *)parse_multilingual_bouquet_name(bits, tag, len) ;
+		break ;
 
-		case DESC_MULTILINGUAL_SERVICE_NAME:
-			descriptor = (struct Descriptor *)parse_multilingual_service_name(bits, tag, len) ;
-			break ;
+	case DESC_MULTILINGUAL_SERVICE_NAME:
+		descriptor = (struct Descriptor *)parse_multilingual_service_name(bits, tag, len) ;
+		break ;
 
-		case DESC_MULTILINGUAL_COMPONENT:
-			descriptor = (struct Descriptor *)parse_multilingual_component(bits, tag, len) ;
-			break ;
+	case DESC_MULTILINGUAL_COMPONENT:
+		descriptor = (struct Descriptor *)parse_multilingual_component(bits, tag, len) ;
+		break ;
 
-		case DESC_PRIVATE_DATA_SPECIFIER:
-			descriptor = (struct Descriptor *)parse_private_data_specifier(bits, tag, len) ;
-			break ;
+	case DESC_PRIVATE_DATA_SPECIFIER:
+		descriptor = (struct Descriptor *)parse_private_data_specifier(bits, tag, len) ;
+		break ;
 
-		case DESC_SERVICE_MOVE:
-			descriptor = (struct Descriptor *)parse_service_move(bits, tag, len) ;
-			break ;
+	case DESC_SERVICE_MOVE:
+		descriptor = (struct Descriptor *)parse_service_move(bits, tag, len) ;
+		break ;
 
-		case DESC_SHORT_SMOOTHING_BUFFER:
-			descriptor = (struct Descriptor *)parse_short_smoothing_buffer(bits, tag, len) ;
-			break ;
+	case DESC_SHORT_SMOOTHING_BUFFER:
+		descriptor = (struct Descriptor *)parse_short_smoothing_buffer(bits, tag, len) ;
+		break ;
 
-		case DESC_FREQUENCY_LIST:
-			descriptor = (struct Descriptor *)parse_frequency_list(bits, tag, len) ;
-			break ;
+	case DESC_FREQUENCY_LIST:
+		descriptor = (struct Descriptor *)parse_frequency_list(bits, tag, len) ;
+		break ;
 
-		case DESC_PARTIAL_TRANSPORT_STREAM:
-			descriptor = (struct Descriptor *)parse_partial_transport_stream(bits, tag, len) ;
-			break ;
+	case DESC_PARTIAL_TRANSPORT_STREAM:
+		descriptor = (struct Descriptor *)parse_partial_transport_stream(bits, tag, len) ;
+		break ;
 
-		case DESC_DATA_BROADCAST:
-			descriptor = (struct Descriptor *)parse_data_broadcast(bits, tag, len) ;
-			break ;
+	case DESC_DATA_BROADCAST:
+		descriptor = (struct Descriptor *)parse_data_broadcast(bits, tag, len) ;
+		break ;
 
-		case DESC_SCRAMBLING:
-			descriptor = (struct Descriptor *)parse_scrambling(bits, tag, len) ;
-			break ;
+	case DESC_SCRAMBLING:
+		descriptor = (struct Descriptor *)parse_scrambling(bits, tag, len) ;
+		break ;
 
-		case DESC_DATA_BROADCAST_ID:
-			descriptor = (struct Descriptor *)parse_data_broadcast_id(bits, tag, len) ;
-			break ;
+	case DESC_DATA_BROADCAST_ID:
+		descriptor = (struct Descriptor *)parse_data_broadcast_id(bits, tag, len) ;
+		break ;
 
-		case DESC_TRANSPORT_STREAM:
-			descriptor = (struct Descriptor *)parse_transport_stream(bits, tag, len) ;
-			break ;
+	case DESC_TRANSPORT_STREAM:
+		descriptor = (struct Descriptor *)parse_transport_stream(bits, tag, len) ;
+		break ;
 
-		case DESC_DSNG:
-			descriptor = (struct Descriptor *)parse_dsng(bits, tag, len) ;
-			break ;
+	case DESC_DSNG:
+		descriptor = (struct Descriptor *)parse_dsng(bits, tag, len) ;
+		break ;
 
-		case DESC_PDC:
-			descriptor = (struct Descriptor *)parse_pdc(bits, tag, len) ;
-			break ;
+	case DESC_PDC:
+		descriptor = (struct Descriptor *)parse_pdc(bits, tag, len) ;
+		break ;
 
-		case DESC_ANCILLARY_DATA:
-			descriptor = (struct Descriptor *)parse_ancillary_data(bits, tag, len) ;
-			break ;
+	case DESC_ANCILLARY_DATA:
+		descriptor = (struct Descriptor *)parse_ancillary_data(bits, tag, len) ;
+		break ;
 
-		case DESC_CELL_FREQUENCY_LINK:
-			descriptor = (struct Descriptor *)parse_cell_frequency_link(bits, tag, len) ;
-			break ;
+	case DESC_CELL_FREQUENCY_LINK:
+		descriptor = (struct Descriptor *)parse_cell_frequency_link(bits, tag, len) ;
+		break ;
 
-		case DESC_ANNOUNCEMENT_SUPPORT:
-			descriptor = (struct Descriptor *)parse_announcement_support(bits, tag, len) ;
-			break ;
+	case DESC_ANNOUNCEMENT_SUPPORT:
+		descriptor = (struct Descriptor *)parse_announcement_support(bits, tag, len) ;
+		break ;
 
-		case DESC_ADAPTATION_FIELD_DATA:
-			descriptor = (struct Descriptor *)parse_adaptation_field_data(bits, tag, len) ;
-			break ;
+	case DESC_ADAPTATION_FIELD_DATA:
+		descriptor = (struct Descriptor *)parse_adaptation_field_data(bits, tag, len) ;
+		break ;
 
-		case DESC_SERVICE_AVAILABILITY:
-			descriptor = (struct Descriptor *)parse_service_availability(bits, tag, len) ;
-			break ;
+	case DESC_SERVICE_AVAILABILITY:
+		descriptor = (struct Descriptor *)parse_service_availability(bits, tag, len) ;
+		break ;
 
-		case DESC_TVA_CONTENT_IDENTIFIER:
-			descriptor = (struct Descriptor *)parse_tva_content_identifier(bits, tag, len) ;
-			break ;
+	case DESC_TVA_CONTENT_IDENTIFIER:
+		descriptor = (struct Descriptor *)parse_tva_content_identifier(bits, tag, len) ;
+		break ;
 
-		case DESC_S2_SATELLITE_DELIVERY_SYSTEM:
-			descriptor = (struct Descriptor *)parse_s2_satellite_delivery_system(bits, tag, len) ;
-			break ;
+	case DESC_S2_SATELLITE_DELIVERY_SYSTEM:
+		descriptor = (struct Descriptor *)parse_s2_satellite_delivery_system(bits, tag, len) ;
+		break ;
 
-		case DESC_EXTENSION:
-			descriptor = (struct Descriptor *)parse_extension(bits, tag, len) ;
-			break ;
+	case DESC_EXTENSION:
+		descriptor = (struct Descriptor *)parse_extension(bits, tag, len) ;
+		break ;
 
-		default:
-			// skip descriptor
-			bits_skip(bits, len*8) ;
-			break ;
-		}
+	default:
+		// no decoder
+		return descriptor ;
+	}
 
 if (bits->buff_len != expected_buff_len)
 {
 	printf("**** parse_desc() : buffer length not as expected (was %d expected %d) ****\n", bits->buff_len, expected_buff_len);
 }
 
-		// add to list
-		if (descriptor)
-		{
-			list_add_tail(&descriptor->next, descriptors_array);
-		}
+	return descriptor ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Keep the descriptor undecoded. The bytes are copied so that they last as long as the rest of the section
+static struct Descriptor *raw_desc(struct TS_bits *bits, unsigned tag, unsigned len)
+{
+struct Descriptor *descriptor ;
+uint8_t *data ;
+unsigned byte ;
+
+	descriptor = (struct Descriptor *)bits_alloc(bits, sizeof(*descriptor) + len) ;
+	memset(descriptor,0,sizeof(*descriptor));
+
+	INIT_LIST_HEAD(&descriptor->next);
+	descriptor->descriptor_tag = DESC_RAW | tag ;
+	descriptor->descriptor_length = len ;
+	descriptor->descriptor_data = data = (uint8_t *)(descriptor + 1) ;
+
+	if (!bits->start_bit && ((int)len <= bits->buff_len))
+	{
+		memcpy(data, bits->buff_ptr, len) ;
+		bits_skip(bits, len*8) ;
+	}
+	else
+	{
+		for (byte=0; byte < len; ++byte)
+			data[byte] = bits_get(bits, 8) ;
+	}
+
+	return descriptor ;
+}
+
+/* ----------------------------------------------------------------------- */
+//
+//descriptor(){
+//descriptor_tag 8 uimsbf
+//descriptor_length 8 uimsbf
+//...
+//}
+//
+enum TS_descriptor_ids parse_desc(struct list_head *descriptors_array, struct TS_bits *bits, struct Section_decode_flags *flags)
+{
+	// common
+	unsigned tag = bits_get(bits, 8) ;
+	unsigned len = bits_get(bits, 8) ;
+	struct Descriptor *descriptor = 0 ;
+
+	//== Only decode descriptor if required to ==
+	if (flags->use_descriptor_mask)
+	{
+		// wanted tags are decoded, everything else (including tags with no decoder) is kept raw
+		if (DESC_MASK_TEST(flags->descriptor_mask, tag))
+			descriptor = decode_desc(bits, tag, len) ;
+		if (!descriptor)
+			descriptor = raw_desc(bits, tag, len) ;
+	}
+	else if (flags->decode_descriptor)
+	{
+		descriptor = decode_desc(bits, tag, len) ;
+		if (!descriptor)
+			bits_skip(bits, len*8) ;
 	}
 	else
 	{
@@ -786,6 +851,276 @@ if (bits->buff_len != expected_buff_len)
 		bits_skip(bits, len*8) ;
 	}
 
+	// add to list
+	if (descriptor)
+	{
+		list_add_tail(&descriptor->next, descriptors_array);
+	}
+
 	return (enum TS_descriptor_ids)tag ;
 }
 
+/* ----------------------------------------------------------------------- */
+// Decode a descriptor that was kept raw. Returns a new (malloc'd) descriptor to be freed with free_desc(), or NULL if
+// there is no decoder for the tag or the data is too short
+struct Descriptor *parse_desc_raw(struct Descriptor *descriptor)
+{
+struct TS_bits desc_bits ;
+struct TS_bits *bits = &desc_bits ;
+struct Descriptor *decoded ;
+
+	if (!(descriptor->descriptor_tag & DESC_RAW))
+		return NULL ;
+
+	bits_init(bits, (const uint8_t *)descriptor->descriptor_data, descriptor->descriptor_length) ;
+	decoded = decode_desc(bits, descriptor->descriptor_tag & 0xff, descriptor->descriptor_length) ;
+	if (decoded && bits->error)
+	{
+		free_desc(decoded) ;
+		decoded = NULL ;
+	}
+
+	return decoded ;
+}
+
+
+//============================================================================================
+// Test: decodes the EIT sections in the file with all descriptors decoded, with only short_event and content decoded
+// (the rest kept raw) and with none decoded. Checks that the raw ones decode with parse_desc_raw() to the same list of
+// descriptors as decoding them all (for a well formed capture - a descriptor that reads past the end of its section
+// stops the section being passed on when it's decoded, but not when it's kept raw), and times the three.
+//
+//   parse_desc [-n reps] file.ts
+//
+#ifdef TEST_MAIN
+
+#include <sys/time.h>
+#include <sys/stat.h>
+
+#include "ts_parse.h"
+#include "tables/parse_si_eit.h"
+
+#define TEST_MAX_DESCS		(1024 * 1024)
+#define TEST_CHUNK			(64 * 1024)
+
+enum Desc_test_mode {
+	TEST_DECODE_ALL,
+	TEST_DECODE_MASK,
+	TEST_DECODE_NONE,
+	TEST_NUM_MODES
+};
+
+static const char *test_mode_names[TEST_NUM_MODES] = { "all", "mask", "none" } ;
+
+struct Desc_test {
+	enum Desc_test_mode	mode ;
+	unsigned			check ;
+
+	// (tag << 8) | length of each descriptor, in order
+	uint32_t			*descs ;
+	unsigned			num_descs ;
+
+	unsigned			decoded ;
+	unsigned			raw ;
+	unsigned			errors ;
+};
+
+//---------------------------------------------------------------------------------------------------------------------------
+static double test_time(void)
+{
+struct timeval tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1e6 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_add(struct Desc_test *test, struct Descriptor *desc)
+{
+	if (test->num_descs < TEST_MAX_DESCS)
+		test->descs[test->num_descs++] = ((desc->descriptor_tag & 0xff) << 8) | desc->descriptor_length ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_handler(struct TS_reader *tsreader, struct TS_state *tsstate, struct Section *section, void *user_data)
+{
+struct Section_event_information *eit = (struct Section_event_information *)section ;
+struct Desc_test *test = (struct Desc_test *)user_data ;
+struct list_head *item, *ditem ;
+
+	if (!test->check)
+		return ;
+
+	list_for_each(item, &eit->eit_array)
+	{
+		struct EIT_entry *eit_entry = list_entry(item, struct EIT_entry, next) ;
+
+		list_for_each(ditem, &eit_entry->descriptors_array)
+		{
+			struct Descriptor *desc = list_entry(ditem, struct Descriptor, next) ;
+			struct Descriptor *decoded ;
+
+			if (!(desc->descriptor_tag & DESC_RAW))
+			{
+				// only the wanted ones should be decoded
+				if ((test->mode == TEST_DECODE_MASK) &&
+					(desc->descriptor_tag != DESC_SHORT_EVENT) && (desc->descriptor_tag != DESC_CONTENT))
+					++test->errors ;
+				if (test->mode == TEST_DECODE_NONE)
+					++test->errors ;
+
+				++test->decoded ;
+				test_add(test, desc) ;
+				continue ;
+			}
+
+			++test->raw ;
+			if (test->mode != TEST_DECODE_MASK)
+				++test->errors ;
+
+			// (raw descriptors with no decoder aren't in the decode all list)
+			decoded = parse_desc_raw(desc) ;
+			if (decoded)
+			{
+				test_add(test, decoded) ;
+				free_desc(decoded) ;
+			}
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_parse(uint8_t *data, unsigned data_len, struct Desc_test *test)
+{
+struct TS_reader *tsreader ;
+struct Section_decode_flags flags = SECTION_DECODE_FLAGS_INIT ;
+unsigned table_id ;
+unsigned offset ;
+
+	switch (test->mode)
+	{
+	case TEST_DECODE_ALL:
+		flags.decode_descriptor = 1 ;
+		break ;
+
+	case TEST_DECODE_MASK:
+		flags.use_descriptor_mask = 1 ;
+		DESC_MASK_SET(flags.descriptor_mask, DESC_SHORT_EVENT) ;
+		DESC_MASK_SET(flags.descriptor_mask, DESC_CONTENT) ;
+		break ;
+
+	default:
+		break ;
+	}
+
+	tsreader = tsreader_new_nofile() ;
+	tsreader->user_data = test ;
+	for (table_id=SECTION_EIT_NOW_ACTUAL; table_id <= SECTION_EIT_OTHER_END; ++table_id)
+		tsreader_register_section(tsreader, table_id, 0xff, test_handler, flags) ;
+
+	tsreader_data_start(tsreader) ;
+	for (offset=0; offset < data_len; offset += TEST_CHUNK)
+		tsreader_data_add_shared(tsreader, &data[offset], (data_len - offset) < TEST_CHUNK ? (data_len - offset) : TEST_CHUNK) ;
+	tsreader_data_end(tsreader) ;
+
+	tsreader_free(tsreader) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct Desc_test tests[TEST_NUM_MODES] ;
+struct stat file_stat ;
+uint8_t *data ;
+unsigned data_len ;
+unsigned reps = 20 ;
+unsigned rep ;
+unsigned failed = 0 ;
+unsigned mode ;
+double start, times[TEST_NUM_MODES] ;
+FILE *file ;
+int saved, fd ;
+int c ;
+
+	while ((c = getopt (argc, argv, "n:")) != -1)
+	{
+		switch (c)
+		{
+		case 'n':
+			reps = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	if (optind >= argc)
+	{
+		printf("Usage: parse_desc [-n reps] file.ts\n") ;
+		return 1 ;
+	}
+
+	// read the file into memory (whole packets)
+	if (stat(argv[optind], &file_stat) || !(file = fopen(argv[optind], "rb")))
+	{
+		printf("FAIL : unable to read %s\n", argv[optind]) ;
+		return 1 ;
+	}
+	data_len = (unsigned)(file_stat.st_size - (file_stat.st_size % TS_PACKET_LEN)) ;
+	data = (uint8_t *)malloc(data_len) ;
+	data_len = fread(data, 1, data_len, file) ;
+	fclose(file) ;
+
+	// (decoding prints each descriptor)
+	fflush(stdout) ;
+	saved = dup(1) ;
+	fd = open("/dev/null", O_WRONLY) ;
+	dup2(fd, 1) ;
+	close(fd) ;
+
+	memset(tests, 0, sizeof(tests)) ;
+	for (mode=0; mode < TEST_NUM_MODES; ++mode)
+	{
+		tests[mode].mode = (enum Desc_test_mode)mode ;
+		tests[mode].descs = (uint32_t *)malloc(TEST_MAX_DESCS * sizeof(uint32_t)) ;
+		tests[mode].check = 1 ;
+		test_parse(data, data_len, &tests[mode]) ;
+		tests[mode].check = 0 ;
+
+		start = test_time() ;
+		for (rep=0; rep < reps; ++rep)
+			test_parse(data, data_len, &tests[mode]) ;
+		times[mode] = test_time() - start ;
+	}
+
+	fflush(stdout) ;
+	dup2(saved, 1) ;
+	close(saved) ;
+
+	for (mode=0; mode < TEST_NUM_MODES; ++mode)
+	{
+		printf("%-4s : %7u decoded, %7u raw, %u errors : %.3f s (%u reps)\n", test_mode_names[mode],
+			tests[mode].decoded, tests[mode].raw, tests[mode].errors, times[mode], reps) ;
+		failed += tests[mode].errors ;
+	}
+
+	// raw ones decoded later should give the same list
+	if ((tests[TEST_DECODE_MASK].num_descs != tests[TEST_DECODE_ALL].num_descs) ||
+		memcmp(tests[TEST_DECODE_MASK].descs, tests[TEST_DECODE_ALL].descs, tests[TEST_DECODE_ALL].num_descs * sizeof(uint32_t)))
+	{
+		printf("FAIL : mask + parse_desc_raw() gave %u descriptors, decoding all gave %u\n",
+			tests[TEST_DECODE_MASK].num_descs, tests[TEST_DECODE_ALL].num_descs) ;
+		++failed ;
+	}
+
+	for (mode=0; mode < TEST_NUM_MODES; ++mode)
+		free(tests[mode].descs) ;
+	free(data) ;
+	printf("%s\n", failed ? "FAIL" : "PASS") ;
+
+	return failed ? 1 : 0 ;
+}
+
+#endif
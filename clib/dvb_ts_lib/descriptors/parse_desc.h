@@ -13,6 +13,8 @@
 /*=============================================================================================*/
 #include "desc_structs.h"
 
+struct Section_decode_flags ;
+
 /*=============================================================================================*/
 // CONSTANTS
 /*=============================================================================================*/
@@ -36,7 +38,8 @@ void print_desc_list(struct list_head *descriptors_array, int level) ;
 /* ----------------------------------------------------------------------- */
 void free_desc(struct Descriptor *descriptor) ;
 void free_descriptors_list(struct list_head *desc_array) ;
-enum TS_descriptor_ids parse_desc(struct list_head *descriptors_array, struct TS_bits *bits, unsigned decode_descriptor);
+enum TS_descriptor_ids parse_desc(struct list_head *descriptors_array, struct TS_bits *bits, struct Section_decode_flags *flags);
+struct Descriptor *parse_desc_raw(struct Descriptor *descriptor) ;
 
 
 #endif /* PARSE_DESC_H_ */
@@ -64,7 +64,7 @@ struct Descriptor_adaptation_field_data *afdd ;
 unsigned byte ;
 int end_buff_len ;
 
-	afdd = (struct Descriptor_adaptation_field_data *)malloc( sizeof(*afdd) ) ;
+	afdd = (struct Descriptor_adaptation_field_data *)bits_alloc(bits, sizeof(*afdd) ) ;
 	memset(afdd,0,sizeof(*afdd));
 
 	//== Parse data ==
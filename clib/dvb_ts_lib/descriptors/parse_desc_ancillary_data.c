@@ -64,7 +64,7 @@ struct Descriptor_ancillary_data *add ;
 unsigned byte ;
 int end_buff_len ;
 
-	add = (struct Descriptor_ancillary_data *)malloc( sizeof(*add) ) ;
+	add = (struct Descriptor_ancillary_data *)bits_alloc(bits, sizeof(*add) ) ;
 	memset(add,0,sizeof(*add));
 
 	//== Parse data ==
@@ -94,7 +94,7 @@ struct Descriptor_announcement_support *asd ;
 unsigned byte ;
 int end_buff_len ;
 
-	asd = (struct Descriptor_announcement_support *)malloc( sizeof(*asd) ) ;
+	asd = (struct Descriptor_announcement_support *)bits_alloc(bits, sizeof(*asd) ) ;
 	memset(asd,0,sizeof(*asd));
 
 	//== Parse data ==
@@ -107,7 +107,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -(asd->descriptor_length - 2) ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct ASD_entry *asd_entry = malloc(sizeof(*asd_entry));
+		struct ASD_entry *asd_entry = bits_alloc(bits,sizeof(*asd_entry));
 		memset(asd_entry,0,sizeof(*asd_entry));
 		list_add_tail(&asd_entry->next,&asd->asd_array);
 
@@ -66,7 +66,7 @@ struct Descriptor_bouquet_name *bnd ;
 unsigned byte ;
 int end_buff_len ;
 
-	bnd = (struct Descriptor_bouquet_name *)malloc( sizeof(*bnd) ) ;
+	bnd = (struct Descriptor_bouquet_name *)bits_alloc(bits, sizeof(*bnd) ) ;
 	memset(bnd,0,sizeof(*bnd));
 
 	//== Parse data ==
@@ -66,7 +66,7 @@ struct Descriptor_ca_identifier *cid ;
 unsigned byte ;
 int end_buff_len ;
 
-	cid = (struct Descriptor_ca_identifier *)malloc( sizeof(*cid) ) ;
+	cid = (struct Descriptor_ca_identifier *)bits_alloc(bits, sizeof(*cid) ) ;
 	memset(cid,0,sizeof(*cid));
 
 	//== Parse data ==
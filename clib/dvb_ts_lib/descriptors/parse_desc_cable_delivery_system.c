@@ -73,7 +73,7 @@ struct Descriptor_cable_delivery_system *cdsd ;
 unsigned byte ;
 int end_buff_len ;
 
-	cdsd = (struct Descriptor_cable_delivery_system *)malloc( sizeof(*cdsd) ) ;
+	cdsd = (struct Descriptor_cable_delivery_system *)bits_alloc(bits, sizeof(*cdsd) ) ;
 	memset(cdsd,0,sizeof(*cdsd));
 
 	//== Parse data ==
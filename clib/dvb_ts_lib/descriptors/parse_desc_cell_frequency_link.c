@@ -75,7 +75,7 @@ struct list_head  *item1, *safe1;
 		printf("      subcell_info_loop_length = %d\n", cfld_entry->subcell_info_loop_length) ;
 		
 		list_for_each_safe(item1,safe1,&cfld_entry->cfld1_array) {
-			struct CFLD1_entry *cfld1_entry = list_entry(item, struct CFLD1_entry, next);
+			struct CFLD1_entry *cfld1_entry = list_entry(item1, struct CFLD1_entry, next);
 			
 			// CFLD entry
 			printf("        -CFLD entry-\n") ;
@@ -95,7 +95,7 @@ struct Descriptor_cell_frequency_link *cfld ;
 unsigned byte ;
 int end_buff_len ;
 
-	cfld = (struct Descriptor_cell_frequency_link *)malloc( sizeof(*cfld) ) ;
+	cfld = (struct Descriptor_cell_frequency_link *)bits_alloc(bits, sizeof(*cfld) ) ;
 	memset(cfld,0,sizeof(*cfld));
 
 	//== Parse data ==
@@ -107,7 +107,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -cfld->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct CFLD_entry *cfld_entry = malloc(sizeof(*cfld_entry));
+		struct CFLD_entry *cfld_entry = bits_alloc(bits,sizeof(*cfld_entry));
 		memset(cfld_entry,0,sizeof(*cfld_entry));
 		list_add_tail(&cfld_entry->next,&cfld->cfld_array);
 
@@ -118,7 +118,7 @@ int end_buff_len ;
 		INIT_LIST_HEAD(&cfld_entry->cfld1_array) ;
 		while (bits->buff_len >= 5)
 		{
-			struct CFLD1_entry *cfld1_entry = malloc(sizeof(*cfld1_entry));
+			struct CFLD1_entry *cfld1_entry = bits_alloc(bits,sizeof(*cfld1_entry));
 			memset(cfld1_entry,0,sizeof(*cfld1_entry));
 			list_add_tail(&cfld1_entry->next,&cfld_entry->cfld1_array);
 
@@ -142,7 +142,7 @@ struct list_head  *item1, *safe1;
 		struct CFLD_entry *cfld_entry = list_entry(item, struct CFLD_entry, next);
 		
 		list_for_each_safe(item1,safe1,&cfld_entry->cfld1_array) {
-			struct CFLD1_entry *cfld1_entry = list_entry(item, struct CFLD1_entry, next);
+			struct CFLD1_entry *cfld1_entry = list_entry(item1, struct CFLD1_entry, next);
 			free(cfld1_entry) ;
 		}
 		
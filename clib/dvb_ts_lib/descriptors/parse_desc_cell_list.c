@@ -84,7 +84,7 @@ struct list_head  *item1, *safe1;
 		printf("      subcell_info_loop_length = %d\n", cld_entry->subcell_info_loop_length) ;
 		
 		list_for_each_safe(item1,safe1,&cld_entry->cld1_array) {
-			struct CLD1_entry *cld1_entry = list_entry(item, struct CLD1_entry, next);
+			struct CLD1_entry *cld1_entry = list_entry(item1, struct CLD1_entry, next);
 			
 			// CLD entry
 			printf("        -CLD entry-\n") ;
@@ -107,7 +107,7 @@ struct Descriptor_cell_list *cld ;
 unsigned byte ;
 int end_buff_len ;
 
-	cld = (struct Descriptor_cell_list *)malloc( sizeof(*cld) ) ;
+	cld = (struct Descriptor_cell_list *)bits_alloc(bits, sizeof(*cld) ) ;
 	memset(cld,0,sizeof(*cld));
 
 	//== Parse data ==
@@ -119,7 +119,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -cld->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct CLD_entry *cld_entry = malloc(sizeof(*cld_entry));
+		struct CLD_entry *cld_entry = bits_alloc(bits,sizeof(*cld_entry));
 		memset(cld_entry,0,sizeof(*cld_entry));
 		list_add_tail(&cld_entry->next,&cld->cld_array);
 
@@ -133,7 +133,7 @@ int end_buff_len ;
 		INIT_LIST_HEAD(&cld_entry->cld1_array) ;
 		while (bits->buff_len >= 8)
 		{
-			struct CLD1_entry *cld1_entry = malloc(sizeof(*cld1_entry));
+			struct CLD1_entry *cld1_entry = bits_alloc(bits,sizeof(*cld1_entry));
 			memset(cld1_entry,0,sizeof(*cld1_entry));
 			list_add_tail(&cld1_entry->next,&cld_entry->cld1_array);
 
@@ -160,7 +160,7 @@ struct list_head  *item1, *safe1;
 		struct CLD_entry *cld_entry = list_entry(item, struct CLD_entry, next);
 		
 		list_for_each_safe(item1,safe1,&cld_entry->cld1_array) {
-			struct CLD1_entry *cld1_entry = list_entry(item, struct CLD1_entry, next);
+			struct CLD1_entry *cld1_entry = list_entry(item1, struct CLD1_entry, next);
 			free(cld1_entry) ;
 		}
 		
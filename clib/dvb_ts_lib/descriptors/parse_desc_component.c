@@ -75,7 +75,7 @@ struct Descriptor_component *cd ;
 unsigned byte ;
 int end_buff_len ;
 
-	cd = (struct Descriptor_component *)malloc( sizeof(*cd) ) ;
+	cd = (struct Descriptor_component *)bits_alloc(bits, sizeof(*cd) ) ;
 	memset(cd,0,sizeof(*cd));
 
 	//== Parse data ==
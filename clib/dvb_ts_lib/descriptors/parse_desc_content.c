@@ -81,7 +81,7 @@ struct Descriptor_content *cd ;
 unsigned byte ;
 int end_buff_len ;
 
-	cd = (struct Descriptor_content *)malloc( sizeof(*cd) ) ;
+	cd = (struct Descriptor_content *)bits_alloc(bits, sizeof(*cd) ) ;
 	memset(cd,0,sizeof(*cd));
 
 	//== Parse data ==
@@ -93,7 +93,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -cd->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct CD_entry *cd_entry = malloc(sizeof(*cd_entry));
+		struct CD_entry *cd_entry = bits_alloc(bits,sizeof(*cd_entry));
 		memset(cd_entry,0,sizeof(*cd_entry));
 		list_add_tail(&cd_entry->next,&cd->cd_array);
 
@@ -69,7 +69,7 @@ struct Descriptor_country_availability *cad ;
 unsigned byte ;
 int end_buff_len ;
 
-	cad = (struct Descriptor_country_availability *)malloc( sizeof(*cad) ) ;
+	cad = (struct Descriptor_country_availability *)bits_alloc(bits, sizeof(*cad) ) ;
 	memset(cad,0,sizeof(*cad));
 
 	//== Parse data ==
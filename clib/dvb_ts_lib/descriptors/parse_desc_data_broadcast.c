@@ -80,7 +80,7 @@ struct Descriptor_data_broadcast *dbd ;
 unsigned byte ;
 int end_buff_len ;
 
-	dbd = (struct Descriptor_data_broadcast *)malloc( sizeof(*dbd) ) ;
+	dbd = (struct Descriptor_data_broadcast *)bits_alloc(bits, sizeof(*dbd) ) ;
 	memset(dbd,0,sizeof(*dbd));
 
 	//== Parse data ==
@@ -68,7 +68,7 @@ struct Descriptor_data_broadcast_id *dbid ;
 unsigned byte ;
 int end_buff_len ;
 
-	dbid = (struct Descriptor_data_broadcast_id *)malloc( sizeof(*dbid) ) ;
+	dbid = (struct Descriptor_data_broadcast_id *)bits_alloc(bits, sizeof(*dbid) ) ;
 	memset(dbid,0,sizeof(*dbid));
 
 	//== Parse data ==
@@ -66,7 +66,7 @@ struct Descriptor_dsng *dd ;
 unsigned byte ;
 int end_buff_len ;
 
-	dd = (struct Descriptor_dsng *)malloc( sizeof(*dd) ) ;
+	dd = (struct Descriptor_dsng *)bits_alloc(bits, sizeof(*dd) ) ;
 	memset(dd,0,sizeof(*dd));
 
 	//== Parse data ==
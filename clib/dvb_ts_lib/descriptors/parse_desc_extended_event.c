@@ -99,7 +99,7 @@ struct Descriptor_extended_event *eed ;
 unsigned byte ;
 int end_buff_len ;
 
-	eed = (struct Descriptor_extended_event *)malloc( sizeof(*eed) ) ;
+	eed = (struct Descriptor_extended_event *)bits_alloc(bits, sizeof(*eed) ) ;
 	memset(eed,0,sizeof(*eed));
 
 	//== Parse data ==
@@ -115,7 +115,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -(eed->descriptor_length - 5) ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct EED_entry *eed_entry = malloc(sizeof(*eed_entry));
+		struct EED_entry *eed_entry = bits_alloc(bits,sizeof(*eed_entry));
 		memset(eed_entry,0,sizeof(*eed_entry));
 		list_add_tail(&eed_entry->next,&eed->eed_array);
 
@@ -68,7 +68,7 @@ struct Descriptor_extension *ed ;
 unsigned byte ;
 int end_buff_len ;
 
-	ed = (struct Descriptor_extension *)malloc( sizeof(*ed) ) ;
+	ed = (struct Descriptor_extension *)bits_alloc(bits, sizeof(*ed) ) ;
 	memset(ed,0,sizeof(*ed));
 
 	//== Parse data ==
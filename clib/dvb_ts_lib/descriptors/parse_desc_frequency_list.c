@@ -69,7 +69,7 @@ struct Descriptor_frequency_list *fld ;
 unsigned byte ;
 int end_buff_len ;
 
-	fld = (struct Descriptor_frequency_list *)malloc( sizeof(*fld) ) ;
+	fld = (struct Descriptor_frequency_list *)bits_alloc(bits, sizeof(*fld) ) ;
 	memset(fld,0,sizeof(*fld));
 
 	//== Parse data ==
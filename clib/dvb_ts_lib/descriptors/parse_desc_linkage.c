@@ -111,7 +111,7 @@ struct Descriptor_linkage *ld ;
 unsigned byte ;
 int end_buff_len ;
 
-	ld = (struct Descriptor_linkage *)malloc( sizeof(*ld) ) ;
+	ld = (struct Descriptor_linkage *)bits_alloc(bits, sizeof(*ld) ) ;
 	memset(ld,0,sizeof(*ld));
 
 	//== Parse data ==
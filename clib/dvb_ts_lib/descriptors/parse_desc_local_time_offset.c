@@ -89,7 +89,7 @@ struct Descriptor_local_time_offset *ltod ;
 unsigned byte ;
 int end_buff_len ;
 
-	ltod = (struct Descriptor_local_time_offset *)malloc( sizeof(*ltod) ) ;
+	ltod = (struct Descriptor_local_time_offset *)bits_alloc(bits, sizeof(*ltod) ) ;
 	memset(ltod,0,sizeof(*ltod));
 
 	//== Parse data ==
@@ -101,7 +101,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -ltod->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct LTOD_entry *ltod_entry = malloc(sizeof(*ltod_entry));
+		struct LTOD_entry *ltod_entry = bits_alloc(bits,sizeof(*ltod_entry));
 		memset(ltod_entry,0,sizeof(*ltod_entry));
 		list_add_tail(&ltod_entry->next,&ltod->ltod_array);
 
@@ -103,7 +103,7 @@ struct list_head  *item1, *safe1;
 		printf("      elementary_cell_field_length = %d\n", md_entry->elementary_cell_field_length) ;
 		
 		list_for_each_safe(item1,safe1,&md_entry->md1_array) {
-			struct MD1_entry *md1_entry = list_entry(item, struct MD1_entry, next);
+			struct MD1_entry *md1_entry = list_entry(item1, struct MD1_entry, next);
 			
 			// MD entry
 			printf("        -MD entry-\n") ;
@@ -150,7 +150,7 @@ struct Descriptor_mosaic *md ;
 unsigned byte ;
 int end_buff_len ;
 
-	md = (struct Descriptor_mosaic *)malloc( sizeof(*md) ) ;
+	md = (struct Descriptor_mosaic *)bits_alloc(bits, sizeof(*md) ) ;
 	memset(md,0,sizeof(*md));
 
 	//== Parse data ==
@@ -166,7 +166,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -(md->descriptor_length - 1) ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct MD_entry *md_entry = malloc(sizeof(*md_entry));
+		struct MD_entry *md_entry = bits_alloc(bits,sizeof(*md_entry));
 		memset(md_entry,0,sizeof(*md_entry));
 		list_add_tail(&md_entry->next,&md->md_array);
 
@@ -178,7 +178,7 @@ int end_buff_len ;
 		INIT_LIST_HEAD(&md_entry->md1_array) ;
 		while (bits->buff_len >= 1)
 		{
-			struct MD1_entry *md1_entry = malloc(sizeof(*md1_entry));
+			struct MD1_entry *md1_entry = bits_alloc(bits,sizeof(*md1_entry));
 			memset(md1_entry,0,sizeof(*md1_entry));
 			list_add_tail(&md1_entry->next,&md_entry->md1_array);
 
@@ -230,7 +230,7 @@ struct list_head  *item1, *safe1;
 		struct MD_entry *md_entry = list_entry(item, struct MD_entry, next);
 		
 		list_for_each_safe(item1,safe1,&md_entry->md1_array) {
-			struct MD1_entry *md1_entry = list_entry(item, struct MD1_entry, next);
+			struct MD1_entry *md1_entry = list_entry(item1, struct MD1_entry, next);
 			free(md1_entry) ;
 		}
 		
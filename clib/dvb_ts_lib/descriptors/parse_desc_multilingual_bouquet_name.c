@@ -81,7 +81,7 @@ struct Descriptor_multilingual_bouquet_name *mbnd ;
 unsigned byte ;
 int end_buff_len ;
 
-	mbnd = (struct Descriptor_multilingual_bouquet_name *)malloc( sizeof(*mbnd) ) ;
+	mbnd = (struct Descriptor_multilingual_bouquet_name *)bits_alloc(bits, sizeof(*mbnd) ) ;
 	memset(mbnd,0,sizeof(*mbnd));
 
 	//== Parse data ==
@@ -93,7 +93,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -mbnd->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct MBND_entry *mbnd_entry = malloc(sizeof(*mbnd_entry));
+		struct MBND_entry *mbnd_entry = bits_alloc(bits,sizeof(*mbnd_entry));
 		memset(mbnd_entry,0,sizeof(*mbnd_entry));
 		list_add_tail(&mbnd_entry->next,&mbnd->mbnd_array);
 
@@ -83,7 +83,7 @@ struct Descriptor_multilingual_component *mcd ;
 unsigned byte ;
 int end_buff_len ;
 
-	mcd = (struct Descriptor_multilingual_component *)malloc( sizeof(*mcd) ) ;
+	mcd = (struct Descriptor_multilingual_component *)bits_alloc(bits, sizeof(*mcd) ) ;
 	memset(mcd,0,sizeof(*mcd));
 
 	//== Parse data ==
@@ -96,7 +96,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -(mcd->descriptor_length - 1) ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct MCD_entry *mcd_entry = malloc(sizeof(*mcd_entry));
+		struct MCD_entry *mcd_entry = bits_alloc(bits,sizeof(*mcd_entry));
 		memset(mcd_entry,0,sizeof(*mcd_entry));
 		list_add_tail(&mcd_entry->next,&mcd->mcd_array);
 
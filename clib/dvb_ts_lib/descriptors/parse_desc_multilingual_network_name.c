@@ -81,7 +81,7 @@ struct Descriptor_multilingual_network_name *mnnd ;
 unsigned byte ;
 int end_buff_len ;
 
-	mnnd = (struct Descriptor_multilingual_network_name *)malloc( sizeof(*mnnd) ) ;
+	mnnd = (struct Descriptor_multilingual_network_name *)bits_alloc(bits, sizeof(*mnnd) ) ;
 	memset(mnnd,0,sizeof(*mnnd));
 
 	//== Parse data ==
@@ -93,7 +93,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -mnnd->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct MNND_entry *mnnd_entry = malloc(sizeof(*mnnd_entry));
+		struct MNND_entry *mnnd_entry = bits_alloc(bits,sizeof(*mnnd_entry));
 		memset(mnnd_entry,0,sizeof(*mnnd_entry));
 		list_add_tail(&mnnd_entry->next,&mnnd->mnnd_array);
 
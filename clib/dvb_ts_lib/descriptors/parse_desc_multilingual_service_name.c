@@ -87,7 +87,7 @@ struct Descriptor_multilingual_service_name *msnd ;
 unsigned byte ;
 int end_buff_len ;
 
-	msnd = (struct Descriptor_multilingual_service_name *)malloc( sizeof(*msnd) ) ;
+	msnd = (struct Descriptor_multilingual_service_name *)bits_alloc(bits, sizeof(*msnd) ) ;
 	memset(msnd,0,sizeof(*msnd));
 
 	//== Parse data ==
@@ -99,7 +99,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -msnd->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct MSND_entry *msnd_entry = malloc(sizeof(*msnd_entry));
+		struct MSND_entry *msnd_entry = bits_alloc(bits,sizeof(*msnd_entry));
 		memset(msnd_entry,0,sizeof(*msnd_entry));
 		list_add_tail(&msnd_entry->next,&msnd->msnd_array);
 
@@ -66,7 +66,7 @@ struct Descriptor_network_name *nnd ;
 unsigned byte ;
 int end_buff_len ;
 
-	nnd = (struct Descriptor_network_name *)malloc( sizeof(*nnd) ) ;
+	nnd = (struct Descriptor_network_name *)bits_alloc(bits, sizeof(*nnd) ) ;
 	memset(nnd,0,sizeof(*nnd));
 
 	//== Parse data ==
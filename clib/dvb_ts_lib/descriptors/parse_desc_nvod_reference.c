@@ -79,7 +79,7 @@ struct Descriptor_nvod_reference *nrd ;
 unsigned byte ;
 int end_buff_len ;
 
-	nrd = (struct Descriptor_nvod_reference *)malloc( sizeof(*nrd) ) ;
+	nrd = (struct Descriptor_nvod_reference *)bits_alloc(bits, sizeof(*nrd) ) ;
 	memset(nrd,0,sizeof(*nrd));
 
 	//== Parse data ==
@@ -91,7 +91,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -nrd->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct NRD_entry *nrd_entry = malloc(sizeof(*nrd_entry));
+		struct NRD_entry *nrd_entry = bits_alloc(bits,sizeof(*nrd_entry));
 		memset(nrd_entry,0,sizeof(*nrd_entry));
 		list_add_tail(&nrd_entry->next,&nrd->nrd_array);
 
@@ -77,7 +77,7 @@ struct Descriptor_parental_rating *prd ;
 unsigned byte ;
 int end_buff_len ;
 
-	prd = (struct Descriptor_parental_rating *)malloc( sizeof(*prd) ) ;
+	prd = (struct Descriptor_parental_rating *)bits_alloc(bits, sizeof(*prd) ) ;
 	memset(prd,0,sizeof(*prd));
 
 	//== Parse data ==
@@ -89,7 +89,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -prd->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct PRD_entry *prd_entry = malloc(sizeof(*prd_entry));
+		struct PRD_entry *prd_entry = bits_alloc(bits,sizeof(*prd_entry));
 		memset(prd_entry,0,sizeof(*prd_entry));
 		list_add_tail(&prd_entry->next,&prd->prd_array);
 
@@ -71,7 +71,7 @@ struct Descriptor_partial_transport_stream *ptsd ;
 unsigned byte ;
 int end_buff_len ;
 
-	ptsd = (struct Descriptor_partial_transport_stream *)malloc( sizeof(*ptsd) ) ;
+	ptsd = (struct Descriptor_partial_transport_stream *)bits_alloc(bits, sizeof(*ptsd) ) ;
 	memset(ptsd,0,sizeof(*ptsd));
 
 	//== Parse data ==
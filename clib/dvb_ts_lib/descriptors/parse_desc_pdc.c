@@ -65,7 +65,7 @@ struct Descriptor_pdc *pd ;
 unsigned byte ;
 int end_buff_len ;
 
-	pd = (struct Descriptor_pdc *)malloc( sizeof(*pd) ) ;
+	pd = (struct Descriptor_pdc *)bits_alloc(bits, sizeof(*pd) ) ;
 	memset(pd,0,sizeof(*pd));
 
 	//== Parse data ==
@@ -64,7 +64,7 @@ struct Descriptor_private_data_specifier *pdsd ;
 unsigned byte ;
 int end_buff_len ;
 
-	pdsd = (struct Descriptor_private_data_specifier *)malloc( sizeof(*pdsd) ) ;
+	pdsd = (struct Descriptor_private_data_specifier *)bits_alloc(bits, sizeof(*pdsd) ) ;
 	memset(pdsd,0,sizeof(*pdsd));
 
 	//== Parse data ==
@@ -86,7 +86,7 @@ struct Descriptor_s2_satellite_delivery_system *ssdsd ;
 unsigned byte ;
 int end_buff_len ;
 
-	ssdsd = (struct Descriptor_s2_satellite_delivery_system *)malloc( sizeof(*ssdsd) ) ;
+	ssdsd = (struct Descriptor_s2_satellite_delivery_system *)bits_alloc(bits, sizeof(*ssdsd) ) ;
 	memset(ssdsd,0,sizeof(*ssdsd));
 
 	//== Parse data ==
@@ -91,7 +91,7 @@ struct Descriptor_satellite_delivery_system *sdsd ;
 unsigned byte ;
 int end_buff_len ;
 
-	sdsd = (struct Descriptor_satellite_delivery_system *)malloc( sizeof(*sdsd) ) ;
+	sdsd = (struct Descriptor_satellite_delivery_system *)bits_alloc(bits, sizeof(*sdsd) ) ;
 	memset(sdsd,0,sizeof(*sdsd));
 
 	//== Parse data ==
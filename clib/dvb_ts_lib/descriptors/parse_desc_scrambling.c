@@ -64,7 +64,7 @@ struct Descriptor_scrambling *sd ;
 unsigned byte ;
 int end_buff_len ;
 
-	sd = (struct Descriptor_scrambling *)malloc( sizeof(*sd) ) ;
+	sd = (struct Descriptor_scrambling *)bits_alloc(bits, sizeof(*sd) ) ;
 	memset(sd,0,sizeof(*sd));
 
 	//== Parse data ==
@@ -76,7 +76,7 @@ struct Descriptor_service *sd ;
 unsigned byte ;
 int end_buff_len ;
 
-	sd = (struct Descriptor_service *)malloc( sizeof(*sd) ) ;
+	sd = (struct Descriptor_service *)bits_alloc(bits, sizeof(*sd) ) ;
 	memset(sd,0,sizeof(*sd));
 
 	//== Parse data ==
@@ -69,7 +69,7 @@ struct Descriptor_service_availability *sad ;
 unsigned byte ;
 int end_buff_len ;
 
-	sad = (struct Descriptor_service_availability *)malloc( sizeof(*sad) ) ;
+	sad = (struct Descriptor_service_availability *)bits_alloc(bits, sizeof(*sad) ) ;
 	memset(sad,0,sizeof(*sad));
 
 	//== Parse data ==
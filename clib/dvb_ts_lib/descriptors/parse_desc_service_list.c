@@ -77,7 +77,7 @@ struct Descriptor_service_list *sld ;
 unsigned byte ;
 int end_buff_len ;
 
-	sld = (struct Descriptor_service_list *)malloc( sizeof(*sld) ) ;
+	sld = (struct Descriptor_service_list *)bits_alloc(bits, sizeof(*sld) ) ;
 	memset(sld,0,sizeof(*sld));
 
 	//== Parse data ==
@@ -89,7 +89,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -sld->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct SLD_entry *sld_entry = malloc(sizeof(*sld_entry));
+		struct SLD_entry *sld_entry = bits_alloc(bits,sizeof(*sld_entry));
 		memset(sld_entry,0,sizeof(*sld_entry));
 		list_add_tail(&sld_entry->next,&sld->sld_array);
 
@@ -68,7 +68,7 @@ struct Descriptor_service_move *smd ;
 unsigned byte ;
 int end_buff_len ;
 
-	smd = (struct Descriptor_service_move *)malloc( sizeof(*smd) ) ;
+	smd = (struct Descriptor_service_move *)bits_alloc(bits, sizeof(*smd) ) ;
 	memset(smd,0,sizeof(*smd));
 
 	//== Parse data ==
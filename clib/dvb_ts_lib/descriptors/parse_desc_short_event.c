@@ -76,7 +76,7 @@ struct Descriptor_short_event *sed ;
 unsigned byte ;
 int end_buff_len ;
 
-	sed = (struct Descriptor_short_event *)malloc( sizeof(*sed) ) ;
+	sed = (struct Descriptor_short_event *)bits_alloc(bits, sizeof(*sed) ) ;
 	memset(sed,0,sizeof(*sed));
 
 	//== Parse data ==
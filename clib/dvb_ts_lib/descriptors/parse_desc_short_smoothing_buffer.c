@@ -70,7 +70,7 @@ struct Descriptor_short_smoothing_buffer *ssbd ;
 unsigned byte ;
 int end_buff_len ;
 
-	ssbd = (struct Descriptor_short_smoothing_buffer *)malloc( sizeof(*ssbd) ) ;
+	ssbd = (struct Descriptor_short_smoothing_buffer *)bits_alloc(bits, sizeof(*ssbd) ) ;
 	memset(ssbd,0,sizeof(*ssbd));
 
 	//== Parse data ==
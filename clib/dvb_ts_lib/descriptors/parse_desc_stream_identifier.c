@@ -64,7 +64,7 @@ struct Descriptor_stream_identifier *sid ;
 unsigned byte ;
 int end_buff_len ;
 
-	sid = (struct Descriptor_stream_identifier *)malloc( sizeof(*sid) ) ;
+	sid = (struct Descriptor_stream_identifier *)bits_alloc(bits, sizeof(*sid) ) ;
 	memset(sid,0,sizeof(*sid));
 
 	//== Parse data ==
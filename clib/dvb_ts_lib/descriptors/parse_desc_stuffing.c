@@ -76,7 +76,7 @@ struct Descriptor_stuffing *sd ;
 unsigned byte ;
 int end_buff_len ;
 
-	sd = (struct Descriptor_stuffing *)malloc( sizeof(*sd) ) ;
+	sd = (struct Descriptor_stuffing *)bits_alloc(bits, sizeof(*sd) ) ;
 	memset(sd,0,sizeof(*sd));
 
 	//== Parse data ==
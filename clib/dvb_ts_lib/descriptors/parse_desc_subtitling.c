@@ -81,7 +81,7 @@ struct Descriptor_subtitling *sd ;
 unsigned byte ;
 int end_buff_len ;
 
-	sd = (struct Descriptor_subtitling *)malloc( sizeof(*sd) ) ;
+	sd = (struct Descriptor_subtitling *)bits_alloc(bits, sizeof(*sd) ) ;
 	memset(sd,0,sizeof(*sd));
 
 	//== Parse data ==
@@ -93,7 +93,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -sd->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct SD_entry *sd_entry = malloc(sizeof(*sd_entry));
+		struct SD_entry *sd_entry = bits_alloc(bits,sizeof(*sd_entry));
 		memset(sd_entry,0,sizeof(*sd_entry));
 		list_add_tail(&sd_entry->next,&sd->sd_array);
 
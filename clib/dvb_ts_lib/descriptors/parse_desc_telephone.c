@@ -99,7 +99,7 @@ struct Descriptor_telephone *td ;
 unsigned byte ;
 int end_buff_len ;
 
-	td = (struct Descriptor_telephone *)malloc( sizeof(*td) ) ;
+	td = (struct Descriptor_telephone *)bits_alloc(bits, sizeof(*td) ) ;
 	memset(td,0,sizeof(*td));
 
 	//== Parse data ==
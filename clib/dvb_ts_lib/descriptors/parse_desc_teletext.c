@@ -81,7 +81,7 @@ struct Descriptor_teletext *td ;
 unsigned byte ;
 int end_buff_len ;
 
-	td = (struct Descriptor_teletext *)malloc( sizeof(*td) ) ;
+	td = (struct Descriptor_teletext *)bits_alloc(bits, sizeof(*td) ) ;
 	memset(td,0,sizeof(*td));
 
 	//== Parse data ==
@@ -93,7 +93,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -td->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct TD_entry *td_entry = malloc(sizeof(*td_entry));
+		struct TD_entry *td_entry = bits_alloc(bits,sizeof(*td_entry));
 		memset(td_entry,0,sizeof(*td_entry));
 		list_add_tail(&td_entry->next,&td->td_array);
 
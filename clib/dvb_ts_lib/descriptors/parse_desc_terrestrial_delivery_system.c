@@ -88,7 +88,7 @@ struct Descriptor_terrestrial_delivery_system *tdsd ;
 unsigned byte ;
 int end_buff_len ;
 
-	tdsd = (struct Descriptor_terrestrial_delivery_system *)malloc( sizeof(*tdsd) ) ;
+	tdsd = (struct Descriptor_terrestrial_delivery_system *)bits_alloc(bits, sizeof(*tdsd) ) ;
 	memset(tdsd,0,sizeof(*tdsd));
 
 	//== Parse data ==
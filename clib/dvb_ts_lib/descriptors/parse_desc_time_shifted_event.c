@@ -66,7 +66,7 @@ struct Descriptor_time_shifted_event *tsed ;
 unsigned byte ;
 int end_buff_len ;
 
-	tsed = (struct Descriptor_time_shifted_event *)malloc( sizeof(*tsed) ) ;
+	tsed = (struct Descriptor_time_shifted_event *)bits_alloc(bits, sizeof(*tsed) ) ;
 	memset(tsed,0,sizeof(*tsed));
 
 	//== Parse data ==
@@ -64,7 +64,7 @@ struct Descriptor_time_shifted_service *tssd ;
 unsigned byte ;
 int end_buff_len ;
 
-	tssd = (struct Descriptor_time_shifted_service *)malloc( sizeof(*tssd) ) ;
+	tssd = (struct Descriptor_time_shifted_service *)bits_alloc(bits, sizeof(*tssd) ) ;
 	memset(tssd,0,sizeof(*tssd));
 
 	//== Parse data ==
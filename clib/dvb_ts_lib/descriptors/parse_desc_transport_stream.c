@@ -66,7 +66,7 @@ struct Descriptor_transport_stream *tsd ;
 unsigned byte ;
 int end_buff_len ;
 
-	tsd = (struct Descriptor_transport_stream *)malloc( sizeof(*tsd) ) ;
+	tsd = (struct Descriptor_transport_stream *)bits_alloc(bits, sizeof(*tsd) ) ;
 	memset(tsd,0,sizeof(*tsd));
 
 	//== Parse data ==
@@ -97,7 +97,7 @@ struct Descriptor_tva_content_identifier *tcid ;
 unsigned byte ;
 int end_buff_len ;
 
-	tcid = (struct Descriptor_tva_content_identifier *)malloc( sizeof(*tcid) ) ;
+	tcid = (struct Descriptor_tva_content_identifier *)bits_alloc(bits, sizeof(*tcid) ) ;
 	memset(tcid,0,sizeof(*tcid));
 
 	//== Parse data ==
@@ -109,7 +109,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -tcid->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct TCID_entry *tcid_entry = malloc(sizeof(*tcid_entry));
+		struct TCID_entry *tcid_entry = bits_alloc(bits,sizeof(*tcid_entry));
 		memset(tcid_entry,0,sizeof(*tcid_entry));
 		list_add_tail(&tcid_entry->next,&tcid->tcid_array);
 
@@ -82,7 +82,7 @@ struct list_head  *item1, *safe1;
 		{
 		
 		list_for_each_safe(item1,safe1,&vdd_entry->vdd1_array) {
-			struct VDD1_entry *vdd1_entry = list_entry(item, struct VDD1_entry, next);
+			struct VDD1_entry *vdd1_entry = list_entry(item1, struct VDD1_entry, next);
 			
 			// VDD entry
 			printf("        -VDD entry-\n") ;
@@ -108,7 +108,7 @@ struct Descriptor_vbi_data *vdd ;
 unsigned byte ;
 int end_buff_len ;
 
-	vdd = (struct Descriptor_vbi_data *)malloc( sizeof(*vdd) ) ;
+	vdd = (struct Descriptor_vbi_data *)bits_alloc(bits, sizeof(*vdd) ) ;
 	memset(vdd,0,sizeof(*vdd));
 
 	//== Parse data ==
@@ -120,19 +120,18 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -vdd->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct VDD_entry *vdd_entry = malloc(sizeof(*vdd_entry));
+		struct VDD_entry *vdd_entry = bits_alloc(bits,sizeof(*vdd_entry));
 		memset(vdd_entry,0,sizeof(*vdd_entry));
 		list_add_tail(&vdd_entry->next,&vdd->vdd_array);
 
 		vdd_entry->data_service_id = bits_get(bits, 8) ;
 		vdd_entry->data_service_descriptor_length = bits_get(bits, 8) ;
+		INIT_LIST_HEAD(&vdd_entry->vdd1_array) ;
 		if (vdd_entry->data_service_id == 0x1 || vdd_entry->data_service_id == 0x2 || vdd_entry->data_service_id == 0x4 || vdd_entry->data_service_id == 0x5 || vdd_entry->data_service_id == 0x6 || vdd_entry->data_service_id == 0x7  )
 		{
-		
-		INIT_LIST_HEAD(&vdd_entry->vdd1_array) ;
 		while (bits->buff_len >= 1)
 		{
-			struct VDD1_entry *vdd1_entry = malloc(sizeof(*vdd1_entry));
+			struct VDD1_entry *vdd1_entry = bits_alloc(bits,sizeof(*vdd1_entry));
 			memset(vdd1_entry,0,sizeof(*vdd1_entry));
 			list_add_tail(&vdd1_entry->next,&vdd_entry->vdd1_array);
 
@@ -171,7 +170,7 @@ struct list_head  *item1, *safe1;
 		struct VDD_entry *vdd_entry = list_entry(item, struct VDD_entry, next);
 		
 		list_for_each_safe(item1,safe1,&vdd_entry->vdd1_array) {
-			struct VDD1_entry *vdd1_entry = list_entry(item, struct VDD1_entry, next);
+			struct VDD1_entry *vdd1_entry = list_entry(item1, struct VDD1_entry, next);
 			free(vdd1_entry) ;
 		}
 		
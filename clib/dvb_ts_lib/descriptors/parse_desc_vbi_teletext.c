@@ -81,7 +81,7 @@ struct Descriptor_vbi_teletext *vtd ;
 unsigned byte ;
 int end_buff_len ;
 
-	vtd = (struct Descriptor_vbi_teletext *)malloc( sizeof(*vtd) ) ;
+	vtd = (struct Descriptor_vbi_teletext *)bits_alloc(bits, sizeof(*vtd) ) ;
 	memset(vtd,0,sizeof(*vtd));
 
 	//== Parse data ==
@@ -93,7 +93,7 @@ int end_buff_len ;
 	end_buff_len = bits_len_calc(bits, -vtd->descriptor_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		struct VTD_entry *vtd_entry = malloc(sizeof(*vtd_entry));
+		struct VTD_entry *vtd_entry = bits_alloc(bits,sizeof(*vtd_entry));
 		memset(vtd_entry,0,sizeof(*vtd_entry));
 		list_add_tail(&vtd_entry->next,&vtd->vtd_array);
 
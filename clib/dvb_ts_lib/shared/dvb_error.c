@@ -20,8 +20,9 @@
 #include "dvb_error.h"
 
 // ERRORS
-enum DVB_error dvb_error_code = ERR_NONE ;
-int dvb_errno = 0 ;
+// (one copy per thread so that readers can be run in parallel threads)
+__thread enum DVB_error dvb_error_code = ERR_NONE ;
+__thread int dvb_errno = 0 ;
 
 static char *DVB_ERRORS[256] = {
 	[0 ... 255]	= "UNKNOWN",
@@ -48,6 +49,8 @@ static char *DVB_ERRORS[256] = {
 	[-ERR_FILE_SEEK]		= "file seek error",
 	[-ERR_FILE_NO_PKTS]		= "file no ts packets",
 	[-ERR_FILE_ZERO]		= "file zero length",
+	[-ERR_FILE_FORMAT]		= "file has invalid format",
+	[-ERR_FILE_NO_INDEX]	= "no index entry found",
 
 	[-ERR_TUNING_TIMEOUT]	= "frontend tuning timed out",
 	[-ERR_TUNING_TIMEOUT0]	= "frontend is not tuned (no timeout specified)",
@@ -78,7 +81,7 @@ static char *DVB_ERRORS[256] = {
 // convert error code into a message string
 char *dvb_error_str(enum DVB_error error)
 {
-static char error_str[256] ;
+static __thread char error_str[256] ;
 
 	// check range
 	if ((error > 0) || (error < ERR_MAX))
@@ -9,7 +9,7 @@
 #define DVB_ERROR_H_
 
 
-// Set the global error code
+// Set the global error code (each thread has its own copy)
 #define SET_DVB_ERROR(err)	\
 { \
 	dvb_error_code = (enum DVB_error)err ; \
@@ -98,6 +98,8 @@ enum DVB_error {
 	ERR_FILE_SEEK,
 	ERR_FILE_NO_PKTS,
 	ERR_FILE_ZERO,
+	ERR_FILE_FORMAT,
+	ERR_FILE_NO_INDEX,
 
 	ERR_EPG_POLL		= -ERR_GRP_EPG_START,
 
@@ -117,11 +119,11 @@ enum DVB_error {
 	ERR_NONE			= ERR_GRP_NONE,
 } ;
 
-// DVB-generated error code
-extern enum DVB_error dvb_error_code ;
+// DVB-generated error code (per thread)
+extern __thread enum DVB_error dvb_error_code ;
 
-// copy of errno
-extern int dvb_errno ;
+// copy of errno (per thread)
+extern __thread int dvb_errno ;
 
 char *dvb_error_str(enum DVB_error) ;
 void dvb_error_clear() ;
@@ -6,7 +6,7 @@
  */
 
 
-// VERSION = 1.01
+// VERSION = 1.02
 
 /*=============================================================================================*/
 // USES
@@ -22,6 +22,8 @@
 #include <inttypes.h>
 
 #include "parse_si.h"
+#include "ts_crc32.h"
+#include "tables/si_view.h"
 
 #include "tables/parse_si_pat.h"  /* 0x00 */
 #include "tables/parse_si_cat.h"  /* 0x01 */
@@ -76,6 +78,21 @@ unsigned SECTION_SYNTAX[SECTION_MAX+1] = {
 
 } ;
 
+// CRC length
+unsigned SECTION_CRC_LEN[SECTION_MAX+1] = {
+	[0 ... SECTION_MAX]							= SI_CRC_LEN,
+
+	// These don't have one
+	[SECTION_TDT]							 	= 0,
+	[SECTION_RST]							 	= 0,
+	[SECTION_ST]							 	= 0,
+	[SECTION_DIT]							 	= 0,
+} ;
+
+
+// Long form section header: table_id_extension, version/current_next, section_number, last_section_number
+#define SECTION_LONG_HEADER_LEN		5
+
 
 /*=============================================================================================*/
 // MACROS
@@ -91,6 +108,144 @@ static void dummy_handler(struct TS_reader *tsreader, struct TS_state *tsstate,
 
 }
 
+/* ----------------------------------------------------------------------- */
+// Pass the section bytes to the view handler (if there is one)
+static void section_view_call(struct TS_reader *tsreader, struct TS_state *tsstate, Section_view_handler view_handler,
+		uint8_t *section, unsigned section_len)
+{
+struct TS_section_view view ;
+
+	if (!view_handler)
+		return ;
+
+	view.pidinfo = tsstate->pidinfo ;
+	view.table_id = section[0] ;
+	view.section = section ;
+	view.section_len = section_len ;
+	if (si_view_valid(&view))
+		view_handler(tsreader, tsstate, &view, tsreader->user_data) ;
+}
+
+
+/* ----------------------------------------------------------------------- */
+static inline unsigned section_cache_hash(unsigned pid, unsigned table_id, unsigned table_id_extension, unsigned section_number)
+{
+	return ((pid * 31 + table_id) * 65599 + table_id_extension * 257 + section_number) & (TS_SECTION_CACHE_BUCKETS-1) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Find the cached copy of this (long form) section
+static struct TS_section_entry *section_cache_find(struct TS_section_cache *cache, unsigned pid, const uint8_t *section)
+{
+struct TS_section_entry *entry ;
+unsigned table_id = section[0] ;
+unsigned table_id_extension = (section[3] << 8) | section[4] ;
+unsigned section_number = section[6] ;
+
+	for (entry = cache->buckets[section_cache_hash(pid, table_id, table_id_extension, section_number)]; entry; entry = entry->next)
+	{
+		if ((entry->pid == pid) && (entry->table_id == table_id) &&
+			(entry->table_id_extension == table_id_extension) && (entry->section_number == section_number))
+			break ;
+	}
+
+	return entry ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Returns 1 if the section is the same version as the cached copy, and byte for byte identical
+static int section_cache_repeat(struct TS_section_entry *entry, const uint8_t *section, unsigned section_len)
+{
+	if (!entry)
+		return 0 ;
+
+	if ((entry->version_number != ((section[5] >> 1) & 0x1f)) || (entry->current_next_indicator != (section[5] & 0x01)))
+		return 0 ;
+
+	if (entry->data_len != section_len)
+		return 0 ;
+
+	return memcmp(entry->data, section, section_len) == 0 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Keep a copy of a CRC checked section, replacing the existing copy (if any). New sections are only added while the
+// cache holds less than max_bytes
+static void section_cache_store(struct TS_section_cache *cache, unsigned max_bytes, struct TS_section_entry *entry, unsigned pid,
+		const uint8_t *section, unsigned section_len)
+{
+unsigned bucket ;
+
+	if (!entry)
+	{
+		// once full, only the sections already cached are updated
+		if (cache->data_bytes + section_len > max_bytes)
+			return ;
+
+		entry = (struct TS_section_entry *)malloc(sizeof(*entry)) ;
+		if (!entry)
+			return ;
+		CLEAR_MEM(entry) ;
+
+		entry->pid = pid ;
+		entry->table_id = section[0] ;
+		entry->table_id_extension = (section[3] << 8) | section[4] ;
+		entry->section_number = section[6] ;
+
+		bucket = section_cache_hash(pid, entry->table_id, entry->table_id_extension, entry->section_number) ;
+		entry->next = cache->buckets[bucket] ;
+		cache->buckets[bucket] = entry ;
+		cache->num_entries++ ;
+	}
+
+	if (entry->data_len != section_len)
+	{
+		cache->data_bytes -= entry->data_len ;
+		free(entry->data) ;
+
+		// on failure the entry never matches, so the section is just checked every time
+		entry->data_len = 0 ;
+		entry->data = (uint8_t *)malloc(section_len) ;
+		if (!entry->data)
+			return ;
+
+		entry->data_len = section_len ;
+		cache->data_bytes += section_len ;
+	}
+
+	memcpy(entry->data, section, section_len) ;
+	entry->version_number = (section[5] >> 1) & 0x1f ;
+	entry->current_next_indicator = section[5] & 0x01 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Forget the cached sections for any table id that matches table_id under the mask (mask 0 = all tables)
+void section_cache_clear(struct TS_section_cache *cache, unsigned table_id, unsigned mask)
+{
+struct TS_section_entry **prev ;
+struct TS_section_entry *entry ;
+unsigned bucket ;
+
+	for (bucket=0; bucket < TS_SECTION_CACHE_BUCKETS; ++bucket)
+	{
+		prev = &cache->buckets[bucket] ;
+		while ((entry = *prev) != NULL)
+		{
+			if ((entry->table_id & mask) != (table_id & mask))
+			{
+				prev = &entry->next ;
+				continue ;
+			}
+
+			*prev = entry->next ;
+			cache->data_bytes -= entry->data_len ;
+			cache->num_entries-- ;
+			free(entry->data) ;
+			free(entry) ;
+		}
+	}
+}
+
 
 /* ----------------------------------------------------------------------- */
 void print_si(struct Section *section)
@@ -196,7 +351,12 @@ unsigned expected_syntax ;
 int ptr ;
 int payload_left = payload_len ;
 Section_handler handler = NULL ;
+Section_view_handler view_handler = NULL ;
 struct Section_decode_flags	flags ;
+struct Section_decode_flags	view_flags ;
+struct TS_section_entry *cached ;
+unsigned cache_section ;
+unsigned repeat ;
 
 	tsparse_dbg_prt(10, ("\n== parse_si() : PID 0x%02x : payload len %d [0x%02x] ==\n", tsstate->pid_item->pidinfo.pid, payload_left, payload[0]));
 
@@ -230,9 +390,9 @@ struct Section_decode_flags	flags ;
 
 			if (tsreader->error_hook)
 			{
-				SET_DVB_ERROR(ERR_SECTIONLEN) ;
+				SET_TSREADER_ERROR(tsreader, ERR_SECTIONLEN) ;
 				if (tsreader->error_hook)
-					tsreader->error_hook(dvb_error_code, &tsstate->pidinfo, tsreader->user_data) ;
+					tsreader->error_hook(tsreader->error_code, &tsstate->pidinfo, tsreader->user_data) ;
 			}
 
 			return 0 ;
@@ -275,9 +435,9 @@ struct Section_decode_flags	flags ;
 			tsstate->pidinfo.pid_error++ ;
 			if (tsreader->error_hook)
 			{
-				SET_DVB_ERROR(ERR_SECTIONLEN) ;
+				SET_TSREADER_ERROR(tsreader, ERR_SECTIONLEN) ;
 				if (tsreader->error_hook)
-					tsreader->error_hook(dvb_error_code, &tsstate->pidinfo, tsreader->user_data) ;
+					tsreader->error_hook(tsreader->error_code, &tsstate->pidinfo, tsreader->user_data) ;
 			}
 
 			return 0 ;
@@ -289,158 +449,223 @@ struct Section_decode_flags	flags ;
 
 			// get handler for this SI table - skip if none specified
 			handler = tsreader->section_decode_table[table_id].handler ;
+			view_handler = tsreader->section_decode_table[table_id].view_handler ;
 			flags = tsreader->section_decode_table[table_id].flags ;
+			view_flags = tsreader->section_decode_table[table_id].view_flags ;
 
 			// check section fits into remaining buffer
-			if ((section_len <= payload_left) && handler)
+			if ((section_len <= payload_left) && (handler || view_handler))
 			{
 				// check syntax
 				if ((expected_syntax != SYNTAX_EITHER) && (section_syntax != expected_syntax))
 				{
 					tsparse_dbg_prt(2, ("Invalid section syntax 0x%02x (expected 0x%02x)\n", section_syntax, expected_syntax)) ;
 
-					SET_DVB_ERROR(ERR_TSCORRUPT) ;
+					SET_TSREADER_ERROR(tsreader, ERR_TSCORRUPT) ;
 					if (tsreader->error_hook)
-						tsreader->error_hook(dvb_error_code, &tsstate->pidinfo, tsreader->user_data) ;
+						tsreader->error_hook(tsreader->error_code, &tsstate->pidinfo, tsreader->user_data) ;
 
 					//TODO: Return here!
 					//return 0 ;
 				}
 
-				// CRC covers whole packet from table_id to crc, need to extend length by section head
-				uint32_t crc = crc32 (&payload[ptr+1], section_len+SECTION_HEADER_LEN);
-				if (!crc)
+				// Long form sections are cached once their CRC has been checked (unless the reader has no cache). Another
+				// copy with the same bytes doesn't need checking again
+				cached = NULL ;
+				repeat = 0 ;
+				cache_section = tsreader->section_cache_bytes && section_syntax && (section_len >= SECTION_LONG_HEADER_LEN+SI_CRC_LEN) ;
+				if (cache_section)
 				{
-					tsparse_dbg_prt(100, ("**SI CRC PASS**\n")) ;
+					cached = section_cache_find(&tsstate->section_cache, tsstate->pidinfo.pid, &payload[ptr+1]) ;
+					repeat = section_cache_repeat(cached, &payload[ptr+1], section_len+SECTION_HEADER_LEN) ;
 				}
-				else
+
+				if (repeat)
 				{
-					tsparse_dbg_prt(2, ("!!SI CRC FAIL!! - SI skipped\n")) ;
-					return 0 ;
+					tsparse_dbg_prt(100, ("**SI unchanged**\n")) ;
+					tsstate->section_cache.repeats++ ;
+				}
+				else if (SECTION_CRC_LEN[table_id])
+				{
+					// CRC covers whole packet from table_id to crc, need to extend length by section head
+					uint32_t crc = ts_crc32(&payload[ptr+1], section_len+SECTION_HEADER_LEN);
+					if (!crc)
+					{
+						tsparse_dbg_prt(100, ("**SI CRC PASS**\n")) ;
+					}
+					else
+					{
+						tsparse_dbg_prt(2, ("!!SI CRC FAIL!! - SI skipped\n")) ;
+						return 0 ;
+					}
+					tsstate->section_cache.checked++ ;
+
+					// (stored before decoding as the handler may change the registrations)
+					if (cache_section)
+						section_cache_store(&tsstate->section_cache, tsreader->section_cache_bytes, cached, tsstate->pidinfo.pid,
+								&payload[ptr+1], section_len+SECTION_HEADER_LEN) ;
 				}
 
-				// ignore CRC in lower level decoding
-				struct TS_bits *bits = bits_new(&payload[ptr+1], section_len+SECTION_HEADER_LEN-SI_CRC_LEN) ;
-
+				// skip the decode if the handler only wants changes (and likewise the view)
+				if (repeat && flags.on_change)
+					handler = NULL ;
+				if (repeat && view_flags.on_change)
+					view_handler = NULL ;
 
-				switch(table_id)
+				if (!handler && !view_handler)
 				{
-
-					// PAT
-					case SECTION_PAT:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_pat(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// CAT
-					case SECTION_CAT:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_cat(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// PMT
-					case SECTION_PMT:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_pmt(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// NIT this
-					case SECTION_NIT_ACTUAL:
-					// NIT other
-					case SECTION_NIT_OTHER:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_nit(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// SDT this
-					case SECTION_SDT_ACTUAL:
-					// SDT other
-					case SECTION_SDT_OTHER:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_sdt(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// BAT
-					case SECTION_BAT:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_bat(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// Now/Next this
-					case SECTION_EIT_NOW_ACTUAL:
-					// Now/Next other
-					case SECTION_EIT_NOW_OTHER:
-					// EIT this
-					case SECTION_EIT_ACTUAL_START ... SECTION_EIT_ACTUAL_END:
-					// EIT other
-					case SECTION_EIT_OTHER_START ... SECTION_EIT_OTHER_END:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_eit(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// TDT
-					case SECTION_TDT:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_tdt(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// RST
-					case SECTION_RST:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_rst(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// ST
-					case SECTION_ST:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_st(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// TOT
-					case SECTION_TOT:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_tot(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// CIT
-					case SECTION_CIT:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_cit(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// DIT
-					case SECTION_DIT:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_dit(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-					// SIT
-					case SECTION_SIT:
-						if (tsreader->debug >= 103)
-							dump_buff(&payload[ptr+1], payload_left, section_len) ;
-						parse_sit(tsreader, tsstate, bits, handler, &flags) ;
-						break;
-
-
-					default:
-fprintf(stderr, "!! Unexpected Table 0x%02x !!\n", table_id) ;
-						break;
+					tsstate->section_cache.skipped++ ;
+				}
+				else if (!handler)
+				{
+					// nothing to decode
+					section_view_call(tsreader, tsstate, view_handler, &payload[ptr+1], section_len+SECTION_HEADER_LEN) ;
+				}
+				else
+				{
+					section_view_call(tsreader, tsstate, view_handler, &payload[ptr+1], section_len+SECTION_HEADER_LEN) ;
+
+					// ignore CRC in lower level decoding
+					struct TS_bits section_bits ;
+					struct TS_bits *bits = &section_bits ;
+					bits_init(bits, &payload[ptr+1], section_len+SECTION_HEADER_LEN-SECTION_CRC_LEN[table_id]) ;
+					bits->arena = &tsstate->si_arena ;
+
+
+					switch(table_id)
+					{
+
+						// PAT
+						case SECTION_PAT:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_pat(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// CAT
+						case SECTION_CAT:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_cat(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// PMT
+						case SECTION_PMT:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_pmt(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// NIT this
+						case SECTION_NIT_ACTUAL:
+						// NIT other
+						case SECTION_NIT_OTHER:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_nit(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// SDT this
+						case SECTION_SDT_ACTUAL:
+						// SDT other
+						case SECTION_SDT_OTHER:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_sdt(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// BAT
+						case SECTION_BAT:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_bat(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// Now/Next this
+						case SECTION_EIT_NOW_ACTUAL:
+						// Now/Next other
+						case SECTION_EIT_NOW_OTHER:
+						// EIT this
+						case SECTION_EIT_ACTUAL_START ... SECTION_EIT_ACTUAL_END:
+						// EIT other
+						case SECTION_EIT_OTHER_START ... SECTION_EIT_OTHER_END:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_eit(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// TDT
+						case SECTION_TDT:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_tdt(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// RST
+						case SECTION_RST:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_rst(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// ST
+						case SECTION_ST:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_st(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// TOT
+						case SECTION_TOT:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_tot(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// CIT
+						case SECTION_CIT:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_cit(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// DIT
+						case SECTION_DIT:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_dit(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+						// SIT
+						case SECTION_SIT:
+							if (tsreader->debug >= 103)
+								dump_buff(&payload[ptr+1], payload_left, section_len) ;
+							parse_sit(tsreader, tsstate, bits, handler, &flags) ;
+							break;
+
+
+						default:
+	fprintf(stderr, "!! Unexpected Table 0x%02x !!\n", table_id) ;
+							break;
+					}
+
+					// section too short for its contents (table not passed to the handler)
+					if (bits->error)
+					{
+						tsparse_dbg_prt(2, ("PSI pid 0x%x Table 0x%x : read past end of section\n", tsstate->pidinfo.pid, table_id)) ;
+
+						tsstate->pid_item->pesinfo.psi_error++ ;
+						tsstate->pidinfo.pid_error++ ;
+						if (tsreader->error_hook)
+						{
+							SET_TSREADER_ERROR(tsreader, ERR_SECTIONLEN) ;
+							tsreader->error_hook(tsreader->error_code, &tsstate->pidinfo, tsreader->user_data) ;
+						}
+					}
+
+					// free the decoded table (unless the handler detached it)
+					arena_reset(&tsstate->si_arena) ;
 				}
-
-				bits_free(&bits) ;
 			}
 		}
 
@@ -455,3 +680,600 @@ fprintf(stderr, "!! Unexpected Table 0x%02x !!\n", table_id) ;
 
 	return 0 ;
 }
+
+
+//============================================================================================
+// Test: decodes every SI table in the file with handlers registered for every copy, then only for changes, and checks
+// the number of handler calls against a count of the changes made independently from tsreader_next_section(), and
+// that a reader with no section cache decodes every copy. Then times both (the file is held in memory). Also checks that the last packet of a file is read, and that the section
+// or PES still buffered at the end of a file is passed on, that a TDT (no CRC) is passed to both kinds of handler
+// with all of its bytes, and that a view handler's flags don't change those of a section handler for the same tables.
+//
+//   parse_si [-n reps] file.ts
+//
+#ifdef TEST_MAIN
+
+#include <sys/time.h>
+#include <sys/stat.h>
+
+#include "ts_parse.h"
+
+#define TEST_MAX_KEYS		65536
+#define TEST_CHUNK			(64 * 1024)
+#define TEST_PAT_PROGRAMS	45
+#define TEST_PID_PAT		0x00
+#define TEST_PID_PES		0x100
+#define TEST_PID_TDT		0x14
+
+struct Section_test_key {
+	unsigned	pid ;
+	uint8_t		*section ;
+	unsigned	section_len ;
+};
+
+struct Section_test_tdt {
+	unsigned	calls ;
+	struct tm	UTC_time ;
+	unsigned	views ;
+	unsigned	view_len ;
+};
+
+//---------------------------------------------------------------------------------------------------------------------------
+static double test_time(void)
+{
+struct timeval tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1e6 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static int test_decoded_table(unsigned table_id)
+{
+	switch (table_id)
+	{
+	case SECTION_PAT:
+	case SECTION_CAT:
+	case SECTION_PMT:
+	case SECTION_NIT_ACTUAL:
+	case SECTION_NIT_OTHER:
+	case SECTION_SDT_ACTUAL:
+	case SECTION_SDT_OTHER:
+	case SECTION_BAT:
+	case SECTION_EIT_NOW_ACTUAL:
+	case SECTION_EIT_NOW_OTHER:
+	case SECTION_EIT_ACTUAL_START ... SECTION_EIT_OTHER_END:
+	case SECTION_TDT:
+	case SECTION_RST:
+	case SECTION_ST:
+	case SECTION_TOT:
+	case SECTION_CIT:
+	case SECTION_DIT:
+	case SECTION_SIT:
+		return 1 ;
+	}
+	return 0 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_handler(struct TS_reader *tsreader, struct TS_state *tsstate, struct Section *section, void *user_data)
+{
+	++*(unsigned *)user_data ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Count the sections, and how many of them are new or changed (sections without a version always count as changed)
+static void test_reference(char *filename, unsigned *sections, unsigned *changes)
+{
+struct TS_reader *tsreader ;
+struct TS_section_view view ;
+struct Section_test_key *keys ;
+struct Section_test_key *key ;
+unsigned num_keys = 0 ;
+unsigned i ;
+
+	*sections = 0 ;
+	*changes = 0 ;
+	keys = (struct Section_test_key *)calloc(TEST_MAX_KEYS, sizeof(*keys)) ;
+	tsreader = tsreader_new(filename) ;
+	if (!tsreader)
+		return ;
+
+	while (tsreader_next_section(tsreader, &view) == 1)
+	{
+		// (parse_si() checks the length and the CRC of every table that has one)
+		if (!test_decoded_table(view.table_id) || (view.section_len <= SECTION_HEADER_LEN+SI_CRC_LEN) ||
+			(view.section_len > SECTION_HEADER_LEN+SECTION_MAX_LENGTHS[view.table_id]) ||
+			(SECTION_CRC_LEN[view.table_id] && ts_crc32(view.section, view.section_len)))
+			continue ;
+
+		++*sections ;
+		if (!(view.section[1] & 0x80) || (view.section_len < SECTION_HEADER_LEN+SECTION_LONG_HEADER_LEN+SI_CRC_LEN))
+		{
+			++*changes ;
+			continue ;
+		}
+
+		// same pid, table_id, table_id_extension and section_number
+		for (i=0, key=NULL; i < num_keys; ++i)
+		{
+			if ((keys[i].pid == view.pidinfo.pid) && (keys[i].section[0] == view.section[0]) &&
+				(keys[i].section[3] == view.section[3]) && (keys[i].section[4] == view.section[4]) &&
+				(keys[i].section[6] == view.section[6]))
+			{
+				key = &keys[i] ;
+				break ;
+			}
+		}
+		if (key && (key->section_len == view.section_len) && !memcmp(key->section, view.section, view.section_len))
+			continue ;
+
+		++*changes ;
+		if (!key)
+		{
+			if (num_keys == TEST_MAX_KEYS)
+				continue ;
+			key = &keys[num_keys++] ;
+			key->pid = view.pidinfo.pid ;
+		}
+		free(key->section) ;
+		key->section = (uint8_t *)malloc(view.section_len) ;
+		memcpy(key->section, view.section, view.section_len) ;
+		key->section_len = view.section_len ;
+	}
+
+	tsreader_free(tsreader) ;
+	for (i=0; i < num_keys; ++i)
+		free(keys[i].section) ;
+	free(keys) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Run the data through a new reader with all tables registered, and a section cache of cache_bytes. Returns the number of
+// handler calls
+static unsigned test_parse(uint8_t *data, unsigned data_len, unsigned on_change, unsigned cache_bytes, struct TS_section_cache *stats)
+{
+struct TS_reader *tsreader ;
+struct Section_decode_flags flags = SECTION_DECODE_FLAGS_INIT ;
+unsigned calls = 0 ;
+unsigned table_id ;
+unsigned offset ;
+
+	flags.on_change = on_change ;
+	tsreader = tsreader_new_nofile() ;
+	tsreader->user_data = &calls ;
+	tsreader->section_cache_bytes = cache_bytes ;
+	for (table_id=0; table_id <= SECTION_MAX; ++table_id)
+	{
+		if (test_decoded_table(table_id))
+			tsreader_register_section(tsreader, table_id, 0xff, test_handler, flags) ;
+	}
+
+	tsreader_data_start(tsreader) ;
+	for (offset=0; offset < data_len; offset += TEST_CHUNK)
+		tsreader_data_add_shared(tsreader, &data[offset], (data_len - offset) < TEST_CHUNK ? (data_len - offset) : TEST_CHUNK) ;
+	tsreader_data_end(tsreader) ;
+
+	*stats = tsreader->tsstate->section_cache ;
+	tsreader_free(tsreader) ;
+
+	return calls ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_count_view_handler(struct TS_reader *tsreader, struct TS_state *tsstate, const struct TS_section_view *view, void *user_data)
+{
+	++((unsigned *)user_data)[1] ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Register a section handler for every copy (descriptors kept raw by an empty mask), then a view handler for changes
+// only, for the same tables. Checks the section handler's flags are unchanged and that each handler is called as its own flags say.
+// Returns the number of failures
+static unsigned test_view_flags(uint8_t *data, unsigned data_len, unsigned sections, unsigned changes)
+{
+struct TS_reader *tsreader ;
+struct Section_decode_flags every = SECTION_DECODE_FLAGS_INIT ;
+struct Section_decode_flags on_change = SECTION_DECODE_FLAGS_INIT ;
+unsigned calls[2] = { 0, 0 } ;
+unsigned flags_kept = 1 ;
+unsigned table_id ;
+unsigned offset ;
+unsigned failed = 0 ;
+
+	every.use_descriptor_mask = 1 ;
+	on_change.on_change = 1 ;
+	tsreader = tsreader_new_nofile() ;
+	tsreader->user_data = calls ;
+	for (table_id=0; table_id <= SECTION_MAX; ++table_id)
+	{
+		if (!test_decoded_table(table_id))
+			continue ;
+
+		tsreader_register_section(tsreader, table_id, 0xff, test_handler, every) ;
+		tsreader_register_section_view(tsreader, table_id, 0xff, test_count_view_handler, on_change) ;
+		if (!tsreader->section_decode_table[table_id].flags.use_descriptor_mask || tsreader->section_decode_table[table_id].flags.on_change)
+			flags_kept = 0 ;
+	}
+
+	tsreader_data_start(tsreader) ;
+	for (offset=0; offset < data_len; offset += TEST_CHUNK)
+		tsreader_data_add_shared(tsreader, &data[offset], (data_len - offset) < TEST_CHUNK ? (data_len - offset) : TEST_CHUNK) ;
+	tsreader_data_end(tsreader) ;
+	tsreader_free(tsreader) ;
+
+	printf("both      : %u calls (expected %u), %u views (expected %u), section handler flags %s\n",
+			calls[0], sections, calls[1], changes, flags_kept ? "kept" : "changed") ;
+	if ((calls[0] != sections) || (calls[1] != changes) || !flags_kept)
+		++failed ;
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_ts_hook(struct TS_pidinfo *pidinfo, uint8_t *packet, unsigned packet_len, void *user_data)
+{
+	++*(unsigned *)user_data ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_pes_hook(struct TS_pidinfo *pidinfo, struct TS_pesinfo *pesinfo, uint8_t *pes, unsigned pes_len, void *user_data)
+{
+	if ((pidinfo->pid == TEST_PID_PES) && (pes_len == TS_PACKET_LEN - 4))
+		++*(unsigned *)user_data ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Write the PES or section (after a pointer_field) to a new file (name made from the template) as packets on the pid :
+// payload_unit_start in the first packet, stuffing after the data in the last. Returns 0 on success
+static int test_unit_file(char *filename, unsigned pid, const uint8_t *unit, unsigned unit_len, unsigned is_section)
+{
+uint8_t packet[TS_PACKET_LEN] ;
+unsigned offset = 0 ;
+unsigned start ;
+unsigned len ;
+unsigned cc = 0 ;
+int fd ;
+
+	fd = mkstemp(filename) ;
+	if (fd < 0)
+		return -1 ;
+
+	while (offset < unit_len)
+	{
+		memset(packet, 0xff, sizeof(packet)) ;
+		packet[0] = SYNC_BYTE ;
+		packet[1] = (offset ? 0x00 : 0x40) | ((pid >> 8) & 0x1f) ;
+		packet[2] = pid & 0xff ;
+		packet[3] = 0x10 | (cc++ & 0xf) ;
+		start = 4 ;
+		if (!offset && is_section)
+			packet[start++] = 0 ;
+
+		len = unit_len - offset ;
+		if (len > TS_PACKET_LEN - start)
+			len = TS_PACKET_LEN - start ;
+		memcpy(&packet[start], &unit[offset], len) ;
+		offset += len ;
+
+		if (write(fd, packet, sizeof(packet)) != sizeof(packet))
+		{
+			close(fd) ;
+			unlink(filename) ;
+			return -1 ;
+		}
+	}
+	close(fd) ;
+
+	return 0 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Fill in a PAT with enough programs to need a second packet. Returns the section length
+static unsigned test_pat(uint8_t *section)
+{
+unsigned section_len = SECTION_HEADER_LEN + SECTION_LONG_HEADER_LEN + 4*TEST_PAT_PROGRAMS + SI_CRC_LEN ;
+unsigned i ;
+uint32_t crc ;
+
+	section[0] = SECTION_PAT ;
+	section[1] = 0xb0 | ((section_len - SECTION_HEADER_LEN) >> 8) ;
+	section[2] = (section_len - SECTION_HEADER_LEN) & 0xff ;
+	section[3] = 0x12 ;
+	section[4] = 0x34 ;
+	section[5] = 0xc1 ;
+	section[6] = 0 ;
+	section[7] = 0 ;
+	for (i=0; i < TEST_PAT_PROGRAMS; ++i)
+	{
+		section[8 + 4*i] = 0 ;
+		section[9 + 4*i] = i + 1 ;
+		section[10 + 4*i] = 0xe0 | ((0x100 + i) >> 8) ;
+		section[11 + 4*i] = (0x100 + i) & 0xff ;
+	}
+	crc = ts_crc32(section, section_len - SI_CRC_LEN) ;
+	for (i=0; i < SI_CRC_LEN; ++i)
+		section[section_len - SI_CRC_LEN + i] = (crc >> (24 - 8*i)) & 0xff ;
+
+	return section_len ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Fill in a video PES (no PTS) that exactly fills a packet. Returns the PES length
+static unsigned test_pes(uint8_t *pes)
+{
+unsigned pes_len = TS_PACKET_LEN - 4 ;
+unsigned i ;
+
+	pes[0] = 0x00 ;
+	pes[1] = 0x00 ;
+	pes[2] = 0x01 ;
+	pes[3] = 0xe0 ;
+	pes[4] = (pes_len - 6) >> 8 ;
+	pes[5] = (pes_len - 6) & 0xff ;
+	pes[6] = 0x80 ;
+	pes[7] = 0x00 ;
+	pes[8] = 0 ;
+	for (i=9; i < pes_len; ++i)
+		pes[i] = i & 0xff ;
+
+	return pes_len ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Write a file of 2 packets holding a PAT that is completed by the last packet and a file of 1 packet holding a
+// complete PES, then check that both packets are read and that the section/PES (nothing follows either of them on its
+// pid) is passed to the section handler/pes_hook and returned by tsreader_next_section()/tsreader_next_pes(). Returns
+// the number of failures
+static unsigned test_last_packet(void)
+{
+char pat_filename[] = "/tmp/parse_si_XXXXXX" ;
+char pes_filename[] = "/tmp/parse_si_XXXXXX" ;
+uint8_t section[SECTION_HEADER_LEN + SECTION_LONG_HEADER_LEN + 4*TEST_PAT_PROGRAMS + SI_CRC_LEN] ;
+uint8_t pes[TS_PACKET_LEN - 4] ;
+struct TS_reader *tsreader ;
+struct TS_section_view section_view ;
+struct TS_pes_view pes_view ;
+struct Section_decode_flags flags = SECTION_DECODE_FLAGS_INIT ;
+unsigned section_len ;
+unsigned pes_len ;
+uint64_t total_pkts = 0 ;
+unsigned pkts = 0 ;
+unsigned hook_sections = 0 ;
+unsigned hook_pes = 0 ;
+unsigned iter_sections = 0 ;
+unsigned iter_pes = 0 ;
+unsigned failed = 0 ;
+
+	section_len = test_pat(section) ;
+	pes_len = test_pes(pes) ;
+	if (test_unit_file(pat_filename, TEST_PID_PAT, section, section_len, 1))
+	{
+		printf("last packet : unable to write %s\n", pat_filename) ;
+		return 1 ;
+	}
+	if (test_unit_file(pes_filename, TEST_PID_PES, pes, pes_len, 0))
+	{
+		printf("last packet : unable to write %s\n", pes_filename) ;
+		unlink(pat_filename) ;
+		return 1 ;
+	}
+
+	// packets
+	tsreader = tsreader_new(pat_filename) ;
+	if (tsreader)
+	{
+		total_pkts = tsreader->tsstate->total_pkts ;
+		tsreader->ts_hook = test_ts_hook ;
+		tsreader->user_data = &pkts ;
+		ts_parse(tsreader) ;
+		tsreader_free(tsreader) ;
+	}
+
+	// push
+	tsreader = tsreader_new(pat_filename) ;
+	if (tsreader)
+	{
+		tsreader_register_section(tsreader, SECTION_PAT, 0xff, test_handler, flags) ;
+		tsreader->user_data = &hook_sections ;
+		ts_parse(tsreader) ;
+		tsreader_free(tsreader) ;
+	}
+
+	tsreader = tsreader_new(pes_filename) ;
+	if (tsreader)
+	{
+		tsreader->pes_hook = test_pes_hook ;
+		tsreader->user_data = &hook_pes ;
+		ts_parse(tsreader) ;
+		tsreader_free(tsreader) ;
+	}
+
+	// pull
+	tsreader = tsreader_new(pat_filename) ;
+	while (tsreader && (tsreader_next_section(tsreader, &section_view) == 1))
+	{
+		if ((section_view.table_id == SECTION_PAT) && (section_view.section_len == section_len) &&
+				!memcmp(section_view.section, section, section_len))
+			++iter_sections ;
+	}
+	tsreader_free(tsreader) ;
+
+	tsreader = tsreader_new(pes_filename) ;
+	while (tsreader && (tsreader_next_pes(tsreader, &pes_view) == 1))
+	{
+		if ((pes_view.pidinfo.pid == TEST_PID_PES) && (pes_view.pes_len == pes_len) && !memcmp(pes_view.pes, pes, pes_len))
+			++iter_pes ;
+	}
+	tsreader_free(tsreader) ;
+
+	unlink(pat_filename) ;
+	unlink(pes_filename) ;
+
+	printf("last packet : %"PRIu64" packets in file, %u read (expected 2)\n", total_pkts, pkts) ;
+	printf("last packet : %u sections to the handler, %u PES to the pes_hook (expected 1)\n", hook_sections, hook_pes) ;
+	printf("last packet : %u sections from tsreader_next_section(), %u PES from tsreader_next_pes() (expected 1)\n",
+			iter_sections, iter_pes) ;
+	if ((total_pkts != 2) || (pkts != 2))
+		++failed ;
+	if ((hook_sections != 1) || (hook_pes != 1))
+		++failed ;
+	if ((iter_sections != 1) || (iter_pes != 1))
+		++failed ;
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_tdt_handler(struct TS_reader *tsreader, struct TS_state *tsstate, struct Section *section, void *user_data)
+{
+struct Section_test_tdt *test = (struct Section_test_tdt *)user_data ;
+struct Section_time_date *tdt = (struct Section_time_date *)section ;
+
+	++test->calls ;
+	test->UTC_time = tdt->UTC_time ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_tdt_view_handler(struct TS_reader *tsreader, struct TS_state *tsstate, const struct TS_section_view *view, void *user_data)
+{
+struct Section_test_tdt *test = (struct Section_test_tdt *)user_data ;
+
+	++test->views ;
+	test->view_len = view->section_len ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Write a file holding a TDT (which has no CRC) and check that it reaches both a section handler and a view handler,
+// and that all 5 bytes of UTC_time are decoded. Returns the number of failures
+static unsigned test_tdt(void)
+{
+char filename[] = "/tmp/parse_si_XXXXXX" ;
+// 1993-10-13 12:45:00 (the example in EN 300 468 annex C)
+const uint8_t section[] = { SECTION_TDT, 0x70, 0x05, 0xc0, 0x79, 0x12, 0x45, 0x00 } ;
+struct TS_reader *tsreader ;
+struct Section_decode_flags flags = SECTION_DECODE_FLAGS_INIT ;
+struct Section_test_tdt test ;
+unsigned failed = 0 ;
+
+	if (test_unit_file(filename, TEST_PID_TDT, section, sizeof(section), 1))
+	{
+		printf("TDT : unable to write %s\n", filename) ;
+		return 1 ;
+	}
+
+	memset(&test, 0, sizeof(test)) ;
+	tsreader = tsreader_new(filename) ;
+	if (tsreader)
+	{
+		tsreader->user_data = &test ;
+		tsreader_register_section(tsreader, SECTION_TDT, 0xff, test_tdt_handler, flags) ;
+		tsreader_register_section_view(tsreader, SECTION_TDT, 0xff, test_tdt_view_handler, flags) ;
+		ts_parse(tsreader) ;
+		tsreader_free(tsreader) ;
+	}
+	unlink(filename) ;
+
+	printf("TDT : %u calls %04d-%02d-%02d %02d:%02d:%02d, %u views of %u bytes (expected 1 call 1993-10-13 12:45:00, 1 view of %u bytes)\n",
+		test.calls, test.UTC_time.tm_year, test.UTC_time.tm_mon, test.UTC_time.tm_mday,
+		test.UTC_time.tm_hour, test.UTC_time.tm_min, test.UTC_time.tm_sec,
+		test.views, test.view_len, (unsigned)sizeof(section)) ;
+	if ((test.calls != 1) || (test.UTC_time.tm_year != 1993) || (test.UTC_time.tm_mon != 10) || (test.UTC_time.tm_mday != 13) ||
+		(test.UTC_time.tm_hour != 12) || (test.UTC_time.tm_min != 45) || (test.UTC_time.tm_sec != 0))
+		++failed ;
+	if ((test.views != 1) || (test.view_len != sizeof(section)))
+		++failed ;
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct TS_section_cache stats ;
+struct stat file_stat ;
+uint8_t *data ;
+unsigned data_len ;
+unsigned sections, changes ;
+unsigned every_calls, change_calls ;
+unsigned reps = 20 ;
+unsigned rep ;
+unsigned failed = 0 ;
+double start, every_time, change_time ;
+FILE *file ;
+int c ;
+
+	while ((c = getopt (argc, argv, "n:")) != -1)
+	{
+		switch (c)
+		{
+		case 'n':
+			reps = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	if (optind >= argc)
+	{
+		printf("Usage: parse_si [-n reps] file.ts\n") ;
+		return 1 ;
+	}
+
+	// read the file into memory (whole packets)
+	if (stat(argv[optind], &file_stat) || !(file = fopen(argv[optind], "rb")))
+	{
+		printf("FAIL : unable to read %s\n", argv[optind]) ;
+		return 1 ;
+	}
+	data_len = (unsigned)(file_stat.st_size - (file_stat.st_size % TS_PACKET_LEN)) ;
+	data = (uint8_t *)malloc(data_len) ;
+	data_len = fread(data, 1, data_len, file) ;
+	fclose(file) ;
+
+	test_reference(argv[optind], &sections, &changes) ;
+
+	every_calls = test_parse(data, data_len, 0, TS_SECTION_CACHE_BYTES, &stats) ;
+	printf("every     : %u calls (expected %u) : %"PRIu64" sections checked, %"PRIu64" repeats\n", every_calls, sections, stats.checked, stats.repeats) ;
+	if (every_calls != sections)
+		++failed ;
+
+	change_calls = test_parse(data, data_len, 1, TS_SECTION_CACHE_BYTES, &stats) ;
+	printf("on change : %u calls (expected %u) : %"PRIu64" sections checked, %"PRIu64" repeats not decoded\n", change_calls, changes, stats.checked, stats.skipped) ;
+	if (change_calls != changes)
+		++failed ;
+
+	// without a cache nothing is held, and every copy is checked and decoded as if it were a change
+	change_calls = test_parse(data, data_len, 1, 0, &stats) ;
+	printf("no cache  : %u calls (expected %u) : %u sections held, %"PRIu64" repeats\n", change_calls, sections, stats.num_entries, stats.repeats) ;
+	if ((change_calls != sections) || stats.num_entries || stats.data_bytes || stats.repeats)
+		++failed ;
+
+	failed += test_view_flags(data, data_len, sections, changes) ;
+
+	// times
+	start = test_time() ;
+	for (rep=0; rep < reps; ++rep)
+		test_parse(data, data_len, 0, TS_SECTION_CACHE_BYTES, &stats) ;
+	every_time = test_time() - start ;
+
+	start = test_time() ;
+	for (rep=0; rep < reps; ++rep)
+		test_parse(data, data_len, 1, TS_SECTION_CACHE_BYTES, &stats) ;
+	change_time = test_time() - start ;
+
+	printf("time : every %.3f s, on change %.3f s (%u reps of %u bytes)\n", every_time, change_time, reps, data_len) ;
+
+	failed += test_last_packet() ;
+	failed += test_tdt() ;
+
+	free(data) ;
+	printf("%s\n", failed ? "FAIL" : "PASS") ;
+
+	return failed ? 1 : 0 ;
+}
+
+#endif
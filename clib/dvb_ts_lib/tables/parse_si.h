@@ -36,6 +36,7 @@ extern unsigned SECTION_MAX_LENGTHS[] ;
 
 /* ----------------------------------------------------------------------- */
 int parse_si(struct TS_reader *tsreader, struct TS_state *tsstate, uint8_t *payload, unsigned payload_len) ;
+void section_cache_clear(struct TS_section_cache *cache, unsigned table_id, unsigned mask) ;
 
 
 #endif /* PARSE_SI_H_ */
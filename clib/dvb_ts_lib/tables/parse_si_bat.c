@@ -113,44 +113,46 @@ int end_buff_len ;
 void parse_bat(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_bouquet_association bat ;
+struct Section_bouquet_association *bat ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	bat = (struct Section_bouquet_association *)bits_alloc(bits, sizeof(*bat)) ;
+	memset(bat,0,sizeof(*bat));
 
-	bat.table_id = bits_get(bits, 8) ;
-	bat.section_syntax_indicator = bits_get(bits, 1) ;
+	bat->table_id = bits_get(bits, 8) ;
+	bat->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	bat.section_length = bits_get(bits, 12) ;
-	bat.bouquet_id = bits_get(bits, 16) ;
+	bat->section_length = bits_get(bits, 12) ;
+	bat->bouquet_id = bits_get(bits, 16) ;
 	bits_skip(bits, 2) ;
-	bat.version_number = bits_get(bits, 5) ;
-	bat.current_next_indicator = bits_get(bits, 1) ;
-	bat.section_number = bits_get(bits, 8) ;
-	bat.last_section_number = bits_get(bits, 8) ;
+	bat->version_number = bits_get(bits, 5) ;
+	bat->current_next_indicator = bits_get(bits, 1) ;
+	bat->section_number = bits_get(bits, 8) ;
+	bat->last_section_number = bits_get(bits, 8) ;
 	bits_skip(bits, 4) ;
-	bat.bouquet_descriptors_length = bits_get(bits, 12) ;
+	bat->bouquet_descriptors_length = bits_get(bits, 12) ;
 
 	// Descriptors
-	INIT_LIST_HEAD(&bat.bouquet_array);
-	end_buff_len = bits_len_calc(bits, -bat.bouquet_descriptors_length ) ;
+	INIT_LIST_HEAD(&bat->bouquet_array);
+	end_buff_len = bits_len_calc(bits, -bat->bouquet_descriptors_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		enum TS_descriptor_ids desc_tag = parse_desc(&bat.bouquet_array, bits, flags->decode_descriptor) ;
+		enum TS_descriptor_ids desc_tag = parse_desc(&bat->bouquet_array, bits, flags) ;
 	}
 
 	bits_skip(bits, 4) ;
-	bat.transport_stream_loop_length = bits_get(bits, 12) ;
+	bat->transport_stream_loop_length = bits_get(bits, 12) ;
 	
-	INIT_LIST_HEAD(&bat.bat_array) ;
+	INIT_LIST_HEAD(&bat->bat_array) ;
 	while (bits->buff_len >= 6)
 	{
-		struct BAT_entry *bat_entry = malloc(sizeof(*bat_entry));
+		struct BAT_entry *bat_entry = bits_alloc(bits,sizeof(*bat_entry));
 		memset(bat_entry,0,sizeof(*bat_entry));
-		list_add_tail(&bat_entry->next,&bat.bat_array);
+		list_add_tail(&bat_entry->next,&bat->bat_array);
 
 		bat_entry->transport_stream_id = bits_get(bits, 16) ;
 		bat_entry->original_network_id = bits_get(bits, 16) ;
@@ -162,23 +164,28 @@ int end_buff_len ;
 		end_buff_len = bits_len_calc(bits, -bat_entry->transport_descriptors_length ) ;
 		while (bits->buff_len > end_buff_len)
 		{
-			enum TS_descriptor_ids desc_tag = parse_desc(&bat_entry->transport_array, bits, flags->decode_descriptor) ;
+			enum TS_descriptor_ids desc_tag = parse_desc(&bat_entry->transport_array, bits, flags) ;
 		}
 
 	}
 	
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&bat, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)bat, tsreader->user_data) ;
 
 	//== Tidy up ==
-	free_descriptors_list(&bat.bouquet_array);
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	free_descriptors_list(&bat->bouquet_array);
 	
-	list_for_each_safe(item,safe,&bat.bat_array) {
+	list_for_each_safe(item,safe,&bat->bat_array) {
 		struct BAT_entry *bat_entry = list_entry(item, struct BAT_entry, next);
 		free_descriptors_list(&bat_entry->transport_array);
 		free(bat_entry) ;
 	}
-	
+
+	free(bat) ;
 }
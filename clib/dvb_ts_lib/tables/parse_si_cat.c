@@ -81,37 +81,45 @@ int end_buff_len ;
 void parse_cat(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_conditional_access cat ;
+struct Section_conditional_access *cat ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	cat = (struct Section_conditional_access *)bits_alloc(bits, sizeof(*cat)) ;
+	memset(cat,0,sizeof(*cat));
 
-	cat.table_id = bits_get(bits, 8) ;
-	cat.section_syntax_indicator = bits_get(bits, 1) ;
+	cat->table_id = bits_get(bits, 8) ;
+	cat->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	cat.section_length = bits_get(bits, 12) ;
+	cat->section_length = bits_get(bits, 12) ;
 	bits_skip(bits, 18) ;
-	cat.version_number = bits_get(bits, 5) ;
-	cat.current_next_indicator = bits_get(bits, 1) ;
-	cat.section_number = bits_get(bits, 8) ;
-	cat.last_section_number = bits_get(bits, 8) ;
+	cat->version_number = bits_get(bits, 5) ;
+	cat->current_next_indicator = bits_get(bits, 1) ;
+	cat->section_number = bits_get(bits, 8) ;
+	cat->last_section_number = bits_get(bits, 8) ;
 
 	// Descriptors
-	INIT_LIST_HEAD(&cat.descriptors_array);
-	end_buff_len = bits_len_calc(bits, -cat.section_length ) ;
+	INIT_LIST_HEAD(&cat->descriptors_array);
+	end_buff_len = bits_len_calc(bits, -cat->section_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		enum TS_descriptor_ids desc_tag = parse_desc(&cat.descriptors_array, bits, flags->decode_descriptor) ;
+		enum TS_descriptor_ids desc_tag = parse_desc(&cat->descriptors_array, bits, flags) ;
 	}
 
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&cat, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)cat, tsreader->user_data) ;
 
 	//== Tidy up ==
-	free_descriptors_list(&cat.descriptors_array);
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	free_descriptors_list(&cat->descriptors_array);
+
+	free(cat) ;
 }
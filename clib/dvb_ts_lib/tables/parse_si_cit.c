@@ -109,43 +109,45 @@ int end_buff_len ;
 void parse_cit(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_content_identifier cit ;
+struct Section_content_identifier *cit ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	cit = (struct Section_content_identifier *)bits_alloc(bits, sizeof(*cit)) ;
+	memset(cit,0,sizeof(*cit));
 
-	cit.table_id = bits_get(bits, 8) ;
-	cit.section_syntax_indicator = bits_get(bits, 1) ;
-	cit.private_indicator = bits_get(bits, 1) ;
+	cit->table_id = bits_get(bits, 8) ;
+	cit->section_syntax_indicator = bits_get(bits, 1) ;
+	cit->private_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 2) ;
-	cit.section_length = bits_get(bits, 12) ;
-	cit.service_id = bits_get(bits, 16) ;
+	cit->section_length = bits_get(bits, 12) ;
+	cit->service_id = bits_get(bits, 16) ;
 	bits_skip(bits, 2) ;
-	cit.version_number = bits_get(bits, 5) ;
-	cit.current_next_indicator = bits_get(bits, 1) ;
-	cit.section_number = bits_get(bits, 8) ;
-	cit.last_section_number = bits_get(bits, 8) ;
-	cit.transport_stream_id = bits_get(bits, 16) ;
-	cit.original_network_id = bits_get(bits, 16) ;
-	cit.prepend_strings_length = bits_get(bits, 8) ;
-
-	end_buff_len = bits_len_calc(bits, -cit.prepend_strings_length) ;
-	cit.prepend_strings[0] = 0 ;
+	cit->version_number = bits_get(bits, 5) ;
+	cit->current_next_indicator = bits_get(bits, 1) ;
+	cit->section_number = bits_get(bits, 8) ;
+	cit->last_section_number = bits_get(bits, 8) ;
+	cit->transport_stream_id = bits_get(bits, 16) ;
+	cit->original_network_id = bits_get(bits, 16) ;
+	cit->prepend_strings_length = bits_get(bits, 8) ;
+
+	end_buff_len = bits_len_calc(bits, -cit->prepend_strings_length) ;
+	cit->prepend_strings[0] = 0 ;
 	for (byte=0; (bits->buff_len > end_buff_len) && (byte < MAX_PREPEND_STRINGS_LEN); ++byte)
 	{
-		cit.prepend_strings[byte] = bits_get(bits, 8) ;
-		cit.prepend_strings[byte+1] = 0 ;
+		cit->prepend_strings[byte] = bits_get(bits, 8) ;
+		cit->prepend_strings[byte+1] = 0 ;
 	}
 
 	
-	INIT_LIST_HEAD(&cit.cit_array) ;
+	INIT_LIST_HEAD(&cit->cit_array) ;
 	while (bits->buff_len >= 4)
 	{
-		struct CIT_entry *cit_entry = malloc(sizeof(*cit_entry));
+		struct CIT_entry *cit_entry = bits_alloc(bits,sizeof(*cit_entry));
 		memset(cit_entry,0,sizeof(*cit_entry));
-		list_add_tail(&cit_entry->next,&cit.cit_array);
+		list_add_tail(&cit_entry->next,&cit->cit_array);
 
 		cit_entry->crid_ref = bits_get(bits, 16) ;
 		cit_entry->prepend_string_index = bits_get(bits, 8) ;
@@ -163,14 +165,18 @@ int end_buff_len ;
 	
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&cit, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)cit, tsreader->user_data) ;
 
 	//== Tidy up ==
-	
-	list_for_each_safe(item,safe,&cit.cit_array) {
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	list_for_each_safe(item,safe,&cit->cit_array) {
 		struct CIT_entry *cit_entry = list_entry(item, struct CIT_entry, next);
 		free(cit_entry) ;
 	}
-	
+
+	free(cit) ;
 }
@@ -68,24 +68,31 @@ int end_buff_len ;
 void parse_dit(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_discontinuity_information dit ;
+struct Section_discontinuity_information *dit ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	dit = (struct Section_discontinuity_information *)bits_alloc(bits, sizeof(*dit)) ;
+	memset(dit,0,sizeof(*dit));
 
-	dit.table_id = bits_get(bits, 8) ;
-	dit.section_syntax_indicator = bits_get(bits, 1) ;
+	dit->table_id = bits_get(bits, 8) ;
+	dit->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	dit.section_length = bits_get(bits, 12) ;
-	dit.transition_flag = bits_get(bits, 1) ;
+	dit->section_length = bits_get(bits, 12) ;
+	dit->transition_flag = bits_get(bits, 1) ;
 	bits_skip(bits, 7) ;
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&dit, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)dit, tsreader->user_data) ;
 
 	//== Tidy up ==
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	free(dit) ;
 }
@@ -117,35 +117,37 @@ int end_buff_len ;
 void parse_eit(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_event_information eit ;
+struct Section_event_information *eit ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	eit = (struct Section_event_information *)bits_alloc(bits, sizeof(*eit)) ;
+	memset(eit,0,sizeof(*eit));
 
-	eit.table_id = bits_get(bits, 8) ;
-	eit.section_syntax_indicator = bits_get(bits, 1) ;
+	eit->table_id = bits_get(bits, 8) ;
+	eit->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	eit.section_length = bits_get(bits, 12) ;
-	eit.service_id = bits_get(bits, 16) ;
+	eit->section_length = bits_get(bits, 12) ;
+	eit->service_id = bits_get(bits, 16) ;
 	bits_skip(bits, 2) ;
-	eit.version_number = bits_get(bits, 5) ;
-	eit.current_next_indicator = bits_get(bits, 1) ;
-	eit.section_number = bits_get(bits, 8) ;
-	eit.last_section_number = bits_get(bits, 8) ;
-	eit.transport_stream_id = bits_get(bits, 16) ;
-	eit.original_network_id = bits_get(bits, 16) ;
-	eit.segment_last_section_number = bits_get(bits, 8) ;
-	eit.last_table_id = bits_get(bits, 8) ;
+	eit->version_number = bits_get(bits, 5) ;
+	eit->current_next_indicator = bits_get(bits, 1) ;
+	eit->section_number = bits_get(bits, 8) ;
+	eit->last_section_number = bits_get(bits, 8) ;
+	eit->transport_stream_id = bits_get(bits, 16) ;
+	eit->original_network_id = bits_get(bits, 16) ;
+	eit->segment_last_section_number = bits_get(bits, 8) ;
+	eit->last_table_id = bits_get(bits, 8) ;
 	
-	INIT_LIST_HEAD(&eit.eit_array) ;
+	INIT_LIST_HEAD(&eit->eit_array) ;
 	while (bits->buff_len >= 12)
 	{
-		struct EIT_entry *eit_entry = malloc(sizeof(*eit_entry));
+		struct EIT_entry *eit_entry = bits_alloc(bits,sizeof(*eit_entry));
 		memset(eit_entry,0,sizeof(*eit_entry));
-		list_add_tail(&eit_entry->next,&eit.eit_array);
+		list_add_tail(&eit_entry->next,&eit->eit_array);
 
 		eit_entry->event_id = bits_get(bits, 16) ;
 		eit_entry->start_time = bits_get_mjd_time(bits) ;
@@ -159,22 +161,26 @@ int end_buff_len ;
 		end_buff_len = bits_len_calc(bits, -eit_entry->descriptors_loop_length ) ;
 		while (bits->buff_len > end_buff_len)
 		{
-			enum TS_descriptor_ids desc_tag = parse_desc(&eit_entry->descriptors_array, bits, flags->decode_descriptor) ;
+			enum TS_descriptor_ids desc_tag = parse_desc(&eit_entry->descriptors_array, bits, flags) ;
 		}
 
 	}
 	
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&eit, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)eit, tsreader->user_data) ;
 
 	//== Tidy up ==
-	
-	list_for_each_safe(item,safe,&eit.eit_array) {
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	list_for_each_safe(item,safe,&eit->eit_array) {
 		struct EIT_entry *eit_entry = list_entry(item, struct EIT_entry, next);
 		free_descriptors_list(&eit_entry->descriptors_array);
 		free(eit_entry) ;
 	}
-	
+
+	free(eit) ;
 }
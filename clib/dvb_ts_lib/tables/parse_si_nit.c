@@ -113,44 +113,46 @@ int end_buff_len ;
 void parse_nit(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_network_information nit ;
+struct Section_network_information *nit ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	nit = (struct Section_network_information *)bits_alloc(bits, sizeof(*nit)) ;
+	memset(nit,0,sizeof(*nit));
 
-	nit.table_id = bits_get(bits, 8) ;
-	nit.section_syntax_indicator = bits_get(bits, 1) ;
+	nit->table_id = bits_get(bits, 8) ;
+	nit->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	nit.section_length = bits_get(bits, 12) ;
-	nit.network_id = bits_get(bits, 16) ;
+	nit->section_length = bits_get(bits, 12) ;
+	nit->network_id = bits_get(bits, 16) ;
 	bits_skip(bits, 2) ;
-	nit.version_number = bits_get(bits, 5) ;
-	nit.current_next_indicator = bits_get(bits, 1) ;
-	nit.section_number = bits_get(bits, 8) ;
-	nit.last_section_number = bits_get(bits, 8) ;
+	nit->version_number = bits_get(bits, 5) ;
+	nit->current_next_indicator = bits_get(bits, 1) ;
+	nit->section_number = bits_get(bits, 8) ;
+	nit->last_section_number = bits_get(bits, 8) ;
 	bits_skip(bits, 4) ;
-	nit.network_descriptors_length = bits_get(bits, 12) ;
+	nit->network_descriptors_length = bits_get(bits, 12) ;
 
 	// Descriptors
-	INIT_LIST_HEAD(&nit.network_array);
-	end_buff_len = bits_len_calc(bits, -nit.network_descriptors_length ) ;
+	INIT_LIST_HEAD(&nit->network_array);
+	end_buff_len = bits_len_calc(bits, -nit->network_descriptors_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		enum TS_descriptor_ids desc_tag = parse_desc(&nit.network_array, bits, flags->decode_descriptor) ;
+		enum TS_descriptor_ids desc_tag = parse_desc(&nit->network_array, bits, flags) ;
 	}
 
 	bits_skip(bits, 4) ;
-	nit.transport_stream_loop_length = bits_get(bits, 12) ;
+	nit->transport_stream_loop_length = bits_get(bits, 12) ;
 	
-	INIT_LIST_HEAD(&nit.nit_array) ;
+	INIT_LIST_HEAD(&nit->nit_array) ;
 	while (bits->buff_len >= 6)
 	{
-		struct NIT_entry *nit_entry = malloc(sizeof(*nit_entry));
+		struct NIT_entry *nit_entry = bits_alloc(bits,sizeof(*nit_entry));
 		memset(nit_entry,0,sizeof(*nit_entry));
-		list_add_tail(&nit_entry->next,&nit.nit_array);
+		list_add_tail(&nit_entry->next,&nit->nit_array);
 
 		nit_entry->transport_stream_id = bits_get(bits, 16) ;
 		nit_entry->original_network_id = bits_get(bits, 16) ;
@@ -162,23 +164,28 @@ int end_buff_len ;
 		end_buff_len = bits_len_calc(bits, -nit_entry->transport_descriptors_length ) ;
 		while (bits->buff_len > end_buff_len)
 		{
-			enum TS_descriptor_ids desc_tag = parse_desc(&nit_entry->transport_array, bits, flags->decode_descriptor) ;
+			enum TS_descriptor_ids desc_tag = parse_desc(&nit_entry->transport_array, bits, flags) ;
 		}
 
 	}
 	
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&nit, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)nit, tsreader->user_data) ;
 
 	//== Tidy up ==
-	free_descriptors_list(&nit.network_array);
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	free_descriptors_list(&nit->network_array);
 	
-	list_for_each_safe(item,safe,&nit.nit_array) {
+	list_for_each_safe(item,safe,&nit->nit_array) {
 		struct NIT_entry *nit_entry = list_entry(item, struct NIT_entry, next);
 		free_descriptors_list(&nit_entry->transport_array);
 		free(nit_entry) ;
 	}
-	
+
+	free(nit) ;
 }
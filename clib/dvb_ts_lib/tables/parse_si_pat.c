@@ -105,31 +105,33 @@ int end_buff_len ;
 void parse_pat(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_program_association pat ;
+struct Section_program_association *pat ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	pat = (struct Section_program_association *)bits_alloc(bits, sizeof(*pat)) ;
+	memset(pat,0,sizeof(*pat));
 
-	pat.table_id = bits_get(bits, 8) ;
-	pat.section_syntax_indicator = bits_get(bits, 1) ;
+	pat->table_id = bits_get(bits, 8) ;
+	pat->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	pat.section_length = bits_get(bits, 12) ;
-	pat.transport_stream_id = bits_get(bits, 16) ;
+	pat->section_length = bits_get(bits, 12) ;
+	pat->transport_stream_id = bits_get(bits, 16) ;
 	bits_skip(bits, 2) ;
-	pat.version_number = bits_get(bits, 5) ;
-	pat.current_next_indicator = bits_get(bits, 1) ;
-	pat.section_number = bits_get(bits, 8) ;
-	pat.last_section_number = bits_get(bits, 8) ;
+	pat->version_number = bits_get(bits, 5) ;
+	pat->current_next_indicator = bits_get(bits, 1) ;
+	pat->section_number = bits_get(bits, 8) ;
+	pat->last_section_number = bits_get(bits, 8) ;
 	
-	INIT_LIST_HEAD(&pat.pat_array) ;
+	INIT_LIST_HEAD(&pat->pat_array) ;
 	while (bits->buff_len >= 4)
 	{
-		struct PAT_entry *pat_entry = malloc(sizeof(*pat_entry));
+		struct PAT_entry *pat_entry = bits_alloc(bits,sizeof(*pat_entry));
 		memset(pat_entry,0,sizeof(*pat_entry));
-		list_add_tail(&pat_entry->next,&pat.pat_array);
+		list_add_tail(&pat_entry->next,&pat->pat_array);
 
 		pat_entry->program_number = bits_get(bits, 16) ;
 		bits_skip(bits, 3) ;
@@ -146,14 +148,18 @@ int end_buff_len ;
 	
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&pat, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)pat, tsreader->user_data) ;
 
 	//== Tidy up ==
-	
-	list_for_each_safe(item,safe,&pat.pat_array) {
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	list_for_each_safe(item,safe,&pat->pat_array) {
 		struct PAT_entry *pat_entry = list_entry(item, struct PAT_entry, next);
 		free(pat_entry) ;
 	}
-	
+
+	free(pat) ;
 }
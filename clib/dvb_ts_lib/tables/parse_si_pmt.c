@@ -114,44 +114,46 @@ int end_buff_len ;
 void parse_pmt(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_program_map pmt ;
+struct Section_program_map *pmt ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	pmt = (struct Section_program_map *)bits_alloc(bits, sizeof(*pmt)) ;
+	memset(pmt,0,sizeof(*pmt));
 
-	pmt.table_id = bits_get(bits, 8) ;
-	pmt.section_syntax_indicator = bits_get(bits, 1) ;
+	pmt->table_id = bits_get(bits, 8) ;
+	pmt->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	pmt.section_length = bits_get(bits, 12) ;
-	pmt.program_number = bits_get(bits, 16) ;
+	pmt->section_length = bits_get(bits, 12) ;
+	pmt->program_number = bits_get(bits, 16) ;
 	bits_skip(bits, 2) ;
-	pmt.version_number = bits_get(bits, 5) ;
-	pmt.current_next_indicator = bits_get(bits, 1) ;
-	pmt.section_number = bits_get(bits, 8) ;
-	pmt.last_section_number = bits_get(bits, 8) ;
+	pmt->version_number = bits_get(bits, 5) ;
+	pmt->current_next_indicator = bits_get(bits, 1) ;
+	pmt->section_number = bits_get(bits, 8) ;
+	pmt->last_section_number = bits_get(bits, 8) ;
 	bits_skip(bits, 3) ;
-	pmt.PCR_PID = bits_get(bits, 13) ;
+	pmt->PCR_PID = bits_get(bits, 13) ;
 	bits_skip(bits, 4) ;
-	pmt.program_info_length = bits_get(bits, 12) ;
+	pmt->program_info_length = bits_get(bits, 12) ;
 
 	// Descriptors
-	INIT_LIST_HEAD(&pmt.descriptors_array);
-	end_buff_len = bits_len_calc(bits, -pmt.program_info_length ) ;
+	INIT_LIST_HEAD(&pmt->descriptors_array);
+	end_buff_len = bits_len_calc(bits, -pmt->program_info_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		enum TS_descriptor_ids desc_tag = parse_desc(&pmt.descriptors_array, bits, flags->decode_descriptor) ;
+		enum TS_descriptor_ids desc_tag = parse_desc(&pmt->descriptors_array, bits, flags) ;
 	}
 
 	
-	INIT_LIST_HEAD(&pmt.pmt_array) ;
+	INIT_LIST_HEAD(&pmt->pmt_array) ;
 	while (bits->buff_len >= 5)
 	{
-		struct PMT_entry *pmt_entry = malloc(sizeof(*pmt_entry));
+		struct PMT_entry *pmt_entry = bits_alloc(bits,sizeof(*pmt_entry));
 		memset(pmt_entry,0,sizeof(*pmt_entry));
-		list_add_tail(&pmt_entry->next,&pmt.pmt_array);
+		list_add_tail(&pmt_entry->next,&pmt->pmt_array);
 
 		pmt_entry->stream_type = bits_get(bits, 8) ;
 		bits_skip(bits, 3) ;
@@ -164,23 +166,28 @@ int end_buff_len ;
 		end_buff_len = bits_len_calc(bits, -pmt_entry->ES_info_length ) ;
 		while (bits->buff_len > end_buff_len)
 		{
-			enum TS_descriptor_ids desc_tag = parse_desc(&pmt_entry->descriptors_array, bits, flags->decode_descriptor) ;
+			enum TS_descriptor_ids desc_tag = parse_desc(&pmt_entry->descriptors_array, bits, flags) ;
 		}
 
 	}
 	
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&pmt, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)pmt, tsreader->user_data) ;
 
 	//== Tidy up ==
-	free_descriptors_list(&pmt.descriptors_array);
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	free_descriptors_list(&pmt->descriptors_array);
 	
-	list_for_each_safe(item,safe,&pmt.pmt_array) {
+	list_for_each_safe(item,safe,&pmt->pmt_array) {
 		struct PMT_entry *pmt_entry = list_entry(item, struct PMT_entry, next);
 		free_descriptors_list(&pmt_entry->descriptors_array);
 		free(pmt_entry) ;
 	}
-	
+
+	free(pmt) ;
 }
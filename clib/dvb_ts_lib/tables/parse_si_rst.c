@@ -87,25 +87,27 @@ int end_buff_len ;
 void parse_rst(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_running_status rst ;
+struct Section_running_status *rst ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	rst = (struct Section_running_status *)bits_alloc(bits, sizeof(*rst)) ;
+	memset(rst,0,sizeof(*rst));
 
-	rst.table_id = bits_get(bits, 8) ;
-	rst.section_syntax_indicator = bits_get(bits, 1) ;
+	rst->table_id = bits_get(bits, 8) ;
+	rst->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	rst.section_length = bits_get(bits, 12) ;
+	rst->section_length = bits_get(bits, 12) ;
 	
-	INIT_LIST_HEAD(&rst.rst_array) ;
+	INIT_LIST_HEAD(&rst->rst_array) ;
 	while (bits->buff_len >= 9)
 	{
-		struct RST_entry *rst_entry = malloc(sizeof(*rst_entry));
+		struct RST_entry *rst_entry = bits_alloc(bits,sizeof(*rst_entry));
 		memset(rst_entry,0,sizeof(*rst_entry));
-		list_add_tail(&rst_entry->next,&rst.rst_array);
+		list_add_tail(&rst_entry->next,&rst->rst_array);
 
 		rst_entry->transport_stream_id = bits_get(bits, 16) ;
 		rst_entry->original_network_id = bits_get(bits, 16) ;
@@ -117,14 +119,18 @@ int end_buff_len ;
 	
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&rst, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)rst, tsreader->user_data) ;
 
 	//== Tidy up ==
-	
-	list_for_each_safe(item,safe,&rst.rst_array) {
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	list_for_each_safe(item,safe,&rst->rst_array) {
 		struct RST_entry *rst_entry = list_entry(item, struct RST_entry, next);
 		free(rst_entry) ;
 	}
-	
+
+	free(rst) ;
 }
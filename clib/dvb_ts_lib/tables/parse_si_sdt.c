@@ -110,33 +110,35 @@ int end_buff_len ;
 void parse_sdt(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_service_description sdt ;
+struct Section_service_description *sdt ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	sdt = (struct Section_service_description *)bits_alloc(bits, sizeof(*sdt)) ;
+	memset(sdt,0,sizeof(*sdt));
 
-	sdt.table_id = bits_get(bits, 8) ;
-	sdt.section_syntax_indicator = bits_get(bits, 1) ;
+	sdt->table_id = bits_get(bits, 8) ;
+	sdt->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	sdt.section_length = bits_get(bits, 12) ;
-	sdt.transport_stream_id = bits_get(bits, 16) ;
+	sdt->section_length = bits_get(bits, 12) ;
+	sdt->transport_stream_id = bits_get(bits, 16) ;
 	bits_skip(bits, 2) ;
-	sdt.version_number = bits_get(bits, 5) ;
-	sdt.current_next_indicator = bits_get(bits, 1) ;
-	sdt.section_number = bits_get(bits, 8) ;
-	sdt.last_section_number = bits_get(bits, 8) ;
-	sdt.original_network_id = bits_get(bits, 16) ;
+	sdt->version_number = bits_get(bits, 5) ;
+	sdt->current_next_indicator = bits_get(bits, 1) ;
+	sdt->section_number = bits_get(bits, 8) ;
+	sdt->last_section_number = bits_get(bits, 8) ;
+	sdt->original_network_id = bits_get(bits, 16) ;
 	bits_skip(bits, 8) ;
 	
-	INIT_LIST_HEAD(&sdt.sdt_array) ;
+	INIT_LIST_HEAD(&sdt->sdt_array) ;
 	while (bits->buff_len >= 5)
 	{
-		struct SDT_entry *sdt_entry = malloc(sizeof(*sdt_entry));
+		struct SDT_entry *sdt_entry = bits_alloc(bits,sizeof(*sdt_entry));
 		memset(sdt_entry,0,sizeof(*sdt_entry));
-		list_add_tail(&sdt_entry->next,&sdt.sdt_array);
+		list_add_tail(&sdt_entry->next,&sdt->sdt_array);
 
 		sdt_entry->service_id = bits_get(bits, 16) ;
 		bits_skip(bits, 6) ;
@@ -151,22 +153,26 @@ int end_buff_len ;
 		end_buff_len = bits_len_calc(bits, -sdt_entry->descriptors_loop_length ) ;
 		while (bits->buff_len > end_buff_len)
 		{
-			enum TS_descriptor_ids desc_tag = parse_desc(&sdt_entry->descriptors_array, bits, flags->decode_descriptor) ;
+			enum TS_descriptor_ids desc_tag = parse_desc(&sdt_entry->descriptors_array, bits, flags) ;
 		}
 
 	}
 	
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&sdt, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)sdt, tsreader->user_data) ;
 
 	//== Tidy up ==
-	
-	list_for_each_safe(item,safe,&sdt.sdt_array) {
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	list_for_each_safe(item,safe,&sdt->sdt_array) {
 		struct SDT_entry *sdt_entry = list_entry(item, struct SDT_entry, next);
 		free_descriptors_list(&sdt_entry->descriptors_array);
 		free(sdt_entry) ;
 	}
-	
+
+	free(sdt) ;
 }
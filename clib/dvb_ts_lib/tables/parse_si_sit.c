@@ -109,42 +109,44 @@ int end_buff_len ;
 void parse_sit(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_selection_information sit ;
+struct Section_selection_information *sit ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	sit = (struct Section_selection_information *)bits_alloc(bits, sizeof(*sit)) ;
+	memset(sit,0,sizeof(*sit));
 
-	sit.table_id = bits_get(bits, 8) ;
-	sit.section_syntax_indicator = bits_get(bits, 1) ;
+	sit->table_id = bits_get(bits, 8) ;
+	sit->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	sit.section_length = bits_get(bits, 12) ;
+	sit->section_length = bits_get(bits, 12) ;
 	bits_skip(bits, 16) ;
 	bits_skip(bits, 2) ;
-	sit.version_number = bits_get(bits, 5) ;
-	sit.current_next_indicator = bits_get(bits, 1) ;
-	sit.section_number = bits_get(bits, 8) ;
-	sit.last_section_number = bits_get(bits, 8) ;
+	sit->version_number = bits_get(bits, 5) ;
+	sit->current_next_indicator = bits_get(bits, 1) ;
+	sit->section_number = bits_get(bits, 8) ;
+	sit->last_section_number = bits_get(bits, 8) ;
 	bits_skip(bits, 4) ;
-	sit.transmission_info_loop_length = bits_get(bits, 12) ;
+	sit->transmission_info_loop_length = bits_get(bits, 12) ;
 
 	// Descriptors
-	INIT_LIST_HEAD(&sit.transmission_info_array);
-	end_buff_len = bits_len_calc(bits, -sit.transmission_info_loop_length ) ;
+	INIT_LIST_HEAD(&sit->transmission_info_array);
+	end_buff_len = bits_len_calc(bits, -sit->transmission_info_loop_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		enum TS_descriptor_ids desc_tag = parse_desc(&sit.transmission_info_array, bits, flags->decode_descriptor) ;
+		enum TS_descriptor_ids desc_tag = parse_desc(&sit->transmission_info_array, bits, flags) ;
 	}
 
 	
-	INIT_LIST_HEAD(&sit.sit_array) ;
+	INIT_LIST_HEAD(&sit->sit_array) ;
 	while (bits->buff_len >= 4)
 	{
-		struct SIT_entry *sit_entry = malloc(sizeof(*sit_entry));
+		struct SIT_entry *sit_entry = bits_alloc(bits,sizeof(*sit_entry));
 		memset(sit_entry,0,sizeof(*sit_entry));
-		list_add_tail(&sit_entry->next,&sit.sit_array);
+		list_add_tail(&sit_entry->next,&sit->sit_array);
 
 		sit_entry->service_id = bits_get(bits, 16) ;
 		bits_skip(bits, 1) ;
@@ -156,23 +158,28 @@ int end_buff_len ;
 		end_buff_len = bits_len_calc(bits, -sit_entry->service_loop_length ) ;
 		while (bits->buff_len > end_buff_len)
 		{
-			enum TS_descriptor_ids desc_tag = parse_desc(&sit_entry->service_array, bits, flags->decode_descriptor) ;
+			enum TS_descriptor_ids desc_tag = parse_desc(&sit_entry->service_array, bits, flags) ;
 		}
 
 	}
 	
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&sit, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)sit, tsreader->user_data) ;
 
 	//== Tidy up ==
-	free_descriptors_list(&sit.transmission_info_array);
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	free_descriptors_list(&sit->transmission_info_array);
 	
-	list_for_each_safe(item,safe,&sit.sit_array) {
+	list_for_each_safe(item,safe,&sit->sit_array) {
 		struct SIT_entry *sit_entry = list_entry(item, struct SIT_entry, next);
 		free_descriptors_list(&sit_entry->service_array);
 		free(sit_entry) ;
 	}
-	
+
+	free(sit) ;
 }
@@ -76,31 +76,38 @@ int end_buff_len ;
 void parse_st(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_stuffing st ;
+struct Section_stuffing *st ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	st = (struct Section_stuffing *)bits_alloc(bits, sizeof(*st)) ;
+	memset(st,0,sizeof(*st));
 
-	st.table_id = bits_get(bits, 8) ;
-	st.section_syntax_indicator = bits_get(bits, 1) ;
+	st->table_id = bits_get(bits, 8) ;
+	st->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	st.section_length = bits_get(bits, 12) ;
+	st->section_length = bits_get(bits, 12) ;
 
-	end_buff_len = bits_len_calc(bits, -st.section_length) ;
-	st.section[0] = 0 ;
+	end_buff_len = bits_len_calc(bits, -st->section_length) ;
+	st->section[0] = 0 ;
 	for (byte=0; (bits->buff_len > end_buff_len) && (byte < MAX_SECTION_LEN); ++byte)
 	{
-		st.section[byte] = bits_get(bits, 8) ;
-		st.section[byte+1] = 0 ;
+		st->section[byte] = bits_get(bits, 8) ;
+		st->section[byte+1] = 0 ;
 	}
 
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&st, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)st, tsreader->user_data) ;
 
 	//== Tidy up ==
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	free(st) ;
 }
@@ -70,23 +70,30 @@ int end_buff_len ;
 void parse_tdt(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_time_date tdt ;
+struct Section_time_date *tdt ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	tdt = (struct Section_time_date *)bits_alloc(bits, sizeof(*tdt)) ;
+	memset(tdt,0,sizeof(*tdt));
 
-	tdt.table_id = bits_get(bits, 8) ;
-	tdt.section_syntax_indicator = bits_get(bits, 1) ;
+	tdt->table_id = bits_get(bits, 8) ;
+	tdt->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	tdt.section_length = bits_get(bits, 12) ;
-	tdt.UTC_time = bits_get_mjd_time(bits) ;
+	tdt->section_length = bits_get(bits, 12) ;
+	tdt->UTC_time = bits_get_mjd_time(bits) ;
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&tdt, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)tdt, tsreader->user_data) ;
 
 	//== Tidy up ==
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	free(tdt) ;
 }
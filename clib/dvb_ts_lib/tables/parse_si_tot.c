@@ -80,35 +80,43 @@ int end_buff_len ;
 void parse_tot(struct TS_reader *tsreader, struct TS_state *tsstate, struct TS_bits *bits,
 		Section_handler handler, struct Section_decode_flags *flags)
 {
-struct Section_time_offset tot ;
+struct Section_time_offset *tot ;
 struct list_head  *item, *safe;
 unsigned byte ;
 int end_buff_len ;
 
 	//== Parse data ==
+	tot = (struct Section_time_offset *)bits_alloc(bits, sizeof(*tot)) ;
+	memset(tot,0,sizeof(*tot));
 
-	tot.table_id = bits_get(bits, 8) ;
-	tot.section_syntax_indicator = bits_get(bits, 1) ;
+	tot->table_id = bits_get(bits, 8) ;
+	tot->section_syntax_indicator = bits_get(bits, 1) ;
 	bits_skip(bits, 1) ;
 	bits_skip(bits, 2) ;
-	tot.section_length = bits_get(bits, 12) ;
-	tot.UTC_time = bits_get_mjd_time(bits) ;
+	tot->section_length = bits_get(bits, 12) ;
+	tot->UTC_time = bits_get_mjd_time(bits) ;
 	bits_skip(bits, 4) ;
-	tot.descriptors_loop_length = bits_get(bits, 12) ;
+	tot->descriptors_loop_length = bits_get(bits, 12) ;
 
 	// Descriptors
-	INIT_LIST_HEAD(&tot.descriptors_array);
-	end_buff_len = bits_len_calc(bits, -tot.descriptors_loop_length ) ;
+	INIT_LIST_HEAD(&tot->descriptors_array);
+	end_buff_len = bits_len_calc(bits, -tot->descriptors_loop_length ) ;
 	while (bits->buff_len > end_buff_len)
 	{
-		enum TS_descriptor_ids desc_tag = parse_desc(&tot.descriptors_array, bits, flags->decode_descriptor) ;
+		enum TS_descriptor_ids desc_tag = parse_desc(&tot->descriptors_array, bits, flags) ;
 	}
 
 	
 	//== Call handler ==
-	if (handler)
-		handler(tsreader, tsstate, (struct Section *)&tot, tsreader->user_data) ;
+	if (handler && !bits->error)
+		handler(tsreader, tsstate, (struct Section *)tot, tsreader->user_data) ;
 
 	//== Tidy up ==
-	free_descriptors_list(&tot.descriptors_array);
+	// (all in the arena if there is one)
+	if (bits->arena)
+		return ;
+
+	free_descriptors_list(&tot->descriptors_array);
+
+	free(tot) ;
 }
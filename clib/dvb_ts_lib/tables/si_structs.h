@@ -22,6 +22,9 @@
 #define SI_HEADER_LEN			4
 #define SECTION_HEADER_LEN		3
 
+// Descriptor tag bitmap (one bit per tag)
+#define DESC_MASK_WORDS			(256 / 32)
+
 // Running Status
 //
 //ValueMeaning
@@ -146,18 +149,42 @@ struct TS_reader ;
 struct TS_state ;
 typedef void (*Section_handler)(struct TS_reader *tsreader, struct TS_state *tsstate, struct Section *section, void *user_data) ;
 
+// A section view handler - passed the CRC checked section bytes (see si_view.h)
+struct TS_section_view ;
+typedef void (*Section_view_handler)(struct TS_reader *tsreader, struct TS_state *tsstate, const struct TS_section_view *view, void *user_data) ;
+
 
 //----------------------------------------------------------------------------------------------
 // Table to register decoding of sections
 
+#define DESC_MASK_SET(mask, tag)	((mask)[((tag) & 0xff) >> 5] |= (1U << ((tag) & 31)))
+#define DESC_MASK_CLR(mask, tag)	((mask)[((tag) & 0xff) >> 5] &= ~(1U << ((tag) & 31)))
+#define DESC_MASK_TEST(mask, tag)	(((mask)[((tag) & 0xff) >> 5] >> ((tag) & 31)) & 1)
+
+// Must start zeroed (all off: descriptors left undecoded, handler called for every copy, no descriptor mask) - declare
+// with SECTION_DECODE_FLAGS_INIT and then set the fields wanted, so that descriptor_mask is never left uninitialised
 struct Section_decode_flags {
 	unsigned	decode_descriptor : 1 ;
+
+	// only call the handler when a section is new or has changed (otherwise called for every copy received)
+	unsigned	on_change : 1 ;
+
+	// only decode the descriptors whose tags are set in descriptor_mask (overrides decode_descriptor). The others are
+	// added to the lists undecoded, with DESC_RAW set in their tag (see parse_desc_raw())
+	unsigned	use_descriptor_mask : 1 ;
+	uint32_t	descriptor_mask[DESC_MASK_WORDS] ;
 }  ;
 
+#define SECTION_DECODE_FLAGS_INIT	{ .decode_descriptor = 0, .on_change = 0, .use_descriptor_mask = 0, .descriptor_mask = { 0 } }
+
 // There is an array of these entries, one per table id
 struct Section_registry {
 	Section_handler						handler ;
+	Section_view_handler				view_handler ;
 	struct Section_decode_flags			flags ;
+
+	// for the view_handler (only on_change applies)
+	struct Section_decode_flags			view_flags ;
 };
 
 
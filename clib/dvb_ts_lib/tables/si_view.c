@@ -0,0 +1,634 @@
+/*
+ * si_view.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * Zero-copy section views (the accessors are all inline in si_view.h)
+ */
+
+// VERSION = 1.00
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "tables/si_view.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+// Long form section header + CRC
+#define VIEW_LONG_MIN_LEN		(8 + SI_CRC_LEN)
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+int si_view_valid(const struct TS_section_view *view)
+{
+unsigned min_len ;
+
+	if (!view->section || (view->section_len < SECTION_HEADER_LEN) ||
+		(view->section_len != SECTION_HEADER_LEN + si_view_section_length(view)))
+		return 0 ;
+
+	switch (si_view_table_id(view))
+	{
+	case SECTION_PAT:
+		min_len = VIEW_LONG_MIN_LEN ;
+		break ;
+
+	case SECTION_PMT:
+		min_len = 12 + SI_CRC_LEN ;
+		break ;
+
+	case SECTION_NIT_ACTUAL:
+	case SECTION_NIT_OTHER:
+	case SECTION_BAT:
+		min_len = 10 + SI_CRC_LEN ;
+		break ;
+
+	case SECTION_SDT_ACTUAL:
+	case SECTION_SDT_OTHER:
+		min_len = 11 + SI_CRC_LEN ;
+		break ;
+
+	case SECTION_EIT_START ... SECTION_EIT_END:
+		min_len = 14 + SI_CRC_LEN ;
+		break ;
+
+	case SECTION_TDT:
+		min_len = 8 ;
+		break ;
+
+	case SECTION_TOT:
+		min_len = 10 + SI_CRC_LEN ;
+		break ;
+
+	case SECTION_RST:
+	case SECTION_ST:
+	case SECTION_DIT:
+		min_len = SECTION_HEADER_LEN ;
+		break ;
+
+	default:
+		min_len = si_view_section_syntax_indicator(view) ? VIEW_LONG_MIN_LEN : SECTION_HEADER_LEN + SI_CRC_LEN ;
+		break ;
+	}
+
+	return view->section_len >= min_len ;
+}
+
+
+
+//============================================================================================
+// Test: registers both a view handler and a (struct) section handler for PAT, PMT, NIT, BAT, SDT, EIT, TDT and TOT
+// and checks that every field and descriptor read through the views matches the decoded tables (descriptors kept raw
+// so all of them are listed). Then times a timeslip style scan of the EIT (event_id and running_status of every
+// event) both ways.
+//
+//   si_view [-n reps] file.ts
+//
+#ifdef TEST_MAIN
+
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+
+#include "ts_parse.h"
+#include "descriptors/parse_desc.h"
+#include "tables/parse_si_pat.h"
+#include "tables/parse_si_pmt.h"
+#include "tables/parse_si_nit.h"
+#include "tables/parse_si_bat.h"
+#include "tables/parse_si_sdt.h"
+#include "tables/parse_si_eit.h"
+#include "tables/parse_si_tdt.h"
+#include "tables/parse_si_tot.h"
+
+#define TEST_CHUNK			(64 * 1024)
+
+struct View_test {
+	// checksum from the view of the current section (waiting for the struct handler)
+	uint64_t	view_sum ;
+	unsigned	pending ;
+
+	unsigned	matched ;
+	unsigned	mismatched ;
+	unsigned	unpaired ;			// section only seen as a view (decoder read past the end)
+	unsigned	loop_errors ;
+
+	// timeslip scan
+	unsigned	running ;
+	unsigned	events ;
+};
+
+//---------------------------------------------------------------------------------------------------------------------------
+static double test_time(void)
+{
+struct timeval tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1e6 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static inline void test_mix(uint64_t *sum, unsigned val)
+{
+	*sum = *sum * 1000003 + val ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_mix_time(uint64_t *sum, struct tm *tm)
+{
+	test_mix(sum, tm->tm_year) ;
+	test_mix(sum, tm->tm_mon) ;
+	test_mix(sum, tm->tm_mday) ;
+	test_mix(sum, tm->tm_hour) ;
+	test_mix(sum, tm->tm_min) ;
+	test_mix(sum, tm->tm_sec) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_view_descs(uint64_t *sum, struct SI_loop *descs, struct View_test *test)
+{
+const uint8_t *desc ;
+
+	while ((desc = si_view_desc_next(descs)))
+	{
+		test_mix(sum, si_view_desc_tag(desc)) ;
+		test_mix(sum, si_view_desc_length(desc)) ;
+		if (si_view_desc_length(desc))
+			test_mix(sum, si_view_desc_data(desc)[si_view_desc_length(desc) - 1]) ;
+	}
+	test->loop_errors += descs->error ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_struct_descs(uint64_t *sum, struct list_head *descs)
+{
+struct list_head *item ;
+
+	list_for_each(item, descs)
+	{
+		struct Descriptor *desc = list_entry(item, struct Descriptor, next) ;
+
+		test_mix(sum, desc->descriptor_tag & 0xff) ;
+		test_mix(sum, desc->descriptor_length) ;
+		if (desc->descriptor_length)
+			test_mix(sum, ((uint8_t *)desc->descriptor_data)[desc->descriptor_length - 1]) ;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_view_handler(struct TS_reader *tsreader, struct TS_state *tsstate, const struct TS_section_view *view, void *user_data)
+{
+struct View_test *test = (struct View_test *)user_data ;
+struct SI_loop loop, descs ;
+const uint8_t *entry ;
+struct tm tm ;
+uint64_t sum = 0 ;
+
+	if (test->pending)
+		++test->unpaired ;
+
+	test_mix(&sum, si_view_table_id(view)) ;
+	if (si_view_section_syntax_indicator(view))
+	{
+		test_mix(&sum, si_view_table_id_extension(view)) ;
+		test_mix(&sum, si_view_version_number(view)) ;
+		test_mix(&sum, si_view_section_number(view)) ;
+	}
+
+	switch (si_view_table_id(view))
+	{
+	case SECTION_PAT:
+		si_view_pat_programs(view, &loop) ;
+		while ((entry = si_view_pat_next(&loop)))
+		{
+			test_mix(&sum, si_view_pat_program_number(entry)) ;
+			test_mix(&sum, si_view_pat_pid(entry)) ;
+		}
+		break ;
+
+	case SECTION_PMT:
+		test_mix(&sum, si_view_pmt_pcr_pid(view)) ;
+		si_view_pmt_descriptors(view, &descs) ;
+		test_view_descs(&sum, &descs, test) ;
+		si_view_pmt_streams(view, &loop) ;
+		while ((entry = si_view_pmt_next(&loop)))
+		{
+			test_mix(&sum, si_view_pmt_stream_type(entry)) ;
+			test_mix(&sum, si_view_pmt_elementary_pid(entry)) ;
+			si_view_pmt_stream_descriptors(entry, &descs) ;
+			test_view_descs(&sum, &descs, test) ;
+		}
+		break ;
+
+	case SECTION_NIT_ACTUAL:
+	case SECTION_NIT_OTHER:
+	case SECTION_BAT:
+		si_view_nit_descriptors(view, &descs) ;
+		test_view_descs(&sum, &descs, test) ;
+		si_view_nit_transport_streams(view, &loop) ;
+		while ((entry = si_view_nit_next(&loop)))
+		{
+			test_mix(&sum, si_view_nit_transport_stream_id(entry)) ;
+			test_mix(&sum, si_view_nit_original_network_id(entry)) ;
+			si_view_nit_transport_descriptors(entry, &descs) ;
+			test_view_descs(&sum, &descs, test) ;
+		}
+		break ;
+
+	case SECTION_SDT_ACTUAL:
+	case SECTION_SDT_OTHER:
+		test_mix(&sum, si_view_sdt_original_network_id(view)) ;
+		si_view_sdt_services(view, &loop) ;
+		while ((entry = si_view_sdt_next(&loop)))
+		{
+			test_mix(&sum, si_view_sdt_service_id(entry)) ;
+			test_mix(&sum, si_view_sdt_eit_schedule_flag(entry)) ;
+			test_mix(&sum, si_view_sdt_eit_present_following_flag(entry)) ;
+			test_mix(&sum, si_view_sdt_running_status(entry)) ;
+			test_mix(&sum, si_view_sdt_free_CA_mode(entry)) ;
+			si_view_sdt_service_descriptors(entry, &descs) ;
+			test_view_descs(&sum, &descs, test) ;
+		}
+		break ;
+
+	case SECTION_EIT_START ... SECTION_EIT_END:
+		test_mix(&sum, si_view_eit_transport_stream_id(view)) ;
+		test_mix(&sum, si_view_eit_original_network_id(view)) ;
+		test_mix(&sum, si_view_eit_segment_last_section_number(view)) ;
+		test_mix(&sum, si_view_eit_last_table_id(view)) ;
+		si_view_eit_events(view, &loop) ;
+		while ((entry = si_view_eit_next(&loop)))
+		{
+			test_mix(&sum, si_view_eit_event_id(entry)) ;
+			tm = si_view_eit_start_time(entry) ;
+			test_mix_time(&sum, &tm) ;
+			test_mix(&sum, si_view_eit_duration(entry)) ;
+			test_mix(&sum, si_view_eit_running_status(entry)) ;
+			test_mix(&sum, si_view_eit_free_CA_mode(entry)) ;
+			si_view_eit_event_descriptors(entry, &descs) ;
+			test_view_descs(&sum, &descs, test) ;
+		}
+		break ;
+
+	case SECTION_TDT:
+		tm = si_view_utc_time(view) ;
+		test_mix_time(&sum, &tm) ;
+		break ;
+
+	case SECTION_TOT:
+		tm = si_view_utc_time(view) ;
+		test_mix_time(&sum, &tm) ;
+		si_view_tot_descriptors(view, &descs) ;
+		test_view_descs(&sum, &descs, test) ;
+		break ;
+	}
+
+	test->view_sum = sum ;
+	test->pending = 1 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_struct_handler(struct TS_reader *tsreader, struct TS_state *tsstate, struct Section *section, void *user_data)
+{
+struct View_test *test = (struct View_test *)user_data ;
+struct list_head *item ;
+uint64_t sum = 0 ;
+
+	test_mix(&sum, section->table_id) ;
+	switch (section->table_id)
+	{
+	case SECTION_PAT:
+	{
+		struct Section_program_association *pat = (struct Section_program_association *)section ;
+
+		test_mix(&sum, pat->transport_stream_id) ;
+		test_mix(&sum, pat->version_number) ;
+		test_mix(&sum, pat->section_number) ;
+		list_for_each(item, &pat->pat_array)
+		{
+			struct PAT_entry *pat_entry = list_entry(item, struct PAT_entry, next) ;
+
+			test_mix(&sum, pat_entry->program_number) ;
+			test_mix(&sum, pat_entry->program_number ? pat_entry->program_map_PID : pat_entry->network_PID) ;
+		}
+		break ;
+	}
+
+	case SECTION_PMT:
+	{
+		struct Section_program_map *pmt = (struct Section_program_map *)section ;
+
+		test_mix(&sum, pmt->program_number) ;
+		test_mix(&sum, pmt->version_number) ;
+		test_mix(&sum, pmt->section_number) ;
+		test_mix(&sum, pmt->PCR_PID) ;
+		test_struct_descs(&sum, &pmt->descriptors_array) ;
+		list_for_each(item, &pmt->pmt_array)
+		{
+			struct PMT_entry *pmt_entry = list_entry(item, struct PMT_entry, next) ;
+
+			test_mix(&sum, pmt_entry->stream_type) ;
+			test_mix(&sum, pmt_entry->elementary_PID) ;
+			test_struct_descs(&sum, &pmt_entry->descriptors_array) ;
+		}
+		break ;
+	}
+
+	case SECTION_NIT_ACTUAL:
+	case SECTION_NIT_OTHER:
+	{
+		struct Section_network_information *nit = (struct Section_network_information *)section ;
+
+		test_mix(&sum, nit->network_id) ;
+		test_mix(&sum, nit->version_number) ;
+		test_mix(&sum, nit->section_number) ;
+		test_struct_descs(&sum, &nit->network_array) ;
+		list_for_each(item, &nit->nit_array)
+		{
+			struct NIT_entry *nit_entry = list_entry(item, struct NIT_entry, next) ;
+
+			test_mix(&sum, nit_entry->transport_stream_id) ;
+			test_mix(&sum, nit_entry->original_network_id) ;
+			test_struct_descs(&sum, &nit_entry->transport_array) ;
+		}
+		break ;
+	}
+
+	case SECTION_BAT:
+	{
+		struct Section_bouquet_association *bat = (struct Section_bouquet_association *)section ;
+
+		test_mix(&sum, bat->bouquet_id) ;
+		test_mix(&sum, bat->version_number) ;
+		test_mix(&sum, bat->section_number) ;
+		test_struct_descs(&sum, &bat->bouquet_array) ;
+		list_for_each(item, &bat->bat_array)
+		{
+			struct BAT_entry *bat_entry = list_entry(item, struct BAT_entry, next) ;
+
+			test_mix(&sum, bat_entry->transport_stream_id) ;
+			test_mix(&sum, bat_entry->original_network_id) ;
+			test_struct_descs(&sum, &bat_entry->transport_array) ;
+		}
+		break ;
+	}
+
+	case SECTION_SDT_ACTUAL:
+	case SECTION_SDT_OTHER:
+	{
+		struct Section_service_description *sdt = (struct Section_service_description *)section ;
+
+		test_mix(&sum, sdt->transport_stream_id) ;
+		test_mix(&sum, sdt->version_number) ;
+		test_mix(&sum, sdt->section_number) ;
+		test_mix(&sum, sdt->original_network_id) ;
+		list_for_each(item, &sdt->sdt_array)
+		{
+			struct SDT_entry *sdt_entry = list_entry(item, struct SDT_entry, next) ;
+
+			test_mix(&sum, sdt_entry->service_id) ;
+			test_mix(&sum, sdt_entry->EIT_schedule_flag) ;
+			test_mix(&sum, sdt_entry->EIT_present_following_flag) ;
+			test_mix(&sum, sdt_entry->running_status) ;
+			test_mix(&sum, sdt_entry->free_CA_mode) ;
+			test_struct_descs(&sum, &sdt_entry->descriptors_array) ;
+		}
+		break ;
+	}
+
+	case SECTION_EIT_START ... SECTION_EIT_END:
+	{
+		struct Section_event_information *eit = (struct Section_event_information *)section ;
+
+		test_mix(&sum, eit->service_id) ;
+		test_mix(&sum, eit->version_number) ;
+		test_mix(&sum, eit->section_number) ;
+		test_mix(&sum, eit->transport_stream_id) ;
+		test_mix(&sum, eit->original_network_id) ;
+		test_mix(&sum, eit->segment_last_section_number) ;
+		test_mix(&sum, eit->last_table_id) ;
+		list_for_each(item, &eit->eit_array)
+		{
+			struct EIT_entry *eit_entry = list_entry(item, struct EIT_entry, next) ;
+
+			test_mix(&sum, eit_entry->event_id) ;
+			test_mix_time(&sum, &eit_entry->start_time) ;
+			test_mix(&sum, eit_entry->duration) ;
+			test_mix(&sum, eit_entry->running_status) ;
+			test_mix(&sum, eit_entry->free_CA_mode) ;
+			test_struct_descs(&sum, &eit_entry->descriptors_array) ;
+		}
+		break ;
+	}
+
+	case SECTION_TDT:
+	{
+		struct Section_time_date *tdt = (struct Section_time_date *)section ;
+
+		test_mix_time(&sum, &tdt->UTC_time) ;
+		break ;
+	}
+
+	case SECTION_TOT:
+	{
+		struct Section_time_offset *tot = (struct Section_time_offset *)section ;
+
+		test_mix_time(&sum, &tot->UTC_time) ;
+		test_struct_descs(&sum, &tot->descriptors_array) ;
+		break ;
+	}
+	}
+
+	if (!test->pending)
+	{
+		printf("FAIL : table 0x%02x decoded without a view\n", section->table_id) ;
+		++test->mismatched ;
+		return ;
+	}
+	test->pending = 0 ;
+
+	if (sum == test->view_sum)
+		++test->matched ;
+	else
+	{
+		printf("FAIL : table 0x%02x view differs from the decoded table\n", section->table_id) ;
+		++test->mismatched ;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Timeslip: the running event of each service
+static void test_timeslip_struct(struct TS_reader *tsreader, struct TS_state *tsstate, struct Section *section, void *user_data)
+{
+struct View_test *test = (struct View_test *)user_data ;
+struct Section_event_information *eit = (struct Section_event_information *)section ;
+struct list_head *item ;
+
+	list_for_each(item, &eit->eit_array)
+	{
+		struct EIT_entry *eit_entry = list_entry(item, struct EIT_entry, next) ;
+
+		++test->events ;
+		if (eit_entry->running_status == RUNNING_STATUS_RUNNING)
+			test->running += eit_entry->event_id ;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_timeslip_view(struct TS_reader *tsreader, struct TS_state *tsstate, const struct TS_section_view *view, void *user_data)
+{
+struct View_test *test = (struct View_test *)user_data ;
+struct SI_loop events ;
+const uint8_t *event ;
+
+	si_view_eit_events(view, &events) ;
+	while ((event = si_view_eit_next(&events)))
+	{
+		++test->events ;
+		if (si_view_eit_running_status(event) == RUNNING_STATUS_RUNNING)
+			test->running += si_view_eit_event_id(event) ;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_parse(uint8_t *data, unsigned data_len, struct View_test *test, Section_handler handler,
+		Section_view_handler view_handler, struct Section_decode_flags flags, unsigned timeslip)
+{
+static const unsigned tables[] = {
+	SECTION_PAT, SECTION_PMT, SECTION_NIT_ACTUAL, SECTION_NIT_OTHER, SECTION_BAT, SECTION_SDT_ACTUAL, SECTION_SDT_OTHER,
+	SECTION_TDT, SECTION_TOT
+} ;
+struct TS_reader *tsreader ;
+unsigned table_id ;
+unsigned offset ;
+unsigned i ;
+
+	tsreader = tsreader_new_nofile() ;
+	tsreader->user_data = test ;
+
+	for (table_id=SECTION_EIT_START; table_id <= SECTION_EIT_END; ++table_id)
+	{
+		if (handler)
+			tsreader_register_section(tsreader, table_id, 0xff, handler, flags) ;
+		if (view_handler)
+			tsreader_register_section_view(tsreader, table_id, 0xff, view_handler, flags) ;
+	}
+	for (i=0; !timeslip && (i < sizeof(tables) / sizeof(tables[0])); ++i)
+	{
+		tsreader_register_section(tsreader, tables[i], 0xff, handler, flags) ;
+		tsreader_register_section_view(tsreader, tables[i], 0xff, view_handler, flags) ;
+	}
+
+	tsreader_data_start(tsreader) ;
+	for (offset=0; offset < data_len; offset += TEST_CHUNK)
+		tsreader_data_add_shared(tsreader, &data[offset], (data_len - offset) < TEST_CHUNK ? (data_len - offset) : TEST_CHUNK) ;
+	tsreader_data_end(tsreader) ;
+
+	tsreader_free(tsreader) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct View_test test ;
+struct View_test struct_test ;
+struct View_test view_test ;
+struct Section_decode_flags flags = SECTION_DECODE_FLAGS_INIT ;
+struct stat file_stat ;
+uint8_t *data ;
+unsigned data_len ;
+unsigned reps = 20 ;
+unsigned rep ;
+unsigned failed = 0 ;
+double start, struct_time, view_time ;
+FILE *file ;
+int c ;
+
+	while ((c = getopt (argc, argv, "n:")) != -1)
+	{
+		switch (c)
+		{
+		case 'n':
+			reps = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	if (optind >= argc)
+	{
+		printf("Usage: si_view [-n reps] file.ts\n") ;
+		return 1 ;
+	}
+
+	// read the file into memory (whole packets)
+	if (stat(argv[optind], &file_stat) || !(file = fopen(argv[optind], "rb")))
+	{
+		printf("FAIL : unable to read %s\n", argv[optind]) ;
+		return 1 ;
+	}
+	data_len = (unsigned)(file_stat.st_size - (file_stat.st_size % TS_PACKET_LEN)) ;
+	data = (uint8_t *)malloc(data_len) ;
+	data_len = fread(data, 1, data_len, file) ;
+	fclose(file) ;
+
+	// views against decoded tables (all descriptors kept raw)
+	memset(&test, 0, sizeof(test)) ;
+	flags.use_descriptor_mask = 1 ;
+	test_parse(data, data_len, &test, test_struct_handler, test_view_handler, flags, 0) ;
+	printf("check    : %u sections matched, %u differ, %u not decoded, %u loop errors\n", test.matched, test.mismatched,
+		test.unpaired + test.pending, test.loop_errors) ;
+	failed += test.mismatched ;
+	if (!test.matched)
+		++failed ;
+
+	// timeslip scan of the EIT
+	flags = (struct Section_decode_flags)SECTION_DECODE_FLAGS_INIT ;
+	memset(&struct_test, 0, sizeof(struct_test)) ;
+	memset(&view_test, 0, sizeof(view_test)) ;
+
+	start = test_time() ;
+	for (rep=0; rep < reps; ++rep)
+		test_parse(data, data_len, &struct_test, test_timeslip_struct, NULL, flags, 1) ;
+	struct_time = test_time() - start ;
+
+	start = test_time() ;
+	for (rep=0; rep < reps; ++rep)
+		test_parse(data, data_len, &view_test, NULL, test_timeslip_view, flags, 1) ;
+	view_time = test_time() - start ;
+
+	printf("timeslip : %u events : struct %.3f s, view %.3f s (%u reps)\n", view_test.events / (reps ? reps : 1),
+		struct_time, view_time, reps) ;
+	if ((struct_test.events != view_test.events) || (struct_test.running != view_test.running))
+	{
+		printf("FAIL : timeslip scan differs (%u/%u events)\n", struct_test.events, view_test.events) ;
+		++failed ;
+	}
+
+	free(data) ;
+	printf("%s\n", failed ? "FAIL" : "PASS") ;
+
+	return failed ? 1 : 0 ;
+}
+
+#endif
@@ -0,0 +1,324 @@
+/*
+ * si_view.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * Zero-copy access to SI sections. Fields are read straight from the section bytes of a TS_section_view (as passed
+ * to a handler registered with tsreader_register_section_view(), or from tsreader_next_section() once checked with
+ * si_view_valid()). Loops are walked with an SI_loop:
+ *
+ *   struct SI_loop events, descs ;
+ *   const uint8_t *event, *desc ;
+ *
+ *   si_view_eit_events(view, &events) ;
+ *   while ((event = si_view_eit_next(&events)))
+ *   {
+ *       id = si_view_eit_event_id(event) ;
+ *       si_view_eit_event_descriptors(event, &descs) ;
+ *       while ((desc = si_view_desc_next(&descs)))
+ *           ...
+ *   }
+ *
+ * An entry that would run past the end of its loop ends the loop and sets the loop's 'error'.
+ */
+
+#ifndef SI_VIEW_H_
+#define SI_VIEW_H_
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+#include <time.h>
+#include <inttypes.h>
+
+#include "ts_structs.h"
+#include "ts_bits.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+#define SI_VIEW_BE16(p)		( ((unsigned)(p)[0] << 8) | (unsigned)(p)[1] )
+#define SI_VIEW_BE24(p)		( ((unsigned)(p)[0] << 16) | ((unsigned)(p)[1] << 8) | (unsigned)(p)[2] )
+#define SI_VIEW_LEN12(p)	( SI_VIEW_BE16(p) & 0x0fff )
+#define SI_VIEW_PID(p)		( SI_VIEW_BE16(p) & 0x1fff )
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+// Entries of a loop within a section
+struct SI_loop {
+	const uint8_t	*ptr ;			// next entry
+	const uint8_t	*end ;			// end of the loop
+	unsigned		error ;			// an entry didn't fit
+};
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+// Check the section is long enough for the fixed fields of its table. Must be true before using any of the table's
+// accessors (views passed to section view handlers have already been checked)
+int si_view_valid(const struct TS_section_view *view) ;
+
+/* ----------------------------------------------------------------------- */
+// Loops
+
+static inline void si_loop_init(struct SI_loop *loop, const uint8_t *start, const uint8_t *end)
+{
+	loop->ptr = start ;
+	loop->end = end > start ? end : start ;
+	loop->error = 0 ;
+}
+
+// Loop of 'len' bytes starting at 'start' (clamped to 'end')
+static inline void si_loop_init_len(struct SI_loop *loop, const uint8_t *start, unsigned len, const uint8_t *end)
+{
+	if (start > end)
+		start = end ;
+	si_loop_init(loop, start, (unsigned)(end - start) < len ? end : start + len) ;
+	if ((unsigned)(end - start) < len)
+		loop->error = 1 ;
+}
+
+// Next entry: 'header_len' fixed bytes, followed by the number of bytes given by the 12 bit length at 'len_offset' in
+// the header (no variable part if len_offset < 0). Returns NULL at the end of the loop
+static inline const uint8_t *si_loop_next(struct SI_loop *loop, unsigned header_len, int len_offset)
+{
+const uint8_t *entry = loop->ptr ;
+unsigned entry_len = header_len ;
+
+	if ((unsigned)(loop->end - entry) < header_len)
+	{
+		if (entry != loop->end)
+			loop->error = 1 ;
+		loop->ptr = loop->end ;
+		return NULL ;
+	}
+
+	if (len_offset >= 0)
+		entry_len += SI_VIEW_LEN12(entry + len_offset) ;
+	if ((unsigned)(loop->end - entry) < entry_len)
+	{
+		loop->error = 1 ;
+		loop->ptr = loop->end ;
+		return NULL ;
+	}
+
+	loop->ptr = entry + entry_len ;
+	return entry ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Descriptors
+
+// Loop of descriptors following a 12 bit descriptors length field
+static inline void si_view_desc_loop(struct SI_loop *loop, const uint8_t *len_field, const uint8_t *end)
+{
+	si_loop_init_len(loop, len_field + 2, SI_VIEW_LEN12(len_field), end) ;
+}
+
+static inline const uint8_t *si_view_desc_next(struct SI_loop *loop)
+{
+const uint8_t *desc = loop->ptr ;
+
+	if ((loop->end - desc < 2) || (loop->end - desc < 2 + desc[1]))
+	{
+		if (desc != loop->end)
+			loop->error = 1 ;
+		loop->ptr = loop->end ;
+		return NULL ;
+	}
+	loop->ptr = desc + 2 + desc[1] ;
+	return desc ;
+}
+
+static inline unsigned si_view_desc_tag(const uint8_t *desc)			{ return desc[0] ; }
+static inline unsigned si_view_desc_length(const uint8_t *desc)			{ return desc[1] ; }
+static inline const uint8_t *si_view_desc_data(const uint8_t *desc)		{ return desc + 2 ; }
+
+// The first descriptor in the loop with this tag (NULL if none)
+static inline const uint8_t *si_view_desc_find(const struct SI_loop *descs, unsigned tag)
+{
+struct SI_loop loop = *descs ;
+const uint8_t *desc ;
+
+	while ((desc = si_view_desc_next(&loop)))
+	{
+		if (desc[0] == tag)
+			return desc ;
+	}
+	return NULL ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Any section
+
+static inline unsigned si_view_table_id(const struct TS_section_view *view)				{ return view->section[0] ; }
+static inline unsigned si_view_section_syntax_indicator(const struct TS_section_view *view)	{ return view->section[1] >> 7 ; }
+static inline unsigned si_view_section_length(const struct TS_section_view *view)			{ return SI_VIEW_LEN12(view->section + 1) ; }
+
+// long form sections
+static inline unsigned si_view_table_id_extension(const struct TS_section_view *view)		{ return SI_VIEW_BE16(view->section + 3) ; }
+static inline unsigned si_view_version_number(const struct TS_section_view *view)			{ return (view->section[5] >> 1) & 0x1f ; }
+static inline unsigned si_view_current_next_indicator(const struct TS_section_view *view)	{ return view->section[5] & 1 ; }
+static inline unsigned si_view_section_number(const struct TS_section_view *view)			{ return view->section[6] ; }
+static inline unsigned si_view_last_section_number(const struct TS_section_view *view)		{ return view->section[7] ; }
+
+// End of the section data (before any CRC)
+static inline const uint8_t *si_view_end(const struct TS_section_view *view)
+{
+	switch (view->section[0])
+	{
+	case SECTION_TDT:
+	case SECTION_RST:
+	case SECTION_ST:
+	case SECTION_DIT:
+		return view->section + view->section_len ;
+	}
+	return view->section + view->section_len - SI_CRC_LEN ;
+}
+
+// 40 bit MJD + BCD UTC time
+static inline struct tm si_view_time(const uint8_t *p)
+{
+struct TS_bits bits ;
+
+	bits_init(&bits, p, 5) ;
+	return bits_get_mjd_time(&bits) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// PAT
+
+static inline unsigned si_view_pat_transport_stream_id(const struct TS_section_view *view)	{ return si_view_table_id_extension(view) ; }
+
+static inline void si_view_pat_programs(const struct TS_section_view *view, struct SI_loop *loop)
+{
+	si_loop_init(loop, view->section + 8, si_view_end(view)) ;
+}
+static inline const uint8_t *si_view_pat_next(struct SI_loop *loop)		{ return si_loop_next(loop, 4, -1) ; }
+
+static inline unsigned si_view_pat_program_number(const uint8_t *prog)	{ return SI_VIEW_BE16(prog) ; }
+static inline unsigned si_view_pat_pid(const uint8_t *prog)				{ return SI_VIEW_PID(prog + 2) ; }
+
+/* ----------------------------------------------------------------------- */
+// PMT
+
+static inline unsigned si_view_pmt_program_number(const struct TS_section_view *view)	{ return si_view_table_id_extension(view) ; }
+static inline unsigned si_view_pmt_pcr_pid(const struct TS_section_view *view)			{ return SI_VIEW_PID(view->section + 8) ; }
+
+static inline void si_view_pmt_descriptors(const struct TS_section_view *view, struct SI_loop *loop)
+{
+	si_view_desc_loop(loop, view->section + 10, si_view_end(view)) ;
+}
+
+static inline void si_view_pmt_streams(const struct TS_section_view *view, struct SI_loop *loop)
+{
+	si_loop_init(loop, view->section + 12 + SI_VIEW_LEN12(view->section + 10), si_view_end(view)) ;
+}
+static inline const uint8_t *si_view_pmt_next(struct SI_loop *loop)				{ return si_loop_next(loop, 5, 3) ; }
+
+static inline unsigned si_view_pmt_stream_type(const uint8_t *stream)			{ return stream[0] ; }
+static inline unsigned si_view_pmt_elementary_pid(const uint8_t *stream)		{ return SI_VIEW_PID(stream + 1) ; }
+static inline void si_view_pmt_stream_descriptors(const uint8_t *stream, struct SI_loop *loop)
+{
+	si_view_desc_loop(loop, stream + 3, stream + 5 + SI_VIEW_LEN12(stream + 3)) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// SDT
+
+static inline unsigned si_view_sdt_transport_stream_id(const struct TS_section_view *view)	{ return si_view_table_id_extension(view) ; }
+static inline unsigned si_view_sdt_original_network_id(const struct TS_section_view *view)	{ return SI_VIEW_BE16(view->section + 8) ; }
+
+static inline void si_view_sdt_services(const struct TS_section_view *view, struct SI_loop *loop)
+{
+	si_loop_init(loop, view->section + 11, si_view_end(view)) ;
+}
+static inline const uint8_t *si_view_sdt_next(struct SI_loop *loop)					{ return si_loop_next(loop, 5, 3) ; }
+
+static inline unsigned si_view_sdt_service_id(const uint8_t *service)					{ return SI_VIEW_BE16(service) ; }
+static inline unsigned si_view_sdt_eit_schedule_flag(const uint8_t *service)			{ return (service[2] >> 1) & 1 ; }
+static inline unsigned si_view_sdt_eit_present_following_flag(const uint8_t *service)	{ return service[2] & 1 ; }
+static inline unsigned si_view_sdt_running_status(const uint8_t *service)				{ return service[3] >> 5 ; }
+static inline unsigned si_view_sdt_free_CA_mode(const uint8_t *service)					{ return (service[3] >> 4) & 1 ; }
+static inline void si_view_sdt_service_descriptors(const uint8_t *service, struct SI_loop *loop)
+{
+	si_view_desc_loop(loop, service + 3, service + 5 + SI_VIEW_LEN12(service + 3)) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// EIT
+
+static inline unsigned si_view_eit_service_id(const struct TS_section_view *view)					{ return si_view_table_id_extension(view) ; }
+static inline unsigned si_view_eit_transport_stream_id(const struct TS_section_view *view)			{ return SI_VIEW_BE16(view->section + 8) ; }
+static inline unsigned si_view_eit_original_network_id(const struct TS_section_view *view)			{ return SI_VIEW_BE16(view->section + 10) ; }
+static inline unsigned si_view_eit_segment_last_section_number(const struct TS_section_view *view)	{ return view->section[12] ; }
+static inline unsigned si_view_eit_last_table_id(const struct TS_section_view *view)				{ return view->section[13] ; }
+
+static inline void si_view_eit_events(const struct TS_section_view *view, struct SI_loop *loop)
+{
+	si_loop_init(loop, view->section + 14, si_view_end(view)) ;
+}
+static inline const uint8_t *si_view_eit_next(struct SI_loop *loop)			{ return si_loop_next(loop, 12, 10) ; }
+
+static inline unsigned si_view_eit_event_id(const uint8_t *event)			{ return SI_VIEW_BE16(event) ; }
+static inline struct tm si_view_eit_start_time(const uint8_t *event)		{ return si_view_time(event + 2) ; }
+static inline unsigned si_view_eit_duration(const uint8_t *event)			{ return SI_VIEW_BE24(event + 7) ; }
+static inline unsigned si_view_eit_running_status(const uint8_t *event)		{ return event[10] >> 5 ; }
+static inline unsigned si_view_eit_free_CA_mode(const uint8_t *event)		{ return (event[10] >> 4) & 1 ; }
+static inline void si_view_eit_event_descriptors(const uint8_t *event, struct SI_loop *loop)
+{
+	si_view_desc_loop(loop, event + 10, event + 12 + SI_VIEW_LEN12(event + 10)) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// NIT (and BAT, which has the same layout with bouquet_id in place of network_id)
+
+static inline unsigned si_view_nit_network_id(const struct TS_section_view *view)		{ return si_view_table_id_extension(view) ; }
+
+static inline void si_view_nit_descriptors(const struct TS_section_view *view, struct SI_loop *loop)
+{
+	si_view_desc_loop(loop, view->section + 8, si_view_end(view)) ;
+}
+
+static inline void si_view_nit_transport_streams(const struct TS_section_view *view, struct SI_loop *loop)
+{
+const uint8_t *end = si_view_end(view) ;
+const uint8_t *len_field = view->section + 10 + SI_VIEW_LEN12(view->section + 8) ;
+
+	if (len_field + 2 > end)
+	{
+		si_loop_init(loop, end, end) ;
+		loop->error = 1 ;
+		return ;
+	}
+	si_loop_init_len(loop, len_field + 2, SI_VIEW_LEN12(len_field), end) ;
+}
+static inline const uint8_t *si_view_nit_next(struct SI_loop *loop)				{ return si_loop_next(loop, 6, 4) ; }
+
+static inline unsigned si_view_nit_transport_stream_id(const uint8_t *ts)		{ return SI_VIEW_BE16(ts) ; }
+static inline unsigned si_view_nit_original_network_id(const uint8_t *ts)		{ return SI_VIEW_BE16(ts + 2) ; }
+static inline void si_view_nit_transport_descriptors(const uint8_t *ts, struct SI_loop *loop)
+{
+	si_view_desc_loop(loop, ts + 4, ts + 6 + SI_VIEW_LEN12(ts + 4)) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// TDT / TOT
+
+static inline struct tm si_view_utc_time(const struct TS_section_view *view)		{ return si_view_time(view->section + 3) ; }
+
+static inline void si_view_tot_descriptors(const struct TS_section_view *view, struct SI_loop *loop)
+{
+	si_view_desc_loop(loop, view->section + 8, si_view_end(view)) ;
+}
+
+#endif /* SI_VIEW_H_ */
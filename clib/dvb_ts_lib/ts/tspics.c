@@ -14,9 +14,6 @@
 //#include "advert/ad_debug.h"
 #include "ts_parse.h"
 
-static unsigned debug=0 ;
-static unsigned ts_debug=0 ;
-
 
 struct Image_size {
 
@@ -40,8 +37,6 @@ struct Results {
 	struct Image_size *sizes ;
 };
 
-static struct Results *results = (struct Results *)0 ;
-
 
 // This structure contains all of the information & is passed to all callbacks
 //
@@ -77,6 +72,7 @@ struct Pics_user_data {
 	//-- global information  --
 	unsigned last_framenum ;
 	struct TS_reader *tsreader ;
+	struct Results *results ;
 
 	// current frame number
 	unsigned current_framenum ;
@@ -146,8 +142,10 @@ uint8_t *img, *pp, *fp ;
 }
 
 //---------------------------------------------------------------------------------------------------------------------------
-void free_results()
+void grab_results_free(struct Results **results_ptr)
 {
+struct Results *results = *results_ptr ;
+
 	if (results)
 	{
 		if (results->images)
@@ -158,18 +156,19 @@ void free_results()
 				if (results->images[i]) free(results->images[i]) ;
 
 			}
-			if (results->sizes) free(results->sizes) ;
 			free(results->images) ;
 		}
+		if (results->sizes) free(results->sizes) ;
 		free(results) ;
 	}
+	*results_ptr = NULL ;
 }
 
 
 //---------------------------------------------------------------------------------------------------------------------------
-void init_results(unsigned start_framenum, unsigned num_frames)
+static struct Results *new_results(unsigned start_framenum, unsigned num_frames)
 {
-	free_results() ;
+struct Results *results ;
 
 	results = (struct Results *)malloc(sizeof(struct Results)) ;
 	CLEAR_MEM(results) ;
@@ -182,22 +181,20 @@ void init_results(unsigned start_framenum, unsigned num_frames)
 	memset(results->images, 0, sizeof(uint32_t *) * num_frames) ;
 	results->sizes = (struct Image_size *)malloc(sizeof(struct Image_size) * num_frames) ;
 	memset(results->sizes, 0, sizeof(struct Image_size) * num_frames) ;
+
+	return results ;
 }
 
 //---------------------------------------------------------------------------------------------------------------------------
-static int _frame_index(unsigned framenum)
+static int _frame_index(struct Results *results, unsigned framenum)
 {
 int index ;
 
+	if (!results)
+		return -2 ;
+
 	index = framenum - results->start_framenum ;
-	if ((index >= 0) && (index < results->num_frames))
-	{
-		if (!results)
-		{
-			index = -2 ;
-		}
-	}
-	else
+	if ((index < 0) || (index >= results->num_frames))
 	{
 		index = -1 ;
 	}
@@ -206,7 +203,7 @@ int index ;
 }
 
 //---------------------------------------------------------------------------------------------------------------------------
-static void cleanup_results()
+static void cleanup_results(struct Results *results)
 {
 unsigned index ;
 unsigned height = 576 / 4 ;
@@ -232,9 +229,9 @@ unsigned width = 704 / 4 ;
 }
 
 //---------------------------------------------------------------------------------------------------------------------------
-static void add_image(unsigned width, unsigned height, uint8_t *frame, unsigned framenum, unsigned scale)
+static void add_image(struct Results *results, unsigned width, unsigned height, uint8_t *frame, unsigned framenum, unsigned scale)
 {
-	int index = _frame_index(framenum);
+	int index = _frame_index(results, framenum);
 
 	if (index >= 0)
 	{
@@ -294,6 +291,7 @@ static void init_user_data(struct Pics_user_data *user_data)
 	//////////////////////////////
 	// State
 	user_data->tsreader = NULL ;
+	user_data->results = NULL ;
 	user_data->last_framenum = 0 ;
 	user_data->current_framenum = 0 ;
 }
@@ -364,7 +362,7 @@ if (user_data->debug >= 2) printf("mpeg2_detect_hook() : PID = %d\n", pidinfo->p
 
 
 	// Convert image data to PPM format and add to results
-	add_image (
+	add_image (user_data->results,
 		info->sequence->width, info->sequence->height,
 		info->display_fbuf->buf[0],
 		framenum+user_data->start_framenum,
@@ -398,7 +396,7 @@ struct TS_reader *tsreader ;
     user_data->tsreader = tsreader ;
 
     if (user_data->debug)
-    	printf("Total Num packets=%u\n", tsreader->tsstate->total_pkts) ;
+    	printf("Total Num packets=%"PRIu64"\n", tsreader->tsstate->total_pkts) ;
 
 	tsreader->pid_hook = pid_hook ;
 	tsreader->mpeg2_hook = mpeg2_hook ;
@@ -418,7 +416,11 @@ struct TS_reader *tsreader ;
 
 
 //============================================================================================
-unsigned grab_pics(char *filename, unsigned start_pkt, unsigned start_framenum, unsigned num_frames, unsigned scale)
+// Grab the frames into a new results object which must be freed with grab_results_free(). Each call has
+// its own results (and debug levels: debug for this module, ts_debug for the TS reader) so this may be called from
+// several threads at once.
+struct Results *grab_pics_results(char *filename, unsigned start_pkt, unsigned start_framenum, unsigned num_frames, unsigned scale,
+		unsigned debug, unsigned ts_debug)
 {
 struct Pics_user_data user_data ;
 
@@ -430,8 +432,7 @@ struct Pics_user_data user_data ;
 	user_data.debug = debug ;
 	user_data.ts_debug = ts_debug ;
 
-
-	init_results(start_framenum, num_frames) ;
+	user_data.results = new_results(start_framenum, num_frames) ;
 
     if (user_data.debug)
     {
@@ -444,22 +445,21 @@ struct Pics_user_data user_data ;
 
 	//-----------------------------------
 	// Ensure we have results for all frames
-	cleanup_results() ;
+	cleanup_results(user_data.results) ;
 
-	return results->num_grabbed_frames ;
+	return user_data.results ;
 }
 
-void grab_debug(unsigned set_debug, unsigned set_ts_debug)
+unsigned grab_results_num_frames(struct Results *results)
 {
-	debug=set_debug ;
-	ts_debug=set_ts_debug ;
+	return results ? results->num_grabbed_frames : 0 ;
 }
 
-int grab_size(unsigned framenum)
+int grab_results_size(struct Results *results, unsigned framenum)
 {
 int size = 0 ;
 
-	int index = _frame_index(framenum);
+	int index = _frame_index(results, framenum);
 	if (index >= 0)
 	{
 		size = results->sizes[index].size ;
@@ -467,11 +467,11 @@ int size = 0 ;
 	return size ;
 }
 
-int grab_height(unsigned framenum)
+int grab_results_height(struct Results *results, unsigned framenum)
 {
 int height = 0 ;
 
-	int index = _frame_index(framenum);
+	int index = _frame_index(results, framenum);
 	if (index >= 0)
 	{
 		height = results->sizes[index].height ;
@@ -479,11 +479,11 @@ int height = 0 ;
 	return height ;
 }
 
-int grab_width(unsigned framenum)
+int grab_results_width(struct Results *results, unsigned framenum)
 {
 int width = 0 ;
 
-	int index = _frame_index(framenum);
+	int index = _frame_index(results, framenum);
 	if (index >= 0)
 	{
 		width = results->sizes[index].width ;
@@ -491,11 +491,11 @@ int width = 0 ;
 	return width ;
 }
 
-unsigned char *grab_image(unsigned framenum)
+unsigned char *grab_results_image(struct Results *results, unsigned framenum)
 {
 unsigned char *image = (unsigned char *)0 ;
 
-	int index = _frame_index(framenum);
+	int index = _frame_index(results, framenum);
 	if (index >= 0)
 	{
 		image = (unsigned char *)results->images[index] ;
@@ -503,11 +503,6 @@ unsigned char *image = (unsigned char *)0 ;
 	return image ;
 }
 
-void grab_free()
-{
-	free_results() ;
-}
-
 
 //============================================================================================
 #ifdef TEST_MAIN
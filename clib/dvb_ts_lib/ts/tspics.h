@@ -10,12 +10,15 @@
 
 #include <stdint.h>
 
-unsigned grab_pics(char *filename, unsigned start_pkt, unsigned start_framenum, unsigned num_frames, unsigned scale) ;
-int grab_size(unsigned framenum) ;
-int grab_width(unsigned framenum) ;
-int grab_height(unsigned framenum) ;
-unsigned char *grab_image(unsigned framenum) ;
-void grab_free() ;
-void grab_debug(unsigned set_debug, unsigned set_ts_debug) ;
+// Re-entrant interface - each call returns its own results
+struct Results ;
+struct Results *grab_pics_results(char *filename, unsigned start_pkt, unsigned start_framenum, unsigned num_frames, unsigned scale,
+		unsigned debug, unsigned ts_debug) ;
+unsigned grab_results_num_frames(struct Results *results) ;
+int grab_results_size(struct Results *results, unsigned framenum) ;
+int grab_results_width(struct Results *results, unsigned framenum) ;
+int grab_results_height(struct Results *results, unsigned framenum) ;
+unsigned char *grab_results_image(struct Results *results, unsigned framenum) ;
+void grab_results_free(struct Results **results) ;
 
 #endif /* TSPICS_H_ */
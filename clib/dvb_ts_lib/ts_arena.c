@@ -0,0 +1,584 @@
+/*
+ * ts_arena.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * Bump allocator used for the decoded SI tables and descriptors. A section decodes into lots of small structs (an
+ * EIT schedule section with descriptors decoded is typically 20 to 60 of them) which all have the same lifetime - the
+ * handler call. Allocating them from an arena that is reset after the handler replaces the malloc/free pair for each
+ * with a pointer bump, and once the arena has warmed up no further mallocs are needed.
+ *
+ * A handler that wants to keep a section detaches the arena's blocks (see tsreader_section_detach())
+ */
+
+// VERSION = 1.00
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "ts_arena.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+// block header, padded so the data that follows it is aligned
+#define BLOCK_HEADER_LEN	((sizeof(struct TS_arena_block) + TS_ARENA_ALIGN - 1) & ~(size_t)(TS_ARENA_ALIGN - 1))
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+static void free_blocks(struct TS_arena_block *block)
+{
+struct TS_arena_block *next ;
+
+	for (; block; block = next)
+	{
+		next = block->next ;
+		free(block) ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+void arena_init(struct TS_arena *arena)
+{
+	memset(arena, 0, sizeof(*arena)) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Free everything allocated, keeping the blocks for re-use
+void arena_reset(struct TS_arena *arena)
+{
+struct TS_arena_block *block ;
+
+	while ((block = arena->blocks))
+	{
+		arena->blocks = block->next ;
+		block->used = 0 ;
+		block->next = arena->spare ;
+		arena->spare = block ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Free everything, including the spare blocks
+void arena_clear(struct TS_arena *arena)
+{
+	free_blocks(arena->blocks) ;
+	free_blocks(arena->spare) ;
+	arena->blocks = NULL ;
+	arena->spare = NULL ;
+}
+
+/* ----------------------------------------------------------------------- */
+struct TS_arena *arena_detach(struct TS_arena *arena)
+{
+struct TS_arena *detached ;
+
+	detached = (struct TS_arena *)malloc(sizeof(*detached)) ;
+	if (!detached)
+		return NULL ;
+
+	arena_init(detached) ;
+	detached->blocks = arena->blocks ;
+	arena->blocks = NULL ;
+
+	return detached ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Free an arena created by arena_detach()
+void arena_free(struct TS_arena **arena)
+{
+	if (!*arena)
+		return ;
+
+	arena_clear(*arena) ;
+	free(*arena) ;
+	*arena = NULL ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Start a new block (a spare one if possible) big enough for 'size' (already rounded up) and allocate from it
+void *arena_alloc_block(struct TS_arena *arena, size_t size)
+{
+struct TS_arena_block *block ;
+struct TS_arena_block **prev ;
+size_t block_size ;
+
+	// first spare that's big enough (they are normally all TS_ARENA_BLOCK_SIZE)
+	for (prev = &arena->spare; (block = *prev); prev = &block->next)
+	{
+		if (size <= block->size)
+		{
+			*prev = block->next ;
+			break ;
+		}
+	}
+
+	if (!block)
+	{
+		block_size = size > TS_ARENA_BLOCK_SIZE ? size : TS_ARENA_BLOCK_SIZE ;
+		block = (struct TS_arena_block *)malloc(BLOCK_HEADER_LEN + block_size) ;
+		if (!block)
+			return NULL ;
+
+		block->size = (unsigned)block_size ;
+		block->data = (uint8_t *)block + BLOCK_HEADER_LEN ;
+		++arena->num_blocks ;
+	}
+
+	block->used = (unsigned)size ;
+	block->next = arena->blocks ;
+	arena->blocks = block ;
+
+	return block->data ;
+}
+
+
+
+//============================================================================================
+// Test/benchmark: decodes the EIT sections in the file (with and without descriptors) the old way, with every struct
+// malloc'd and freed, and then from an arena - counting the calls to malloc/free and timing both. Then runs the whole
+// file through a reader, detaching every 8th EIT section from its handler and checking that they are all unchanged at
+// the end.
+//
+//   ts_arena [-n reps] eit_schedule.ts
+//
+#ifdef TEST_MAIN
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+
+#include "ts_parse.h"
+#include "ts_crc32.h"
+#include "tables/parse_si_eit.h"
+#include "descriptors/parse_desc.h"
+
+#define TEST_MAX_SECTIONS	65536
+#define TEST_KEEP_EVERY		8
+#define TEST_CHUNK			(64 * 1024)
+
+struct Arena_test_section {
+	uint8_t		*data ;
+	unsigned	len ;
+};
+
+struct Arena_test_kept {
+	struct TS_arena							*arena ;
+	struct Section_event_information		*eit ;
+	uint64_t								sum ;
+};
+
+struct Arena_test_detach {
+	unsigned					sections ;
+	unsigned					num_kept ;
+	struct Arena_test_kept		kept[TEST_MAX_SECTIONS / TEST_KEEP_EVERY] ;
+};
+
+// count the heap calls
+extern void *__libc_malloc(size_t size) ;
+extern void *__libc_calloc(size_t nmemb, size_t size) ;
+extern void *__libc_realloc(void *ptr, size_t size) ;
+extern void __libc_free(void *ptr) ;
+
+static uint64_t test_mallocs ;
+static uint64_t test_frees ;
+
+void *malloc(size_t size)
+{
+	++test_mallocs ;
+	return __libc_malloc(size) ;
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	++test_mallocs ;
+	return __libc_calloc(nmemb, size) ;
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	++test_mallocs ;
+	return __libc_realloc(ptr, size) ;
+}
+
+void free(void *ptr)
+{
+	if (ptr)
+		++test_frees ;
+	__libc_free(ptr) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static double test_time(void)
+{
+struct timeval tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1e6 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// (parse_desc() prints each descriptor it decodes)
+static int test_quiet(int saved)
+{
+int fd ;
+
+	fflush(stdout) ;
+	if (saved < 0)
+	{
+		saved = dup(1) ;
+		fd = open("/dev/null", O_WRONLY) ;
+		dup2(fd, 1) ;
+		close(fd) ;
+		return saved ;
+	}
+	dup2(saved, 1) ;
+	close(saved) ;
+	return -1 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static uint64_t test_checksum(struct Section_event_information *eit)
+{
+struct list_head *item, *ditem ;
+uint64_t sum ;
+
+	sum = (eit->table_id << 24) | (eit->service_id << 8) | eit->section_number ;
+	list_for_each(item, &eit->eit_array)
+	{
+		struct EIT_entry *eit_entry = list_entry(item, struct EIT_entry, next) ;
+
+		sum = sum * 31 + eit_entry->event_id + eit_entry->duration ;
+		list_for_each(ditem, &eit_entry->descriptors_array)
+		{
+			struct Descriptor *desc = list_entry(ditem, struct Descriptor, next) ;
+			sum = sum * 31 + (desc->descriptor_tag << 8) + desc->descriptor_length ;
+		}
+	}
+	return sum ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_handler(struct TS_reader *tsreader, struct TS_state *tsstate, struct Section *section, void *user_data)
+{
+	*(uint64_t *)user_data += test_checksum((struct Section_event_information *)section) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_detach_handler(struct TS_reader *tsreader, struct TS_state *tsstate, struct Section *section, void *user_data)
+{
+struct Arena_test_detach *detach = (struct Arena_test_detach *)user_data ;
+struct Arena_test_kept *kept ;
+
+	if ((detach->sections++ % TEST_KEEP_EVERY) || (detach->num_kept == TEST_MAX_SECTIONS / TEST_KEEP_EVERY))
+		return ;
+
+	kept = &detach->kept[detach->num_kept++] ;
+	kept->arena = tsreader_section_detach(tsreader) ;
+	kept->eit = (struct Section_event_information *)section ;
+	kept->sum = test_checksum(kept->eit) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Get copies of the intact EIT sections
+static unsigned test_read_sections(char *filename, struct Arena_test_section *sections)
+{
+struct TS_reader *tsreader ;
+struct TS_section_view view ;
+unsigned num_sections = 0 ;
+
+	tsreader = tsreader_new(filename) ;
+	if (!tsreader)
+		return 0 ;
+
+	while ((tsreader_next_section(tsreader, &view) == 1) && (num_sections < TEST_MAX_SECTIONS))
+	{
+		if ((view.table_id < SECTION_EIT_NOW_ACTUAL) || (view.table_id > SECTION_EIT_OTHER_END) ||
+			(view.section_len <= SECTION_HEADER_LEN+SI_CRC_LEN) || ts_crc32(view.section, view.section_len))
+			continue ;
+
+		sections[num_sections].data = (uint8_t *)malloc(view.section_len) ;
+		memcpy(sections[num_sections].data, view.section, view.section_len) ;
+		sections[num_sections].len = view.section_len ;
+		++num_sections ;
+	}
+	tsreader_free(tsreader) ;
+
+	return num_sections ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Decode all of the sections 'reps' times (the handler adds up their checksums)
+static void test_decode(struct TS_reader *tsreader, struct Arena_test_section *sections, unsigned num_sections,
+		unsigned reps, unsigned decode_descriptor, struct TS_arena *arena,
+		uint64_t *mallocs, uint64_t *frees, double *time)
+{
+struct Section_decode_flags flags = SECTION_DECODE_FLAGS_INIT ;
+struct TS_bits bits ;
+unsigned rep, i ;
+double start ;
+int saved ;
+
+	flags.decode_descriptor = decode_descriptor ;
+	saved = test_quiet(-1) ;
+	*mallocs = test_mallocs ;
+	*frees = test_frees ;
+	start = test_time() ;
+	for (rep=0; rep < reps; ++rep)
+	{
+		for (i=0; i < num_sections; ++i)
+		{
+			bits_init(&bits, sections[i].data, sections[i].len - SI_CRC_LEN) ;
+			bits.arena = arena ;
+			parse_eit(tsreader, tsreader->tsstate, &bits, test_handler, &flags) ;
+			if (arena)
+				arena_reset(arena) ;
+		}
+	}
+	*time = test_time() - start ;
+	*mallocs = test_mallocs - *mallocs ;
+	*frees = test_frees - *frees ;
+	test_quiet(saved) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Compare decoding with malloc and with an arena. Returns number of failures
+static unsigned test_compare(struct Arena_test_section *sections, unsigned num_sections, unsigned reps, unsigned decode_descriptor)
+{
+struct TS_reader *tsreader ;
+struct TS_arena arena ;
+uint64_t malloc_sum = 0, arena_sum = 0 ;
+uint64_t malloc_mallocs, malloc_frees, arena_mallocs, arena_frees ;
+double malloc_time, arena_time ;
+
+	tsreader = tsreader_new_nofile() ;
+	arena_init(&arena) ;
+
+	// (first pass warms up the arena)
+	tsreader->user_data = &malloc_sum ;
+	test_decode(tsreader, sections, num_sections, 1, decode_descriptor, NULL, &malloc_mallocs, &malloc_frees, &malloc_time) ;
+	tsreader->user_data = &arena_sum ;
+	test_decode(tsreader, sections, num_sections, 1, decode_descriptor, &arena, &arena_mallocs, &arena_frees, &arena_time) ;
+
+	printf("descriptors %-3s : malloc %7.2f mallocs %7.2f frees per section, arena %5.2f mallocs %5.2f frees (%"PRIu64" blocks)\n",
+		decode_descriptor ? "on" : "off",
+		(double)malloc_mallocs / num_sections, (double)malloc_frees / num_sections,
+		(double)arena_mallocs / num_sections, (double)arena_frees / num_sections, arena.num_blocks) ;
+
+	tsreader->user_data = &malloc_sum ;
+	test_decode(tsreader, sections, num_sections, reps, decode_descriptor, NULL, &malloc_mallocs, &malloc_frees, &malloc_time) ;
+	tsreader->user_data = &arena_sum ;
+	test_decode(tsreader, sections, num_sections, reps, decode_descriptor, &arena, &arena_mallocs, &arena_frees, &arena_time) ;
+
+	printf("                  time malloc %.3f s, arena %.3f s (%u reps) : %"PRIu64" mallocs in steady state\n",
+		malloc_time, arena_time, reps, arena_mallocs) ;
+
+	arena_clear(&arena) ;
+	tsreader_free(tsreader) ;
+
+	return (malloc_sum != arena_sum) || arena_mallocs ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Keep some of the sections. Returns number of failures
+static unsigned test_detach(uint8_t *data, unsigned data_len)
+{
+struct TS_reader *tsreader ;
+struct Arena_test_detach *detach ;
+struct Section_decode_flags flags = SECTION_DECODE_FLAGS_INIT ;
+unsigned failed = 0 ;
+unsigned table_id ;
+unsigned offset ;
+unsigned i ;
+int saved ;
+
+	flags.decode_descriptor = 1 ;
+	detach = (struct Arena_test_detach *)calloc(1, sizeof(*detach)) ;
+	tsreader = tsreader_new_nofile() ;
+	tsreader->user_data = detach ;
+	for (table_id=SECTION_EIT_NOW_ACTUAL; table_id <= SECTION_EIT_OTHER_END; ++table_id)
+		tsreader_register_section(tsreader, table_id, 0xff, test_detach_handler, flags) ;
+
+	saved = test_quiet(-1) ;
+	tsreader_data_start(tsreader) ;
+	for (offset=0; offset < data_len; offset += TEST_CHUNK)
+		tsreader_data_add_shared(tsreader, &data[offset], (data_len - offset) < TEST_CHUNK ? (data_len - offset) : TEST_CHUNK) ;
+	tsreader_data_end(tsreader) ;
+	test_quiet(saved) ;
+
+	// the reader's arena has been re-used for all the other sections since
+	for (i=0; i < detach->num_kept; ++i)
+	{
+		if (!detach->kept[i].arena || (test_checksum(detach->kept[i].eit) != detach->kept[i].sum))
+			++failed ;
+	}
+	tsreader_free(tsreader) ;
+
+	// still valid after the reader has gone
+	for (i=0; i < detach->num_kept; ++i)
+	{
+		if (test_checksum(detach->kept[i].eit) != detach->kept[i].sum)
+			++failed ;
+		arena_free(&detach->kept[i].arena) ;
+	}
+
+	printf("detach : kept %u of %u sections, %u changed\n", detach->num_kept, detach->sections, failed) ;
+	free(detach) ;
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_pes_hook(struct TS_pidinfo *pidinfo, struct TS_pesinfo *pesinfo, uint8_t *pesdata, unsigned pesdata_len, void *user_data)
+{
+	++*(unsigned *)user_data ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Parse the PES on all pids twice over: the first pass warms up the reassembly buffer pool, after which there should be
+// no more heap calls. Then check the pool keeps to a limit. Returns number of failures
+static unsigned test_steady_state(uint8_t *data, unsigned data_len)
+{
+struct TS_reader *tsreader ;
+const struct TS_buffer_pool_stats *stats ;
+unsigned num_pes = 0 ;
+unsigned pool_mallocs ;
+uint64_t mallocs ;
+uint64_t limit ;
+unsigned failed = 0 ;
+unsigned pass ;
+unsigned offset ;
+
+	tsreader = tsreader_new_nofile() ;
+	tsreader->pes_hook = test_pes_hook ;
+	tsreader->user_data = &num_pes ;
+	stats = tsreader_buffer_pool_stats(tsreader) ;
+
+	tsreader_data_start(tsreader) ;
+	for (pass=0; pass < 2; ++pass)
+	{
+		mallocs = test_mallocs ;
+		pool_mallocs = stats->num_mallocs ;
+		for (offset=0; offset < data_len; offset += TEST_CHUNK)
+			tsreader_data_add_shared(tsreader, &data[offset], (data_len - offset) < TEST_CHUNK ? (data_len - offset) : TEST_CHUNK) ;
+	}
+	mallocs = test_mallocs - mallocs ;
+	pool_mallocs = stats->num_mallocs - pool_mallocs ;
+	tsreader_data_end(tsreader) ;
+
+	printf("steady state : %u PES, pool %u mallocs (peak %"PRIu64" bytes in use), then %"PRIu64" mallocs and %u pool mallocs\n",
+		num_pes, stats->num_mallocs, stats->mem_peak, mallocs, pool_mallocs) ;
+	if (!num_pes || !stats->num_mallocs || mallocs || pool_mallocs)
+		++failed ;
+
+	// with half the memory it needed, some buffers can't grow but the pool stays within the limit
+	limit = stats->mem_peak / 2 ;
+	tsreader_free(tsreader) ;
+
+	tsreader = tsreader_new_nofile() ;
+	tsreader->pes_hook = test_pes_hook ;
+	tsreader->user_data = &num_pes ;
+	tsreader_buffer_pool_limit(tsreader, limit) ;
+	stats = tsreader_buffer_pool_stats(tsreader) ;
+
+	tsreader_data_start(tsreader) ;
+	for (offset=0; offset < data_len; offset += TEST_CHUNK)
+		tsreader_data_add_shared(tsreader, &data[offset], (data_len - offset) < TEST_CHUNK ? (data_len - offset) : TEST_CHUNK) ;
+	tsreader_data_end(tsreader) ;
+
+	printf("limit %"PRIu64" bytes : peak %"PRIu64" in use, %"PRIu64" allocated, %u refused\n",
+		limit, stats->mem_peak, stats->mem_allocated, stats->num_fails) ;
+	if ((stats->mem_peak > limit) || (stats->mem_allocated > limit) || !stats->num_fails)
+		++failed ;
+	tsreader_free(tsreader) ;
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct Arena_test_section *sections ;
+struct stat file_stat ;
+uint8_t *data ;
+unsigned data_len ;
+unsigned num_sections ;
+unsigned reps = 20 ;
+unsigned failed = 0 ;
+unsigned i ;
+FILE *file ;
+int c ;
+
+	while ((c = getopt (argc, argv, "n:")) != -1)
+	{
+		switch (c)
+		{
+		case 'n':
+			reps = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	if (optind >= argc)
+	{
+		printf("Usage: ts_arena [-n reps] file.ts\n") ;
+		return 1 ;
+	}
+
+	sections = (struct Arena_test_section *)calloc(TEST_MAX_SECTIONS, sizeof(*sections)) ;
+	num_sections = test_read_sections(argv[optind], sections) ;
+	printf("%u EIT sections\n", num_sections) ;
+	if (!num_sections)
+	{
+		printf("FAIL : no EIT sections in %s\n", argv[optind]) ;
+		return 1 ;
+	}
+
+	failed += test_compare(sections, num_sections, reps, 0) ;
+	failed += test_compare(sections, num_sections, reps, 1) ;
+
+	// read the file into memory (whole packets)
+	if (stat(argv[optind], &file_stat) || !(file = fopen(argv[optind], "rb")))
+	{
+		printf("FAIL : unable to read %s\n", argv[optind]) ;
+		return 1 ;
+	}
+	data_len = (unsigned)(file_stat.st_size - (file_stat.st_size % TS_PACKET_LEN)) ;
+	data = (uint8_t *)malloc(data_len) ;
+	data_len = fread(data, 1, data_len, file) ;
+	fclose(file) ;
+
+	failed += test_detach(data, data_len) ;
+	failed += test_steady_state(data, data_len) ;
+
+	for (i=0; i < num_sections; ++i)
+		free(sections[i].data) ;
+	free(sections) ;
+	free(data) ;
+	printf("%s\n", failed ? "FAIL" : "PASS") ;
+
+	return failed ? 1 : 0 ;
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * ts_arena.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef TS_ARENA_H_
+#define TS_ARENA_H_
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+#include <stddef.h>
+#include <inttypes.h>
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+// Normal block size (larger requests get a block to themselves)
+#define TS_ARENA_BLOCK_SIZE		(16*1024)
+
+// Alignment of every allocation
+#define TS_ARENA_ALIGN			16
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+struct TS_arena_block {
+	struct TS_arena_block	*next ;
+	unsigned				size ;			// bytes available for allocations
+	unsigned				used ;
+	uint8_t					*data ;
+};
+
+// Bump allocator. Everything allocated is freed at once by arena_reset() (blocks kept for re-use) or arena_clear()
+struct TS_arena {
+	struct TS_arena_block	*blocks ;		// in use - current block first
+	struct TS_arena_block	*spare ;		// emptied by arena_reset()
+
+	// stats
+	uint64_t				num_allocs ;	// arena_alloc() calls
+	uint64_t				num_blocks ;	// blocks malloc'd
+};
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+void arena_init(struct TS_arena *arena) ;
+void arena_reset(struct TS_arena *arena) ;
+void arena_clear(struct TS_arena *arena) ;
+
+// Move everything allocated so far into a new (malloc'd) arena, leaving this one empty. The memory stays valid until
+// arena_free() is called on the returned arena
+struct TS_arena *arena_detach(struct TS_arena *arena) ;
+void arena_free(struct TS_arena **arena) ;
+
+// Slow path of arena_alloc() - gets a new block
+void *arena_alloc_block(struct TS_arena *arena, size_t size) ;
+
+/* ----------------------------------------------------------------------- */
+// Allocate (uninitialised) memory. Returns NULL only if a new block can't be malloc'd
+static inline void *arena_alloc(struct TS_arena *arena, size_t size)
+{
+struct TS_arena_block *block = arena->blocks ;
+
+	size = (size + TS_ARENA_ALIGN - 1) & ~(size_t)(TS_ARENA_ALIGN - 1) ;
+	++arena->num_allocs ;
+	if (block && (size <= block->size - block->used))
+	{
+		void *ptr = block->data + block->used ;
+		block->used += (unsigned)size ;
+		return ptr ;
+	}
+	return arena_alloc_block(arena, size) ;
+}
+
+#endif /* TS_ARENA_H_ */
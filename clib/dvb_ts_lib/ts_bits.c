@@ -34,128 +34,6 @@
 // FUNCTIONS
 /*=============================================================================================*/
 
-/* ----------------------------------------------------------------------- */
-void bits_free(struct TS_bits **bits)
-{
-struct TS_bits *bp = *bits ;
-
-	if (bp)
-	{
-		free(bp) ;
-	}
-	*bits = NULL ;
-}
-
-/* ----------------------------------------------------------------------- */
-struct TS_bits *bits_new(uint8_t *src, unsigned src_len)
-{
-struct TS_bits *bp ;
-
-	// create struct
-	bp = (struct TS_bits *)malloc(sizeof(struct TS_bits)) ;
-	memset(bp, 0, sizeof(*bp));
-
-	// init
-	bp->buff_ptr = src ;
-	bp->buff_len = src_len ;
-	bp->start_bit = 0 ;
-
-	return bp ;
-}
-
-
-
-
-/* ----------------------------------------------------------------------- */
-unsigned bits_get(struct TS_bits *bits, unsigned len)
-{
-unsigned int result = 0;
-unsigned start_len = len + bits->start_bit ;
-unsigned mask ;
-int left_shift ;
-unsigned byte = 0 ;
-
-	if (len==0)
-		return 0 ;
-
-if (len > 32)
-{
-	fprintf(stderr, "BUGGER! Request for > 32 bits!\n") ;
-	exit(1) ;
-}
-
-if (bits->buff_len <= 0)
-{
-	fprintf(stderr, "BUGGER! Gone past the end of the buffer!\n") ;
-	exit(1) ;
-}
-
-	if (len == 32)
-	{
-		mask = 0xffffffff ;
-	}
-	else
-	{
-		mask = (1 << len) -1 ;
-	}
-
-	// We want to shift the "start" bit to the MS bit of the final length
-	//
-	// 0   s  7    - NOTE: start bit is numbered from MS = 0 to LS = 7
-	// [  0   ]
-	//
-	//
-	left_shift = (len-1) - (7-bits->start_bit) ;
-
-	if (left_shift >= 0)
-	{
-
-		while (left_shift >= 0)
-		{
-			result |= bits->buff_ptr[byte++] << left_shift ;
-			left_shift -= 8 ;
-		}
-	}
-	if ((left_shift < 0) && (left_shift > -8))
-	{
-		result |= bits->buff_ptr[byte] >> -left_shift ;
-	}
-
-	result &= mask ;
-
-	// update buffer
-	bits->start_bit = start_len % 8 ;
-	bits->buff_len -= start_len / 8 ;
-	bits->buff_ptr += start_len / 8 ;
-
-    return result;
-}
-
-/* ----------------------------------------------------------------------- */
-void bits_skip(struct TS_bits *bits, unsigned len)
-{
-unsigned int result ;
-
-	while (len > 32)
-	{
-		// chop into 32 bit chunkc
-		result= bits_get(bits, 32) ;
-		len -= 32 ;
-	}
-	result = bits_get(bits, len) ;
-}
-
-/* ----------------------------------------------------------------------- */
-// Calculate the result of adding the offset to the current buffer length and return
-// that result (clamping value to 0 min)
-int bits_len_calc(struct TS_bits *bits, int offset)
-{
-	int len = bits->buff_len + offset ;
-	if (len < 0) len = 0 ;
-	return len ;
-}
-
-
 /* ----------------------------------------------------------------------- */
 // Read the 16 bit MJD & 24 bit START then convert to time_t format
 struct tm bits_get_mjd_time(struct TS_bits *bits)
@@ -249,3 +127,272 @@ unsigned byte ;
 	printf("\n") ;
 }
 
+
+//============================================================================================
+// Test: checks bits_get()/bits_skip() against the original byte-by-byte reader for random field sizes and positions
+// (including reads off the end of the buffer), then times decoding every table section in the file.
+//
+//   ts_bits [-n reps] file.ts
+//
+#ifdef TEST_MAIN
+
+#include <sys/time.h>
+
+#include "ts_parse.h"
+#include "tables/parse_si_pat.h"
+#include "tables/parse_si_cat.h"
+#include "tables/parse_si_pmt.h"
+#include "tables/parse_si_nit.h"
+#include "tables/parse_si_sdt.h"
+#include "tables/parse_si_bat.h"
+#include "tables/parse_si_eit.h"
+#include "tables/parse_si_tot.h"
+#include "tables/parse_si_cit.h"
+#include "tables/parse_si_sit.h"
+
+#define TEST_BUFF_LEN		64
+#define TEST_RUNS			200000
+#define TEST_MAX_SECTIONS	100000
+
+//---------------------------------------------------------------------------------------------------------------------------
+static double test_time(void)
+{
+struct timeval tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1e6 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// The original reader: builds the result a byte at a time
+static unsigned test_ref_get(const uint8_t **buff_ptr, int *buff_len, unsigned *start_bit, unsigned len)
+{
+unsigned int result = 0;
+unsigned start_len = len + *start_bit ;
+unsigned mask ;
+int left_shift ;
+unsigned byte = 0 ;
+
+	if (len==0)
+		return 0 ;
+
+	mask = (len == 32) ? 0xffffffff : (1 << len) -1 ;
+	left_shift = (len-1) - (7-*start_bit) ;
+	while (left_shift >= 0)
+	{
+		result |= (*buff_ptr)[byte++] << left_shift ;
+		left_shift -= 8 ;
+	}
+	if ((left_shift < 0) && (left_shift > -8))
+		result |= (*buff_ptr)[byte] >> -left_shift ;
+
+	*start_bit = start_len % 8 ;
+	*buff_len -= start_len / 8 ;
+	*buff_ptr += start_len / 8 ;
+
+    return result & mask ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Returns number of failures
+static unsigned test_cross_check(void)
+{
+uint8_t buff[TEST_BUFF_LEN] ;
+struct TS_bits bits ;
+const uint8_t *ref_ptr ;
+int ref_len ;
+unsigned ref_bit ;
+unsigned failed = 0 ;
+unsigned reads = 0 ;
+unsigned overruns = 0 ;
+unsigned run, i, len, val, ref ;
+
+	srand(1) ;
+	for (run=0; run < TEST_RUNS; ++run)
+	{
+		len = 1 + rand() % TEST_BUFF_LEN ;
+		for (i=0; i < len; ++i)
+			buff[i] = rand() & 0xff ;
+
+		bits_init(&bits, buff, len) ;
+		ref_ptr = buff ;
+		ref_len = (int)len ;
+		ref_bit = 0 ;
+
+		while (!bits.error)
+		{
+			// mostly the common field sizes, both aligned and not
+			len = (rand() & 1) ? 8 * (1 + rand() % 4) : rand() % 33 ;
+
+			// past the end - must flag the error rather than read anything
+			if ((int)((ref_bit + len + 7) >> 3) > ref_len)
+			{
+				val = bits_get(&bits, len) ;
+				if (!bits.error || val || bits.buff_len)
+				{
+					printf("FAIL : %u bits at bit %u of %d bytes : no error\n", len, ref_bit, ref_len) ;
+					++failed ;
+				}
+				++overruns ;
+				break ;
+			}
+
+			ref = test_ref_get(&ref_ptr, &ref_len, &ref_bit, len) ;
+			switch (len)
+			{
+			case 8: val = bits_get(&bits, 8) ; break ;
+			case 16: val = bits_get(&bits, 16) ; break ;
+			case 24: val = bits_get(&bits, 24) ; break ;
+			case 32: val = bits_get(&bits, 32) ; break ;
+			default:
+				if (rand() & 1)
+				{
+					val = bits_get(&bits, len) ;
+				}
+				else
+				{
+					bits_skip(&bits, len) ;
+					val = ref ;
+				}
+				break ;
+			}
+			++reads ;
+
+			if ((val != ref) || (bits.buff_ptr != ref_ptr) || (bits.buff_len != ref_len) || (bits.start_bit != ref_bit) || bits.error)
+			{
+				printf("FAIL : %u bits : got 0x%08x expected 0x%08x\n", len, val, ref) ;
+				++failed ;
+				break ;
+			}
+		}
+	}
+	printf("%s : cross check : %u reads, %u overruns\n", failed ? "FAIL" : "PASS", reads, overruns) ;
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Decode one section (without its CRC). Returns 0 if there's no parser for it
+static unsigned test_decode(struct TS_reader *tsreader, uint8_t *section, unsigned section_len)
+{
+struct Section_decode_flags flags = SECTION_DECODE_FLAGS_INIT ;
+struct TS_bits bits ;
+
+	flags.decode_descriptor = 1 ;
+	bits_init(&bits, section, section_len - 4) ;
+	switch (section[0])
+	{
+	case SECTION_PAT:
+		parse_pat(tsreader, tsreader->tsstate, &bits, NULL, &flags) ;
+		break ;
+	case SECTION_CAT:
+		parse_cat(tsreader, tsreader->tsstate, &bits, NULL, &flags) ;
+		break ;
+	case SECTION_PMT:
+		parse_pmt(tsreader, tsreader->tsstate, &bits, NULL, &flags) ;
+		break ;
+	case SECTION_NIT_ACTUAL:
+	case SECTION_NIT_OTHER:
+		parse_nit(tsreader, tsreader->tsstate, &bits, NULL, &flags) ;
+		break ;
+	case SECTION_SDT_ACTUAL:
+	case SECTION_SDT_OTHER:
+		parse_sdt(tsreader, tsreader->tsstate, &bits, NULL, &flags) ;
+		break ;
+	case SECTION_BAT:
+		parse_bat(tsreader, tsreader->tsstate, &bits, NULL, &flags) ;
+		break ;
+	case SECTION_EIT_NOW_ACTUAL:
+	case SECTION_EIT_NOW_OTHER:
+	case SECTION_EIT_ACTUAL_START ... SECTION_EIT_OTHER_END:
+		parse_eit(tsreader, tsreader->tsstate, &bits, NULL, &flags) ;
+		break ;
+	case SECTION_TOT:
+		parse_tot(tsreader, tsreader->tsstate, &bits, NULL, &flags) ;
+		break ;
+	case SECTION_CIT:
+		parse_cit(tsreader, tsreader->tsstate, &bits, NULL, &flags) ;
+		break ;
+	case SECTION_SIT:
+		parse_sit(tsreader, tsreader->tsstate, &bits, NULL, &flags) ;
+		break ;
+	default:
+		return 0 ;
+	}
+	return 1 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct TS_reader *tsreader ;
+struct TS_section_view view ;
+uint8_t **sections ;
+unsigned *section_lens ;
+unsigned num_sections = 0 ;
+unsigned decoded ;
+unsigned reps = 20 ;
+unsigned failed ;
+unsigned i, rep ;
+double start, elapsed ;
+int c ;
+
+	while ((c = getopt (argc, argv, "n:")) != -1)
+	{
+		switch (c)
+		{
+		case 'n':
+			reps = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	failed = test_cross_check() ;
+
+	if (optind < argc)
+	{
+		// copy out all of the sections
+		sections = (uint8_t **)malloc(TEST_MAX_SECTIONS * sizeof(uint8_t *)) ;
+		section_lens = (unsigned *)malloc(TEST_MAX_SECTIONS * sizeof(unsigned)) ;
+		tsreader = tsreader_new(argv[optind]) ;
+		if (!tsreader)
+		{
+			printf("FAIL : unable to read %s\n", argv[optind]) ;
+			return 1 ;
+		}
+		while ((num_sections < TEST_MAX_SECTIONS) && (tsreader_next_section(tsreader, &view) == 1))
+		{
+			if (view.section_len <= 4)
+				continue ;
+			sections[num_sections] = (uint8_t *)malloc(view.section_len) ;
+			memcpy(sections[num_sections], view.section, view.section_len) ;
+			section_lens[num_sections++] = view.section_len ;
+		}
+
+		// decode them all (with descriptors)
+		decoded = 0 ;
+		start = test_time() ;
+		for (rep=0; rep < reps; ++rep)
+			for (i=0; i < num_sections; ++i)
+				decoded += test_decode(tsreader, sections[i], section_lens[i]) ;
+		elapsed = test_time() - start ;
+
+		printf("decode : %u sections x %u : %.3f s : %.0f sections/s\n", num_sections, reps, elapsed, decoded / elapsed) ;
+
+		for (i=0; i < num_sections; ++i)
+			free(sections[i]) ;
+		free(sections) ;
+		free(section_lens) ;
+		tsreader_free(tsreader) ;
+	}
+
+	printf("%s\n", failed ? "FAIL" : "PASS") ;
+
+	return failed ? 1 : 0 ;
+}
+
+#endif
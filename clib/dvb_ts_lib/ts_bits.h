@@ -12,6 +12,11 @@
 // USES
 /*=============================================================================================*/
 #include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "ts_arena.h"
 
 /*=============================================================================================*/
 // CONSTANTS
@@ -25,26 +30,167 @@
 // STRUCTS
 /*=============================================================================================*/
 
+// Bit reader - normally on the stack, set up with bits_init(). Reading past the end of the buffer sets 'error' and
+// returns 0 (the buffer is then treated as empty). Decoded structs are allocated from 'arena' if set, otherwise with
+// malloc() and freed by the decoder
 struct TS_bits {
-	uint8_t *buff_ptr ;
-	int buff_len ;
-	unsigned start_bit ;
+	const uint8_t *buff_ptr ;		// byte containing the next bit
+	int buff_len ;					// bytes left from buff_ptr
+	unsigned start_bit ;			// next bit in *buff_ptr (0 = MS bit)
+	unsigned error ;
+	struct TS_arena *arena ;
 };
 
 /*=============================================================================================*/
 // FUNCTIONS
 /*=============================================================================================*/
 
-void bits_free(struct TS_bits **bits);
-struct TS_bits *bits_new(uint8_t *src, unsigned src_len);
-unsigned bits_get(struct TS_bits *bits, unsigned len);
-void bits_skip(struct TS_bits *bits, unsigned len);
-int bits_len_calc(struct TS_bits *bits, int offset);
 struct tm bits_get_mjd_time(struct TS_bits *bits) ;
 
 // Utility print functions
 void bits_dump_indent(unsigned level) ;
 void bits_dump(char *name, unsigned *buff, unsigned length, unsigned level) ;
 
+/* ----------------------------------------------------------------------- */
+static inline void bits_init(struct TS_bits *bits, const uint8_t *src, unsigned src_len)
+{
+	bits->buff_ptr = src ;
+	bits->buff_len = (int)src_len ;
+	bits->start_bit = 0 ;
+	bits->error = 0 ;
+	bits->arena = NULL ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Memory for a decoded struct (uninitialised)
+static inline void *bits_alloc(struct TS_bits *bits, size_t size)
+{
+	if (bits->arena)
+		return arena_alloc(bits->arena, size) ;
+	return malloc(size) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Over-read: flag the error and stop any further reads
+static inline unsigned bits_overrun(struct TS_bits *bits)
+{
+	bits->buff_ptr += bits->buff_len ;
+	bits->buff_len = 0 ;
+	bits->start_bit = 0 ;
+	bits->error = 1 ;
+	return 0 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// The next 64 bits (big endian) starting at the current byte. Any bytes past the end of the buffer read as 0
+static inline uint64_t bits_cache(const struct TS_bits *bits)
+{
+uint64_t cache ;
+int i ;
+
+	if (bits->buff_len >= 8)
+	{
+		memcpy(&cache, bits->buff_ptr, sizeof(cache)) ;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		cache = __builtin_bswap64(cache) ;
+#endif
+		return cache ;
+	}
+
+	cache = 0 ;
+	for (i=0; i < bits->buff_len; ++i)
+		cache |= (uint64_t)bits->buff_ptr[i] << (56 - 8*i) ;
+	return cache ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Any field of up to 32 bits at any bit position
+static inline unsigned bits_get_any(struct TS_bits *bits, unsigned len)
+{
+unsigned end_bit = bits->start_bit + len ;
+uint64_t cache ;
+
+	if ((len > 32) || ((int)((end_bit + 7) >> 3) > bits->buff_len))
+		return bits_overrun(bits) ;
+
+	cache = bits_cache(bits) << bits->start_bit ;
+
+	bits->buff_ptr += end_bit >> 3 ;
+	bits->buff_len -= end_bit >> 3 ;
+	bits->start_bit = end_bit & 7 ;
+
+	return (unsigned)(cache >> (64 - len)) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Byte aligned 8/16/24/32 bit field
+static inline unsigned bits_get_bytes(struct TS_bits *bits, unsigned num_bytes)
+{
+const uint8_t *p = bits->buff_ptr ;
+unsigned result ;
+
+	switch (num_bytes)
+	{
+	case 1:
+		result = p[0] ;
+		break ;
+	case 2:
+		result = ((unsigned)p[0] << 8) | p[1] ;
+		break ;
+	case 3:
+		result = ((unsigned)p[0] << 16) | ((unsigned)p[1] << 8) | p[2] ;
+		break ;
+	default:
+		result = ((unsigned)p[0] << 24) | ((unsigned)p[1] << 16) | ((unsigned)p[2] << 8) | p[3] ;
+		break ;
+	}
+	bits->buff_ptr += num_bytes ;
+	bits->buff_len -= num_bytes ;
+
+	return result ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Read a field of 'len' bits (up to 32). Whole byte fields with a constant length take the byte aligned path whenever
+// the reader is on a byte boundary
+static inline __attribute__((always_inline)) unsigned bits_get(struct TS_bits *bits, unsigned len)
+{
+	if (__builtin_constant_p(len) && len && (len <= 32) && !(len & 7))
+	{
+		if (!bits->start_bit && (bits->buff_len >= (int)(len >> 3)))
+			return bits_get_bytes(bits, len >> 3) ;
+	}
+	if (!len)
+		return 0 ;
+
+	return bits_get_any(bits, len) ;
+}
+
+/* ----------------------------------------------------------------------- */
+static inline void bits_skip(struct TS_bits *bits, unsigned len)
+{
+unsigned end_bit = bits->start_bit + len ;
+
+	if ((int)((end_bit + 7) >> 3) > bits->buff_len)
+	{
+		bits_overrun(bits) ;
+		return ;
+	}
+
+	bits->buff_ptr += end_bit >> 3 ;
+	bits->buff_len -= end_bit >> 3 ;
+	bits->start_bit = end_bit & 7 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Calculate the result of adding the offset to the current buffer length and return
+// that result (clamping value to 0 min)
+static inline int bits_len_calc(struct TS_bits *bits, int offset)
+{
+	int len = bits->buff_len + offset ;
+	if (len < 0) len = 0 ;
+	return len ;
+}
+
 
 #endif /* TS_BITS_H_ */
@@ -0,0 +1,413 @@
+/*
+ * ts_crc32.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * CRC-32/MPEG-2 (as used by PSI/SI sections). The byte at a time table version in dvbsnoop/crc32.c is kept as the
+ * reference; this provides two faster versions giving the same result:
+ *
+ *   slicing-by-8	8 tables of 256 entries, where table k gives the CRC contribution of a byte followed by k zero bytes,
+ *   				so 8 bytes are processed per step with 8 independent lookups
+ *
+ *   carry-less		on x86 cpus with PCLMULQDQ (checked at run time) the data is folded 64 bytes at a time: each 128 bit
+ *   multiply		block A is moved on n bits by multiplying its two halves by the 32 bit constants x^(n+64) mod P and
+ *   				x^n mod P and xor-ing the products into the block n bits further on. The single 128 bit value left at
+ *   				the end (plus any tail bytes) is finished off with the tables
+ *
+ * The tables and constants are created (and the method chosen) on first use.
+ */
+
+// VERSION = 1.00
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "ts_crc32.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HAVE_CLMUL	1
+#include <immintrin.h>
+#else
+#define HAVE_CLMUL	0
+#endif
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+#define BE32(p)		( ((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3] )
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT ;
+static uint32_t crc_tables[8][256] ;
+static unsigned crc_clmul ;
+
+// folding constants (x^n mod P) for moving a block on 512 bits (4 blocks) and 128 bits (1 block)
+static uint32_t k576, k512, k192, k128 ;
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+// x^n mod P
+static uint32_t xpow_mod(unsigned n)
+{
+uint32_t r = 1 ;
+
+	while (n--)
+		r = (r << 1) ^ ((r & 0x80000000) ? TS_CRC32_POLY : 0) ;
+
+	return r ;
+}
+
+/* ----------------------------------------------------------------------- */
+static void crc_init(void)
+{
+unsigned b, k ;
+uint32_t crc ;
+
+	for (b=0; b < 256; ++b)
+	{
+		crc = b << 24 ;
+		for (k=0; k < 8; ++k)
+			crc = (crc << 1) ^ ((crc & 0x80000000) ? TS_CRC32_POLY : 0) ;
+		crc_tables[0][b] = crc ;
+	}
+	for (k=1; k < 8; ++k)
+	{
+		for (b=0; b < 256; ++b)
+			crc_tables[k][b] = (crc_tables[k-1][b] << 8) ^ crc_tables[0][crc_tables[k-1][b] >> 24] ;
+	}
+
+	k576 = xpow_mod(576) ;
+	k512 = xpow_mod(512) ;
+	k192 = xpow_mod(192) ;
+	k128 = xpow_mod(128) ;
+
+#if HAVE_CLMUL
+	__builtin_cpu_init() ;
+	crc_clmul = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3") ;
+#endif
+}
+
+/* ----------------------------------------------------------------------- */
+// Continue the CRC (crc = TS_CRC32_INIT to start) over the data, 8 bytes at a time
+uint32_t ts_crc32_slice8(uint32_t crc, const uint8_t *data, unsigned len)
+{
+uint32_t hi, lo ;
+
+	pthread_once(&crc_once, crc_init) ;
+
+	while (len >= 8)
+	{
+		hi = crc ^ BE32(data) ;
+		lo = BE32(data+4) ;
+		crc = crc_tables[7][hi >> 24] ^ crc_tables[6][(hi >> 16) & 0xff] ^
+			crc_tables[5][(hi >> 8) & 0xff] ^ crc_tables[4][hi & 0xff] ^
+			crc_tables[3][lo >> 24] ^ crc_tables[2][(lo >> 16) & 0xff] ^
+			crc_tables[1][(lo >> 8) & 0xff] ^ crc_tables[0][lo & 0xff] ;
+		data += 8 ;
+		len -= 8 ;
+	}
+
+	while (len--)
+		crc = (crc << 8) ^ crc_tables[0][(crc >> 24) ^ *data++] ;
+
+	return crc ;
+}
+
+/* ----------------------------------------------------------------------- */
+unsigned ts_crc32_have_clmul(void)
+{
+	pthread_once(&crc_once, crc_init) ;
+	return crc_clmul ;
+}
+
+#if HAVE_CLMUL
+
+/* ----------------------------------------------------------------------- */
+// Move the block on by the distance given by k = { x^(n+64) mod P, x^n mod P } and add in the block there
+static inline __attribute__((always_inline, target("pclmul,ssse3"))) __m128i fold(__m128i block, __m128i k, __m128i next)
+{
+	return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(block, k, 0x11), _mm_clmulepi64_si128(block, k, 0x00)), next) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Load 16 bytes as a 128 bit polynomial (first byte holds the highest powers)
+static inline __attribute__((always_inline, target("pclmul,ssse3"))) __m128i load_block(const uint8_t *data, __m128i swap)
+{
+	return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), swap) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Only call if ts_crc32_have_clmul() is set
+__attribute__((target("pclmul,ssse3")))
+uint32_t ts_crc32_clmul(const uint8_t *data, unsigned len)
+{
+const __m128i swap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0) ;
+__m128i k4, k1 ;
+__m128i x0, x1, x2, x3 ;
+uint8_t block[16] ;
+uint32_t crc ;
+
+	pthread_once(&crc_once, crc_init) ;
+	if (len < 64)
+		return ts_crc32_slice8(TS_CRC32_INIT, data, len) ;
+
+	k4 = _mm_set_epi64x(k576, k512) ;
+	k1 = _mm_set_epi64x(k192, k128) ;
+
+	// starting the CRC at all ones is the same as inverting the first 32 bits of data
+	x0 = _mm_xor_si128(load_block(data, swap), _mm_set_epi32((int)TS_CRC32_INIT, 0, 0, 0)) ;
+	x1 = load_block(data+16, swap) ;
+	x2 = load_block(data+32, swap) ;
+	x3 = load_block(data+48, swap) ;
+	data += 64 ;
+	len -= 64 ;
+
+	while (len >= 64)
+	{
+		x0 = fold(x0, k4, load_block(data, swap)) ;
+		x1 = fold(x1, k4, load_block(data+16, swap)) ;
+		x2 = fold(x2, k4, load_block(data+32, swap)) ;
+		x3 = fold(x3, k4, load_block(data+48, swap)) ;
+		data += 64 ;
+		len -= 64 ;
+	}
+
+	// down to 1 block
+	x0 = fold(x0, k1, x1) ;
+	x0 = fold(x0, k1, x2) ;
+	x0 = fold(x0, k1, x3) ;
+	while (len >= 16)
+	{
+		x0 = fold(x0, k1, load_block(data, swap)) ;
+		data += 16 ;
+		len -= 16 ;
+	}
+
+	// what's left is congruent to the data so far, so its CRC (starting from 0) continues on to the tail
+	_mm_storeu_si128((__m128i *)block, _mm_shuffle_epi8(x0, swap)) ;
+	crc = ts_crc32_slice8(0, block, sizeof(block)) ;
+
+	return ts_crc32_slice8(crc, data, len) ;
+}
+
+#else
+
+/* ----------------------------------------------------------------------- */
+uint32_t ts_crc32_clmul(const uint8_t *data, unsigned len)
+{
+	return ts_crc32_slice8(TS_CRC32_INIT, data, len) ;
+}
+
+#endif
+
+/* ----------------------------------------------------------------------- */
+uint32_t ts_crc32(const uint8_t *data, unsigned len)
+{
+	pthread_once(&crc_once, crc_init) ;
+
+	if (crc_clmul && (len >= TS_CRC32_CLMUL_MIN))
+		return ts_crc32_clmul(data, len) ;
+
+	return ts_crc32_slice8(TS_CRC32_INIT, data, len) ;
+}
+
+
+
+//============================================================================================
+// Test: checks the slicing-by-8 and carry-less multiply versions against the reference crc32() for random data of
+// every length up to 4096 bytes (and random SI sections with their CRC appended), then measures the throughput of each
+// for some typical section lengths (MBytes of each, none for 0).
+//
+//   ts_crc32 [-n MBytes]
+//
+#ifdef TEST_MAIN
+
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "dvbsnoop/crc32.h"
+
+#define TEST_MAX_LEN		4096
+#define TEST_RUNS			20
+
+//---------------------------------------------------------------------------------------------------------------------------
+static double test_time(void)
+{
+struct timeval tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1e6 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Returns number of failures
+static unsigned test_cross_check(void)
+{
+uint8_t *buff ;
+unsigned failed = 0 ;
+unsigned checks = 0 ;
+unsigned run, len, offset, i ;
+uint32_t ref, crc ;
+
+	buff = (uint8_t *)malloc(TEST_MAX_LEN + 16) ;
+	srand(1) ;
+	for (run=0; run < TEST_RUNS; ++run)
+	{
+		for (len=0; len <= TEST_MAX_LEN; ++len)
+		{
+			// vary the alignment too
+			offset = rand() % 16 ;
+			for (i=0; i < len; ++i)
+				buff[offset+i] = rand() & 0xff ;
+
+			// every 4th one is a section with its CRC on the end (so the CRC over all of it is 0)
+			if (((len & 3) == 0) && (len >= 8))
+			{
+				ref = crc32(&buff[offset], len-4) ;
+				buff[offset+len-4] = ref >> 24 ;
+				buff[offset+len-3] = (ref >> 16) & 0xff ;
+				buff[offset+len-2] = (ref >> 8) & 0xff ;
+				buff[offset+len-1] = ref & 0xff ;
+			}
+
+			ref = crc32(&buff[offset], len) ;
+
+			crc = ts_crc32_slice8(TS_CRC32_INIT, &buff[offset], len) ;
+			if (crc != ref)
+			{
+				printf("FAIL : slicing-by-8 : len %u : got 0x%08x expected 0x%08x\n", len, crc, ref) ;
+				++failed ;
+			}
+
+			if (ts_crc32_have_clmul())
+			{
+				crc = ts_crc32_clmul(&buff[offset], len) ;
+				if (crc != ref)
+				{
+					printf("FAIL : clmul : len %u : got 0x%08x expected 0x%08x\n", len, crc, ref) ;
+					++failed ;
+				}
+			}
+
+			crc = ts_crc32(&buff[offset], len) ;
+			if (crc != ref)
+			{
+				printf("FAIL : ts_crc32 : len %u : got 0x%08x expected 0x%08x\n", len, crc, ref) ;
+				++failed ;
+			}
+
+			if (((len & 3) == 0) && (len >= 8) && ref)
+			{
+				printf("FAIL : section with CRC : len %u : got 0x%08x expected 0\n", len, ref) ;
+				++failed ;
+			}
+
+			++checks ;
+		}
+	}
+	free(buff) ;
+
+	printf("%s : cross check : %u lengths/alignments, clmul %s\n", failed ? "FAIL" : "PASS", checks,
+			ts_crc32_have_clmul() ? "tested" : "not available") ;
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Returns MBytes/s
+static double test_speed(unsigned method, const uint8_t *buff, unsigned len, unsigned mbytes)
+{
+unsigned reps = (unsigned)(((uint64_t)mbytes << 20) / len) ;
+volatile uint32_t sum = 0 ;
+double start ;
+unsigned rep ;
+
+	start = test_time() ;
+	for (rep=0; rep < reps; ++rep)
+	{
+		switch (method)
+		{
+		case 0: sum += crc32((uint8_t *)buff, len) ; break ;
+		case 1: sum += ts_crc32_slice8(TS_CRC32_INIT, buff, len) ; break ;
+		case 2: sum += ts_crc32_clmul(buff, len) ; break ;
+		default: sum += ts_crc32(buff, len) ; break ;
+		}
+	}
+
+	return ((double)reps * len / (1024.0*1024.0)) / (test_time() - start) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+static const unsigned lens[] = { 16, 64, 188, 1024, 4096 } ;
+static const char *names[] = { "reference", "slicing-by-8", "clmul", "ts_crc32" } ;
+uint8_t buff[TEST_MAX_LEN] ;
+unsigned mbytes = 64 ;
+unsigned failed ;
+unsigned i, method ;
+int c ;
+
+	while ((c = getopt (argc, argv, "n:")) != -1)
+	{
+		switch (c)
+		{
+		case 'n':
+			mbytes = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	failed = test_cross_check() ;
+
+	for (i=0; i < sizeof(buff); ++i)
+		buff[i] = rand() & 0xff ;
+
+	if (mbytes)
+	{
+		printf("MBytes/s      ") ;
+		for (i=0; i < sizeof(lens)/sizeof(lens[0]); ++i)
+			printf(" %8u", lens[i]) ;
+		printf("\n") ;
+
+		for (method=0; method < 4; ++method)
+		{
+			if ((method == 2) && !ts_crc32_have_clmul())
+				continue ;
+
+			printf("%-13s ", names[method]) ;
+			for (i=0; i < sizeof(lens)/sizeof(lens[0]); ++i)
+				printf(" %8.0f", test_speed(method, buff, lens[i], mbytes)) ;
+			printf("\n") ;
+		}
+	}
+
+	printf("%s\n", failed ? "FAIL" : "PASS") ;
+
+	return failed ? 1 : 0 ;
+}
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * ts_crc32.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef TS_CRC32_H_
+#define TS_CRC32_H_
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+#include <inttypes.h>
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+// CRC-32/MPEG-2 polynomial (x^32 + x^26 + x^23 + x^22 + x^16 + x^12 + x^11 + x^10 + x^8 + x^7 + x^5 + x^4 + x^2 + x + 1)
+#define TS_CRC32_POLY			0x04c11db7
+#define TS_CRC32_INIT			0xffffffff
+
+// Shortest data worth using the carry-less multiply version for (below this the tables are faster)
+#define TS_CRC32_CLMUL_MIN		64
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+// CRC-32/MPEG-2 of the data using the fastest method available on this cpu (same result as the dvbsnoop crc32()). A
+// section including its CRC gives 0 if it is intact
+uint32_t ts_crc32(const uint8_t *data, unsigned len) ;
+
+// The separate methods (for testing)
+uint32_t ts_crc32_slice8(uint32_t crc, const uint8_t *data, unsigned len) ;
+unsigned ts_crc32_have_clmul(void) ;
+uint32_t ts_crc32_clmul(const uint8_t *data, unsigned len) ;
+
+#endif /* TS_CRC32_H_ */
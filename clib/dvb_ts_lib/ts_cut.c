@@ -5,6 +5,7 @@
 // VERSION 1.01
 
 #include "ts_split.h"
+#include "ts_cut.h"
 
 //========================================================================================================
 // CUT
@@ -12,141 +13,468 @@
 
 
 //---------------------------------------------------------------------------------------------------------
-// void (*tsparse_ts_hook)(unsigned long, unsigned, const uint8_t *, unsigned, unsigned, unsigned) ;
-void ts_cut_hook(struct TS_pidinfo *pidinfo, uint8_t *packet, unsigned packet_len, void *user_data)
+// Step through the cut list - returns true if the packet is to be kept
+static unsigned cut_pkt_ok(struct TS_cut_data *hook_data, uint64_t pktnum)
 {
-struct TS_cut_data *hook_data = (struct TS_cut_data *)user_data ;
-static unsigned prev_ok=1;
+unsigned ok = 1 ;
 
-	if (hook_data->ofile)
+	// check cut
+	if (hook_data->current_cut == UNSET_CUT_LIST)
 	{
-	unsigned ok = 1 ;
+	struct list_head *item;
 
-		if (hook_data->debug >= 10)
+		list_for_each(item, hook_data->cut_list)
 		{
-			printf("-> TS PID 0x%x (%u) [%u] :: start=%d err=%d\n",
-					pidinfo->pid, pidinfo->pid,
-					pidinfo->pktnum,
-					pidinfo->pes_start ? 1 : 0,
-					pidinfo->pid_error ? 1 : 0) ;
+			hook_data->current_cut = list_entry(item, struct TS_cut, next);
+			break;
 		}
+	}
 
-		// check cut
-		if (hook_data->current_cut == UNSET_CUT_LIST)
+	if (hook_data->current_cut != END_CUT_LIST)
+	{
+		// check current
+		if (pktnum < hook_data->current_cut->start)
 		{
-		struct list_head *item;
-
-			list_for_each(item, hook_data->cut_list)
-			{
-				hook_data->current_cut = list_entry(item, struct TS_cut, next);
-				break;
-			}
+			// ok, not in this cut band
 		}
-
-		if (hook_data->current_cut != END_CUT_LIST)
+		else
 		{
-			// check current
-			if (pidinfo->pktnum < hook_data->current_cut->start)
+
+			if (pktnum <= hook_data->current_cut->end)
 			{
-				// ok, not in this cut band
+				// cut, in this cut band
+				ok = 0 ;
+
+				if (hook_data->prev_ok)
+				{
+					if (hook_data->debug) printf("Skipping %"PRIu64" .. %"PRIu64"\n", hook_data->current_cut->start, hook_data->current_cut->end) ;
+				}
+
+				hook_data->prev_ok = ok ;
+
 			}
 			else
 			{
+			struct list_head *item;
 
-				if (pidinfo->pktnum <= hook_data->current_cut->end)
+				// ok, beyond this cut band - find next cut region
+				do
 				{
-					// cut, in this cut band
-					ok = 0 ;
-
-					if (prev_ok)
+					list_next_each(hook_data->current_cut, END_CUT_LIST, item, hook_data->cut_list)
 					{
-						if (hook_data->debug) printf("Skipping %u .. %u\n", hook_data->current_cut->start, hook_data->current_cut->end) ;
+						hook_data->current_cut = list_entry(item, struct TS_cut, next);
+						break;
 					}
+				} while ( (hook_data->current_cut != END_CUT_LIST) && (pktnum > hook_data->current_cut->start) ) ;
 
-					prev_ok = ok ;
+				hook_data->prev_ok=1;
 
-				}
-				else
-				{
-				struct list_head *item;
+			}
+		}
+	}
 
-					// ok, beyond this cut band - find next cut region
-					do
-					{
-						list_next_each(hook_data->current_cut, END_CUT_LIST, item, hook_data->cut_list)
-						{
-							hook_data->current_cut = list_entry(item, struct TS_cut, next);
-							break;
-						}
-					} while ( (hook_data->current_cut != END_CUT_LIST) && (pidinfo->pktnum > hook_data->current_cut->start) ) ;
+	return ok ;
+}
 
-					prev_ok=1;
+//---------------------------------------------------------------------------------------------------------
+// void (*tsparse_batch_hook)(struct TS_pkt_desc *, unsigned, void *) ;
+static void ts_cut_hook(struct TS_pkt_desc *pkts, unsigned num_pkts, void *user_data)
+{
+struct TS_cut_data *hook_data = (struct TS_cut_data *)user_data ;
+struct iovec iov[TS_BATCH_MAX] ;
+unsigned num_iov = 0 ;
+unsigned i ;
 
-				}
+	if (hook_data->ofile)
+	{
+		for (i=0; i < num_pkts; ++i)
+		{
+		unsigned ok ;
+
+			if (hook_data->debug >= 10)
+			{
+				printf("-> TS PID 0x%x (%u) [%"PRIu64"] :: start=%d err=%d\n",
+						pkts[i].pid, pkts[i].pid,
+						pkts[i].pktnum,
+						pkts[i].flags & TS_PKT_FLAG_START ? 1 : 0,
+						pkts[i].flags & TS_PKT_FLAG_ERROR ? 1 : 0) ;
 			}
-		}
 
-		if (hook_data->debug >= 10)
-		{
-			printf("-> TS PID 0x%x (%u) [%u] :: ok=%d\n",
-					pidinfo->pid, pidinfo->pid,
-					pidinfo->pktnum,
-					ok) ;
-		}
+			ok = cut_pkt_ok(hook_data, pkts[i].pktnum) ;
 
+			if (hook_data->debug >= 10)
+			{
+				printf("-> TS PID 0x%x (%u) [%"PRIu64"] :: ok=%d\n",
+						pkts[i].pid, pkts[i].pid,
+						pkts[i].pktnum,
+						ok) ;
+			}
 
-		// write if allowed to
-		if (ok)
-		{
-			// no error
-			write(hook_data->ofile, packet, packet_len);
+			// write if allowed to
+			if (ok)
+			{
+				cut_iov_add(iov, &num_iov, pkts[i].packet - hook_data->tsreader->packet_prefix, hook_data->tsreader->packet_size) ;
+			}
 		}
+
+		// write out the whole batch in one go
+		cut_iov_write(hook_data->ofile, iov, &num_iov) ;
 	}
 }
 
 
 
 //---------------------------------------------------------------------------------------------------------
-int ts_cut(char *filename, char *ofilename, struct list_head *cuts_array, unsigned debug)
+// tsfanout_end_hook
+static int ts_cut_end(struct TS_reader *tsreader, void *user_data)
 {
-int file;
-struct TS_cut_data hook_data ;
+struct TS_cut_data *hook_data = (struct TS_cut_data *)user_data ;
+
+	close(hook_data->ofile) ;
+	free_cut_list(hook_data->cut_list) ;
+	free(hook_data) ;
+
+	return 0 ;
+}
+
+//---------------------------------------------------------------------------------------------------------
+// Add cutting the file to a single pass of the file. The cut list is freed once done
+int ts_cut_fanout(struct TS_fanout *fanout, char *ofilename, struct list_head *cuts_array, unsigned debug)
+{
+struct TS_cut_data *hook_data ;
 struct TS_reader *tsreader ;
 
-	hook_data.cut_list = cuts_array ;
+	hook_data = (struct TS_cut_data *)malloc(sizeof(struct TS_cut_data)) ;
+	if (!hook_data)
+	{
+		RETURN_DVB_ERROR(ERR_MALLOC);
+	}
+	CLEAR_MEM(hook_data) ;
 
-	hook_data.current_cut = UNSET_CUT_LIST ;
-	hook_data.debug = debug ;
-	hook_data.ofile = 0 ;
-	hook_data.split_count = 0 ;
-	hook_data.cut_file = 0 ;
+	hook_data->cut_list = cuts_array ;
+
+	hook_data->current_cut = UNSET_CUT_LIST ;
+	hook_data->prev_ok = 1 ;
+	hook_data->debug = debug ;
+	hook_data->split_count = 0 ;
+	hook_data->cut_file = 0 ;
 
-    hook_data.ofile = open(ofilename, O_CREAT | O_TRUNC | O_WRONLY | O_LARGEFILE, 0666);
-    if (-1 == hook_data.ofile) {
+    hook_data->ofile = open(ofilename, O_CREAT | O_TRUNC | O_WRONLY | O_LARGEFILE, 0666);
+    if (-1 == hook_data->ofile) {
+    	free(hook_data) ;
 		RETURN_DVB_ERROR(ERR_FILE);
     }
 
-	tsreader = tsreader_new(filename) ;
+	tsreader = tsfanout_add(fanout, ts_cut_end, hook_data) ;
     if (!tsreader)
     {
+    	close(hook_data->ofile) ;
+    	free(hook_data) ;
     	return(dvb_error_code);
     }
-	tsreader->ts_hook = ts_cut_hook ;
-	tsreader->user_data = &hook_data ;
+	tsreader->batch_hook = ts_cut_hook ;
+	hook_data->tsreader = tsreader ;
 	tsreader->debug = debug ;
 
-	remove_ext(filename, hook_data.fname) ;
-	remove_ext(ofilename, hook_data.ofname) ;
+	remove_ext(fanout->filename, hook_data->fname) ;
+	remove_ext(ofilename, hook_data->ofname) ;
+
+	return 0 ;
+}
+
+//---------------------------------------------------------------------------------------------------------
+int ts_cut(char *filename, char *ofilename, struct list_head *cuts_array, unsigned debug)
+{
+struct TS_fanout *fanout ;
+int status ;
+
+	fanout = tsfanout_new(filename) ;
+    if (!fanout)
+    {
+    	return(dvb_error_code);
+    }
 
 	// parse data
-    ts_parse(tsreader) ;
+	status = ts_cut_fanout(fanout, ofilename, cuts_array, debug) ;
+	if (!status)
+		status = tsfanout_run(fanout) ;
+	tsfanout_free(fanout) ;
+
+	return(status) ;
+}
+
+
+//============================================================================================
+// Test: builds a sparse file of (by default) 1 TB, i.e. well over 2^32 packets, containing the first few
+// thousand packets of the source file at the start, straddling packet 2^32, and at the end. Each copy is then
+// read back via tsreader_setpos() and checked against the source (packet numbers, data and progress), along with
+// the fast head/tail timing and the cut list handling around the 32 bit boundary. Reports SKIP if the file system
+// can't hold the sparse file.
+//
+//   ts_cut [-s size_gb] [-n num_pkts] [-d debug] source.ts sparse.ts
+//
+#ifdef TEST_MAIN
+
+#include <signal.h>
 
-	close(hook_data.ofile) ;
+#include "ts_timing.h"
+
+#define TEST_BOUNDARY_PKT	(1ULL << 32)
+
+struct test_region {
+	uint64_t	pktnum ;		// packet number of the first packet of this copy of the source
+	uint64_t	count ;			// packets seen
+	uint64_t	first ;			// first/last packet numbers seen
+	uint64_t	last ;
+	uint64_t	sum ;			// checksum of packet data and packet number relative to pktnum
+	uint64_t	progress_total ;
+	int64_t		start_ts ;		// as TS_state after tsreader_set_timing()
+	int64_t		end_ts ;
+};
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_ts_hook(struct TS_pidinfo *pidinfo, uint8_t *packet, unsigned packet_len, void *user_data)
+{
+struct test_region *region = (struct test_region *)user_data ;
+unsigned i ;
+
+	if (!region->count)
+		region->first = pidinfo->pktnum ;
+	region->last = pidinfo->pktnum ;
+	++region->count ;
+
+	region->sum += (pidinfo->pktnum - region->pktnum) * 31 ;
+	for (i=0; i < packet_len; ++i)
+		region->sum += (uint64_t)packet[i] << (i & 7) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_progress_hook(enum TS_progress_state state, uint64_t progress, uint64_t total, void *user_data)
+{
+struct test_region *region = (struct test_region *)user_data ;
+
+	if (state == PROGRESS_START)
+		region->progress_total = total ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Read num_pkts from the position. Returns 0 on success
+static int test_read(char *filename, int64_t skip_pkts, int origin, uint64_t num_pkts, struct test_region *region)
+{
+struct TS_reader *tsreader ;
+int status ;
+
+	tsreader = tsreader_new(filename) ;
+	if (!tsreader)
+		return -1 ;
+	tsreader->ts_hook = test_ts_hook ;
+	tsreader->progress_hook = test_progress_hook ;
+	tsreader->user_data = region ;
+	tsreader->use_mmap = 1 ;
+
+	status = tsreader_setpos(tsreader, skip_pkts, origin, num_pkts) ;
+	if (!status)
+		status = ts_parse(tsreader) ;
+
+	tsreader_set_timing(tsreader) ;
+	region->start_ts = tsreader->tsstate->start_ts ;
+	region->end_ts = tsreader->tsstate->end_ts ;
 
 	tsreader_free(tsreader) ;
-	free_cut_list(hook_data.cut_list) ;
+	return status ;
+}
 
-	return(dvb_error_code) ;
+//---------------------------------------------------------------------------------------------------------------------------
+static int test_check(const char *name, struct test_region *region, struct test_region *ref, uint64_t total_pkts)
+{
+int ok = (region->count == ref->count) && (region->sum == ref->sum) &&
+		(region->first - region->pktnum == ref->first) && (region->last - region->pktnum == ref->last) &&
+		(region->progress_total == total_pkts) ;
+
+	printf("%s : %s : pkt %"PRIu64" : %"PRIu64" pkts (%"PRIu64" .. %"PRIu64") sum 0x%016"PRIx64" : progress total %"PRIu64"\n",
+			ok ? "PASS" : "FAIL", name, region->pktnum,
+			region->count, region->first, region->last, region->sum, region->progress_total) ;
+	return ok ? 0 : 1 ;
 }
 
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct TS_cut_data hook_data ;
+struct TS_reader *tsreader ;
+struct TS_timing *timing ;
+struct test_region ref, region ;
+struct list_head cut_list ;
+uint64_t size_gb = 1024 ;
+uint64_t num_pkts = 20000 ;
+uint64_t total_pkts ;
+uint64_t reader_pkts ;
+uint64_t copies[3] ;
+uint64_t pktnum ;
+unsigned packet_size ;
+unsigned debug = 0 ;
+unsigned kept ;
+uint8_t *data ;
+ssize_t data_len ;
+char *source, *sparse ;
+int failed = 0 ;
+int file ;
+int c ;
+unsigned i ;
+
+	while ((c = getopt (argc, argv, "s:n:d:")) != -1)
+	{
+		switch (c)
+		{
+		case 's':
+			size_gb = strtoull(optarg, NULL, 10) ;
+			break;
+
+		case 'n':
+			num_pkts = strtoull(optarg, NULL, 10) ;
+			break;
+
+		case 'd':
+			debug = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	if (optind+1 >= argc)
+	{
+		printf("Error: Must specify source and sparse filenames\n") ;
+		abort() ;
+	}
+	source = argv[optind] ;
+	sparse = argv[optind+1] ;
+
+	tsreader = tsreader_new(source) ;
+	if (!tsreader)
+	{
+		printf("FAIL : unable to read %s\n", source) ;
+		return 1 ;
+	}
+	packet_size = tsreader->packet_size ;
+	if (num_pkts > tsreader->tsstate->total_pkts)
+		num_pkts = tsreader->tsstate->total_pkts ;
+	tsreader_free(tsreader) ;
+
+	// reference copy of the start of the source
+	memset(&ref, 0, sizeof(ref)) ;
+	test_read(source, 0, SEEK_SET, num_pkts, &ref) ;
+
+	// build the sparse file
+	total_pkts = (size_gb << 30) / packet_size ;
+	if (total_pkts < TEST_BOUNDARY_PKT + num_pkts)
+	{
+		printf("FAIL : %"PRIu64" GB is too small to cross packet %"PRIu64"\n", size_gb, (uint64_t)TEST_BOUNDARY_PKT) ;
+		return 1 ;
+	}
+	copies[0] = 0 ;
+	copies[1] = TEST_BOUNDARY_PKT - num_pkts/2 ;
+	copies[2] = total_pkts - num_pkts ;
+
+	data = (uint8_t *)malloc(num_pkts * packet_size) ;
+	file = open(source, O_RDONLY | O_LARGEFILE) ;
+	data_len = read(file, data, num_pkts * packet_size) ;
+	close(file) ;
+
+	if (data_len != (ssize_t)(num_pkts * packet_size))
+	{
+		printf("FAIL : unable to read %s\n", source) ;
+		return 1 ;
+	}
+
+	// not every file system can hold a file this size, even a sparse one (and a file size limit gives EFBIG rather
+	// than killing the test)
+	signal(SIGXFSZ, SIG_IGN) ;
+	file = open(sparse, O_CREAT | O_TRUNC | O_WRONLY | O_LARGEFILE, 0666) ;
+	if ((file < 0) || (ftruncate64(file, (off64_t)(total_pkts * packet_size)) != 0))
+	{
+		printf("SKIP : unable to create a %"PRIu64" GB sparse file %s : %s\n", size_gb, sparse, strerror(errno)) ;
+		if (file >= 0)
+		{
+			close(file) ;
+			unlink(sparse) ;
+		}
+		return 0 ;
+	}
+	for (i=0; i < 3; ++i)
+	{
+		if (pwrite64(file, data, data_len, (off64_t)(copies[i] * packet_size)) != data_len)
+		{
+			printf("FAIL : unable to write %s\n", sparse) ;
+			return 1 ;
+		}
+	}
+	close(file) ;
+	free(data) ;
+
+	printf("Sparse file %s : %"PRIu64" GB : %"PRIu64" pkts of %u bytes : copies of %"PRIu64" pkts\n",
+			sparse, size_gb, total_pkts, packet_size, num_pkts) ;
+
+	// total packets
+	tsreader = tsreader_new(sparse) ;
+	reader_pkts = tsreader->tsstate->total_pkts ;
+	tsreader_free(tsreader) ;
+	printf("%s : total pkts %"PRIu64" (expected %"PRIu64")\n", reader_pkts == total_pkts ? "PASS" : "FAIL",
+			reader_pkts, total_pkts) ;
+	if (reader_pkts != total_pkts)
+		++failed ;
+
+	// read each copy back
+	for (i=0; i < 3; ++i)
+	{
+		memset(&region, 0, sizeof(region)) ;
+		region.pktnum = copies[i] ;
+		test_read(sparse, (int64_t)copies[i], SEEK_SET, num_pkts, &region) ;
+		failed += test_check("SEEK_SET", &region, &ref, reader_pkts) ;
+	}
+
+	memset(&region, 0, sizeof(region)) ;
+	region.pktnum = copies[2] ;
+	test_read(sparse, -(int64_t)num_pkts, SEEK_END, num_pkts, &region) ;
+	failed += test_check("SEEK_END", &region, &ref, reader_pkts) ;
+
+	// fast timing windows are the first and last copies, so should match the start of the source
+	timing = ts_fast_timing(sparse, (unsigned)num_pkts, debug) ;
+	if (!timing || (timing->start_ts != ref.start_ts) || (timing->end_ts != ref.end_ts))
+	{
+		printf("FAIL : fast timing\n") ;
+		++failed ;
+	}
+	else
+	{
+		printf("PASS : fast timing : start %"PRId64" end %"PRId64"\n", timing->start_ts, timing->end_ts) ;
+	}
+	tstiming_free(timing) ;
+
+	// cut list either side of the boundary, and one entirely beyond it
+	INIT_LIST_HEAD(&cut_list) ;
+	add_cut(&cut_list, TEST_BOUNDARY_PKT - 100, TEST_BOUNDARY_PKT + 99) ;
+	add_cut(&cut_list, TEST_BOUNDARY_PKT + 1000, TEST_BOUNDARY_PKT + 1009) ;
+	memset(&hook_data, 0, sizeof(hook_data)) ;
+	hook_data.cut_list = &cut_list ;
+	hook_data.current_cut = UNSET_CUT_LIST ;
+	hook_data.prev_ok = 1 ;
+	hook_data.debug = debug ;
+
+	kept = 0 ;
+	for (pktnum=TEST_BOUNDARY_PKT - 2000; pktnum < TEST_BOUNDARY_PKT + 2000; ++pktnum)
+		kept += cut_pkt_ok(&hook_data, pktnum) ;
+	printf("%s : cut list : kept %u of 4000\n", kept == 4000 - 210 ? "PASS" : "FAIL", kept) ;
+	if (kept != 4000 - 210)
+		++failed ;
+	free_cut_list(&cut_list) ;
+
+	unlink(sparse) ;
+
+	printf("%s\n", failed ? "FAILED" : "ALL PASSED") ;
+	return failed ? 1 : 0 ;
+}
 
+#endif
@@ -9,10 +9,12 @@
 #define TS_CUT_H_
 
 #include "ts_skip.h"
+#include "ts_fanout.h"
 
 
 //---------------------------------------------------------------------------------------------------------
 int ts_cut(char *filename, char *ofilename, struct list_head *cuts_array, unsigned debug);
+int ts_cut_fanout(struct TS_fanout *fanout, char *ofilename, struct list_head *cuts_array, unsigned debug);
 
 
 #endif /* TS_CUT_H_ */
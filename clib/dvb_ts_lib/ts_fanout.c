@@ -0,0 +1,702 @@
+/*
+ * ts_fanout.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * Single pass fan-out. The file is read once and every buffer is passed to any number of consumers (e.g. cutting,
+ * splitting and indexing the same recording), each of which has its own TS_reader with its own hooks, user data and
+ * parse state. The consumers process the buffers in place with tsreader_data_add_shared() so the data is never copied.
+ *
+ * Normally the consumers are called one after the other in the reading thread. When 'threaded' is set, each consumer
+ * instead runs in its own thread, working through a ring of shared read-only buffers at its own pace. A buffer is only
+ * re-used once every consumer has finished with it, so a slow consumer only holds up the others once it is a whole
+ * ring behind.
+ */
+
+// VERSION = 1.00
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "ts_parse.h"
+#include "ts_readahead.h"
+#include "ts_fanout.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+// Pass a buffer to the consumer. Once it no longer wants data it is marked as done
+static void fanout_consume(struct TS_fanout_consumer *consumer, struct TS_fanout_buff *buff)
+{
+uint64_t start ;
+int status ;
+
+	if (consumer->done)
+		return ;
+
+	start = readahead_time_us() ;
+	status = tsreader_data_add_shared(consumer->tsreader, buff->data, (unsigned)buff->data_len) ;
+	consumer->parse_us += readahead_time_us() - start ;
+
+	if (status)
+		consumer->status = status ;
+	if (status || !consumer->tsreader->buff_state.running)
+		consumer->done = 1 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// All consumers called in turn from this thread
+static int fanout_run_serial(struct TS_fanout *fanout, unsigned buff_size)
+{
+struct TS_fanout_buff *buff = &fanout->buffs[0] ;
+unsigned active ;
+unsigned i ;
+
+	do
+	{
+		buff->data_len = readahead_fill(fanout->tsreader->file, buff->data, buff_size) ;
+		if (buff->data_len <= 0)
+			break ;
+		fanout->bytes_read += buff->data_len ;
+
+		active = 0 ;
+		for (i=0; i < fanout->num_consumers; ++i)
+		{
+			fanout_consume(&fanout->consumers[i], buff) ;
+			if (!fanout->consumers[i].done)
+				++active ;
+		}
+	} while (active) ;
+
+	return 0 ;
+}
+
+/* ----------------------------------------------------------------------- */
+static void *fanout_thread(void *arg)
+{
+struct TS_fanout_consumer *consumer = (struct TS_fanout_consumer *)arg ;
+struct TS_fanout *fanout = consumer->fanout ;
+struct TS_fanout_buff *buff ;
+uint64_t start ;
+unsigned done ;
+
+	for (;;)
+	{
+		// wait for the next buffer
+		pthread_mutex_lock(&fanout->lock) ;
+		start = readahead_time_us() ;
+		while (!fanout->eof && (consumer->next_buff == fanout->num_filled))
+			pthread_cond_wait(&fanout->filled, &fanout->lock) ;
+		consumer->wait_us += readahead_time_us() - start ;
+
+		if (consumer->next_buff == fanout->num_filled)
+		{
+			pthread_mutex_unlock(&fanout->lock) ;
+			break ;
+		}
+		buff = &fanout->buffs[consumer->next_buff % fanout->num_buffs] ;
+		pthread_mutex_unlock(&fanout->lock) ;
+
+		// buffer can't change until released
+		done = consumer->done ;
+		fanout_consume(consumer, buff) ;
+
+		// release it (a consumer that's done still releases the buffers already counted for it)
+		pthread_mutex_lock(&fanout->lock) ;
+		++consumer->next_buff ;
+		if (!done && consumer->done)
+			--fanout->active ;
+		if (--buff->refs == 0 || !fanout->active)
+			pthread_cond_signal(&fanout->freed) ;
+		pthread_mutex_unlock(&fanout->lock) ;
+	}
+
+	return NULL ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Each consumer in its own thread, this thread just reads
+static int fanout_run_threaded(struct TS_fanout *fanout, unsigned buff_size)
+{
+struct TS_fanout_buff *buff ;
+unsigned num_threads ;
+unsigned active ;
+uint64_t start ;
+int status ;
+unsigned i ;
+
+	status = 0 ;
+	fanout->num_filled = 0 ;
+	fanout->eof = 0 ;
+	fanout->active = fanout->num_consumers ;
+
+	for (num_threads=0; num_threads < fanout->num_consumers; ++num_threads)
+	{
+		fanout->consumers[num_threads].next_buff = 0 ;
+		if (pthread_create(&fanout->consumers[num_threads].thread, NULL, fanout_thread, &fanout->consumers[num_threads]) != 0)
+		{
+			SET_DVB_ERROR(ERR_MALLOC) ;
+			status = ERR_MALLOC ;
+			break ;
+		}
+	}
+
+	while (!status)
+	{
+		// wait for every consumer to finish with the next buffer
+		pthread_mutex_lock(&fanout->lock) ;
+		buff = &fanout->buffs[fanout->num_filled % fanout->num_buffs] ;
+		start = readahead_time_us() ;
+		while (fanout->active && buff->refs)
+			pthread_cond_wait(&fanout->freed, &fanout->lock) ;
+		fanout->read_wait_us += readahead_time_us() - start ;
+		active = fanout->active ;
+		pthread_mutex_unlock(&fanout->lock) ;
+
+		// no point reading any more
+		if (!active)
+			break ;
+
+		// buffer is owned by this thread until it's counted as filled
+		buff->data_len = readahead_fill(fanout->tsreader->file, buff->data, buff_size) ;
+		if (buff->data_len <= 0)
+			break ;
+		fanout->bytes_read += buff->data_len ;
+
+		pthread_mutex_lock(&fanout->lock) ;
+		buff->refs = fanout->num_consumers ;
+		++fanout->num_filled ;
+		pthread_cond_broadcast(&fanout->filled) ;
+		pthread_mutex_unlock(&fanout->lock) ;
+	}
+
+	// let the consumers finish what's left
+	pthread_mutex_lock(&fanout->lock) ;
+	fanout->eof = 1 ;
+	pthread_cond_broadcast(&fanout->filled) ;
+	pthread_mutex_unlock(&fanout->lock) ;
+
+	for (i=0; i < num_threads; ++i)
+		pthread_join(fanout->consumers[i].thread, NULL) ;
+
+	return status ;
+}
+
+/* ----------------------------------------------------------------------- */
+static int fanout_end(struct TS_fanout_consumer *consumer)
+{
+int status = consumer->status ;
+
+	if (!consumer->ended)
+	{
+		consumer->ended = 1 ;
+		if (consumer->end_hook)
+		{
+			status = consumer->end_hook(consumer->tsreader, consumer->end_data) ;
+			if (!consumer->status)
+				consumer->status = status ;
+		}
+	}
+	return consumer->status ;
+}
+
+/*=============================================================================================*/
+// PUBLIC
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+// Open the file ready to add the consumers. Returns NULL on error
+struct TS_fanout *tsfanout_new(char *filename)
+{
+struct TS_fanout *fanout ;
+
+	fanout = (struct TS_fanout *)malloc(sizeof(struct TS_fanout)) ;
+	if (!fanout)
+	{
+		SET_DVB_ERROR(ERR_MALLOC) ;
+		return NULL ;
+	}
+	CLEAR_MEM(fanout) ;
+
+	fanout->tsreader = tsreader_new(filename) ;
+	if (!fanout->tsreader)
+	{
+		free(fanout) ;
+		return NULL ;
+	}
+	fanout->filename = strdup(filename) ;
+
+	pthread_mutex_init(&fanout->lock, NULL) ;
+	pthread_cond_init(&fanout->filled, NULL) ;
+	pthread_cond_init(&fanout->freed, NULL) ;
+
+	return fanout ;
+}
+
+/* ----------------------------------------------------------------------- */
+void tsfanout_free(struct TS_fanout *fanout)
+{
+unsigned i ;
+
+	if (fanout)
+	{
+		for (i=0; i < fanout->num_consumers; ++i)
+		{
+			fanout_end(&fanout->consumers[i]) ;
+			tsreader_free(fanout->consumers[i].tsreader) ;
+		}
+
+		pthread_cond_destroy(&fanout->freed) ;
+		pthread_cond_destroy(&fanout->filled) ;
+		pthread_mutex_destroy(&fanout->lock) ;
+
+		tsreader_free(fanout->tsreader) ;
+		free(fanout->filename) ;
+		free(fanout) ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Add a consumer. Set the hooks (and any other settings) on the returned reader as normal; its user_data is set to
+// the user_data given here which is also passed to the (optional) end_hook. Returns NULL on error
+struct TS_reader *tsfanout_add(struct TS_fanout *fanout, tsfanout_end_hook end_hook, void *user_data)
+{
+struct TS_fanout_consumer *consumer ;
+
+	if (fanout->num_consumers >= TS_FANOUT_MAX)
+	{
+		SET_DVB_ERROR(ERR_OVERFLOW) ;
+		return NULL ;
+	}
+
+	consumer = &fanout->consumers[fanout->num_consumers] ;
+	CLEAR_MEM(consumer) ;
+
+	consumer->tsreader = tsreader_new(NULL) ;
+	if (!consumer->tsreader)
+		return NULL ;
+	++fanout->num_consumers ;
+
+	consumer->fanout = fanout ;
+	consumer->end_hook = end_hook ;
+	consumer->end_data = user_data ;
+	consumer->tsreader->user_data = user_data ;
+	consumer->tsreader->packet_size = fanout->tsreader->packet_size ;
+
+	return consumer->tsreader ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Read the file (from the position set on fanout->tsreader) passing the data to all of the consumers. Returns 0 on
+// success, otherwise the first error from any of the consumers
+int tsfanout_run(struct TS_fanout *fanout)
+{
+struct TS_reader *tsreader = fanout->tsreader ;
+struct TS_fanout_consumer *consumer ;
+unsigned buff_size ;
+unsigned num_buffs ;
+int status ;
+unsigned i ;
+
+	CHECK_TS_READER(tsreader) ;
+
+	num_buffs = fanout->num_buffs ? fanout->num_buffs : TS_FANOUT_BUFFS ;
+	if (num_buffs < 2)
+		num_buffs = 2 ;
+	buff_size = fanout->buff_size ? fanout->buff_size : TS_FANOUT_SIZE ;
+	buff_size -= buff_size % tsreader->packet_size ;
+	if (buff_size < tsreader->packet_size)
+		buff_size = tsreader->packet_size ;
+
+	// all consumers see the same packets as the source reader would
+	for (i=0; i < fanout->num_consumers; ++i)
+	{
+		consumer = &fanout->consumers[i] ;
+		consumer->tsreader->packet_size = tsreader->packet_size ;
+		consumer->tsreader->tsstate->total_pkts = tsreader->tsstate->total_pkts ;
+		consumer->tsreader->tsstate->pidinfo.pktnum = tsreader->tsstate->pidinfo.pktnum ;
+		if (!consumer->tsreader->num_pkts)
+			consumer->tsreader->num_pkts = tsreader->num_pkts ;
+
+		consumer->status = tsreader_data_start(consumer->tsreader) ;
+		consumer->done = consumer->status ? 1 : 0 ;
+	}
+
+	// only one buffer needed unless threaded
+	if (!fanout->threaded)
+		num_buffs = 1 ;
+	fanout->num_buffs = num_buffs ;
+	fanout->buffs = (struct TS_fanout_buff *)calloc(num_buffs, sizeof(struct TS_fanout_buff)) ;
+	status = fanout->buffs ? 0 : ERR_MALLOC ;
+	for (i=0; !status && (i < num_buffs); ++i)
+	{
+		fanout->buffs[i].data = (uint8_t *)malloc(buff_size) ;
+		if (!fanout->buffs[i].data)
+			status = ERR_MALLOC ;
+	}
+
+	tsparse_dbg_prt(10, ("TS: tsfanout_run() consumers=%u threaded=%u buffs=%u size=%u\n",
+			fanout->num_consumers, fanout->threaded, num_buffs, buff_size)) ;
+
+	if (!status)
+	{
+		if (fanout->threaded)
+			status = fanout_run_threaded(fanout, buff_size) ;
+		else
+			status = fanout_run_serial(fanout, buff_size) ;
+	}
+
+	if (fanout->buffs)
+	{
+		for (i=0; i < num_buffs; ++i)
+			free(fanout->buffs[i].data) ;
+		free(fanout->buffs) ;
+		fanout->buffs = NULL ;
+	}
+
+	if (status)
+	{
+		SET_TSREADER_ERROR(tsreader, status) ;
+	}
+
+	// finish off each consumer
+	for (i=0; i < fanout->num_consumers; ++i)
+	{
+		consumer = &fanout->consumers[i] ;
+		if (!consumer->status)
+			consumer->status = tsreader_data_end(consumer->tsreader) ;
+		fanout_end(consumer) ;
+
+		tsparse_dbg_prt(10, ("TS: fanout consumer %u status=%d wait=%"PRIu64" us, parse=%"PRIu64" us\n",
+				i, consumer->status, consumer->wait_us, consumer->parse_us)) ;
+
+		if (!status)
+			status = consumer->status ;
+	}
+
+	tsparse_dbg_prt(10, ("TS: fanout read %"PRIu64" bytes, read wait=%"PRIu64" us\n", fanout->bytes_read, fanout->read_wait_us)) ;
+
+	return status ;
+}
+
+//============================================================================================
+// Test: cuts, splits and indexes the file in a single pass (with and without threads) alongside a checksum
+// consumer, and checks the results are the same as running ts_cut(), ts_split() and tsindex_build() separately
+// and a plain ts_parse(). The threaded pass also has a slow consumer and one that stops early.
+//
+//   ts_fanout [-d debug] [-s slow_us] file.ts outdir
+//
+#ifdef TEST_MAIN
+
+#include <sys/time.h>
+#include <sys/stat.h>
+
+#include "ts_cut.h"
+#include "ts_split.h"
+#include "ts_index.h"
+
+#define TEST_STOP_PKTS		1000
+
+struct test_sum {
+	uint64_t	count ;
+	uint64_t	sum ;
+	unsigned	slow_us ;
+};
+
+//---------------------------------------------------------------------------------------------------------------------------
+static double test_time(void)
+{
+struct timeval tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1e6 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_ts_hook(struct TS_pidinfo *pidinfo, uint8_t *packet, unsigned packet_len, void *user_data)
+{
+struct test_sum *sum = (struct test_sum *)user_data ;
+unsigned i ;
+
+	++sum->count ;
+	sum->sum += pidinfo->pktnum * 31 ;
+	for (i=0; i < packet_len; i += 4)
+		sum->sum += (uint64_t)packet[i] << (i & 7) ;
+
+	if (sum->slow_us && !(sum->count % 1024))
+		usleep(sum->slow_us) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static struct list_head *test_cuts(struct list_head *cuts, uint64_t total_pkts)
+{
+	INIT_LIST_HEAD(cuts) ;
+	add_cut(cuts, total_pkts / 10, total_pkts / 5) ;
+	add_cut(cuts, total_pkts / 2, (total_pkts * 3) / 5) ;
+	return cuts ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Returns 0 if the files are the same
+static int test_cmp(const char *name_a, const char *name_b)
+{
+FILE *fa, *fb ;
+char ba[65536], bb[65536] ;
+size_t na, nb ;
+int diff = 1 ;
+
+	fa = fopen(name_a, "rb") ;
+	fb = fopen(name_b, "rb") ;
+	if (fa && fb)
+	{
+		do
+		{
+			na = fread(ba, 1, sizeof(ba), fa) ;
+			nb = fread(bb, 1, sizeof(bb), fb) ;
+			diff = (na != nb) || memcmp(ba, bb, na) ;
+		} while (!diff && na) ;
+	}
+	if (fa) fclose(fa) ;
+	if (fb) fclose(fb) ;
+	return diff ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Compare the split files. Returns the number of differences
+static int test_cmp_split(const char *dir, const char *name_a, const char *name_b)
+{
+char fa[1024], fb[1024] ;
+struct stat st ;
+unsigned i ;
+int diffs = 0 ;
+
+	for (i=1; ; ++i)
+	{
+		sprintf(fa, "%s/%s-%04u.ts", dir, name_a, i) ;
+		sprintf(fb, "%s/%s-%04u.ts", dir, name_b, i) ;
+		if (stat(fa, &st) != 0)
+		{
+			diffs += (stat(fb, &st) == 0) ;
+			break ;
+		}
+		diffs += test_cmp(fa, fb) ;
+		unlink(fa) ;
+		unlink(fb) ;
+	}
+	return diffs + (i == 1) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Everything in one pass. Returns the number of failures
+static int test_fanout(char *filename, char *dir, unsigned threaded, unsigned slow_us, struct test_sum *ref,
+		struct TS_index *ref_index, uint64_t total_pkts, unsigned debug)
+{
+struct TS_fanout *fanout ;
+struct TS_reader *tsreader ;
+struct TS_index *index ;
+struct test_sum sum, slow, stop ;
+struct list_head cut_list, split_list ;
+char ofname[1024], ref_name[1024] ;
+const char *mode = threaded ? "threaded" : "serial" ;
+double start ;
+int status ;
+int failed = 0 ;
+unsigned i ;
+
+	memset(&sum, 0, sizeof(sum)) ;
+	memset(&slow, 0, sizeof(slow)) ;
+	memset(&stop, 0, sizeof(stop)) ;
+	slow.slow_us = slow_us ;
+
+	start = test_time() ;
+
+	fanout = tsfanout_new(filename) ;
+	fanout->threaded = threaded ;
+	fanout->tsreader->debug = debug ;
+
+	tsreader = tsfanout_add(fanout, NULL, &sum) ;
+	tsreader->ts_hook = test_ts_hook ;
+
+	sprintf(ofname, "%s/fan-cut.ts", dir) ;
+	ts_cut_fanout(fanout, ofname, test_cuts(&cut_list, total_pkts), debug) ;
+	sprintf(ofname, "%s/fan-split.ts", dir) ;
+	ts_split_fanout(fanout, ofname, test_cuts(&split_list, total_pkts), debug) ;
+	index = tsindex_fanout(fanout, debug) ;
+
+	if (threaded)
+	{
+		tsreader = tsfanout_add(fanout, NULL, &slow) ;
+		tsreader->ts_hook = test_ts_hook ;
+
+		tsreader = tsfanout_add(fanout, NULL, &stop) ;
+		tsreader->ts_hook = test_ts_hook ;
+		tsreader->num_pkts = TEST_STOP_PKTS ;
+	}
+
+	status = tsfanout_run(fanout) ;
+
+	printf("%s : %.3f s : read wait %.3f s", mode, test_time() - start, fanout->read_wait_us / 1e6) ;
+	for (i=0; i < fanout->num_consumers; ++i)
+		printf(" : [%u] wait %.3f parse %.3f", i, fanout->consumers[i].wait_us / 1e6, fanout->consumers[i].parse_us / 1e6) ;
+	printf("\n") ;
+
+	tsfanout_free(fanout) ;
+
+	if (status)
+	{
+		printf("FAIL : %s : error %d\n", mode, status) ;
+		++failed ;
+	}
+	if ((sum.count != ref->count) || (sum.sum != ref->sum))
+	{
+		printf("FAIL : %s : checksum %"PRIu64" pkts 0x%016"PRIx64" expected %"PRIu64" pkts 0x%016"PRIx64"\n",
+				mode, sum.count, sum.sum, ref->count, ref->sum) ;
+		++failed ;
+	}
+	if (threaded && ((slow.count != ref->count) || (slow.sum != ref->sum)))
+	{
+		printf("FAIL : %s : slow consumer checksum differs\n", mode) ;
+		++failed ;
+	}
+	if (threaded && (stop.count > TEST_STOP_PKTS))
+	{
+		printf("FAIL : %s : stopped consumer saw %"PRIu64" pkts\n", mode, stop.count) ;
+		++failed ;
+	}
+
+	sprintf(ofname, "%s/fan-cut.ts", dir) ;
+	sprintf(ref_name, "%s/sep-cut.ts", dir) ;
+	if (test_cmp(ofname, ref_name))
+	{
+		printf("FAIL : %s : cut file differs\n", mode) ;
+		++failed ;
+	}
+	unlink(ofname) ;
+
+	if (test_cmp_split(dir, "fan-split", "sep-split"))
+	{
+		printf("FAIL : %s : split files differ\n", mode) ;
+		++failed ;
+	}
+
+	if (!index || (index->num_entries != ref_index->num_entries) ||
+			memcmp(index->entries, ref_index->entries, index->num_entries * sizeof(struct TS_index_entry)))
+	{
+		printf("FAIL : %s : index differs\n", mode) ;
+		++failed ;
+	}
+	tsindex_free(index) ;
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct TS_reader *tsreader ;
+struct TS_index *ref_index ;
+struct test_sum ref ;
+struct list_head cut_list, split_list ;
+char ofname[1024] ;
+char *filename, *dir ;
+uint64_t total_pkts ;
+unsigned debug = 0 ;
+unsigned slow_us = 200 ;
+int failed = 0 ;
+double start ;
+int c ;
+
+	while ((c = getopt (argc, argv, "d:s:")) != -1)
+	{
+		switch (c)
+		{
+		case 'd':
+			debug = atoi(optarg) ;
+			break;
+
+		case 's':
+			slow_us = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	if (optind+1 >= argc)
+	{
+		printf("Error: Must specify input filename and output directory\n") ;
+		abort() ;
+	}
+	filename = argv[optind] ;
+	dir = argv[optind+1] ;
+
+	// reference checksum
+	memset(&ref, 0, sizeof(ref)) ;
+	start = test_time() ;
+	tsreader = tsreader_new(filename) ;
+	if (!tsreader)
+	{
+		printf("FAIL : unable to read %s\n", filename) ;
+		return 1 ;
+	}
+	total_pkts = tsreader->tsstate->total_pkts ;
+	tsreader->ts_hook = test_ts_hook ;
+	tsreader->user_data = &ref ;
+	ts_parse(tsreader) ;
+	tsreader_free(tsreader) ;
+	printf("parse : %.3f s : %"PRIu64" pkts\n", test_time() - start, ref.count) ;
+
+	// each on its own
+	start = test_time() ;
+	sprintf(ofname, "%s/sep-cut.ts", dir) ;
+	failed += ts_cut(filename, ofname, test_cuts(&cut_list, total_pkts), debug) != 0 ;
+	sprintf(ofname, "%s/sep-split.ts", dir) ;
+	failed += ts_split(filename, ofname, test_cuts(&split_list, total_pkts), debug) != 0 ;
+	ref_index = tsindex_build(filename, debug) ;
+	failed += !ref_index ;
+	printf("separate : %.3f s\n", test_time() - start) ;
+	if (failed)
+	{
+		printf("FAIL : separate runs\n") ;
+		return 1 ;
+	}
+
+	// all at once
+	failed += test_fanout(filename, dir, 0, slow_us, &ref, ref_index, total_pkts, debug) ;
+
+	sprintf(ofname, "%s/sep-split.ts", dir) ;
+	ts_split(filename, ofname, test_cuts(&split_list, total_pkts), debug) ;
+	failed += test_fanout(filename, dir, 1, slow_us, &ref, ref_index, total_pkts, debug) ;
+
+	sprintf(ofname, "%s/sep-cut.ts", dir) ;
+	unlink(ofname) ;
+	tsindex_free(ref_index) ;
+
+	printf("%s\n", failed ? "FAIL" : "PASS") ;
+
+	return failed ? 1 : 0 ;
+}
+
+#endif
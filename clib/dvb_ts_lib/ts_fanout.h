@@ -0,0 +1,111 @@
+/*
+ * ts_fanout.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef TS_FANOUT_H_
+#define TS_FANOUT_H_
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "ts_structs.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+// maximum number of consumers of one pass
+#define TS_FANOUT_MAX			8
+
+// default ring of buffers shared by the consumers (size is rounded down to a whole number of packets)
+#define TS_FANOUT_BUFFS			8
+#define TS_FANOUT_SIZE			(2048 * TS_PACKET_LEN)
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+// Called once the pass has finished (or from tsfanout_free() if it was never run) so that the consumer can tidy up.
+// Returns the consumer's final status
+typedef int (*tsfanout_end_hook)(struct TS_reader *, void *) ;
+
+struct TS_fanout ;
+
+// One subscriber to the pass. Each has its own reader (no file) with its own hooks, user data and parse state
+struct TS_fanout_consumer {
+	struct TS_fanout	*fanout ;
+	struct TS_reader	*tsreader ;
+
+	tsfanout_end_hook	end_hook ;
+	void				*end_data ;
+	unsigned			ended ;
+
+	int					status ;
+	unsigned			done ;			// no longer wants data (stopped, reached its end, or error)
+
+	// worker thread
+	pthread_t			thread ;
+	uint64_t			next_buff ;		// sequence number of the next buffer to process
+
+	// time (in usecs) spent waiting for data and parsing
+	uint64_t			wait_us ;
+	uint64_t			parse_us ;
+};
+
+// A shared read-only buffer
+struct TS_fanout_buff {
+	uint8_t				*data ;
+	int					data_len ;
+	unsigned			refs ;			// consumers yet to finish with it
+};
+
+// A single read of a file passed to any number of consumers
+struct TS_fanout {
+	// reader opened on the file. Use tsreader_setpos() on this to select the packets read; it has no hooks
+	struct TS_reader			*tsreader ;
+	char						*filename ;
+
+	// user settings
+	unsigned					threaded ;		// set to run each consumer in its own thread
+	unsigned					num_buffs ;		// number of shared buffers (0 = use default)
+	unsigned					buff_size ;		// size of each buffer (0 = use default)
+
+	unsigned					num_consumers ;
+	struct TS_fanout_consumer	consumers[TS_FANOUT_MAX] ;
+
+	// ring (protected by lock)
+	struct TS_fanout_buff		*buffs ;
+	uint64_t					num_filled ;	// sequence number of the next buffer to fill
+	unsigned					active ;		// consumers still wanting data
+	unsigned					eof ;
+
+	pthread_mutex_t				lock ;
+	pthread_cond_t				filled ;
+	pthread_cond_t				freed ;
+
+	// stats
+	uint64_t					bytes_read ;
+	uint64_t					read_wait_us ;	// time the reader was held up by the slowest consumer
+};
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+struct TS_fanout *tsfanout_new(char *filename) ;
+void tsfanout_free(struct TS_fanout *fanout) ;
+
+struct TS_reader *tsfanout_add(struct TS_fanout *fanout, tsfanout_end_hook end_hook, void *user_data) ;
+int tsfanout_run(struct TS_fanout *fanout) ;
+
+#endif /* TS_FANOUT_H_ */
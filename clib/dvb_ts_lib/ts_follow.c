@@ -0,0 +1,434 @@
+/*
+ * ts_follow.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * Following a file that is still being written (e.g. by write_stream_demux()). Instead of stopping at the
+ * end of the file the reader waits for it to grow, using inotify when it's available or polling otherwise.
+ * The writer is treated as finished when a "done" sentinel file appears or when no new data has arrived for
+ * a timeout period.
+ */
+
+// VERSION = 1.00
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <poll.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#include "ts_follow.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+#define FOLLOW_EVENT_BUFFSIZE	4096
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+uint64_t follow_time_us(void)
+{
+struct timespec ts ;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts) ;
+	return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)(ts.tv_nsec / 1000) ;
+}
+
+/* ----------------------------------------------------------------------- */
+static uint64_t follow_wall_us(void)
+{
+struct timespec ts ;
+
+	clock_gettime(CLOCK_REALTIME, &ts) ;
+	return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)(ts.tv_nsec / 1000) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Time (usecs) since the data just read was written, or 0 on error. The file modification time is often only as
+// accurate as a kernel tick, so the time of the inotify event is used instead when there is one (or, when polling,
+// the time the reader last reached the end of the file if that's later - the data can't have been written before then)
+uint64_t follow_latency_us(struct TS_follow *follow)
+{
+struct stat64 file_stat ;
+uint64_t now, written ;
+
+	if (fstat64(follow->file, &file_stat) != 0)
+		return 0 ;
+	now = follow_wall_us() ;
+
+	written = (uint64_t)file_stat.st_mtim.tv_sec * 1000000ULL + (uint64_t)(file_stat.st_mtim.tv_nsec / 1000) ;
+	if (written < follow->write_wall_us)
+		written = follow->write_wall_us ;
+	return now > written ? now - written : 0 ;
+}
+
+/* ----------------------------------------------------------------------- */
+static int64_t follow_size(int file)
+{
+struct stat64 file_stat ;
+
+	if (fstat64(file, &file_stat) != 0)
+		return -1 ;
+	return (int64_t)file_stat.st_size ;
+}
+
+/* ----------------------------------------------------------------------- */
+struct TS_follow *follow_new(int file, const char *done_file, unsigned timeout_ms)
+{
+struct TS_follow *follow ;
+char path[64] ;
+
+	follow = (struct TS_follow *)calloc(1, sizeof(struct TS_follow)) ;
+	if (!follow)
+		return NULL ;
+
+	follow->file = file ;
+	follow->done_file = done_file ;
+	follow->timeout_ms = timeout_ms ;
+	follow->last_data_us = follow_time_us() ;
+	follow->last_size = follow_size(file) ;
+
+	// watch the open file (via /proc so that the file name isn't needed) - fall back to polling if not possible
+	follow->notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC) ;
+	if (follow->notify >= 0)
+	{
+		sprintf(path, "/proc/self/fd/%d", file) ;
+		if (inotify_add_watch(follow->notify, path, IN_MODIFY | IN_CLOSE_WRITE) < 0)
+		{
+			close(follow->notify) ;
+			follow->notify = -1 ;
+		}
+	}
+
+	return follow ;
+}
+
+/* ----------------------------------------------------------------------- */
+void follow_free(struct TS_follow **follow)
+{
+	if (*follow)
+	{
+		if ((*follow)->notify >= 0)
+			close((*follow)->notify) ;
+		free(*follow) ;
+		*follow = NULL ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Called at the end of the file. Waits (for at most TS_FOLLOW_POLL_MS) for the file to be written to. Returns
+// non-zero if the file should be read again, or 0 once the writer has finished and all of its data has been read.
+int follow_wait(struct TS_follow *follow)
+{
+struct pollfd pfd ;
+uint8_t events[FOLLOW_EVENT_BUFFSIZE] ;
+uint64_t now ;
+int64_t size ;
+
+	// the sentinel was seen before the last read, so everything has now been read
+	if (follow->done)
+		return 0 ;
+	follow->write_wall_us = follow_wall_us() ;
+
+	// file has grown since the last wait
+	now = follow_time_us() ;
+	size = follow_size(follow->file) ;
+	if (size != follow->last_size)
+	{
+		follow->last_size = size ;
+		follow->last_data_us = now ;
+		return 1 ;
+	}
+
+	// writer finished - read once more to pick up anything written before the sentinel was created
+	if (follow->done_file && (access(follow->done_file, F_OK) == 0))
+	{
+		follow->done = 1 ;
+		return 1 ;
+	}
+	if (follow->timeout_ms && (now - follow->last_data_us >= (uint64_t)follow->timeout_ms * 1000))
+		return 0 ;
+
+	// wait for the next write
+	if (follow->notify >= 0)
+	{
+		pfd.fd = follow->notify ;
+		pfd.events = POLLIN ;
+		if (poll(&pfd, 1, TS_FOLLOW_POLL_MS) > 0)
+		{
+			follow->write_wall_us = follow_wall_us() ;
+			while (read(follow->notify, events, sizeof(events)) > 0)
+				;
+		}
+	}
+	else
+	{
+		usleep(TS_FOLLOW_POLL_MS * 1000) ;
+	}
+
+	return 1 ;
+}
+
+
+//============================================================================================
+// Test: a writer thread copies the source file into a new file a block at a time (blocks deliberately end
+// part way through a packet), while the reader follows it from when the file is still empty. Checks that every
+// packet is seen exactly as it is when parsing the complete file, and reports the delay from each write to the
+// packets reaching the hook.
+//
+//   ts_follow [-b block_bytes] [-i interval_ms] [-t timeout_ms] [-d debug] source.ts follow.ts
+//
+#ifdef TEST_MAIN
+
+#include <pthread.h>
+#include "ts_parse.h"
+
+struct test_writer {
+	char		*source ;
+	char		*dest ;
+	char		*done_file ;		// created after the last write (NULL = don't create)
+	unsigned	block ;
+	unsigned	interval_ms ;
+
+	uint64_t	*write_us ;			// time each block was written
+	unsigned	packet_size ;
+};
+
+struct test_count {
+	uint64_t	pkts ;
+	uint64_t	sum ;
+
+	// measured delay from each write to its packets reaching the hook
+	struct test_writer	*writer ;
+	uint64_t	latency_pkts ;
+	uint64_t	latency_total_us ;
+	uint64_t	latency_max_us ;
+};
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void *test_writer_thread(void *arg)
+{
+struct test_writer *writer = (struct test_writer *)arg ;
+uint8_t *buff ;
+unsigned block ;
+int in, out ;
+ssize_t len ;
+
+	buff = (uint8_t *)malloc(writer->block) ;
+	in = open(writer->source, O_RDONLY) ;
+	out = open(writer->dest, O_WRONLY | O_APPEND) ;
+
+	for (block=0; (len = read(in, buff, writer->block)) > 0; ++block)
+	{
+		usleep(writer->interval_ms * 1000) ;
+		writer->write_us[block] = follow_time_us() ;
+		if (write(out, buff, len) != len)
+			break ;
+	}
+
+	close(out) ;
+	close(in) ;
+	free(buff) ;
+
+	if (writer->done_file)
+		close(open(writer->done_file, O_CREAT | O_WRONLY, 0666)) ;
+
+	return NULL ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static off_t test_file_size(const char *filename)
+{
+struct stat file_stat ;
+
+	if (stat(filename, &file_stat) != 0)
+		return 0 ;
+	return file_stat.st_size ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_ts_hook(struct TS_pidinfo *pidinfo, uint8_t *packet, unsigned packet_len, void *user_data)
+{
+struct test_count *count = (struct test_count *)user_data ;
+uint64_t latency ;
+unsigned i ;
+
+	// block containing the end of this packet
+	if (count->writer)
+	{
+		latency = follow_time_us() - count->writer->write_us[((pidinfo->pktnum+1) * count->writer->packet_size - 1) / count->writer->block] ;
+		++count->latency_pkts ;
+		count->latency_total_us += latency ;
+		if (latency > count->latency_max_us)
+			count->latency_max_us = latency ;
+	}
+
+	++count->pkts ;
+	count->sum += pidinfo->pktnum * 31 ;
+	for (i=0; i < packet_len; ++i)
+		count->sum += (uint64_t)packet[i] << (i & 7) ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Follow the file while the writer creates it. Returns non-zero on failure
+static int test_follow(const char *name, struct test_writer *writer, unsigned timeout_ms, struct test_count *ref, unsigned debug)
+{
+struct TS_reader *tsreader ;
+struct test_count count ;
+pthread_t thread ;
+uint64_t start ;
+double secs ;
+int status ;
+int ok ;
+
+	unlink(writer->dest) ;
+	if (writer->done_file)
+		unlink(writer->done_file) ;
+	close(open(writer->dest, O_CREAT | O_TRUNC | O_WRONLY, 0666)) ;
+
+	// nothing written yet - only a follow reader can be opened
+	tsreader = tsreader_new(writer->dest) ;
+	if (tsreader || (dvb_error_code != ERR_FILE_ZERO))
+	{
+		printf("FAIL : %s : tsreader_new() opened empty file %s\n", name, writer->dest) ;
+		tsreader_free(tsreader) ;
+		return 1 ;
+	}
+	tsreader = tsreader_new_follow(writer->dest) ;
+	if (!tsreader)
+	{
+		printf("FAIL : %s : unable to open %s\n", name, writer->dest) ;
+		return 1 ;
+	}
+	memset(&count, 0, sizeof(count)) ;
+	count.writer = writer ;
+	tsreader->debug = debug ;
+	tsreader->ts_hook = test_ts_hook ;
+	tsreader->user_data = &count ;
+	tsreader->follow_done = writer->done_file ;
+	tsreader->follow_timeout = timeout_ms ;
+
+	start = follow_time_us() ;
+	pthread_create(&thread, NULL, test_writer_thread, writer) ;
+	status = ts_parse(tsreader) ;
+	secs = (double)(follow_time_us() - start) / 1e6 ;
+	pthread_join(thread, NULL) ;
+
+	ok = !status && (count.pkts == ref->pkts) && (count.sum == ref->sum) && (tsreader->packet_size == writer->packet_size) ;
+	printf("%s : %s : %"PRIu64" pkts (expected %"PRIu64") in %.3f s : %"PRIu64" waits\n",
+			ok ? "PASS" : "FAIL", name, count.pkts, ref->pkts, secs, tsreader->follow_stats.waits) ;
+	printf("  write to hook : mean %"PRIu64" us max %"PRIu64" us : reader estimate mean %"PRIu64" us max %"PRIu64" us\n",
+			count.latency_total_us / count.latency_pkts, count.latency_max_us,
+			tsreader->follow_stats.latency_samples ? tsreader->follow_stats.latency_total_us / tsreader->follow_stats.latency_samples : 0,
+			tsreader->follow_stats.latency_max_us) ;
+
+	tsreader_free(tsreader) ;
+	unlink(writer->dest) ;
+	if (writer->done_file)
+		unlink(writer->done_file) ;
+
+	return ok ? 0 : 1 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct TS_reader *tsreader ;
+struct test_writer writer ;
+struct test_count ref ;
+char done_file[256] ;
+unsigned timeout_ms = 500 ;
+unsigned debug = 0 ;
+int failed = 0 ;
+int c ;
+
+	memset(&writer, 0, sizeof(writer)) ;
+	writer.block = 100000 ;
+	writer.interval_ms = 5 ;
+
+	while ((c = getopt (argc, argv, "b:i:t:d:")) != -1)
+	{
+		switch (c)
+		{
+		case 'b':
+			writer.block = atoi(optarg) ;
+			break;
+
+		case 'i':
+			writer.interval_ms = atoi(optarg) ;
+			break;
+
+		case 't':
+			timeout_ms = atoi(optarg) ;
+			break;
+
+		case 'd':
+			debug = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	if (optind+1 >= argc)
+	{
+		printf("Error: Must specify source and follow filenames\n") ;
+		abort() ;
+	}
+	writer.source = argv[optind] ;
+	writer.dest = argv[optind+1] ;
+	sprintf(done_file, "%s.done", writer.dest) ;
+
+	writer.write_us = (uint64_t *)calloc(test_file_size(writer.source) / writer.block + 1, sizeof(uint64_t)) ;
+
+	// reference from the complete file
+	memset(&ref, 0, sizeof(ref)) ;
+	tsreader = tsreader_new(writer.source) ;
+	if (!tsreader)
+	{
+		printf("FAIL : unable to read %s\n", writer.source) ;
+		return 1 ;
+	}
+	tsreader->ts_hook = test_ts_hook ;
+	tsreader->user_data = &ref ;
+	tsreader->tsstate->total_pkts = 0 ;		// read up to the end of the file, as follow mode does
+	ts_parse(tsreader) ;
+	writer.packet_size = tsreader->packet_size ;
+	tsreader_free(tsreader) ;
+
+	// stopped by the sentinel file
+	writer.done_file = done_file ;
+	failed += test_follow("sentinel", &writer, 0, &ref, debug) ;
+
+	// stopped by the timeout
+	writer.done_file = NULL ;
+	failed += test_follow("timeout", &writer, timeout_ms, &ref, debug) ;
+
+	free(writer.write_us) ;
+
+	printf("%s\n", failed ? "FAILED" : "ALL PASSED") ;
+	return failed ? 1 : 0 ;
+}
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * ts_follow.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef TS_FOLLOW_H_
+#define TS_FOLLOW_H_
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+#include <inttypes.h>
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+// Longest wait (msecs) before re-checking for the writer having finished. Also the poll period when inotify
+// isn't available
+#define TS_FOLLOW_POLL_MS		100
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+// Waits at the end of a file that is still being written
+struct TS_follow {
+	int					file ;
+	int					notify ;			// inotify instance watching the file (-1 = polling)
+
+	const char			*done_file ;		// writer has finished once this exists (NULL = not used)
+	unsigned			timeout_ms ;		// writer has finished once there's been no new data for this long (0 = not used)
+
+	unsigned			done ;				// writer finished - stop at the next end of file
+	uint64_t			last_data_us ;		// when new data was last seen (monotonic)
+	uint64_t			write_wall_us ;		// earliest time the next data can have been written (wall clock)
+	int64_t				last_size ;
+};
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+uint64_t follow_time_us(void) ;
+uint64_t follow_latency_us(struct TS_follow *follow) ;
+
+struct TS_follow *follow_new(int file, const char *done_file, unsigned timeout_ms) ;
+void follow_free(struct TS_follow **follow) ;
+
+int follow_wait(struct TS_follow *follow) ;
+
+#endif /* TS_FOLLOW_H_ */
@@ -0,0 +1,784 @@
+/*
+ * ts_index.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * Time -> file position index. The file is parsed once to find the start of every GOP on each video pid
+ * (as flagged by mpeg2_frame_flags()), and the packet number, byte offset and PTS of each is saved in a sidecar
+ * file alongside the recording. The reader can then be positioned at the GOP at (or just before) any time
+ * with tsreader_seek_time().
+ *
+ * Sidecar file format (all values little endian):
+ *
+ *   header:  magic (4) version (4) num_entries (4) reserved (4) file_size (8) file_mtime (8)
+ *   entries: pts (8) pktnum (8) pos (8) pid (4) reserved (4)
+ */
+
+// VERSION = 1.00
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+
+#include "ts_parse.h"
+#include "ts_skip.h"
+#include "ts_fanout.h"
+#include "ts_index.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+#define INDEX_HEADER_LEN	32
+#define INDEX_ENTRY_LEN		32
+
+// only the start of each video PES is checked for a GOP header
+#define INDEX_SCAN_LEN		1024
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+struct TS_index_build {
+	struct TS_reader	*tsreader ;
+	struct TS_index		*index ;
+	unsigned			debug ;
+};
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+static void put_le(uint8_t *buff, uint64_t val, unsigned len)
+{
+unsigned i ;
+
+	for (i=0; i < len; ++i, val >>= 8)
+		buff[i] = (uint8_t)(val & 0xff) ;
+}
+
+/* ----------------------------------------------------------------------- */
+static uint64_t get_le(const uint8_t *buff, unsigned len)
+{
+uint64_t val = 0 ;
+
+	while (len--)
+		val = (val << 8) | buff[len] ;
+	return val ;
+}
+
+/* ----------------------------------------------------------------------- */
+static struct TS_index *index_new(void)
+{
+struct TS_index *index ;
+
+	index = (struct TS_index *)malloc(sizeof(struct TS_index)) ;
+	if (!index)
+	{
+		SET_DVB_ERROR(ERR_MALLOC) ;
+		return NULL ;
+	}
+	CLEAR_MEM(index) ;
+
+	return index ;
+}
+
+/* ----------------------------------------------------------------------- */
+static int index_add(struct TS_index *index, unsigned pid, uint64_t pktnum, uint64_t pos, int64_t pts)
+{
+struct TS_index_entry *entries ;
+struct TS_index_entry *entry ;
+
+	if (index->num_entries >= index->max_entries)
+	{
+		index->max_entries = index->max_entries ? 2 * index->max_entries : 1024 ;
+		entries = (struct TS_index_entry *)realloc(index->entries, index->max_entries * sizeof(struct TS_index_entry)) ;
+		if (!entries)
+		{
+			RETURN_DVB_ERROR(ERR_MALLOC) ;
+		}
+		index->entries = entries ;
+	}
+
+	entry = &index->entries[index->num_entries++] ;
+	CLEAR_MEM(entry) ;
+	entry->pts = pts ;
+	entry->pktnum = pktnum ;
+	entry->pos = pos ;
+	entry->pid = pid ;
+
+	return 0 ;
+}
+
+/* ----------------------------------------------------------------------- */
+static int index_cmp(const void *a, const void *b)
+{
+const struct TS_index_entry *ea = (const struct TS_index_entry *)a ;
+const struct TS_index_entry *eb = (const struct TS_index_entry *)b ;
+
+	if (ea->pid != eb->pid)
+		return ea->pid < eb->pid ? -1 : 1 ;
+	if (ea->pktnum != eb->pktnum)
+		return ea->pktnum < eb->pktnum ? -1 : 1 ;
+	return 0 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Set the details of the TS file that the index refers to
+static int index_file_info(char *filename, uint64_t *file_size, int64_t *file_mtime)
+{
+struct stat64 file_stat ;
+
+	if (stat64(filename, &file_stat) != 0)
+	{
+		RETURN_DVB_ERROR(ERR_FILE) ;
+	}
+	*file_size = (uint64_t)file_stat.st_size ;
+	*file_mtime = (int64_t)file_stat.st_mtime ;
+
+	return 0 ;
+}
+
+//---------------------------------------------------------------------------------------------------------
+// void (*tsparse_pes_data_hook)(struct TS_pidinfo *, struct TS_pesinfo *, uint8_t *, unsigned, void *) ;
+static void index_pes_data_hook(struct TS_pidinfo *pidinfo, struct TS_pesinfo *pesinfo, uint8_t *pesdata, unsigned pesdata_len, void *user_data)
+{
+struct TS_index_build *build = (struct TS_index_build *)user_data ;
+unsigned flags ;
+
+	if ((pesinfo->code & video_stream_mask) != video_stream)
+		return ;
+	if (pesinfo->pts == UNSET_TS)
+		return ;
+
+	if (pesdata_len > INDEX_SCAN_LEN)
+		pesdata_len = INDEX_SCAN_LEN ;
+	flags = mpeg2_frame_flags(build->tsreader, build->tsreader->tsstate, pesdata, pesdata_len) ;
+
+	if (flags & FRAME_FLAG_GOP)
+	{
+		if (build->debug >= 2)
+			printf("GOP pid %u : pkt %"PRIu64" : pos %"PRIu64" : pts %"PRId64"\n", pidinfo->pid, pesinfo->start_pkt,
+					pesinfo->start_pos, pesinfo->pts) ;
+
+		// the byte offset is kept as well as the packet number since the packets need not start at a multiple
+		// of the packet size (e.g. a recording that starts part way through a packet)
+		if (index_add(build->index, pidinfo->pid, pesinfo->start_pkt, pesinfo->start_pos, pesinfo->pts) != 0)
+			tsreader_stop(build->tsreader) ;
+	}
+}
+
+
+/*=============================================================================================*/
+// PUBLIC
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+// Create the sidecar filename (e.g. rec.ts -> rec.tsidx). idxname must be at least strlen(filename)+sizeof(TS_INDEX_EXT)
+void tsindex_filename(char *filename, char *idxname)
+{
+	remove_ext(filename, idxname) ;
+	strcat(idxname, TS_INDEX_EXT) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// tsfanout_end_hook
+static int index_end(struct TS_reader *tsreader, void *user_data)
+{
+struct TS_index_build *build = (struct TS_index_build *)user_data ;
+int status = 0 ;
+
+	if (tsreader->tsstate->stop_flag)
+		status = ERR_MALLOC ;
+
+	// group by pid
+	qsort(build->index->entries, build->index->num_entries, sizeof(struct TS_index_entry), index_cmp) ;
+
+	if (build->debug)
+		printf("Indexed : %u GOPs\n", build->index->num_entries) ;
+
+	free(build) ;
+
+	return status ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Add building the index to a single pass of the file. The index is complete once tsfanout_run() has returned
+// successfully; it's up to the caller to free it. Returns NULL on error
+struct TS_index *tsindex_fanout(struct TS_fanout *fanout, unsigned debug)
+{
+struct TS_index_build *build ;
+struct TS_index *index ;
+
+	index = index_new() ;
+	if (!index)
+		return NULL ;
+
+	if (index_file_info(fanout->filename, &index->file_size, &index->file_mtime) != 0)
+	{
+		tsindex_free(index) ;
+		return NULL ;
+	}
+
+	build = (struct TS_index_build *)malloc(sizeof(struct TS_index_build)) ;
+	if (!build)
+	{
+		tsindex_free(index) ;
+		SET_DVB_ERROR(ERR_MALLOC) ;
+		return NULL ;
+	}
+	build->index = index ;
+	build->debug = debug ;
+	build->tsreader = tsfanout_add(fanout, index_end, build) ;
+	if (!build->tsreader)
+	{
+		free(build) ;
+		tsindex_free(index) ;
+		return NULL ;
+	}
+	build->tsreader->debug = debug ;
+	build->tsreader->pes_data_hook = index_pes_data_hook ;
+
+	return index ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Parse the whole file to create the index. Returns NULL on error
+struct TS_index *tsindex_build(char *filename, unsigned debug)
+{
+struct TS_fanout *fanout ;
+struct TS_index *index ;
+int status ;
+
+	fanout = tsfanout_new(filename) ;
+	if (!fanout)
+		return NULL ;
+
+	index = tsindex_fanout(fanout, debug) ;
+	status = index ? tsfanout_run(fanout) : dvb_error_code ;
+	tsfanout_free(fanout) ;
+
+	if (status)
+	{
+		tsindex_free(index) ;
+		SET_DVB_ERROR(status) ;
+		return NULL ;
+	}
+
+	return index ;
+}
+
+/* ----------------------------------------------------------------------- */
+int tsindex_save(struct TS_index *index, char *idxname)
+{
+uint8_t *data ;
+unsigned data_len ;
+unsigned i ;
+int file ;
+int rc ;
+
+	data_len = INDEX_HEADER_LEN + index->num_entries * INDEX_ENTRY_LEN ;
+	data = (uint8_t *)malloc(data_len) ;
+	if (!data)
+	{
+		RETURN_DVB_ERROR(ERR_MALLOC) ;
+	}
+
+	put_le(&data[0], TS_INDEX_MAGIC, 4) ;
+	put_le(&data[4], TS_INDEX_VERSION, 4) ;
+	put_le(&data[8], index->num_entries, 4) ;
+	put_le(&data[12], 0, 4) ;
+	put_le(&data[16], index->file_size, 8) ;
+	put_le(&data[24], (uint64_t)index->file_mtime, 8) ;
+
+	for (i=0; i < index->num_entries; ++i)
+	{
+	uint8_t *p = &data[INDEX_HEADER_LEN + i*INDEX_ENTRY_LEN] ;
+
+		put_le(&p[0], (uint64_t)index->entries[i].pts, 8) ;
+		put_le(&p[8], index->entries[i].pktnum, 8) ;
+		put_le(&p[16], index->entries[i].pos, 8) ;
+		put_le(&p[24], index->entries[i].pid, 4) ;
+		put_le(&p[28], 0, 4) ;
+	}
+
+	file = open(idxname, O_CREAT | O_TRUNC | O_WRONLY | O_BINARY, 0666);
+	if (-1 == file)
+	{
+		free(data) ;
+		RETURN_DVB_ERROR(ERR_FILE) ;
+	}
+	rc = write(file, data, data_len) ;
+	close(file) ;
+	free(data) ;
+
+	if (rc != (int)data_len)
+	{
+		unlink(idxname) ;
+		RETURN_DVB_ERROR(ERR_FILE) ;
+	}
+
+	return 0 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Read a saved index. Returns NULL on error
+struct TS_index *tsindex_load(char *idxname)
+{
+uint8_t header[INDEX_HEADER_LEN] ;
+uint8_t entry[INDEX_ENTRY_LEN] ;
+struct TS_index *index ;
+unsigned num_entries ;
+unsigned i ;
+FILE *file ;
+
+	file = fopen(idxname, "rb") ;
+	if (!file)
+	{
+		SET_DVB_ERROR(ERR_FILE) ;
+		return NULL ;
+	}
+
+	if ((fread(header, sizeof(header), 1, file) != 1) ||
+			(get_le(&header[0], 4) != TS_INDEX_MAGIC) ||
+			(get_le(&header[4], 4) != TS_INDEX_VERSION))
+	{
+		fclose(file) ;
+		SET_DVB_ERROR(ERR_FILE_FORMAT) ;
+		return NULL ;
+	}
+
+	index = index_new() ;
+	if (!index)
+	{
+		fclose(file) ;
+		return NULL ;
+	}
+	num_entries = (unsigned)get_le(&header[8], 4) ;
+	index->file_size = get_le(&header[16], 8) ;
+	index->file_mtime = (int64_t)get_le(&header[24], 8) ;
+
+	for (i=0; i < num_entries; ++i)
+	{
+		if (fread(entry, sizeof(entry), 1, file) != 1)
+		{
+			fclose(file) ;
+			tsindex_free(index) ;
+			SET_DVB_ERROR(ERR_FILE_FORMAT) ;
+			return NULL ;
+		}
+
+		if (index_add(index, (unsigned)get_le(&entry[24], 4), get_le(&entry[8], 8), get_le(&entry[16], 8),
+				(int64_t)get_le(&entry[0], 8)) != 0)
+		{
+			fclose(file) ;
+			tsindex_free(index) ;
+			return NULL ;
+		}
+	}
+	fclose(file) ;
+
+	return index ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Get the index for a file - uses the sidecar file if it's up to date, otherwise (re)builds the index and
+// saves it. Returns NULL on error
+struct TS_index *tsindex_get(char *filename, unsigned debug)
+{
+struct TS_index *index ;
+uint64_t file_size ;
+int64_t file_mtime ;
+char *idxname ;
+
+	if (index_file_info(filename, &file_size, &file_mtime) != 0)
+		return NULL ;
+
+	idxname = (char *)malloc(strlen(filename) + sizeof(TS_INDEX_EXT)) ;
+	if (!idxname)
+	{
+		SET_DVB_ERROR(ERR_MALLOC) ;
+		return NULL ;
+	}
+	tsindex_filename(filename, idxname) ;
+
+	index = tsindex_load(idxname) ;
+	if (index && ((index->file_size != file_size) || (index->file_mtime != file_mtime)))
+	{
+		if (debug)
+			printf("Index %s is out of date\n", idxname) ;
+
+		tsindex_free(index) ;
+		index = NULL ;
+	}
+
+	if (!index)
+	{
+		index = tsindex_build(filename, debug) ;
+
+		// not being able to save it doesn't stop this index being used
+		if (index)
+			tsindex_save(index, idxname) ;
+	}
+
+	free(idxname) ;
+	return index ;
+}
+
+/* ----------------------------------------------------------------------- */
+void tsindex_free(struct TS_index *index)
+{
+	if (index)
+	{
+		if (index->entries)
+			free(index->entries) ;
+		free(index) ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Find the last GOP on the pid that starts at or before the pts (or the first GOP if the pts is before
+// that). A pid of 0 uses the first video pid in the index. Returns the entry number, or an error code
+int tsindex_find(struct TS_index *index, unsigned pid, int64_t pts)
+{
+unsigned lo, hi, mid ;
+unsigned first, end ;
+
+	if (!index->num_entries)
+	{
+		RETURN_DVB_ERROR(ERR_FILE_NO_INDEX) ;
+	}
+	if (!pid)
+		pid = index->entries[0].pid ;
+
+	// find the entries for this pid
+	lo = 0 ;
+	hi = index->num_entries ;
+	while (lo < hi)
+	{
+		mid = lo + (hi - lo) / 2 ;
+		if (index->entries[mid].pid < pid)
+			lo = mid + 1 ;
+		else
+			hi = mid ;
+	}
+	first = lo ;
+
+	hi = index->num_entries ;
+	while (lo < hi)
+	{
+		mid = lo + (hi - lo) / 2 ;
+		if (index->entries[mid].pid <= pid)
+			lo = mid + 1 ;
+		else
+			hi = mid ;
+	}
+	end = lo ;
+
+	if (first == end)
+	{
+		RETURN_DVB_ERROR(ERR_FILE_NO_INDEX) ;
+	}
+
+	// find the first entry after the pts
+	lo = first ;
+	hi = end ;
+	while (lo < hi)
+	{
+		mid = lo + (hi - lo) / 2 ;
+		if (index->entries[mid].pts <= pts)
+			lo = mid + 1 ;
+		else
+			hi = mid ;
+	}
+
+	// preceding GOP
+	return (int)(lo > first ? lo - 1 : first) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Position the reader at the start of the GOP that contains the pts (see tsindex_find())
+int tsreader_seek_time(struct TS_reader *tsreader, struct TS_index *index, unsigned pid, int64_t pts)
+{
+int entry ;
+
+	CHECK_TS_READER(tsreader) ;
+
+	entry = tsindex_find(index, pid, pts) ;
+	if (entry < 0)
+	{
+		RETURN_TSREADER_ERROR(tsreader, entry) ;
+	}
+
+	tsparse_dbg_prt(100, ("tsreader_seek_time(pid=%u, pts=%"PRId64") GOP pkt %"PRIu64" pos %"PRIu64" pts %"PRId64"\n",
+			pid, pts, index->entries[entry].pktnum, index->entries[entry].pos, index->entries[entry].pts)) ;
+
+	return tsreader_setpos_byte(tsreader, index->entries[entry].pos, index->entries[entry].pktnum, tsreader->num_pkts) ;
+}
+
+
+//============================================================================================
+// Test: builds (or loads) the index for a file, then checks that seeking to each GOP's PTS (and to times
+// between GOPs) positions the reader at the right GOP. The same is then done for a copy of the file with some
+// junk in front of the first packet, where each GOP has to be found by its byte offset rather than its packet
+// number.
+//
+//   ts_index [-d debug] file.ts
+//
+#ifdef TEST_MAIN
+
+#include <sys/time.h>
+
+// bytes of junk in front of the packets in the copy of the file - more than a packet, so that seeking by packet number
+// alone (and then re-syncing) would end up a packet too early
+#define TEST_PREFIX_LEN		(2*TS_PACKET_LEN + 100)
+
+//---------------------------------------------------------------------------------------------------------------------------
+static double test_time(void)
+{
+struct timeval tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1e6 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Check the reader really is at a video PES start on the expected pid
+static unsigned test_position(struct TS_reader *tsreader, struct TS_index_entry *entry)
+{
+struct TS_packet_view view ;
+
+	if (tsreader_next_packet(tsreader, &view) != 1)
+		return 1 ;
+
+	return (view.pidinfo.pid != entry->pid) || (view.pidinfo.pktnum != entry->pktnum) || !view.pidinfo.pes_start ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Seek to every GOP, and half way to the next. Returns the number of failures
+static unsigned test_seeks(char *filename, struct TS_index *index)
+{
+struct TS_reader *tsreader ;
+unsigned failed = 0 ;
+unsigned i ;
+int entry ;
+
+	tsreader = tsreader_new(filename) ;
+	if (!tsreader)
+	{
+		printf("FAIL : unable to open %s\n", filename) ;
+		return 1 ;
+	}
+
+	for (i=0; i < index->num_entries; ++i)
+	{
+	struct TS_index_entry *gop = &index->entries[i] ;
+	int64_t pts = gop->pts ;
+
+		if ((i+1 < index->num_entries) && (index->entries[i+1].pid == gop->pid))
+			pts += (index->entries[i+1].pts - gop->pts) / 2 ;
+
+		entry = tsindex_find(index, gop->pid, pts) ;
+		if (entry != (int)i)
+		{
+			printf("FAIL : pid %u pts %"PRId64" : got entry %d expected %u\n", gop->pid, pts, entry, i) ;
+			++failed ;
+			continue ;
+		}
+
+		if ((tsreader_seek_time(tsreader, index, gop->pid, pts) != 0) || test_position(tsreader, gop))
+		{
+			printf("FAIL : pid %u pts %"PRId64" : reader not at pkt %"PRIu64"\n", gop->pid, pts, gop->pktnum) ;
+			++failed ;
+		}
+	}
+
+	tsreader_free(tsreader) ;
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Copy the file with TEST_PREFIX_LEN bytes of junk in front, index the copy, and check the GOPs are the same ones
+// (just moved along) and can still be seeked to. Returns the number of failures
+static unsigned test_prefix(char *filename, struct TS_index *index, unsigned debug)
+{
+struct TS_index *prefixed ;
+char *copyname ;
+char *idxname ;
+uint8_t buff[65536] ;
+size_t len ;
+FILE *in, *out ;
+unsigned failed = 0 ;
+unsigned i ;
+
+	copyname = (char *)malloc(strlen(filename) + sizeof(".prefix.ts")) ;
+	sprintf(copyname, "%s.prefix.ts", filename) ;
+	idxname = (char *)malloc(strlen(copyname) + sizeof(TS_INDEX_EXT)) ;
+	tsindex_filename(copyname, idxname) ;
+
+	in = fopen(filename, "rb") ;
+	out = fopen(copyname, "wb") ;
+	if (!in || !out)
+	{
+		printf("FAIL : unable to create %s\n", copyname) ;
+		if (in) fclose(in) ;
+		if (out) fclose(out) ;
+		free(copyname) ;
+		free(idxname) ;
+		return 1 ;
+	}
+	memset(buff, 0, TEST_PREFIX_LEN) ;
+	fwrite(buff, 1, TEST_PREFIX_LEN, out) ;
+	while ((len = fread(buff, 1, sizeof(buff), in)) > 0)
+		fwrite(buff, 1, len, out) ;
+	fclose(in) ;
+	fclose(out) ;
+
+	unlink(idxname) ;
+	prefixed = tsindex_get(copyname, debug) ;
+	if (!prefixed || (prefixed->num_entries != index->num_entries))
+	{
+		printf("FAIL : prefixed : %u GOPs (expected %u)\n", prefixed ? prefixed->num_entries : 0, index->num_entries) ;
+		++failed ;
+	}
+	else
+	{
+		for (i=0; i < index->num_entries; ++i)
+		{
+		struct TS_index_entry *gop = &prefixed->entries[i] ;
+
+			if ((gop->pktnum != index->entries[i].pktnum) || (gop->pts != index->entries[i].pts) ||
+					(gop->pos != index->entries[i].pos + TEST_PREFIX_LEN))
+			{
+				printf("FAIL : prefixed : GOP %u at pkt %"PRIu64" pos %"PRIu64" (expected pkt %"PRIu64" pos %"PRIu64")\n",
+						i, gop->pktnum, gop->pos, index->entries[i].pktnum, index->entries[i].pos + TEST_PREFIX_LEN) ;
+				++failed ;
+				break ;
+			}
+		}
+
+		failed += test_seeks(copyname, prefixed) ;
+	}
+
+	printf("prefixed : %u byte prefix : %u GOPs : %s\n", TEST_PREFIX_LEN, prefixed ? prefixed->num_entries : 0,
+			failed ? "FAIL" : "ok") ;
+
+	tsindex_free(prefixed) ;
+	unlink(idxname) ;
+	unlink(copyname) ;
+	free(idxname) ;
+	free(copyname) ;
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct TS_index *index ;
+struct TS_index *loaded ;
+char *idxname ;
+unsigned debug = 0 ;
+unsigned failed = 0 ;
+unsigned i ;
+double start, build_time, load_time, seek_time ;
+int c ;
+
+	while ((c = getopt (argc, argv, "d:")) != -1)
+	{
+		switch (c)
+		{
+		case 'd':
+			debug = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	if (optind >= argc)
+	{
+		printf("Error: Must specify input filename\n") ;
+		abort() ;
+	}
+
+	idxname = (char *)malloc(strlen(argv[optind]) + sizeof(TS_INDEX_EXT)) ;
+	tsindex_filename(argv[optind], idxname) ;
+	unlink(idxname) ;
+
+	// build + save
+	start = test_time() ;
+	index = tsindex_get(argv[optind], debug) ;
+	build_time = test_time() - start ;
+	if (!index)
+	{
+		printf("FAIL : error %d : %s\n", dvb_error_code, dvb_error_str(dvb_error_code)) ;
+		return 1 ;
+	}
+
+	// load - must be the same
+	start = test_time() ;
+	loaded = tsindex_get(argv[optind], debug) ;
+	load_time = test_time() - start ;
+	if (!loaded || (loaded->num_entries != index->num_entries) ||
+			memcmp(loaded->entries, index->entries, index->num_entries * sizeof(struct TS_index_entry)))
+	{
+		printf("FAIL : loaded index differs\n") ;
+		++failed ;
+	}
+
+	// the packets in this file are all whole packets from the start
+	for (i=0; i < index->num_entries; ++i)
+	{
+		if (index->entries[i].pos != index->entries[i].pktnum * TS_PACKET_LEN)
+		{
+			printf("FAIL : GOP %u at pkt %"PRIu64" pos %"PRIu64"\n", i, index->entries[i].pktnum, index->entries[i].pos) ;
+			++failed ;
+			break ;
+		}
+	}
+
+	// seek to every GOP, and half way to the next
+	start = test_time() ;
+	failed += test_seeks(argv[optind], index) ;
+	seek_time = test_time() - start ;
+
+	// junk in front of the first packet
+	failed += test_prefix(argv[optind], index, debug) ;
+
+	// before the start
+	if (index->num_entries && (tsindex_find(index, 0, 0) != 0))
+	{
+		printf("FAIL : time before start\n") ;
+		++failed ;
+	}
+
+	printf("%s : %u GOPs : build %.3f s, load %.4f s, %u seeks %.4f s\n",
+			failed ? "FAIL" : "PASS", index->num_entries,
+			build_time, load_time, index->num_entries, seek_time) ;
+
+	tsindex_free(index) ;
+	tsindex_free(loaded) ;
+	free(idxname) ;
+
+	return failed ? 1 : 0 ;
+}
+
+#endif
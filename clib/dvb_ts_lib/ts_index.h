@@ -0,0 +1,73 @@
+/*
+ * ts_index.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef TS_INDEX_H_
+#define TS_INDEX_H_
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+#include <inttypes.h>
+
+#include "ts_structs.h"
+#include "ts_fanout.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+// sidecar file extension (replaces the .ts)
+#define TS_INDEX_EXT		".tsidx"
+
+// file format
+#define TS_INDEX_MAGIC		0x58495354		// "TSIX"
+#define TS_INDEX_VERSION	4
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+// One GOP start on a video pid
+struct TS_index_entry {
+	int64_t		pts ;			// PTS of the PES containing the GOP header (wrap adjusted, as TS_pesinfo)
+	uint64_t	pktnum ;		// packet that starts that PES
+	uint64_t	pos ;			// byte offset of that packet in the file
+	unsigned	pid ;
+};
+
+// All GOP starts in a file, in pid order and then file order
+struct TS_index {
+	// details of the TS file when indexed (used to check the index is up to date)
+	uint64_t				file_size ;
+	int64_t					file_mtime ;
+
+	unsigned				num_entries ;
+	unsigned				max_entries ;
+	struct TS_index_entry	*entries ;
+};
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+struct TS_index *tsindex_build(char *filename, unsigned debug) ;
+struct TS_index *tsindex_fanout(struct TS_fanout *fanout, unsigned debug) ;
+struct TS_index *tsindex_load(char *idxname) ;
+int tsindex_save(struct TS_index *index, char *idxname) ;
+struct TS_index *tsindex_get(char *filename, unsigned debug) ;
+void tsindex_free(struct TS_index *index) ;
+
+void tsindex_filename(char *filename, char *idxname) ;
+int tsindex_find(struct TS_index *index, unsigned pid, int64_t pts) ;
+
+int tsreader_seek_time(struct TS_reader *tsreader, struct TS_index *index, unsigned pid, int64_t pts) ;
+
+#endif /* TS_INDEX_H_ */
@@ -0,0 +1,816 @@
+/*
+ * ts_parallel.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * Parse a single large file using several threads. The file is split into packet-aligned chunks, each
+ * of which is parsed by its own TS_reader (and so its own TS_state) using the TS_pool. Each reader
+ * starts with no pid state, so any PES/PSI already in progress at the start of a chunk is simply
+ * discarded (its header - and so its timestamps - belong to the previous chunk).
+ *
+ * A chunk is a range of bytes, not a number of packets: any junk in the file (and so any re-sync) moves the
+ * packets off the packet-aligned positions. Each chunk starts at the first packet its reader would sync to from
+ * the packet-aligned split point, and its reader stops at the start of the next chunk (TS_reader end_pos). So
+ * anything between a split point and the start of the next chunk is parsed by the previous reader, which is in
+ * sync there just as a single reader of the whole file would be.
+ *
+ * Every chunk produces a TS_summary of its packets. Once all are done, the summaries are reduced in file
+ * order with tssummary_merge() into the result for the whole file. Any new per-pid result just needs
+ * adding to TS_pid_summary, tssummary_packet() and pid_merge().
+ */
+
+// VERSION = 1.00
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+
+#ifdef TEST_MAIN
+// split even a small test file into plenty of chunks
+#ifndef TS_PARALLEL_MIN_CHUNK
+#define TS_PARALLEL_MIN_CHUNK	100
+#endif
+#endif
+
+#include "ts_parse.h"
+#include "ts_sync.h"
+#include "ts_pool.h"
+#include "ts_parallel.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+struct TS_parallel_chunk {
+	uint64_t			start_pkt ;
+	uint64_t			num_pkts ;		// 0 = to end of file
+	off64_t				start_pos ;		// byte offset of the first packet
+	off64_t				end_pos ;		// byte offset of the first packet in the next chunk (0 = end of file)
+	int					status ;
+	struct TS_summary	*summary ;
+};
+
+struct TS_parallel {
+	off64_t						sync_offset ;	// bytes before the first packet
+	unsigned					packet_size ;
+	unsigned					debug ;
+	struct TS_parallel_chunk	*chunks ;
+};
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+static struct TS_pid_summary *summary_pid_get(struct TS_summary *summary, unsigned pid)
+{
+struct TS_pid_summary *pid_summary ;
+
+	pid_summary = summary->pids[pid & MAX_PID] ;
+	if (pid_summary)
+		return pid_summary ;
+
+	pid_summary = (struct TS_pid_summary *)malloc(sizeof(*pid_summary)) ;
+	CLEAR_MEM(pid_summary) ;
+	pid_summary->pid = pid & MAX_PID ;
+	pid_summary->start_pts = UNSET_TS ;
+	pid_summary->end_pts = UNSET_TS ;
+	pid_summary->start_dts = UNSET_TS ;
+	pid_summary->end_dts = UNSET_TS ;
+
+	summary->pids[pid & MAX_PID] = pid_summary ;
+	++summary->num_pids ;
+
+	return pid_summary ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Add the range next_start..next_end (which follows start..end in the stream) to start..end. The later range
+// will have been wrap adjusted relative to its own start, so has to be checked again against ours.
+static void timing_merge(int64_t *start, int64_t *end, int64_t next_start, int64_t next_end)
+{
+	if (next_start == UNSET_TS)
+		return ;
+
+	if (*start == UNSET_TS)
+	{
+		*start = next_start ;
+		*end = next_end ;
+		return ;
+	}
+
+	// check for wrap
+	if (next_end+MAX_TS_DIFF < *start)
+	{
+		next_end += TS_WRAP ;
+	}
+
+	if (*end < next_end)
+		*end = next_end ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Add the results for the packets that follow on from pid_summary (renumbering them by adding renumber)
+static void pid_merge(struct TS_pid_summary *pid_summary, const struct TS_pid_summary *next, uint64_t renumber)
+{
+	if (next->num_pkts)
+	{
+		if (!pid_summary->num_pkts)
+			pid_summary->start_pkt = next->start_pkt + renumber ;
+		pid_summary->end_pkt = next->end_pkt + renumber ;
+	}
+	pid_summary->num_pkts += next->num_pkts ;
+	pid_summary->num_errors += next->num_errors ;
+
+	timing_merge(&pid_summary->start_pts, &pid_summary->end_pts, next->start_pts, next->end_pts) ;
+	timing_merge(&pid_summary->start_dts, &pid_summary->end_dts, next->start_dts, next->end_dts) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Find the packet size and the offset of the first packet in the file (as tsreader_new() and the sync search at the
+// start of ts_parse() would)
+static off64_t parallel_sync_offset(int file, unsigned *packet_size)
+{
+uint8_t buff[TS_BUFFSIZE] ;
+int bytes_read ;
+unsigned prefix ;
+unsigned offset ;
+
+	*packet_size = TS_PACKET_LEN ;
+	bytes_read = read(file, buff, sizeof(buff)) ;
+	if (bytes_read < TS_PACKET_LEN)
+		return 0 ;
+
+	*packet_size = ts_sync_packet_size(buff, (unsigned)bytes_read) ;
+	if (!*packet_size)
+		*packet_size = TS_PACKET_LEN ;
+	prefix = (*packet_size == TS_M2TS_PACKET_LEN) ? TS_M2TS_HEADER_LEN : 0 ;
+
+	offset = ts_sync_find(buff + prefix, (unsigned)bytes_read - prefix, 4*(*packet_size)+1, TS_SYNC_CONFIRM, *packet_size) ;
+	if (offset > 4*(*packet_size))
+		return 0 ;
+
+	return (off64_t)offset ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Find the first packet at or after pos, using the same search as the reader uses to re-sync but carrying on past
+// its search range (a reader that is already in sync just reads on through any junk, so the previous chunk covers
+// everything up to here). Returns the end of the file if there are no more packets
+static off64_t parallel_sync_pos(int file, off64_t pos, unsigned packet_size)
+{
+uint8_t buff[8 * TS_RS_PACKET_LEN] ;
+ssize_t bytes_read ;
+unsigned prefix ;
+unsigned offset ;
+
+	prefix = (packet_size == TS_M2TS_PACKET_LEN) ? TS_M2TS_HEADER_LEN : 0 ;
+	for (;;)
+	{
+		bytes_read = pread64(file, buff, 8*packet_size, pos) ;
+		if (bytes_read <= (ssize_t)prefix)
+			return pos + (bytes_read > 0 ? bytes_read : 0) ;
+
+		offset = ts_sync_find(buff + prefix, (unsigned)bytes_read - prefix, 4*packet_size+1, TS_SYNC_CONFIRM, packet_size) ;
+		if (offset <= 4*packet_size)
+			return pos + (off64_t)offset ;
+
+		// not enough left to confirm a packet
+		if (bytes_read < (ssize_t)(8*packet_size))
+			return pos + bytes_read ;
+
+		pos += 4*packet_size + 1 ;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------
+// void (*tsparse_ts_hook)(struct TS_pidinfo *, uint8_t *, unsigned, void *) ;
+static void parallel_ts_hook(struct TS_pidinfo *pidinfo, uint8_t *packet, unsigned packet_len, void *user_data)
+{
+	tssummary_packet((struct TS_summary *)user_data, pidinfo) ;
+}
+
+//---------------------------------------------------------------------------------------------------------
+// Called in the worker thread to position the reader on its chunk
+static int parallel_setup(struct TS_reader *tsreader, unsigned index, void *user_data)
+{
+struct TS_parallel *parallel = (struct TS_parallel *)user_data ;
+struct TS_parallel_chunk *chunk = &parallel->chunks[index] ;
+int status ;
+
+	tsreader->debug = parallel->debug ;
+	tsreader->user_data = chunk->summary ;
+	tsreader->ts_hook = parallel_ts_hook ;
+	tsreader->use_mmap = 1 ;
+
+	// stop at the start of the next chunk
+	tsreader->end_pos = (uint64_t)chunk->end_pos ;
+
+	status = tsreader_setpos(tsreader, (int64_t)chunk->start_pkt, SEEK_SET, 0) ;
+	if (!status && (lseek64(tsreader->file, chunk->start_pos, SEEK_SET) == (off64_t)-1))
+	{
+		SET_TSREADER_ERROR(tsreader, ERR_FILE_SEEK) ;
+		status = tsreader->error_code ;
+	}
+	chunk->summary->start_pkt = tsreader->tsstate->pidinfo.pktnum ;
+
+	// not parsed, so the done hook won't be called
+	chunk->status = status ;
+	return status ;
+}
+
+//---------------------------------------------------------------------------------------------------------
+static void parallel_done(struct TS_reader *tsreader, unsigned index, int status, void *user_data)
+{
+struct TS_parallel *parallel = (struct TS_parallel *)user_data ;
+struct TS_parallel_chunk *chunk = &parallel->chunks[index] ;
+
+	chunk->status = status ;
+	if (tsreader)
+	{
+		tssummary_add_timing(chunk->summary, tsreader) ;
+
+		if (parallel->debug)
+			printf("Chunk %u : pkts %"PRIu64" .. +%"PRIu64" : %u pids, %"PRIu64" pkts : status %d\n",
+					index, chunk->start_pkt, chunk->num_pkts,
+					chunk->summary->num_pids, chunk->summary->total_pkts, status) ;
+	}
+}
+
+
+/*=============================================================================================*/
+// PUBLIC
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+struct TS_summary *tssummary_new(void)
+{
+struct TS_summary *summary ;
+
+	summary = (struct TS_summary *)malloc(sizeof(struct TS_summary)) ;
+	if (!summary)
+	{
+		SET_DVB_ERROR(ERR_MALLOC) ;
+		return NULL ;
+	}
+	CLEAR_MEM(summary) ;
+
+	summary->start_ts = UNSET_TS ;
+	summary->end_ts = UNSET_TS ;
+
+	return summary ;
+}
+
+/* ----------------------------------------------------------------------- */
+void tssummary_free(struct TS_summary *summary)
+{
+unsigned pid ;
+
+	if (summary)
+	{
+		for (pid=0; pid < ALL_PID; ++pid)
+		{
+			if (summary->pids[pid])
+				free(summary->pids[pid]) ;
+		}
+		free(summary) ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Add a packet (in stream order) - use from the ts_hook
+void tssummary_packet(struct TS_summary *summary, struct TS_pidinfo *pidinfo)
+{
+struct TS_pid_summary *pid_summary = summary_pid_get(summary, pidinfo->pid) ;
+
+	if (!pid_summary->num_pkts)
+		pid_summary->start_pkt = pidinfo->pktnum ;
+	pid_summary->end_pkt = pidinfo->pktnum ;
+	++pid_summary->num_pkts ;
+
+	if (pidinfo->pid_error)
+		++pid_summary->num_errors ;
+
+	++summary->total_pkts ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Add the PTS/DTS ranges from a reader that has finished parsing the packets in this summary
+void tssummary_add_timing(struct TS_summary *summary, struct TS_reader *tsreader)
+{
+struct list_head  *item;
+struct TS_pid    *piditem;
+struct TS_pid_summary timing ;
+
+	CHECK_TS_READER(tsreader) ;
+
+	summary->end_pkt = tsreader->tsstate->pidinfo.pktnum ;
+
+	list_for_each(item,&tsreader->tsstate->pid_list)
+	{
+		piditem = list_entry(item, struct TS_pid, next);
+
+		CLEAR_MEM(&timing) ;
+		timing.start_pts = piditem->pesinfo.start_pts ;
+		timing.end_pts = piditem->pesinfo.end_pts ;
+		timing.start_dts = piditem->pesinfo.start_dts ;
+		timing.end_dts = piditem->pesinfo.end_dts ;
+
+		pid_merge(summary_pid_get(summary, piditem->pidinfo.pid), &timing, 0) ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Reduction step: add the results in 'next' (which must be for the packets following those already in
+// summary) into summary. The overall start/end times are cleared - call tssummary_set_timing() once all merged.
+//
+// The packets in 'next' are renumbered to follow on from ours. A chunk's reader numbers its packets from its
+// start position in the file, which is more than the number of packets before it if any bytes were skipped.
+// (Summaries without start_pkt/end_pkt set are merged as numbered.)
+void tssummary_merge(struct TS_summary *summary, const struct TS_summary *next)
+{
+uint64_t renumber ;
+unsigned pid ;
+
+	renumber = summary->end_pkt - next->start_pkt ;
+
+	for (pid=0; pid < ALL_PID; ++pid)
+	{
+		if (next->pids[pid])
+			pid_merge(summary_pid_get(summary, pid), next->pids[pid], renumber) ;
+	}
+	summary->total_pkts += next->total_pkts ;
+	summary->end_pkt = next->end_pkt + renumber ;
+
+	summary->start_ts = UNSET_TS ;
+	summary->end_ts = UNSET_TS ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Set the start & end points for whole video based on min/max times of the streams (as tsreader_set_timing())
+void tssummary_set_timing(struct TS_summary *summary)
+{
+struct TS_pid_summary *pid_summary ;
+unsigned pid ;
+
+	summary->start_ts = UNSET_TS ;
+	summary->end_ts = UNSET_TS ;
+
+	for (pid=0; pid < ALL_PID; ++pid)
+	{
+		pid_summary = summary->pids[pid] ;
+		if (!pid_summary)
+			continue ;
+
+		// start
+		if (pid_summary->start_pts != UNSET_TS)
+		{
+			if ((summary->start_ts == UNSET_TS) || (pid_summary->start_pts < summary->start_ts))
+				summary->start_ts = pid_summary->start_pts ;
+		}
+		if (pid_summary->start_dts != UNSET_TS)
+		{
+			if ((summary->start_ts == UNSET_TS) || (pid_summary->start_dts < summary->start_ts))
+				summary->start_ts = pid_summary->start_dts ;
+		}
+
+		// end
+		if (pid_summary->end_pts != UNSET_TS)
+		{
+			if ((summary->end_ts == UNSET_TS) || (pid_summary->end_pts > summary->end_ts))
+				summary->end_ts = pid_summary->end_pts ;
+		}
+		if (pid_summary->end_dts != UNSET_TS)
+		{
+			if ((summary->end_ts == UNSET_TS) || (pid_summary->end_dts > summary->end_ts))
+				summary->end_ts = pid_summary->end_dts ;
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Parse the whole file in num_chunks chunks using num_threads threads (0 = one per cpu ; num_chunks 0 = one
+// per thread). Returns the summary for the whole file (free with tssummary_free()), or NULL on error.
+struct TS_summary *ts_parse_parallel(char *filename, unsigned num_threads, unsigned num_chunks, unsigned debug)
+{
+struct TS_parallel parallel ;
+struct TS_pool pool ;
+struct TS_summary *summary = NULL ;
+struct stat64 file_stat ;
+char **files = NULL ;
+uint64_t total_pkts ;
+uint64_t chunk_pkts ;
+unsigned i ;
+int status = 0 ;
+int file ;
+
+	// work out where the packets are
+	file = open(filename, O_RDONLY | O_LARGEFILE | O_BINARY, 0666);
+	if (-1 == file)
+	{
+		SET_DVB_ERROR(ERR_FILE) ;
+		return(NULL);
+	}
+	if (fstat64(file, &file_stat) != 0)
+	{
+		close(file) ;
+		SET_DVB_ERROR(ERR_FILE) ;
+		return(NULL);
+	}
+
+	memset(&parallel, 0, sizeof(parallel)) ;
+	parallel.debug = debug ;
+	parallel.sync_offset = parallel_sync_offset(file, &parallel.packet_size) ;
+
+	total_pkts = (uint64_t)(file_stat.st_size - parallel.sync_offset) / parallel.packet_size ;
+	if (!total_pkts)
+	{
+		close(file) ;
+		SET_DVB_ERROR(ERR_FILE_NO_PKTS) ;
+		return(NULL);
+	}
+
+	// split into chunks
+	if (!num_threads)
+		num_threads = (unsigned)sysconf(_SC_NPROCESSORS_ONLN) ;
+	if (!num_threads)
+		num_threads = 1 ;
+	if (!num_chunks)
+		num_chunks = num_threads ;
+	if (num_chunks > total_pkts / TS_PARALLEL_MIN_CHUNK)
+		num_chunks = (unsigned)(total_pkts / TS_PARALLEL_MIN_CHUNK) ;
+	if (!num_chunks)
+		num_chunks = 1 ;
+	chunk_pkts = total_pkts / num_chunks ;
+
+	if (debug)
+		printf("Parallel parse %s : %"PRIu64" pkts (offset %"PRId64") : %u chunks of %"PRIu64" pkts, %u threads\n",
+				filename, total_pkts, (int64_t)parallel.sync_offset, num_chunks, chunk_pkts, num_threads) ;
+
+	parallel.chunks = (struct TS_parallel_chunk *)calloc(num_chunks, sizeof(struct TS_parallel_chunk)) ;
+	files = (char **)calloc(num_chunks, sizeof(char *)) ;
+	if (!parallel.chunks || !files)
+	{
+		SET_DVB_ERROR(ERR_MALLOC) ;
+		goto done ;
+	}
+
+	for (i=0; i < num_chunks; ++i)
+	{
+		files[i] = filename ;
+		parallel.chunks[i].start_pkt = (uint64_t)i * chunk_pkts ;
+		parallel.chunks[i].num_pkts = (i == num_chunks-1) ? 0 : chunk_pkts ;
+		parallel.chunks[i].summary = tssummary_new() ;
+		if (!parallel.chunks[i].summary)
+			goto done ;
+
+		// split between packets
+		parallel.chunks[i].start_pos = parallel.sync_offset ;
+		if (i)
+		{
+			parallel.chunks[i].start_pos = parallel_sync_pos(file,
+					parallel.sync_offset + (off64_t)parallel.chunks[i].start_pkt * parallel.packet_size, parallel.packet_size) ;
+			parallel.chunks[i-1].end_pos = parallel.chunks[i].start_pos ;
+		}
+	}
+
+	// parse the chunks
+	memset(&pool, 0, sizeof(pool)) ;
+	pool.files = files ;
+	pool.num_files = num_chunks ;
+	pool.num_threads = num_threads ;
+	pool.user_data = &parallel ;
+	pool.setup_hook = parallel_setup ;
+	pool.done_hook = parallel_done ;
+
+	status = tspool_run(&pool) ;
+	if (status < 0)
+		goto done ;
+
+	// the whole file is only valid if every chunk is
+	for (i=0; i < num_chunks; ++i)
+	{
+		if (parallel.chunks[i].status)
+		{
+			SET_DVB_ERROR(parallel.chunks[i].status) ;
+			goto done ;
+		}
+	}
+
+	// reduce
+	summary = parallel.chunks[0].summary ;
+	parallel.chunks[0].summary = NULL ;
+	for (i=1; i < num_chunks; ++i)
+	{
+		tssummary_merge(summary, parallel.chunks[i].summary) ;
+	}
+	tssummary_set_timing(summary) ;
+
+done:
+	close(file) ;
+	if (parallel.chunks)
+	{
+		for (i=0; i < num_chunks; ++i)
+			tssummary_free(parallel.chunks[i].summary) ;
+		free(parallel.chunks) ;
+	}
+	if (files)
+		free(files) ;
+
+	return summary ;
+}
+
+
+//============================================================================================
+// Test: parses the file in one go, then in chunks, and checks the merged results for every pid are
+// the same. Also checks the merge copes with the PTS wrapping between chunks.
+//
+//   ts_parallel [-t threads] [-c chunks] [-d debug] file.ts
+//
+// Compares the file parsed as 1 chunk with it parsed in parallel, then does the same for a noisy copy of the file
+// (junk between packets and corrupt sync bytes) split into the smallest chunks allowed (TS_PARALLEL_MIN_CHUNK, which
+// can be set with -DTS_PARALLEL_MIN_CHUNK=pkts)
+//
+#ifdef TEST_MAIN
+
+#include <sys/time.h>
+
+// packets between each bit of noise in the noisy copy of the file
+#define TEST_NOISE_PKTS		149
+
+//---------------------------------------------------------------------------------------------------------------------------
+static double test_time(void)
+{
+struct timeval tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1e6 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static unsigned test_compare(struct TS_summary *ref, struct TS_summary *summary)
+{
+unsigned pid ;
+unsigned failed = 0 ;
+
+	for (pid=0; pid < ALL_PID; ++pid)
+	{
+		if (!ref->pids[pid] && !summary->pids[pid])
+			continue ;
+
+		if (!ref->pids[pid] || !summary->pids[pid] ||
+				(memcmp(ref->pids[pid], summary->pids[pid], sizeof(struct TS_pid_summary)) != 0))
+		{
+			printf("FAIL pid %u\n", pid) ;
+			++failed ;
+		}
+	}
+
+	if ((ref->total_pkts != summary->total_pkts) || (ref->num_pids != summary->num_pids) ||
+			(ref->start_ts != summary->start_ts) || (ref->end_ts != summary->end_ts))
+	{
+		printf("FAIL totals : pkts %"PRIu64"/%"PRIu64" pids %u/%u start %"PRId64"/%"PRId64" end %"PRId64"/%"PRId64"\n",
+				ref->total_pkts, summary->total_pkts, ref->num_pids, summary->num_pids,
+				ref->start_ts, summary->start_ts, ref->end_ts, summary->end_ts) ;
+		++failed ;
+	}
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Two chunks where the pts wraps in the second one
+static unsigned test_wrap(void)
+{
+struct TS_summary *first = tssummary_new() ;
+struct TS_summary *second = tssummary_new() ;
+struct TS_pidinfo pidinfo = { .pid = 100 } ;
+unsigned failed = 0 ;
+
+	pidinfo.pktnum = 10 ;
+	tssummary_packet(first, &pidinfo) ;
+	first->pids[100]->start_pts = TS_WRAP - 10*TS_FREQ ;
+	first->pids[100]->end_pts = TS_WRAP - 5*TS_FREQ ;
+
+	pidinfo.pktnum = 20 ;
+	pidinfo.pid_error = 1 ;
+	tssummary_packet(second, &pidinfo) ;
+	second->pids[100]->start_pts = 2*TS_FREQ ;
+	second->pids[100]->end_pts = 7*TS_FREQ ;
+
+	tssummary_merge(first, second) ;
+	tssummary_set_timing(first) ;
+
+	if ((first->pids[100]->num_pkts != 2) || (first->pids[100]->num_errors != 1) ||
+			(first->pids[100]->start_pkt != 10) || (first->pids[100]->end_pkt != 20) ||
+			(first->end_ts - first->start_ts != 17*TS_FREQ))
+	{
+		printf("FAIL wrap : start %"PRId64" end %"PRId64"\n", first->start_ts, first->end_ts) ;
+		++failed ;
+	}
+
+	tssummary_free(first) ;
+	tssummary_free(second) ;
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Write a copy of the file (name made from the template) with junk between some of the packets and some sync bytes
+// corrupted, so that the readers have to re-sync, often close to a chunk split. Returns 0 on success
+static int test_noisy_file(const char *filename, char *noisy_filename)
+{
+uint8_t packet[TS_PACKET_LEN] ;
+uint8_t junk[2*TS_PACKET_LEN] ;
+uint64_t pktnum = 0 ;
+unsigned len ;
+unsigned i ;
+FILE *in ;
+int fd ;
+int status = 0 ;
+
+	in = fopen(filename, "rb") ;
+	if (!in)
+		return -1 ;
+
+	fd = mkstemp(noisy_filename) ;
+	if (fd < 0)
+	{
+		fclose(in) ;
+		return -1 ;
+	}
+
+	for (i=0; i < sizeof(junk); ++i)
+		junk[i] = (uint8_t)(i * 13) ;
+
+	while (!status && (fread(packet, 1, sizeof(packet), in) == sizeof(packet)))
+	{
+		++pktnum ;
+
+		// every so often (far enough apart that the re-syncs don't overlap) add less than a packet of junk, up to
+		// 2 packets of junk, or corrupt the sync byte
+		len = 0 ;
+		if (pktnum % TEST_NOISE_PKTS == 0)
+		{
+			switch ((pktnum / TEST_NOISE_PKTS) % 3)
+			{
+			case 0:
+				len = (unsigned)(pktnum % TS_PACKET_LEN) + 1 ;
+				break ;
+
+			case 1:
+				len = (unsigned)(pktnum % sizeof(junk)) + 1 ;
+				break ;
+
+			default:
+				packet[0] = 0x00 ;
+				break ;
+			}
+		}
+
+		if ((write(fd, packet, sizeof(packet)) != sizeof(packet)) || (write(fd, junk, len) != (ssize_t)len))
+			status = -1 ;
+	}
+
+	fclose(in) ;
+	close(fd) ;
+	if (status)
+		unlink(noisy_filename) ;
+
+	return status ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Parse a noisy copy of the file as 1 chunk and as the most chunks allowed, and compare. Returns the number of failures
+static unsigned test_noisy(const char *filename, unsigned num_threads, unsigned debug)
+{
+char noisy_filename[] = "/tmp/ts_parallel_XXXXXX" ;
+struct TS_summary *ref ;
+struct TS_summary *summary ;
+unsigned failed = 0 ;
+
+	if (test_noisy_file(filename, noisy_filename) != 0)
+	{
+		printf("FAIL noisy : unable to write %s\n", noisy_filename) ;
+		return 1 ;
+	}
+
+	ref = ts_parse_parallel(noisy_filename, 1, 1, debug) ;
+	summary = NULL ;
+	if (ref)
+		summary = ts_parse_parallel(noisy_filename, num_threads, ~0u, debug) ;
+
+	if (!ref)
+	{
+		// the file was already too noisy to add more
+		printf("SKIP noisy : parse error %d : %s\n", dvb_error_code, dvb_error_str(dvb_error_code)) ;
+	}
+	else if (!summary)
+	{
+		printf("FAIL noisy : parse error %d : %s\n", dvb_error_code, dvb_error_str(dvb_error_code)) ;
+		++failed ;
+	}
+	else
+	{
+		failed += test_compare(ref, summary) ;
+		printf("%s noisy : %"PRIu64" pkts, %u pids, chunks of %u pkts\n",
+				failed ? "FAIL" : "PASS", summary->total_pkts, summary->num_pids, (unsigned)TS_PARALLEL_MIN_CHUNK) ;
+	}
+
+	tssummary_free(ref) ;
+	tssummary_free(summary) ;
+	unlink(noisy_filename) ;
+
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct TS_summary *ref ;
+struct TS_summary *summary ;
+unsigned num_threads = 0 ;
+unsigned num_chunks = 0 ;
+unsigned debug = 0 ;
+unsigned failed = 0 ;
+double start, ref_time, par_time ;
+int c ;
+
+	while ((c = getopt (argc, argv, "t:c:d:")) != -1)
+	{
+		switch (c)
+		{
+		case 't':
+			num_threads = atoi(optarg) ;
+			break;
+
+		case 'c':
+			num_chunks = atoi(optarg) ;
+			break;
+
+		case 'd':
+			debug = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	if (optind >= argc)
+	{
+		printf("Error: Must specify input filename\n") ;
+		abort() ;
+	}
+
+	failed += test_wrap() ;
+
+	start = test_time() ;
+	ref = ts_parse_parallel(argv[optind], 1, 1, debug) ;
+	ref_time = test_time() - start ;
+
+	start = test_time() ;
+	summary = ts_parse_parallel(argv[optind], num_threads, num_chunks, debug) ;
+	par_time = test_time() - start ;
+
+	if (!ref || !summary)
+	{
+		printf("FAIL : parse error %d : %s\n", dvb_error_code, dvb_error_str(dvb_error_code)) ;
+		return 1 ;
+	}
+
+	failed += test_compare(ref, summary) ;
+
+	printf("%s : %"PRIu64" pkts, %u pids, start %"PRId64" end %"PRId64" : 1 chunk %.3f s, parallel %.3f s\n",
+			failed ? "FAIL" : "PASS",
+			summary->total_pkts, summary->num_pids, summary->start_ts, summary->end_ts,
+			ref_time, par_time) ;
+
+	tssummary_free(ref) ;
+	tssummary_free(summary) ;
+
+	failed += test_noisy(argv[optind], num_threads, debug) ;
+
+	return failed ? 1 : 0 ;
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * ts_parallel.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef TS_PARALLEL_H_
+#define TS_PARALLEL_H_
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+#include <inttypes.h>
+
+#include "ts_structs.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+// don't bother splitting the file into chunks smaller than this (packets)
+#ifndef TS_PARALLEL_MIN_CHUNK
+#define TS_PARALLEL_MIN_CHUNK	(64 * 1024)
+#endif
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+// Results for one pid over a range of packets
+struct TS_pid_summary {
+	unsigned	pid ;
+	uint64_t	num_pkts ;
+	uint64_t	num_errors ;		// packets with a sync or transport error
+
+	// first/last packet on this pid
+	uint64_t	start_pkt ;
+	uint64_t	end_pkt ;
+
+	// as TS_pesinfo start/end (UNSET_TS if none seen)
+	int64_t		start_pts ;
+	int64_t		end_pts ;
+	int64_t		start_dts ;
+	int64_t		end_dts ;
+};
+
+// Results for a range of packets. Summaries of consecutive ranges of the file can be merged with tssummary_merge()
+struct TS_summary {
+	uint64_t				total_pkts ;
+	unsigned				num_pids ;
+
+	// as TS_state start/end - set by tssummary_set_timing()
+	int64_t					start_ts ;
+	int64_t					end_ts ;
+
+	// direct lookup by pid (NULL until first packet seen on that pid)
+	struct TS_pid_summary	*pids[ALL_PID] ;
+
+	// reader packet numbers (as TS_pidinfo pktnum) at the start of the range (set before parsing it) and after its
+	// last packet (set by tssummary_add_timing()). The packets in the next range are renumbered to follow on from
+	// end_pkt when merged
+	uint64_t				start_pkt ;
+	uint64_t				end_pkt ;
+};
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+struct TS_summary *tssummary_new(void) ;
+void tssummary_free(struct TS_summary *summary) ;
+
+void tssummary_packet(struct TS_summary *summary, struct TS_pidinfo *pidinfo) ;
+void tssummary_add_timing(struct TS_summary *summary, struct TS_reader *tsreader) ;
+void tssummary_merge(struct TS_summary *summary, const struct TS_summary *next) ;
+void tssummary_set_timing(struct TS_summary *summary) ;
+
+struct TS_summary *ts_parse_parallel(char *filename, unsigned num_threads, unsigned num_chunks, unsigned debug) ;
+
+#endif /* TS_PARALLEL_H_ */
@@ -15,11 +15,16 @@
 #include <ctype.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "ts_parse.h"
 #include "ts_bits.h"
+#include "ts_readahead.h"
+#include "ts_follow.h"
+#include "ts_sync.h"
 #include "tables/parse_si.h"
-#include "dvbsnoop/crc32.h"
+#include "ts_crc32.h"
 
 /*=============================================================================================*/
 // libmpeg2
@@ -27,10 +32,11 @@ void dump_state (FILE * f, mpeg2_state_t state, const mpeg2_info_t * info,
 		 int offset, int verbose);
 
 /*=============================================================================================*/
+// Local
+static int tsreader_data_process(struct TS_reader *tsreader) ;
+static void iter_reset(struct TS_reader *tsreader) ;
 
-// Check for PTS/DTS wrap
-#define MAX_TS_DIFF		(60 * TS_FREQ)
-#define TS_WRAP			(1LL << 33)
+/*=============================================================================================*/
 
 // libmpeg2 states
 static char *STATE_STRINGS[16] = {
@@ -154,6 +160,120 @@ unsigned byte ;
 }
 
 
+/*=============================================================================================*/
+// TS_buffer_pool
+
+/* ----------------------------------------------------------------------- */
+// Size class needed to hold size bytes (TS_POOL_CLASSES if bigger than the largest class)
+static unsigned pool_class(unsigned size)
+{
+unsigned cls = 0 ;
+unsigned block_size = TS_POOL_MIN_SIZE ;
+
+	while ((cls < TS_POOL_CLASSES) && (block_size < size))
+	{
+		++cls ;
+		block_size <<= 1 ;
+	}
+	return cls ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Get a block of at least size bytes. Sets *block_size to the actual size
+static uint8_t *pool_alloc(struct TS_buffer_pool *pool, unsigned size, unsigned *block_size)
+{
+unsigned cls = pool_class(size) ;
+uint8_t *block ;
+
+	if (cls < TS_POOL_CLASSES)
+	{
+		*block_size = TS_POOL_MIN_SIZE << cls ;
+
+		// reuse a free block if there is one (the free list link is stored in the block)
+		block = pool->free_list[cls] ;
+		if (block)
+		{
+			memcpy(&pool->free_list[cls], block, sizeof(uint8_t *)) ;
+		}
+	}
+	else
+	{
+		*block_size = (size + TS_POOL_MIN_SIZE-1) & ~(TS_POOL_MIN_SIZE-1) ;
+		block = NULL ;
+	}
+
+	if (!block)
+	{
+		// keep within the limit, giving back the unused blocks if that helps
+		if (pool->mem_limit && (pool->stats.mem_allocated + *block_size > pool->mem_limit))
+		{
+			buffer_pool_free(pool) ;
+			if (pool->stats.mem_allocated + *block_size > pool->mem_limit)
+			{
+				++pool->stats.num_fails ;
+				*block_size = 0 ;
+				return NULL ;
+			}
+		}
+
+		block = (uint8_t *)malloc(*block_size) ;
+		if (!block)
+		{
+			*block_size = 0 ;
+			return NULL ;
+		}
+
+		pool->stats.mem_allocated += *block_size ;
+		pool->stats.mem_total += *block_size ;
+		++pool->stats.num_mallocs ;
+	}
+
+	pool->stats.mem_in_use += *block_size ;
+	if (pool->stats.mem_in_use > pool->stats.mem_peak)
+		pool->stats.mem_peak = pool->stats.mem_in_use ;
+
+	return block ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Hand a block back to the pool
+static void pool_release(struct TS_buffer_pool *pool, uint8_t *block, unsigned block_size)
+{
+unsigned cls = pool_class(block_size) ;
+
+	pool->stats.mem_in_use -= block_size ;
+
+	if ((cls < TS_POOL_CLASSES) && (block_size == (TS_POOL_MIN_SIZE << cls)))
+	{
+		memcpy(block, &pool->free_list[cls], sizeof(uint8_t *)) ;
+		pool->free_list[cls] = block ;
+	}
+	else
+	{
+		pool->stats.mem_allocated -= block_size ;
+		free(block) ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Free all unused blocks held by the pool
+void buffer_pool_free(struct TS_buffer_pool *pool)
+{
+unsigned cls ;
+uint8_t *block ;
+
+	for (cls=0; cls < TS_POOL_CLASSES; ++cls)
+	{
+		while ( (block = pool->free_list[cls]) )
+		{
+			memcpy(&pool->free_list[cls], block, sizeof(uint8_t *)) ;
+			pool->stats.mem_allocated -= (TS_POOL_MIN_SIZE << cls) ;
+			free(block) ;
+		}
+	}
+}
+
+
 /*=============================================================================================*/
 // TS_buff
 
@@ -162,15 +282,14 @@ void buffer_free(struct TS_buffer **buff)
 {
 struct TS_buffer *bp = *buff ;
 
-//fprintf(stderr, "buffer_free(**TS_buffer=%p)\n", buff) ;
-
 	if (bp)
 	{
-//		fprintf(stderr, " + **TS_buffer=%p [=> %p]\n", buff, *buff) ;
-//		fprintf(stderr, " + buff_size=%d buff= %p\n", bp->buff_size, bp->buff) ;
 		if (bp->buff_size)
 		{
-			free(bp->buff) ;
+			if (bp->pool)
+				pool_release(bp->pool, bp->buff, bp->buff_size) ;
+			else
+				free(bp->buff) ;
 		}
 		free(bp) ;
 	}
@@ -194,7 +313,21 @@ struct TS_buffer *bp ;
 	bp->buff = (uint8_t *)malloc(TS_BUFFSIZE*sizeof(uint8_t)) ;
 	bp->buff_size = TS_BUFFSIZE ;
 
-//fprintf(stderr, "buffer_new() TS_buffer=%p [buff = %p])\n", bp, bp->buff) ;
+	return bp ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Create a buffer that takes its memory from the pool (no memory is used until data is added)
+struct TS_buffer *buffer_new_pooled(struct TS_buffer_pool *pool)
+{
+struct TS_buffer *bp ;
+
+	// create struct
+	bp = (struct TS_buffer *)malloc(sizeof(struct TS_buffer)) ;
+	CLEAR_MEM(bp) ;
+
+	bp->MAGIC = MAGIC_BUFF ;
+	bp->pool = pool ;
 
 	return bp ;
 }
@@ -208,12 +341,14 @@ void buffer_clear(struct TS_buffer *bp)
 
 
 /* ----------------------------------------------------------------------- */
+// Append data to the buffer. The buffer grows geometrically and is never shrunk, so a buffer that is
+// re-used (e.g. for each PES packet on a pid) settles at the largest size needed
 uint8_t *buffer_data(struct TS_buffer **buff, const uint8_t *data, unsigned data_len)
 {
 struct TS_buffer *bp ;
 unsigned new_len ;
-
-//fprintf(stderr, "buffer_data(**TS_buffer=%p, data_len=%d)\n", buff, data_len) ;
+unsigned new_size ;
+uint8_t *new_buff ;
 
 	// check for first time
 	if (!*buff)
@@ -224,27 +359,35 @@ unsigned new_len ;
 	bp = *buff ;
 	new_len = bp->data_len + data_len ;
 
-//	fprintf(stderr, " + **TS_buffer=%p [=> %p] : buff=%p\n", buff, *buff, bp->buff) ;
-
 	// able to add data?
-	if (new_len >= bp->buff_size)
-	{
-//		fprintf(stderr, " + + realloc()\n") ;
-		bp->buff_size += TS_BUFFSIZE ;
-		bp->buff = realloc(bp->buff, bp->buff_size) ;
-//		fprintf(stderr, " + + buff=%p\n", bp->buff) ;
-	}
-	else if (bp->buff_size - new_len > 2*TS_BUFFSIZE )
+	if (new_len > bp->buff_size)
 	{
-//		fprintf(stderr, " + + downsize() data_len=%d, new_len=%d : curr size=%d\n", bp->data_len, new_len, bp->buff_size) ;
-		// scale down if required
-		bp->buff_size = ( ( (new_len + TS_BUFFSIZE-1) / TS_BUFFSIZE) + 1) * TS_BUFFSIZE ;
-//		fprintf(stderr, " + + new size=%d\n", bp->buff_size) ;
-		bp->buff = realloc(bp->buff, bp->buff_size) ;
-//		fprintf(stderr, " + + buff=%p\n", bp->buff) ;
-	}
+		new_size = bp->buff_size ? bp->buff_size : TS_POOL_MIN_SIZE ;
+		while (new_size < new_len)
+			new_size <<= 1 ;
+
+		if (bp->pool)
+		{
+			new_buff = pool_alloc(bp->pool, new_size, &new_size) ;
+			if (new_buff && bp->buff_size)
+			{
+				memcpy(new_buff, bp->buff, bp->data_len) ;
+				pool_release(bp->pool, bp->buff, bp->buff_size) ;
+			}
+		}
+		else
+		{
+			new_buff = realloc(bp->buff, new_size) ;
+		}
 
-//	fprintf(stderr, " + buff=%p .. %p : copying into %p .. %p\n", bp->buff, &bp->buff[bp->buff_size-1], &bp->buff[bp->data_len], &bp->buff[bp->data_len+data_len-1]) ;
+		if (!new_buff)
+		{
+			SET_DVB_ERROR(ERR_MALLOC) ;
+			return bp->buff ;
+		}
+		bp->buff = new_buff ;
+		bp->buff_size = new_size ;
+	}
 
 	// copy data
 	memcpy(&bp->buff[bp->data_len], data, data_len) ;
@@ -259,19 +402,15 @@ unsigned new_len ;
 
 /* ----------------------------------------------------------------------- */
 // get existing or return created
-static struct TS_pid* piditem_get(struct list_head *pid_list, struct TS_pidinfo *pidinfo)
+static struct TS_pid* piditem_get(struct TS_state *tsstate, struct TS_pidinfo *pidinfo)
 {
 struct TS_pid   *piditem;
-struct list_head *item;
 
-	list_for_each(item, pid_list)
+	piditem = tsstate->pid_table[pidinfo->pid & MAX_PID] ;
+	if (piditem)
 	{
-		piditem = list_entry(item, struct TS_pid, next);
-		if (piditem->pidinfo.pid != pidinfo->pid)
-			continue;
-
 		return piditem;
-    }
+	}
 
 	piditem = malloc(sizeof(*piditem));
     CLEAR_MEM(piditem);
@@ -286,9 +425,10 @@ struct list_head *item;
 	//    };
 
     memcpy(&piditem->pidinfo, pidinfo, sizeof(*pidinfo)) ;
-    piditem->pes_buff = buffer_new() ;
+    piditem->pes_buff = NULL ;
     piditem->pes_state = PES_SKIP ;
-    list_add_tail(&piditem->next, pid_list);
+    list_add_tail(&piditem->next, &tsstate->pid_list);
+    tsstate->pid_table[pidinfo->pid & MAX_PID] = piditem ;
 
     piditem->pesinfo.start_pts = UNSET_TS ;
     piditem->pesinfo.start_dts = UNSET_TS ;
@@ -323,7 +463,8 @@ static void piditem_free(struct TS_pid * piditem)
 // Start of new PES, reset flags/counters etc
 static void pes_start(struct TS_pid * pid_item)
 {
-	pid_item->pes_buff->data_len = 0 ;
+	if (pid_item->pes_buff)
+		pid_item->pes_buff->data_len = 0 ;
 	pid_item->pes_state = PES_HEADER ;
 
 	pid_item->pesinfo.psi_error = 0 ;
@@ -340,9 +481,12 @@ static void pes_start(struct TS_pid * pid_item)
 //	struct TS_pidinfo 	pidinfo ;
 //	struct TS_pid		*pid_item ;
 //
-//	// list of TS_pid
+//	// list of TS_pid (in order of creation)
 //    struct list_head    pid_list;
 //
+//    // direct lookup of TS_pid by pid (NULL until first packet seen on that pid)
+//    struct TS_pid		*pid_table[ALL_PID] ;
+//
 //    // Set to total number of packets
 //    unsigned			total_pkts ;
 //
@@ -360,6 +504,36 @@ static void pes_start(struct TS_pid * pid_item)
 ////	struct list_head	pkt_list ;
 //};
 
+/* ----------------------------------------------------------------------- */
+// Zero the statistics of every pid seen so far (they stay allocated, so any pointers from tsreader_pid_stats() are
+// still valid)
+static void pid_stats_clear(struct TS_state *tsstate)
+{
+struct TS_pid_stats *stats ;
+unsigned i ;
+
+	for (i=0; i < tsstate->num_stats_pids; ++i)
+	{
+		stats = tsstate->pid_stats[tsstate->stats_pids[i]] ;
+		CLEAR_MEM(stats) ;
+		stats->next_cc = TS_STATS_CC_UNSET ;
+	}
+	tsstate->stats_pcr_pid = ALL_PID ;
+}
+
+/* ----------------------------------------------------------------------- */
+static void pid_stats_free(struct TS_state *tsstate)
+{
+unsigned i ;
+
+	for (i=0; i < tsstate->num_stats_pids; ++i)
+	{
+		free(tsstate->pid_stats[tsstate->stats_pids[i]]) ;
+		tsstate->pid_stats[tsstate->stats_pids[i]] = NULL ;
+	}
+	tsstate->num_stats_pids = 0 ;
+}
+
 /* ----------------------------------------------------------------------- */
 static void tsstate_free(struct TS_state *tsstate)
 {
@@ -373,6 +547,10 @@ struct TS_pid    *piditem;
 		list_del(&piditem->next);
 		piditem_free(piditem);
 	};
+	pid_stats_free(tsstate) ;
+	buffer_pool_free(&tsstate->buff_pool) ;
+	section_cache_clear(&tsstate->section_cache, 0, 0) ;
+	arena_clear(&tsstate->si_arena) ;
 //	list_for_each_safe(item,safe,&tsstate->pkt_list)
 //	{
 //		pktitem = list_entry(item, struct TS_pkt, next);
@@ -405,6 +583,9 @@ struct TS_state *tsstate ;
 	tsstate->total_pkts = 0 ;
 	tsstate->stop_flag = 0 ;
 
+	// no pid statistics until the first packet on each pid
+	tsstate->stats_pcr_pid = ALL_PID ;
+
 //    // list of TS packets
 //	INIT_LIST_HEAD(&tsstate->pkt_list);
 //	tsstate->start_pktnum = 0LLU ;
@@ -460,7 +641,7 @@ unsigned flags = 0 ;
 				{
 					flags |= FRAME_FLAG_START ;
 
-					tsparse_dbg_prt(200, (" @@ Video Start @@ pes start pkt %u : [at offset %d]\n",
+					tsparse_dbg_prt(200, (" @@ Video Start @@ pes start pkt %"PRIu64" : [at offset %d]\n",
 							tsstate->pid_item->pesinfo.start_pkt, (int)(p-pesdata))) ;
 				}
 				else
@@ -522,7 +703,7 @@ unsigned flags = 0 ;
 						break ;
 					}
 
-					tsparse_dbg_prt(200, ("    @#@ code 0x%02x %s @#@ pes start pkt %u : [at offset %d]\n",
+					tsparse_dbg_prt(200, ("    @#@ code 0x%02x %s @#@ pes start pkt %"PRIu64" : [at offset %d]\n",
 							(int)p[3], codestr, tsstate->pid_item->pesinfo.start_pkt, (int)(p-pesdata))) ;
 				}
 				p+=3 ;
@@ -575,15 +756,13 @@ mpeg2_state_t state;
 unsigned state_cycle = 0 ;
 unsigned frame_flags ;
 
-// for debug
-static int total_offset = 0;
 const mpeg2_info_t * info;
 
 	CHECK_TS_READER(tsreader) ;
 
 
 	tsparse_dbg_prt(202, ("\n\n--[ video ]----------\n%d bytes\n", pesdata_len)) ;
-	if (tsreader->debug >= 202)
+	if (tsparse_dbg_on(202))
 		dump_buff(pesdata, pesdata_len, pesdata_len) ;
 
 	// mainly looking for GOP start
@@ -601,7 +780,7 @@ const mpeg2_info_t * info;
 
 	// for debug
     info = mpeg2_info(tsreader->mpeg2.decoder);
-    total_offset += pesdata_len ;
+    tsreader->mpeg2.total_offset += pesdata_len ;
 
 	do
 	{
@@ -622,9 +801,9 @@ const mpeg2_info_t * info;
 		 *  GOP = Group of 26 pictures
 		 */
 		tsparse_dbg_prt(200, ("---[ mpeg2 dump_state ]------------------------\nstate = %s [%d]\n", STATE_STRINGS[state], state));
-		if (tsreader->debug >= 202)
+		if (tsparse_dbg_on(202))
 			dump_state (stderr, state, info,
-					total_offset - mpeg2_getpos(tsreader->mpeg2.decoder), 100 /* verbosity */);
+					tsreader->mpeg2.total_offset - mpeg2_getpos(tsreader->mpeg2.decoder), 100 /* verbosity */);
 		tsparse_dbg_prt(102, ("state = %s [%d]\n", STATE_STRINGS[state], state));
 
 		switch (state) {
@@ -696,14 +875,14 @@ const mpeg2_info_t * info;
 
 	// Use the tags to store:
 	// tag = frame info index
-	// tag2 = packet count of pes containing GOP (once every 26 frames)
+	// tag2 = packet count of pes containing GOP (once every 26 frames) - low 32 bits only, the full count is in frame_info
 	struct TS_frame_info *frame_info = frame_info_entry(tsreader, tsreader->mpeg2.frame_info_index) ;
 	frame_info->framenum = tsreader->mpeg2.framenum ;
 	frame_info->gop_pkt = tsreader->mpeg2.gop_pktnum ;
 	memcpy(&frame_info->pesinfo, &tsstate->pid_item->pesinfo, sizeof(tsstate->pid_item->pesinfo)) ;
 	memcpy(&frame_info->pidinfo, &tsstate->pid_item->pidinfo, sizeof(tsstate->pid_item->pidinfo)) ;
 
-	mpeg2_tag_picture(tsreader->mpeg2.decoder, tsreader->mpeg2.frame_info_index, tsreader->mpeg2.gop_pktnum) ;
+	mpeg2_tag_picture(tsreader->mpeg2.decoder, tsreader->mpeg2.frame_info_index, (uint32_t)tsreader->mpeg2.gop_pktnum) ;
 	tsreader->mpeg2.frame_info_index++ ;
 
 	tsparse_dbg_prt(102, ("cycle=%d\n-------------------------------------\n\n", state_cycle));
@@ -718,14 +897,12 @@ mpeg2_state_t state;
 unsigned state_cycle = 0 ;
 unsigned frame_flags ;
 
-// for debug
-static int total_offset = 0;
 const mpeg2_info_t * info;
 
 	CHECK_TS_READER(tsreader) ;
 
 	tsparse_dbg_prt(202, ("\n\n--[ rgb video ]----------\n%d bytes\n", pesdata_len)) ;
-	if (tsreader->debug >= 202)
+	if (tsparse_dbg_on(202))
 		dump_buff(pesdata, pesdata_len, pesdata_len) ;
 
 	// mainly looking for GOP start
@@ -743,7 +920,7 @@ const mpeg2_info_t * info;
 
 	// for debug
     info = mpeg2_info(tsreader->mpeg2.decoder);
-    total_offset += pesdata_len ;
+    tsreader->mpeg2.total_offset += pesdata_len ;
 
 	do
 	{
@@ -763,9 +940,9 @@ const mpeg2_info_t * info;
 		 *  GOP = Group of 26 pictures
 		 */
 		tsparse_dbg_prt(200, ("---[ rgb mpeg2 dump_state ]------------------------\nstate = %s [%d]\n", STATE_STRINGS[state], state));
-		if (tsreader->debug >= 202)
+		if (tsparse_dbg_on(202))
 			dump_state (stderr, state, info,
-					total_offset - mpeg2_getpos(tsreader->mpeg2.decoder), 100 /* verbosity */);
+					tsreader->mpeg2.total_offset - mpeg2_getpos(tsreader->mpeg2.decoder), 100 /* verbosity */);
 		tsparse_dbg_prt(102, ("state = %s [%d]\n", STATE_STRINGS[state], state));
 
 		switch (state) {
@@ -825,14 +1002,14 @@ const mpeg2_info_t * info;
 
 	// Use the tags to store:
 	// tag = frame info index
-	// tag2 = packet count of pes containing GOP (once every 26 frames)
+	// tag2 = packet count of pes containing GOP (once every 26 frames) - low 32 bits only, the full count is in frame_info
 	struct TS_frame_info *frame_info = frame_info_entry(tsreader, tsreader->mpeg2.frame_info_index) ;
 	frame_info->framenum = tsreader->mpeg2.framenum ;
 	frame_info->gop_pkt = tsreader->mpeg2.gop_pktnum ;
 	memcpy(&frame_info->pesinfo, &tsstate->pid_item->pesinfo, sizeof(tsstate->pid_item->pesinfo)) ;
 	memcpy(&frame_info->pidinfo, &tsstate->pid_item->pidinfo, sizeof(tsstate->pid_item->pidinfo)) ;
 
-	mpeg2_tag_picture(tsreader->mpeg2.decoder, tsreader->mpeg2.frame_info_index, tsreader->mpeg2.gop_pktnum) ;
+	mpeg2_tag_picture(tsreader->mpeg2.decoder, tsreader->mpeg2.frame_info_index, (uint32_t)tsreader->mpeg2.gop_pktnum) ;
 	tsreader->mpeg2.frame_info_index++ ;
 
 	tsparse_dbg_prt(102, ("cycle=%d\n-------------------------------------\n\n", state_cycle));
@@ -978,7 +1155,7 @@ unsigned dbg_num ;
 	tsstate->pid_item->pesinfo.code = code ;
 
 	tsparse_dbg_prt(102, ("PES code 0x%03x PES Len %d Data:\n", code, packet_length)) ;
-	if (tsreader->debug >= 103)
+	if (tsparse_dbg_on(103))
 		dump_buff(payload, payload_len, 32) ;
 
 	byte = 6 ;
@@ -1063,8 +1240,8 @@ dbg_num=5 ;
 				tsstate->pidinfo.pid_error++ ;
 				if (tsreader->error_hook)
 				{
-					SET_DVB_ERROR(ERR_PESHEAD) ;
-					tsreader->error_hook(dvb_error_code, &tsstate->pidinfo, tsreader->user_data) ;
+					SET_TSREADER_ERROR(tsreader, ERR_PESHEAD) ;
+					tsreader->error_hook(tsreader->error_code, &tsstate->pidinfo, tsreader->user_data) ;
 				}
 			}
 			pts = (int64_t)((payload[byte] >> 1) & 0x07) << 30;
@@ -1072,7 +1249,7 @@ dbg_num=5 ;
 			pts |=  (((payload[byte+3]<<8) | payload[byte+4]) >> 1);
 
 			tsparse_dbg_prt(100, ("PTS definition:\n")) ;
-			if (tsreader->debug >= 100)
+			if (tsparse_dbg_on(100))
 				dump_buff(&payload[byte], payload_len, 5) ;
 
 			byte += 5 ;
@@ -1124,8 +1301,8 @@ dbg_num=10 ;
 				tsstate->pidinfo.pid_error++ ;
 				if (tsreader->error_hook)
 				{
-					SET_DVB_ERROR(ERR_PESHEAD) ;
-					tsreader->error_hook(dvb_error_code, &tsstate->pidinfo, tsreader->user_data) ;
+					SET_TSREADER_ERROR(tsreader, ERR_PESHEAD) ;
+					tsreader->error_hook(tsreader->error_code, &tsstate->pidinfo, tsreader->user_data) ;
 				}
 			}
 		    pts = (int64_t)((payload[byte] >> 1) & 0x07) << 30;
@@ -1133,7 +1310,7 @@ dbg_num=10 ;
 		    pts |=  (((payload[byte+3]<<8) | payload[byte+4]) >> 1);
 
 			tsparse_dbg_prt(100, ("PTS definition:\n")) ;
-		    if (tsreader->debug >= 100)
+		    if (tsparse_dbg_on(100))
 				dump_buff(&payload[byte], payload_len, 5) ;
 
 		    byte += 5 ;
@@ -1143,7 +1320,7 @@ dbg_num=10 ;
 		    dts |=  (((payload[byte+3]<<8) | payload[byte+4]) >> 1);
 
 			tsparse_dbg_prt(100, ("DTS definition:\n")) ;
-		    if (tsreader->debug >= 100)
+		    if (tsparse_dbg_on(100))
 				dump_buff(&payload[byte], payload_len, 5) ;
 
 			byte += 5 ;
@@ -1275,7 +1452,7 @@ dbg_num=10 ;
 		// DTS
 		if (tsstate->pid_item->pesinfo.start_dts == UNSET_TS)
 		{
-			tsstate->pid_item->pesinfo.start_dts = pts ;
+			tsstate->pid_item->pesinfo.start_dts = dts ;
 		}
 		else
 		{
@@ -1289,7 +1466,7 @@ dbg_num=10 ;
 
 		if (tsstate->pid_item->pesinfo.end_dts == UNSET_TS)
 		{
-			tsstate->pid_item->pesinfo.end_dts = pts ;
+			tsstate->pid_item->pesinfo.end_dts = dts ;
 		}
 		else
 		{
@@ -1321,78 +1498,128 @@ printf("]\n") ;
 
 
 /* ----------------------------------------------------------------------- */
-static int handle_payload(struct TS_reader *tsreader, struct TS_state *tsstate,
-			uint8_t *payload, unsigned payload_len)
+// Does anything use the complete PES/PSI starting on the current pid? Hooks are checked each time so
+// the decision follows any changes made to them; registered sections are cached in tsstate->psi_pids
+static unsigned reassembly_required(struct TS_reader *tsreader, struct TS_state *tsstate, unsigned is_pes)
 {
-	CHECK_TS_READER(tsreader) ;
-	if (tsstate->pidinfo.pid == NULL_PID)
+unsigned code ;
+
+	// these get everything
+	if (tsreader->pes_hook || tsreader->pes_data_hook)
+		return 1 ;
+
+	// pull iterator
+	if (tsreader->iter.want & (is_pes ? TS_ITER_PES : TS_ITER_SECTIONS))
+		return 1 ;
+
+	if (is_pes)
+	{
+		code = tsstate->pid_item->pesinfo.code ;
+
+		if (tsreader->mpeg2.decoder && ((code & video_stream_mask) == video_stream))
+			return 1 ;
+
+		if (tsreader->audio_hook && ((code & audio_stream_mask) == audio_stream))
+			return 1 ;
+
 		return 0 ;
+	}
 
-	tsparse_dbg_prt(102, ("handle_payload(pid %d) : pkt %u : payload len %d  pes_start=%d\n",
-		tsstate->pidinfo.pid, tsstate->pidinfo.pktnum,
-		payload_len, tsstate->pidinfo.pes_start?1:0)) ;
+	return PID_BITMAP_TEST(tsstate->psi_pids, tsstate->pidinfo.pid) ;
+}
 
-    // process buffered data
-	if (tsstate->pidinfo.pes_start)
+/* ----------------------------------------------------------------------- */
+// The PES/PSI buffered on the current pid is complete - pass it on to the decoders, hooks and pull iterator
+static void unit_complete(struct TS_reader *tsreader, struct TS_state *tsstate)
+{
+uint8_t *buff = tsstate->pid_item->pes_buff->buff ;
+unsigned buff_len = tsstate->pid_item->pes_buff->data_len ;
+
+	tsparse_dbg_prt(102, ("handle_payload(pid %d) : call process_*() with existing buffer : buffered data len %d:\n",
+			tsstate->pidinfo.pid, tsstate->pid_item->pes_buff->data_len)) ;
+
+	if ((buff[0]==0) && (buff[1]==0) && (buff[2]==1))
 	{
-		if (tsstate->pid_item->pes_buff->data_len)
-		{
-		uint8_t *buff = tsstate->pid_item->pes_buff->buff ;
-		unsigned buff_len = tsstate->pid_item->pes_buff->data_len ;
+		// do something with the PES data
+		tsstate->pid_item->pesinfo.pes_psi = T_PES ;
+		process_pes(tsreader, tsstate, buff, buff_len) ;
+	}
 
-			tsparse_dbg_prt(102, ("handle_payload(pid %d) : call process_*() with existing buffer : buffered data len %d:\n",
-					tsstate->pidinfo.pid, tsstate->pid_item->pes_buff->data_len)) ;
+	//# PSI
+	else
+	{
+		if (tsparse_dbg_on(103))
+			dump_buff(buff, buff_len, (tsparse_dbg_on(104) ? buff_len : 31) ) ;
 
-			if ((buff[0]==0) && (buff[1]==0) && (buff[2]==1))
-			{
-				// do something with the PES data
-				tsstate->pid_item->pesinfo.pes_psi = T_PES ;
-				process_pes(tsreader, tsstate, buff, buff_len) ;
-			}
+		// do something with the PSI data
+		tsstate->pid_item->pesinfo.pes_psi = T_PSI ;
+		parse_si(tsreader, tsstate, buff, buff_len) ;
+	}
 
-			//# PSI
-			else
-			{
-				if (tsreader->debug >= 103)
-					dump_buff(buff, buff_len, (tsreader->debug >= 104 ? buff_len : 31) ) ;
+	// send to hook
+	if (tsreader->pes_hook)
+	{
+		// Complete PES packet - Header + Data
+		tsreader->pes_hook(&tsstate->pidinfo, &tsstate->pid_item->pesinfo,
+				buff, buff_len,
+				tsreader->user_data) ;
+	}
 
-				// do something with the PSI data
-				tsstate->pid_item->pesinfo.pes_psi = T_PSI ;
-				parse_si(tsreader, tsstate, buff, buff_len) ;
-			}
+	// send to hook
+	if (tsreader->pes_data_hook)
+	{
+		// Just the PES data
+		tsreader->pes_data_hook(&tsstate->pidinfo, &tsstate->pid_item->pesinfo,
+				tsstate->pid_item->pesinfo.pesdata_p, tsstate->pid_item->pesinfo.pesdata_len,
+				tsreader->user_data) ;
+	}
 
-			// send to hook
-			if (tsreader->pes_hook)
-			{
-				// Complete PES packet - Header + Data
-				tsreader->pes_hook(&tsstate->pidinfo, &tsstate->pid_item->pesinfo,
-						buff, buff_len,
-						tsreader->user_data) ;
-			}
+	// send to hook
+	if (tsreader->mpeg2.decoder)
+	{
+		// Just the PES data
+		process_mpeg2(tsreader, tsstate, tsstate->pid_item->pesinfo.pesdata_p, tsstate->pid_item->pesinfo.pesdata_len) ;
+	}
 
-			// send to hook
-			if (tsreader->pes_data_hook)
-			{
-				// Just the PES data
-				tsreader->pes_data_hook(&tsstate->pidinfo, &tsstate->pid_item->pesinfo,
-						tsstate->pid_item->pesinfo.pesdata_p, tsstate->pid_item->pesinfo.pesdata_len,
-						tsreader->user_data) ;
-			}
+	// send to hook
+	if (tsreader->audio_hook)
+	{
+		// Just the PES data
+		process_audio(tsreader, tsstate, tsstate->pid_item->pesinfo.pesdata_p, tsstate->pid_item->pesinfo.pesdata_len) ;
+	}
 
-			// send to hook
-			if (tsreader->mpeg2.decoder)
-			{
-				// Just the PES data
-				process_mpeg2(tsreader, tsstate, tsstate->pid_item->pesinfo.pesdata_p, tsstate->pid_item->pesinfo.pesdata_len) ;
-			}
+	// pass to the pull iterator - the buffer is swapped out so it's left intact until the next call
+	if (!tsreader->iter.unit_buff &&
+			(tsreader->iter.want & (tsstate->pid_item->pesinfo.pes_psi == T_PES ? TS_ITER_PES : TS_ITER_SECTIONS)) )
+	{
+		tsreader->iter.unit_buff = tsstate->pid_item->pes_buff ;
+		tsreader->iter.pidinfo = tsstate->pidinfo ;
+		tsreader->iter.pesinfo = tsstate->pid_item->pesinfo ;
 
-			// send to hook
-			if (tsreader->audio_hook)
-			{
-				// Just the PES data
-				process_audio(tsreader, tsstate, tsstate->pid_item->pesinfo.pesdata_p, tsstate->pid_item->pesinfo.pesdata_len) ;
-			}
-		}
+		tsstate->pid_item->pes_buff = tsreader->iter.spare_buff ;
+		tsreader->iter.spare_buff = NULL ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+static int handle_payload(struct TS_reader *tsreader, struct TS_state *tsstate,
+			uint8_t *payload, unsigned payload_len)
+{
+unsigned is_pes = 0 ;
+
+	CHECK_TS_READER(tsreader) ;
+	if (tsstate->pidinfo.pid == NULL_PID)
+		return 0 ;
+
+	tsparse_dbg_prt(102, ("handle_payload(pid %d) : pkt %"PRIu64" : payload len %d  pes_start=%d\n",
+		tsstate->pidinfo.pid, tsstate->pidinfo.pktnum,
+		payload_len, tsstate->pidinfo.pes_start?1:0)) ;
+
+    // process buffered data
+	if (tsstate->pidinfo.pes_start)
+	{
+		if (tsstate->pid_item->pes_buff && tsstate->pid_item->pes_buff->data_len)
+			unit_complete(tsreader, tsstate) ;
 
 		// reset state
 		pes_start(tsstate->pid_item) ;
@@ -1403,6 +1630,8 @@ static int handle_payload(struct TS_reader *tsreader, struct TS_state *tsstate,
 	{
 		tsstate->pid_item->pesinfo.start_pkt = tsreader->tsstate->pidinfo.pktnum ;
 		tsstate->pid_item->pesinfo.end_pkt = tsreader->tsstate->pidinfo.pktnum ;
+		tsstate->pid_item->pesinfo.start_pos = tsreader->buff_state.start_pos + tsreader->buff_state.skipped +
+				tsreader->buff_state.pktnum * tsreader->packet_size ;
 
 		tsparse_dbg_prt(102, ("handle_payload(pid %d) : calling process_* with new data : payload len = %d\n",
 				tsstate->pidinfo.pid, payload_len)) ;
@@ -1421,6 +1650,8 @@ static int handle_payload(struct TS_reader *tsreader, struct TS_state *tsstate,
 		{
 			// do something with the PES data
 			process_pes(tsreader, tsstate, payload, payload_len) ;
+
+			is_pes = 1 ;
 		}
 
 		//# PSI
@@ -1429,6 +1660,12 @@ static int handle_payload(struct TS_reader *tsreader, struct TS_state *tsstate,
 			// do something with the PSI data
 //SDP-just buffer until next start?//			process_psi(tsreader, tsstate, payload, payload_len) ;
 		}
+
+		// don't bother buffering if nothing is going to use the complete PES/PSI
+		if (!reassembly_required(tsreader, tsstate, is_pes))
+		{
+			tsstate->pid_item->pes_state = PES_SKIP ;
+		}
 	}
 
 	// buffer if required
@@ -1436,101 +1673,352 @@ static int handle_payload(struct TS_reader *tsreader, struct TS_state *tsstate,
 	{
 		tsstate->pid_item->pesinfo.end_pkt = tsreader->tsstate->pidinfo.pktnum ;
 
+		// only pids that actually get reassembled need a buffer
+		if (!tsstate->pid_item->pes_buff)
+			tsstate->pid_item->pes_buff = buffer_new_pooled(&tsstate->buff_pool) ;
+
 		buffer_data(&tsstate->pid_item->pes_buff, payload, payload_len) ;
 
 		tsparse_dbg_prt(102, ("<buffered> handle_payload(pid %d) : buffered - length now = %d\n",
 				tsstate->pidinfo.pid, tsstate->pid_item->pes_buff->data_len)) ;
-//		if (tsreader->debug >= 103)
-//			dump_buff(tsstate->pid_item->pes_buff->buff, tsstate->pid_item->pes_buff->data_len, (tsreader->debug >= 104 ? tsstate->pid_item->pes_buff->data_len : 31) ) ;
+//		if (tsparse_dbg_on(103))
+//			dump_buff(tsstate->pid_item->pes_buff->buff, tsstate->pid_item->pes_buff->data_len, (tsparse_dbg_on(104) ? tsstate->pid_item->pes_buff->data_len : 31) ) ;
 	}
 
 	return 0 ;
 }
 
 /* ----------------------------------------------------------------------- */
-static int parse_ts_packet(struct TS_reader *tsreader, struct TS_state *tsstate,
-		uint8_t *packet, unsigned packet_len)
+// Is the PES/PSI buffered on this pid complete at the end of the data? A PSI is always passed on (its sections carry
+// their own lengths) but a PES only if it has all of the bytes given by its PES_packet_length
+static unsigned unit_pending(struct TS_pid *piditem)
 {
-unsigned pid_ok, pes_complete ;
+struct TS_buffer *pes_buff = piditem->pes_buff ;
+unsigned pes_len ;
 
-uint8_t *payload ;
-unsigned start ;
-int payload_len ;
-
-	CHECK_TS_READER(tsreader) ;
-	tsstate->pid_item = NULL ;
-
-	/*
-		# ISO 13818-1
-		#
-		#	sync_byte 8 bslbf
-		#
-		#	transport_error_indicator 1 bslbf
-		#	payload_unit_start_indicator 1 bslbf
-		#	transport_priority 1 bslbf
-		#	PID 13 uimsbf
-		#
-		#	transport_scrambling_control 2 bslbf
-		#	adaptation_field_control 2 bslbf
-		#	continuity_counter 4 uimsbf
-		#
-		#	if(adaptation_field_control = = '10' || adaptation_field_control = = '11'){
-		#		adaptation_field()
-		#	}
-		#	if(adaptation_field_control = = '01' || adaptation_field_control = = '11') {
-		#		for (i = 0; i < N; i++){
-		#			data_byte 8 bslbf
-		#		}
-		#	}
-	*/
-	tsstate->pidinfo.pid = (((packet[1] & 0x1f) << 8) | (packet[2] & 0xff)) & MAX_PID ;
-	tsstate->pidinfo.err_flag = packet[1] & 0x80;
-	tsstate->pidinfo.pes_start = packet[1] & 0x40;
+	if ((piditem->pes_state == PES_SKIP) || !pes_buff || !pes_buff->data_len)
+		return 0 ;
 
-    /* skip adaptation field */
-	tsstate->pidinfo.afc = (packet[3] >> 4) & 3;
-	start=4 ;
-	payload = &packet[start] ;
+	if ((pes_buff->data_len >= 3) && (pes_buff->buff[0]==0) && (pes_buff->buff[1]==0) && (pes_buff->buff[2]==1))
+	{
+		if (pes_buff->data_len < 6)
+			return 0 ;
 
-	if (tsstate->pidinfo.afc == 0) /* reserved value */
-        return 0;
-    if (tsstate->pidinfo.afc == 2) /* adaptation field only */
-        return 0;
-    if (tsstate->pidinfo.afc == 3)
-    {
-        /* skip adaptation_field */
-    	start += payload[0] + 1 ;
-    }
-    /* if past the end of packet, ignore */
-    if (start >= packet_len)
-        return 0;
+		pes_len = (pes_buff->buff[4] << 8) | pes_buff->buff[5] ;
+		return pes_len && (pes_buff->data_len >= 6 + pes_len) ;
+	}
 
-	payload = &packet[start] ;
-	payload_len = packet_len - start ;
+	return 1 ;
+}
 
-if (tsreader->debug >= 100)
+/* ----------------------------------------------------------------------- */
+// At the end of the data, pass on the PES/PSI still buffered on each pid (normally one is only known to be complete
+// when the next starts). Passes on at most max_units (0 = all of them), and returns the number passed on
+static unsigned units_flush(struct TS_reader *tsreader, unsigned max_units)
 {
-	printf ("PID %d (0x%03x) - start=%d, payload len=%d\n", tsstate->pidinfo.pid, tsstate->pidinfo.pid, start, payload_len) ;
-	dump_buff(packet, packet_len, 31) ;
-}
+struct TS_state *tsstate = tsreader->tsstate ;
+struct TS_pidinfo pidinfo = tsstate->pidinfo ;
+struct TS_pid *pid_item = tsstate->pid_item ;
+struct list_head *item ;
+struct TS_pid *piditem ;
+unsigned num_units = 0 ;
+
+	list_for_each(item, &tsstate->pid_list)
+	{
+		piditem = list_entry(item, struct TS_pid, next) ;
+		if (!unit_pending(piditem))
+			continue ;
 
+		tsparse_dbg_prt(102, ("units_flush(pid %d) : %d bytes left at end of data\n", piditem->pidinfo.pid, piditem->pes_buff->data_len)) ;
 
-    // cumulative error
-    tsstate->pidinfo.pid_error = 0 ;
+		tsstate->pid_item = piditem ;
+		tsstate->pidinfo.pid = piditem->pidinfo.pid ;
+		tsstate->pidinfo.pes_start = 0 ;
+		unit_complete(tsreader, tsstate) ;
 
-	// look at pid?
-	pid_ok=1;
-	if (tsreader->pid_hook)
-	{
-		//# see if we want to process this pid
-		pid_ok = tsreader->pid_hook(tsstate->pidinfo.pid, tsreader->user_data) ;
+		// only once
+		pes_start(piditem) ;
+		piditem->pes_state = PES_SKIP ;
+
+		if (++num_units == max_units)
+			break ;
 	}
 
+	tsstate->pidinfo = pidinfo ;
+	tsstate->pid_item = pid_item ;
 
-	if (pid_ok)
-	{
-		// Update pid
-		tsstate->pid_item = piditem_get(&tsstate->pid_list, &tsstate->pidinfo) ;
+	return num_units ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Pass any saved packets to the batch hook. Must be called before the buffer the packets point into is changed
+static void tsreader_batch_flush(struct TS_reader *tsreader)
+{
+	if (tsreader->batch_len)
+	{
+		tsreader->batch_hook(tsreader->batch, tsreader->batch_len, tsreader->user_data) ;
+		tsreader->batch_len = 0 ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Continuity counter is not the expected value (or this is the first packet on the pid). A single repeat of a
+// packet is allowed, and the check is skipped on packets whose header is known to be corrupt or that flag a
+// discontinuity
+static void pid_stats_cc(struct TS_pid_stats *stats, const uint8_t *packet)
+{
+unsigned cc = packet[3] & 0x0f ;
+
+	if (packet[1] & 0x80)
+		return ;
+
+	if ((stats->next_cc != TS_STATS_CC_UNSET) && (cc != ((stats->next_cc - 1) & 0x0f)))
+	{
+		// discontinuity_indicator
+		if (!((packet[3] & 0x20) && packet[4] && (packet[5] & 0x80)))
+			++stats->cc_errors ;
+	}
+	stats->next_cc = (cc + 1) & 0x0f ;
+}
+
+/* ----------------------------------------------------------------------- */
+// PCR seen on a pid. Every TS_STATS_WINDOW of the reference PCR, set the bitrate of all pids over that window
+static void pid_stats_pcr(struct TS_state *tsstate, unsigned pid, const uint8_t *packet)
+{
+int64_t pcr ;
+int64_t elapsed ;
+struct TS_pid_stats *stats ;
+unsigned i ;
+
+	if ((tsstate->stats_pcr_pid != ALL_PID) && (tsstate->stats_pcr_pid != pid))
+		return ;
+
+	pcr = ((int64_t)packet[6] << 25) | (packet[7] << 17) | (packet[8] << 9) | (packet[9] << 1) | (packet[10] >> 7) ;
+	elapsed = (pcr - tsstate->stats_window_start) & (TS_WRAP-1) ;
+	if ((tsstate->stats_pcr_pid != ALL_PID) && (elapsed < TS_STATS_WINDOW))
+		return ;
+
+	for (i=0; i < tsstate->num_stats_pids; ++i)
+	{
+		stats = tsstate->pid_stats[tsstate->stats_pids[i]] ;
+		if ((tsstate->stats_pcr_pid != ALL_PID) && (elapsed < TS_STATS_MAX_WINDOW))
+			stats->bitrate = (unsigned)(((stats->pkts - stats->window_pkts) * TS_PACKET_LEN * 8 * TS_FREQ) / elapsed) ;
+		stats->window_pkts = stats->pkts ;
+	}
+	tsstate->stats_pcr_pid = pid ;
+	tsstate->stats_window_start = pcr ;
+}
+
+/* ----------------------------------------------------------------------- */
+// First packet on a pid - create its statistics. Returns NULL if out of memory (the pid just isn't counted)
+static struct TS_pid_stats *pid_stats_new(struct TS_state *tsstate, unsigned pid)
+{
+struct TS_pid_stats *stats ;
+
+	stats = (struct TS_pid_stats *)malloc(sizeof(struct TS_pid_stats)) ;
+	if (!stats)
+		return NULL ;
+	CLEAR_MEM(stats) ;
+	stats->next_cc = TS_STATS_CC_UNSET ;
+
+	tsstate->pid_stats[pid] = stats ;
+	tsstate->stats_pids[tsstate->num_stats_pids++] = pid ;
+
+	return stats ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Update the transport statistics for this packet's pid. Only allocates for the first packet on a pid, and anything
+// other than counting is moved out of line
+static inline __attribute__((always_inline)) void pid_stats_update(struct TS_state *tsstate,
+		const uint8_t *packet, unsigned packet_len)
+{
+unsigned pid = ((packet[1] & 0x1f) << 8) | packet[2] ;
+struct TS_pid_stats *stats = tsstate->pid_stats[pid] ;
+unsigned afc = (packet[3] >> 4) & 3 ;
+unsigned header_len ;
+
+	if (__builtin_expect(!stats, 0))
+	{
+		stats = pid_stats_new(tsstate, pid) ;
+		if (!stats)
+			return ;
+	}
+
+	++stats->pkts ;
+	if (__builtin_expect((packet[1] & 0x80) | (packet[3] & 0xc0), 0))
+	{
+		stats->tei += packet[1] >> 7 ;
+		stats->scrambled += (packet[3] & 0xc0) ? 1 : 0 ;
+	}
+
+	if (__builtin_expect(afc == 1, 1))
+	{
+		stats->payload_bytes += packet_len - 4 ;
+	}
+	else if (afc & 2)
+	{
+		header_len = 5 + packet[4] ;
+		if ((afc & 1) && (header_len < packet_len))
+			stats->payload_bytes += packet_len - header_len ;
+
+		if ((packet[4] >= 7) && (packet[5] & 0x10))
+		{
+			++stats->pcrs ;
+			pid_stats_pcr(tsstate, pid, packet) ;
+		}
+	}
+
+	// continuity counter only increments on packets with a payload
+	if (afc & 1)
+	{
+		if (__builtin_expect((packet[3] & 0x0f) == stats->next_cc, 1))
+			stats->next_cc = (stats->next_cc + 1) & 0x0f ;
+		else if (pid != NULL_PID)
+			pid_stats_cc(stats, packet) ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Continuity and timing are lost when the read position jumps, so restart the checks (keeps the counts)
+static void pid_stats_restart(struct TS_state *tsstate)
+{
+unsigned i ;
+
+	for (i=0; i < tsstate->num_stats_pids; ++i)
+		tsstate->pid_stats[tsstate->stats_pids[i]]->next_cc = TS_STATS_CC_UNSET ;
+	tsstate->stats_pcr_pid = ALL_PID ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Returns 1 if the packet was passed on (i.e. the same packets seen by the ts_hook), 0 if dropped.
+//
+// Always inlined with a constant 'loop' so that each specialised loop only contains the checks for the hooks that
+// it can be used with (see tsreader_select_loop())
+static inline __attribute__((always_inline)) int parse_ts_packet_loop(struct TS_reader *tsreader, struct TS_state *tsstate,
+		uint8_t *packet, unsigned packet_len, const enum TS_parse_loop loop)
+{
+unsigned pid_ok, pes_complete ;
+unsigned pid ;
+
+uint8_t *payload ;
+unsigned start ;
+int payload_len ;
+
+	CHECK_TS_READER(tsreader) ;
+	tsstate->pid_item = NULL ;
+
+	// the statistics are of the whole transport stream, so are kept for the pids that are filtered out too
+	pid_stats_update(tsstate, packet, packet_len) ;
+
+	// drop unwanted pids before doing anything else
+	if ((loop == TS_LOOP_GENERIC) && (tsreader->pid_filter_mode != PID_FILTER_OFF))
+	{
+		pid = (((packet[1] & 0x1f) << 8) | packet[2]) ;
+		if (!PID_BITMAP_TEST(tsreader->pid_filter, pid) &&
+				((tsreader->pid_filter_mode == PID_FILTER_ON) || PID_BITMAP_TEST(tsreader->pid_filter_known, pid)) )
+			return 0 ;
+	}
+
+	/*
+		# ISO 13818-1
+		#
+		#	sync_byte 8 bslbf
+		#
+		#	transport_error_indicator 1 bslbf
+		#	payload_unit_start_indicator 1 bslbf
+		#	transport_priority 1 bslbf
+		#	PID 13 uimsbf
+		#
+		#	transport_scrambling_control 2 bslbf
+		#	adaptation_field_control 2 bslbf
+		#	continuity_counter 4 uimsbf
+		#
+		#	if(adaptation_field_control = = '10' || adaptation_field_control = = '11'){
+		#		adaptation_field()
+		#	}
+		#	if(adaptation_field_control = = '01' || adaptation_field_control = = '11') {
+		#		for (i = 0; i < N; i++){
+		#			data_byte 8 bslbf
+		#		}
+		#	}
+	*/
+	tsstate->pidinfo.pid = (((packet[1] & 0x1f) << 8) | (packet[2] & 0xff)) & MAX_PID ;
+	tsstate->pidinfo.err_flag = packet[1] & 0x80;
+	tsstate->pidinfo.pes_start = packet[1] & 0x40;
+
+    /* skip adaptation field */
+	tsstate->pidinfo.afc = (packet[3] >> 4) & 3;
+	start=4 ;
+	payload = &packet[start] ;
+
+	// PCR is in the adaptation field, so check before any adaptation field only packets are dropped
+	if ((loop == TS_LOOP_GENERIC) && tsreader->pcr_hook && (tsstate->pidinfo.afc & 2) && (packet[4] >= 7) && (packet[5] & 0x10))
+	{
+	int64_t pcr_base ;
+	unsigned pcr_ext ;
+
+		pcr_base = ((int64_t)packet[6] << 25) | (packet[7] << 17) | (packet[8] << 9) | (packet[9] << 1) | (packet[10] >> 7) ;
+		pcr_ext = ((packet[10] & 0x01) << 8) | packet[11] ;
+		tsreader->pcr_hook(&tsstate->pidinfo, pcr_base, pcr_ext, tsreader->user_data) ;
+	}
+
+	if (tsstate->pidinfo.afc == 0) /* reserved value */
+        return 0;
+    if (tsstate->pidinfo.afc == 2) /* adaptation field only */
+        return 0;
+    if (tsstate->pidinfo.afc == 3)
+    {
+        /* skip adaptation_field */
+    	start += payload[0] + 1 ;
+    }
+    /* if past the end of packet, ignore */
+    if (start >= packet_len)
+        return 0;
+
+	payload = &packet[start] ;
+	payload_len = packet_len - start ;
+
+if ((loop == TS_LOOP_GENERIC) && tsparse_dbg_on(100))
+{
+	printf ("PID %d (0x%03x) - start=%d, payload len=%d\n", tsstate->pidinfo.pid, tsstate->pidinfo.pid, start, payload_len) ;
+	dump_buff(packet, packet_len, 31) ;
+}
+
+
+    // cumulative error
+    tsstate->pidinfo.pid_error = 0 ;
+
+	// look at pid?
+	pid_ok=1;
+	if (loop != TS_LOOP_GENERIC)
+	{
+		// no pid selection
+	}
+	else if (tsreader->pid_filter_mode == PID_FILTER_LEARN)
+	{
+		// first time for this pid - ask the hook and remember the answer
+		if (!PID_BITMAP_TEST(tsreader->pid_filter_known, tsstate->pidinfo.pid))
+		{
+			if (tsreader->pid_hook)
+				pid_ok = tsreader->pid_hook(tsstate->pidinfo.pid, tsreader->user_data) ;
+
+			PID_BITMAP_SET(tsreader->pid_filter_known, tsstate->pidinfo.pid) ;
+			if (pid_ok)
+				PID_BITMAP_SET(tsreader->pid_filter, tsstate->pidinfo.pid) ;
+		}
+	}
+	else if ((tsreader->pid_filter_mode == PID_FILTER_OFF) && tsreader->pid_hook)
+	{
+		//# see if we want to process this pid
+		pid_ok = tsreader->pid_hook(tsstate->pidinfo.pid, tsreader->user_data) ;
+	}
+
+
+	if (pid_ok)
+	{
+		// Update pid
+		tsstate->pid_item = piditem_get(tsstate, &tsstate->pidinfo) ;
 
 		//## Do checks for this packet
 
@@ -1538,10 +2026,10 @@ if (tsreader->debug >= 100)
 		if (packet[0] != SYNC_BYTE)
 		{
 			++tsstate->pidinfo.pid_error ;
-			if (tsreader->error_hook)
+			if ((loop == TS_LOOP_GENERIC) && tsreader->error_hook)
 			{
-				SET_DVB_ERROR(ERR_BADSYNC) ;
-				tsreader->error_hook(dvb_error_code, &tsstate->pidinfo, tsreader->user_data) ;
+				SET_TSREADER_ERROR(tsreader, ERR_BADSYNC) ;
+				tsreader->error_hook(tsreader->error_code, &tsstate->pidinfo, tsreader->user_data) ;
 			}
 		}
 
@@ -1549,10 +2037,10 @@ if (tsreader->debug >= 100)
 		if (tsstate->pidinfo.err_flag)
 		{
 			++tsstate->pidinfo.pid_error ;
-			if (tsreader->error_hook)
+			if ((loop == TS_LOOP_GENERIC) && tsreader->error_hook)
 			{
-				SET_DVB_ERROR(ERR_TSERR) ;
-				tsreader->error_hook(dvb_error_code, &tsstate->pidinfo, tsreader->user_data) ;
+				SET_TSREADER_ERROR(tsreader, ERR_TSERR) ;
+				tsreader->error_hook(tsreader->error_code, &tsstate->pidinfo, tsreader->user_data) ;
 			}
 		}
 
@@ -1565,7 +2053,7 @@ if (tsreader->debug >= 100)
 		tsstate->pid_item->pesinfo.ts_error += tsstate->pidinfo.pid_error ;
 		if (tsstate->pidinfo.err_flag) ++tsstate->pid_item->pesinfo.ts_error ;
 
-		if (tsreader->payload_hook)
+		if ((loop == TS_LOOP_GENERIC) && tsreader->payload_hook)
 		{
 			tsreader->payload_hook(&tsstate->pidinfo, payload, payload_len, tsreader->user_data) ;
 		}
@@ -1574,13 +2062,55 @@ if (tsreader->debug >= 100)
 		handle_payload(tsreader, tsstate, payload, payload_len) ;
 
 		//## do something with raw packet
-		if (tsreader->ts_hook)
+		if ((loop != TS_LOOP_UNITS) && tsreader->ts_hook)
 		{
 			tsreader->ts_hook(&tsstate->pidinfo, packet, packet_len, tsreader->user_data) ;
 		}
+
+		//## or save it for the next batch
+		if ((loop != TS_LOOP_UNITS) && tsreader->batch_hook)
+		{
+		struct TS_pkt_desc *desc = &tsreader->batch[tsreader->batch_len++] ;
+
+			desc->packet = packet ;
+			desc->pid = tsstate->pidinfo.pid ;
+			desc->pktnum = tsstate->pidinfo.pktnum ;
+			desc->arrival_ts = tsstate->pidinfo.arrival_ts ;
+			desc->flags = (tsstate->pidinfo.pes_start ? TS_PKT_FLAG_START : 0) |
+					(tsstate->pidinfo.pid_error ? TS_PKT_FLAG_ERROR : 0) ;
+
+			if (tsreader->batch_len >= TS_BATCH_MAX)
+				tsreader_batch_flush(tsreader) ;
+		}
 	}
 
-	return 0 ;
+	return pid_ok ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Parse a packet with whatever hooks are currently set
+static int parse_ts_packet(struct TS_reader *tsreader, struct TS_state *tsstate,
+		uint8_t *packet, unsigned packet_len)
+{
+	return parse_ts_packet_loop(tsreader, tsstate, packet, packet_len, TS_LOOP_GENERIC) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Choose the packet loop for the hooks/decoders that are active. Anything not covered by the specialised loops (or
+// any debug) uses the generic loop
+static void tsreader_select_loop(struct TS_reader *tsreader)
+{
+	tsreader->parse_loop = TS_LOOP_GENERIC ;
+
+	if (tsreader->debug ||
+			(tsreader->pid_filter_mode != PID_FILTER_OFF) ||
+			tsreader->pid_hook || tsreader->error_hook || tsreader->payload_hook || tsreader->pcr_hook)
+		return ;
+
+	if (tsreader->ts_hook || tsreader->batch_hook)
+		tsreader->parse_loop = TS_LOOP_TS ;
+	else
+		tsreader->parse_loop = TS_LOOP_UNITS ;
 }
 
 /*=============================================================================================*/
@@ -1642,6 +2172,66 @@ void ts_null_packet(uint8_t *packet, unsigned packet_len)
 /*=============================================================================================*/
 // SI table decoding
 
+/* ----------------------------------------------------------------------- */
+// Pid that a table is transmitted on (EN 300 468 table 1), or ALL_PID if it can be on any pid (e.g. PMT)
+static unsigned section_pid(unsigned table_id)
+{
+	switch (table_id)
+	{
+	case SECTION_PAT:
+		return 0x00 ;
+	case SECTION_CAT:
+		return 0x01 ;
+	case SECTION_TSDT:
+		return 0x02 ;
+	case SECTION_NIT_ACTUAL:
+	case SECTION_NIT_OTHER:
+		return 0x10 ;
+	case SECTION_SDT_ACTUAL:
+	case SECTION_SDT_OTHER:
+	case SECTION_BAT:
+		return 0x11 ;
+	case SECTION_EIT_START ... SECTION_EIT_END:
+		return 0x12 ;
+	case SECTION_RST:
+		return 0x13 ;
+	case SECTION_TDT:
+	case SECTION_TOT:
+		return 0x14 ;
+	case SECTION_DIT:
+		return 0x1E ;
+	case SECTION_SIT:
+		return 0x1F ;
+	default:
+		break ;
+	}
+	return ALL_PID ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Work out which pids carry sections that have a registered handler
+static void tsreader_update_psi_pids(struct TS_reader *tsreader)
+{
+struct TS_state *tsstate = tsreader->tsstate ;
+unsigned table_id ;
+unsigned pid ;
+
+	memset(tsstate->psi_pids, 0, sizeof(tsstate->psi_pids)) ;
+	for (table_id=0; table_id <= SECTION_MAX; ++table_id)
+	{
+		if (!tsreader->section_decode_table[table_id].handler && !tsreader->section_decode_table[table_id].view_handler)
+			continue ;
+
+		pid = section_pid(table_id) ;
+		if (pid == ALL_PID)
+		{
+			memset(tsstate->psi_pids, 0xff, sizeof(tsstate->psi_pids)) ;
+			break ;
+		}
+		PID_BITMAP_SET(tsstate->psi_pids, pid) ;
+	}
+}
+
 /* ----------------------------------------------------------------------- */
 int tsreader_register_section(struct TS_reader *tsreader,
 		unsigned table_id, unsigned mask,
@@ -1664,39 +2254,156 @@ enum TS_section_ids id ;
 		tsreader->section_decode_table[id].handler = handler ;
 		++updated ;
 	}
+
+	// update which pids now need their sections reassembling
+	tsreader_update_psi_pids(tsreader) ;
+
+	// a new handler sees the current sections of these tables, whether or not they change
+	section_cache_clear(&tsreader->tsstate->section_cache, table_id, mask) ;
+
+	return (updated) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Register a handler to be passed the section bytes of these tables rather than the decoded tables (see si_view.h).
+// Can be used alongside a handler registered with tsreader_register_section(); each keeps its own flags (of which only
+// on_change applies to views)
+int tsreader_register_section_view(struct TS_reader *tsreader,
+		unsigned table_id, unsigned mask,
+		Section_view_handler handler, struct Section_decode_flags flags)
+{
+int updated = 0 ;
+enum TS_section_ids masked_val ;
+enum TS_section_ids id ;
+
+	CHECK_TS_READER(tsreader) ;
+
+	id = table_id & SECTION_MAX ;
+
+	id &= mask ;
+	masked_val = id ;
+	for ( ; (id <= SECTION_MAX) && ( (id & mask) == masked_val); ++id )
+	{
+		tsreader->section_decode_table[id].view_flags = flags ;
+		tsreader->section_decode_table[id].view_handler = handler ;
+		++updated ;
+	}
+
+	tsreader_update_psi_pids(tsreader) ;
+	section_cache_clear(&tsreader->tsstate->section_cache, table_id, mask) ;
+
 	return (updated) ;
 }
 
+/* ----------------------------------------------------------------------- */
+// Forget all of the SI sections seen so far (e.g. after moving the read position) so that handlers registered with
+// the on_change flag are passed every table again
+void tsreader_section_cache_clear(struct TS_reader *tsreader)
+{
+	CHECK_TS_READER(tsreader) ;
+	section_cache_clear(&tsreader->tsstate->section_cache, 0, 0) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Called from a section handler to keep the section it was passed (normally freed when the handler returns). Returns
+// the arena holding the section and everything it points to - the section remains valid until arena_free() is called
+// on it
+struct TS_arena *tsreader_section_detach(struct TS_reader *tsreader)
+{
+	CHECK_TS_READER(tsreader) ;
+	return arena_detach(&tsreader->tsstate->si_arena) ;
+}
+
 
 /*=============================================================================================*/
-// TS_reader
+// PID filter
 
 /* ----------------------------------------------------------------------- */
-// Set the start & end points for whole video based on min/max times of the streams
-void tsreader_set_timing(struct TS_reader *tsreader)
+// Set the filter mode and empty the filter
+void tsreader_pid_filter_mode(struct TS_reader *tsreader, enum TS_pid_filter_mode mode)
 {
-struct list_head  *item;
-struct TS_pid    *piditem;
+	CHECK_TS_READER(tsreader) ;
+
+	tsreader->pid_filter_mode = mode ;
+	memset(tsreader->pid_filter, 0, sizeof(tsreader->pid_filter)) ;
+	memset(tsreader->pid_filter_known, 0, sizeof(tsreader->pid_filter_known)) ;
 
+	// may be changed while parsing
+	tsreader_select_loop(tsreader) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Accept this pid. Turns the filter on if it's currently off
+void tsreader_pid_filter_set(struct TS_reader *tsreader, unsigned pid)
+{
 	CHECK_TS_READER(tsreader) ;
-	tsparse_dbg_prt(102, ("tsreader_set_timing()\n")) ;
 
-	list_for_each(item,&tsreader->tsstate->pid_list)
-	{
-		piditem = list_entry(item, struct TS_pid, next);
+	if (tsreader->pid_filter_mode == PID_FILTER_OFF)
+		tsreader_pid_filter_mode(tsreader, PID_FILTER_ON) ;
 
-		tsparse_dbg_prt(102, ("Start=%"PRId64"  End=%"PRId64"\n", tsreader->tsstate->start_ts, tsreader->tsstate->end_ts)) ;
-		tsparse_dbg_prt(102, ("PID %d\n", piditem->pidinfo.pid)) ;
-		tsparse_dbg_prt(102, (" + PTS Start=%"PRId64"  End=%"PRId64" : DTS Start=%"PRId64"  End=%"PRId64"\n",
-										piditem->pesinfo.start_pts, piditem->pesinfo.end_pts,
-										piditem->pesinfo.start_dts, piditem->pesinfo.end_dts
-										)) ;
+	pid &= MAX_PID ;
+	PID_BITMAP_SET(tsreader->pid_filter, pid) ;
+	PID_BITMAP_SET(tsreader->pid_filter_known, pid) ;
+}
 
-		// start
-		if (piditem->pesinfo.start_pts != UNSET_TS)
-		{
-			if  ((tsreader->tsstate->start_ts == UNSET_TS) || (piditem->pesinfo.start_pts < tsreader->tsstate->start_ts))
-			{
+/* ----------------------------------------------------------------------- */
+// Reject this pid. Turns the filter on if it's currently off
+void tsreader_pid_filter_clear(struct TS_reader *tsreader, unsigned pid)
+{
+	CHECK_TS_READER(tsreader) ;
+
+	if (tsreader->pid_filter_mode == PID_FILTER_OFF)
+		tsreader_pid_filter_mode(tsreader, PID_FILTER_ON) ;
+
+	pid &= MAX_PID ;
+	PID_BITMAP_CLR(tsreader->pid_filter, pid) ;
+	PID_BITMAP_SET(tsreader->pid_filter_known, pid) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Swap accepted/rejected pids (e.g. set the pids to drop then invert)
+void tsreader_pid_filter_invert(struct TS_reader *tsreader)
+{
+unsigned i ;
+
+	CHECK_TS_READER(tsreader) ;
+
+	for (i=0; i < PID_BITMAP_WORDS; ++i)
+	{
+		tsreader->pid_filter[i] = ~tsreader->pid_filter[i] ;
+	}
+}
+
+
+/*=============================================================================================*/
+// TS_reader
+
+/* ----------------------------------------------------------------------- */
+// Set the start & end points for whole video based on min/max times of the streams
+void tsreader_set_timing(struct TS_reader *tsreader)
+{
+struct list_head  *item;
+struct TS_pid    *piditem;
+
+	CHECK_TS_READER(tsreader) ;
+	tsparse_dbg_prt(102, ("tsreader_set_timing()\n")) ;
+
+	list_for_each(item,&tsreader->tsstate->pid_list)
+	{
+		piditem = list_entry(item, struct TS_pid, next);
+
+		tsparse_dbg_prt(102, ("Start=%"PRId64"  End=%"PRId64"\n", tsreader->tsstate->start_ts, tsreader->tsstate->end_ts)) ;
+		tsparse_dbg_prt(102, ("PID %d\n", piditem->pidinfo.pid)) ;
+		tsparse_dbg_prt(102, (" + PTS Start=%"PRId64"  End=%"PRId64" : DTS Start=%"PRId64"  End=%"PRId64"\n",
+										piditem->pesinfo.start_pts, piditem->pesinfo.end_pts,
+										piditem->pesinfo.start_dts, piditem->pesinfo.end_dts
+										)) ;
+
+		// start
+		if (piditem->pesinfo.start_pts != UNSET_TS)
+		{
+			if  ((tsreader->tsstate->start_ts == UNSET_TS) || (piditem->pesinfo.start_pts < tsreader->tsstate->start_ts))
+			{
 				tsreader->tsstate->start_ts = piditem->pesinfo.start_pts ;
 				tsparse_dbg_prt(102, (" + + Set start = pts\n")) ;
 			}
@@ -1736,20 +2443,21 @@ struct TS_pid    *piditem;
 
 /* ----------------------------------------------------------------------- */
 // Origin is as lseek ; skip_pkts can be -ve if origin is SEEK_END
-int tsreader_setpos(struct TS_reader *tsreader, int skip_pkts, int origin, unsigned num_pkts)
+int tsreader_setpos(struct TS_reader *tsreader, int64_t skip_pkts, int origin, uint64_t num_pkts)
 {
 off64_t rc = 0 ;
 off64_t pos ;
-int abs_skip ;
+uint64_t abs_skip ;
 int skip_sign ;
+int status = 0 ;
 
 	CHECK_TS_READER(tsreader) ;
 
-	abs_skip = skip_pkts ;
+	abs_skip = (uint64_t)skip_pkts ;
 	skip_sign = 1 ;
 	if (skip_pkts < 0)
 	{
-		abs_skip = -skip_pkts ;
+		abs_skip = -(uint64_t)skip_pkts ;
 		skip_sign = -1 ;
 	}
 
@@ -1758,14 +2466,18 @@ int skip_sign ;
 	{
 		abs_skip = tsreader->tsstate->total_pkts ;
 	}
-	skip_pkts = skip_sign * abs_skip ;
+	skip_pkts = skip_sign * (int64_t)abs_skip ;
 
 	// set position
 	tsreader->num_pkts = num_pkts ;
-	tsreader->skip = abs_skip ;
+	tsreader->skip = (int64_t)abs_skip ;
 	tsreader->origin = origin ;
 	tsreader->tsstate->pidinfo.pktnum = 0 ;
 
+	// throw away anything the pull iterator read from the old position
+	iter_reset(tsreader) ;
+	pid_stats_restart(tsreader->tsstate) ;
+
 	// skip if no file open
 	if (!tsreader->file)
 		return 0 ;
@@ -1775,9 +2487,9 @@ int skip_sign ;
 
 
 	// calc pos
-	pos = (off64_t)(skip_pkts) * (off64_t)(TS_PACKET_LEN) ;
+	pos = (off64_t)(skip_pkts) * (off64_t)(tsreader->packet_size) ;
 
-	tsparse_dbg_prt(100, ("tsreader_setpos(skip=%d, origin=%d) pos=%"PRId64"\n", skip_pkts, origin, (long long int)pos)) ;
+	tsparse_dbg_prt(100, ("tsreader_setpos(skip=%"PRId64", origin=%d) pos=%"PRId64"\n", skip_pkts, origin, (int64_t)pos)) ;
 
 	rc = lseek64(tsreader->file, pos, origin) ;
 
@@ -1785,22 +2497,54 @@ int skip_sign ;
 
 	if (rc == (off64_t)-1)
 	{
-		SET_DVB_ERROR(ERR_FILE_SEEK) ;
-		if (tsreader->debug >= 100)
+		SET_TSREADER_ERROR(tsreader, ERR_FILE_SEEK) ;
+		status = tsreader->error_code ;
+		if (tsparse_dbg_on(100))
 			perror("File seek error: ") ;
 
 		// On error - reset to start of file
 		lseek64(tsreader->file, (off64_t)0, SEEK_SET) ;
+		tsreader->buff_state.start_pos = 0 ;
 
 //TODO: on error seek to 0?
 	}
 	else
 	{
 		// set packet number
-		tsreader->tsstate->pidinfo.pktnum = (unsigned)(rc / TS_PACKET_LEN) ;
+		tsreader->tsstate->pidinfo.pktnum = (uint64_t)rc / tsreader->packet_size ;
+
+		// a pull iterator carries on from here
+		tsreader->buff_state.start_pos = (uint64_t)rc ;
 	}
 
-	return(dvb_error_code) ;
+	return(status) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Position at a byte offset in the file (e.g. a packet start recorded from TS_pesinfo.start_pos, which need not be
+// a whole number of packets into the file). pktnum is the packet number to carry on counting from
+int tsreader_setpos_byte(struct TS_reader *tsreader, uint64_t pos, uint64_t pktnum, uint64_t num_pkts)
+{
+int status ;
+
+	CHECK_TS_READER(tsreader) ;
+
+	// reset the reader state as for any other new position
+	status = tsreader_setpos(tsreader, 0, SEEK_SET, num_pkts) ;
+	if (status || !tsreader->file)
+		return status ;
+
+	tsparse_dbg_prt(100, ("tsreader_setpos_byte(pos=%"PRIu64", pktnum=%"PRIu64")\n", pos, pktnum)) ;
+
+	if (lseek64(tsreader->file, (off64_t)pos, SEEK_SET) == (off64_t)-1)
+	{
+		lseek64(tsreader->file, (off64_t)0, SEEK_SET) ;
+		RETURN_TSREADER_ERROR(tsreader, ERR_FILE_SEEK) ;
+	}
+	tsreader->buff_state.start_pos = pos ;
+	tsreader->tsstate->pidinfo.pktnum = pktnum ;
+
+	return 0 ;
 }
 
 /* ----------------------------------------------------------------------- */
@@ -1813,7 +2557,63 @@ void tsreader_start_framenum(struct TS_reader *tsreader, unsigned framenum)
 
 
 /* ----------------------------------------------------------------------- */
-struct TS_reader *tsreader_new(char *filename)
+// Get the transport statistics for a pid. May be called at any time (including from a hook); the counts cover every
+// packet on the pid read so far by this reader, including any dropped by the pid filter. The pointer stays valid
+// until the reader is freed
+const struct TS_pid_stats *tsreader_pid_stats(struct TS_reader *tsreader, unsigned pid)
+{
+static const struct TS_pid_stats unseen = { .next_cc = TS_STATS_CC_UNSET } ;
+
+	CHECK_TS_READER(tsreader) ;
+	if (!tsreader->tsstate->pid_stats[pid & MAX_PID])
+		return &unseen ;
+	return tsreader->tsstate->pid_stats[pid & MAX_PID] ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Zero the transport statistics for all pids
+void tsreader_pid_stats_clear(struct TS_reader *tsreader)
+{
+	CHECK_TS_READER(tsreader) ;
+	pid_stats_clear(tsreader->tsstate) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Memory used by the PES/PSI reassembly buffers
+const struct TS_buffer_pool_stats *tsreader_buffer_pool_stats(struct TS_reader *tsreader)
+{
+	CHECK_TS_READER(tsreader) ;
+	return &tsreader->tsstate->buff_pool.stats ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Cap the memory the reassembly buffers can allocate (0 = no limit). A buffer that can't grow within the limit loses
+// the data being added and the error is set to ERR_MALLOC
+void tsreader_buffer_pool_limit(struct TS_reader *tsreader, uint64_t max_bytes)
+{
+	CHECK_TS_READER(tsreader) ;
+	tsreader->tsstate->buff_pool.mem_limit = max_bytes ;
+}
+
+
+/* ----------------------------------------------------------------------- */
+// Work out the packet size from the start of the file (defaults to TS_PACKET_LEN if it can't be decided)
+static unsigned tsreader_probe_packet_size(int file)
+{
+uint8_t buff[TS_SYNC_PROBE_LEN] ;
+ssize_t bytes_read ;
+unsigned packet_size = 0 ;
+
+	bytes_read = pread64(file, buff, sizeof(buff), 0) ;
+	if (bytes_read > 0)
+		packet_size = ts_sync_packet_size(buff, (unsigned)bytes_read) ;
+
+	return packet_size ? packet_size : TS_PACKET_LEN ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Open the file (if any). An empty file is only allowed when it's to be followed
+static struct TS_reader *tsreader_open(char *filename, unsigned follow)
 {
 int file = 0 ;
 struct TS_reader *tsreader = NULL ;
@@ -1837,27 +2637,27 @@ off64_t size ;
 
 	tsreader->file = file ;
 	tsreader->tsstate = tsstate_new() ;
+	tsreader->packet_size = TS_PACKET_LEN ;
+	tsreader->section_cache_bytes = TS_SECTION_CACHE_BYTES ;
 
 	// work out total number of packets
 	if (tsreader->file)
 	{
-		size = lseek64(tsreader->file, -1, SEEK_END) ;
+		tsreader->packet_size = tsreader_probe_packet_size(tsreader->file) ;
+
+		size = lseek64(tsreader->file, 0, SEEK_END) ;
 
-		// size = -1 :
-		// errorno=EINVAL for zero length file
-		if (size < 0)
+		// size = -1 : error
+		// size = 0 : zero length file (nothing written yet if following)
+		if ((size < 0) || (!size && !follow))
 		{
-			size = 0 ;
-			SET_DVB_ERROR(ERR_FILE) ;
-			if (errno == EINVAL)
-			{
-				SET_DVB_ERROR(ERR_FILE_ZERO) ;
-			}
+			SET_DVB_ERROR(size ? ERR_FILE : ERR_FILE_ZERO) ;
 			tsreader_free(tsreader) ;
 			return(NULL) ;
 		}
-		tsreader->tsstate->total_pkts = (unsigned)(size / (off64_t)TS_PACKET_LEN) ;
+		tsreader->tsstate->total_pkts = (uint64_t)size / tsreader->packet_size ;
 	}
+	tsreader->follow = follow ;
 
 	// set position
 	tsreader_setpos(tsreader, 0, SEEK_SET, 0) ;
@@ -1865,6 +2665,26 @@ off64_t size ;
 	return tsreader ;
 }
 
+/* ----------------------------------------------------------------------- */
+struct TS_reader *tsreader_new(char *filename)
+{
+	return tsreader_open(filename, 0) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Open a file that's still being written (e.g. a recording that has only just been created, so may still be empty)
+// with follow set. Set follow_done/follow_timeout before ts_parse(). If there wasn't a whole packet when it was
+// opened, the packet size is worked out once some data has been written
+struct TS_reader *tsreader_new_follow(char *filename)
+{
+	if (!filename)
+	{
+		SET_DVB_ERROR(ERR_FILE) ;
+		return(NULL) ;
+	}
+	return tsreader_open(filename, 1) ;
+}
+
 
 /* ----------------------------------------------------------------------- */
 struct TS_reader *tsreader_new_nofile()
@@ -1891,6 +2711,12 @@ void tsreader_free(struct TS_reader *tsreader)
 		if (tsreader->file)
 			close(tsreader->file) ;
 
+		// pull iterator (buffers go back to the state's pool so must be freed first)
+		buffer_free(&tsreader->iter.unit_buff) ;
+		buffer_free(&tsreader->iter.spare_buff) ;
+		if (tsreader->iter.buff)
+			free(tsreader->iter.buff) ;
+
 		tsstate_free(tsreader->tsstate) ;
 
 		// optionally clear out libmpeg2 settings
@@ -1973,6 +2799,256 @@ static void tsreader_set_audio(struct TS_reader *tsreader)
 }
 
 
+/* ----------------------------------------------------------------------- */
+// Memory mapped version of the main loop. Packets are processed directly from the mapped file (no copying). The file
+// is mapped a window at a time, starting from the current file position (so any tsreader_setpos() is honoured)
+static int ts_parse_mmap(struct TS_reader *tsreader, off64_t file_size)
+{
+off64_t pos ;
+off64_t consumed ;
+off64_t map_start ;
+size_t map_len ;
+size_t window ;
+size_t page_size ;
+uint8_t *map ;
+uint8_t *start_ptr ;
+int status;
+
+	CHECK_TS_READER(tsreader) ;
+
+	status = 0 ;
+
+	page_size = (size_t)sysconf(_SC_PAGESIZE) ;
+	window = tsreader->mmap_window ? tsreader->mmap_window : TS_MMAP_WINDOW ;
+	window -= window % page_size ;
+	if (window < 2*page_size)
+		window = 2*page_size ;
+
+	pos = lseek64(tsreader->file, 0, SEEK_CUR) ;
+	if (pos < 0)
+	{
+		RETURN_TSREADER_ERROR(tsreader, ERR_FILE_SEEK) ;
+	}
+
+	tsparse_dbg_prt(10, ("TS: ts_parse_mmap() pos=%"PRId64" size=%"PRId64" window=%u\n", (int64_t)pos, (int64_t)file_size, (unsigned)window)) ;
+
+	// main loop
+	while (tsreader->buff_state.running > 0)
+	{
+		// need at least a packet's worth of data
+		if (file_size - pos < tsreader->packet_size)
+			break ;
+
+		// map next window (must start on a page boundary)
+		map_start = pos - (pos % page_size) ;
+		map_len = window ;
+		if ((off64_t)map_len > file_size - map_start)
+			map_len = (size_t)(file_size - map_start) ;
+
+		map = (uint8_t *)mmap(NULL, map_len, PROT_READ, MAP_SHARED, tsreader->file, map_start) ;
+		if (map == MAP_FAILED)
+		{
+			RETURN_TSREADER_ERROR(tsreader, ERR_READ) ;
+		}
+		madvise(map, map_len, MADV_SEQUENTIAL) ;
+
+		// process packets straight out of the map
+		start_ptr = &map[pos - map_start] ;
+		tsreader->buff_state.bptr = start_ptr ;
+		tsreader->buff_state.buffer_len = (int)(map_len - (size_t)(pos - map_start)) ;
+
+		status = tsreader_data_process(tsreader) ;
+
+		consumed = (off64_t)(tsreader->buff_state.bptr - start_ptr) ;
+		pos += consumed ;
+
+		// don't leave dangling pointers into the map
+		tsreader->buff_state.bptr = tsreader->buff_state.buffer ;
+		tsreader->buff_state.buffer_len = 0 ;
+		munmap(map, map_len) ;
+
+		if (status) return (status) ;
+
+		// nothing more could be used from this window
+		if (!consumed)
+			break ;
+	}
+
+	// leave the file positioned after the last processed packet
+	lseek64(tsreader->file, pos, SEEK_SET) ;
+
+	return status;
+}
+
+/* ----------------------------------------------------------------------- */
+// Parse the file using a background thread to read ahead into a ring of large buffers. The packets are
+// processed in place in each buffer; any partial packet at the end of a buffer is copied into the
+// spare space in front of the next one.
+static int ts_parse_readahead(struct TS_reader *tsreader)
+{
+struct TS_readahead *ra ;
+unsigned num_buffs ;
+unsigned buff_size ;
+unsigned leftover ;
+uint8_t *data ;
+int data_len ;
+uint64_t start ;
+int status;
+
+	CHECK_TS_READER(tsreader) ;
+
+	status = 0 ;
+	leftover = 0 ;
+	memset(&tsreader->io_stats, 0, sizeof(tsreader->io_stats)) ;
+
+	num_buffs = tsreader->readahead_buffs ? tsreader->readahead_buffs : TS_READAHEAD_BUFFS ;
+	if (num_buffs < 2)
+		num_buffs = 2 ;
+	buff_size = tsreader->readahead_size ? tsreader->readahead_size : TS_READAHEAD_SIZE ;
+	buff_size -= buff_size % tsreader->packet_size ;
+	if (buff_size < tsreader->packet_size)
+		buff_size = tsreader->packet_size ;
+
+	tsparse_dbg_prt(10, ("TS: ts_parse_readahead() buffs=%u size=%u\n", num_buffs, buff_size)) ;
+
+	ra = readahead_new(tsreader->file, num_buffs, buff_size, tsreader->packet_size) ;
+	if (!ra)
+	{
+		RETURN_TSREADER_ERROR(tsreader, ERR_MALLOC) ;
+	}
+
+    // main loop
+    while (tsreader->buff_state.running > 0)
+    {
+    	readahead_get(ra, &data, &data_len) ;
+    	if (data_len <= 0)
+    	{
+    		readahead_release(ra) ;
+    		break ;
+    	}
+		tsreader->io_stats.bytes_read += data_len ;
+		++tsreader->io_stats.buffs_read ;
+
+    	// prepend partial packet from previous buffer
+    	if (leftover)
+    	{
+    		data -= leftover ;
+    		memcpy(data, tsreader->buff_state.buffer, leftover) ;
+    		data_len += leftover ;
+    		leftover = 0 ;
+    	}
+
+		start = readahead_time_us() ;
+
+		tsreader->buff_state.bptr = data ;
+		tsreader->buff_state.buffer_len = data_len ;
+		status = tsreader_data_process(tsreader) ;
+
+		// save any partial packet (always less than a packet) before handing the buffer back
+		if (!status && (tsreader->buff_state.buffer_len > 0) && (tsreader->buff_state.buffer_len < tsreader->packet_size))
+		{
+			leftover = tsreader->buff_state.buffer_len ;
+			memmove(tsreader->buff_state.buffer, tsreader->buff_state.bptr, leftover) ;
+		}
+		tsreader->buff_state.bptr = tsreader->buff_state.buffer ;
+		tsreader->buff_state.buffer_len = 0 ;
+
+		tsreader->io_stats.parse_us += readahead_time_us() - start ;
+
+		readahead_release(ra) ;
+
+		if (status) break ;
+    }
+
+	tsreader->io_stats.io_wait_us = ra->wait_us ;
+	readahead_free(&ra) ;
+
+	tsparse_dbg_prt(10, ("TS: readahead io wait=%"PRIu64" us, parse=%"PRIu64" us\n", tsreader->io_stats.io_wait_us, tsreader->io_stats.parse_us)) ;
+
+    return status;
+}
+
+/* ----------------------------------------------------------------------- */
+// Follow a file that is still being written: rather than stopping at the end of the file, wait for more data until
+// the writer has finished. Any partial packet at the end of the data is kept (by tsreader_data_add()) until the
+// rest of it has been written.
+static int ts_parse_follow(struct TS_reader *tsreader)
+{
+uint8_t buffer[TS_BUFFSIZE];
+struct TS_follow *follow ;
+unsigned caught_up ;
+uint64_t latency ;
+int bytes_read ;
+int status;
+
+	CHECK_TS_READER(tsreader) ;
+
+	status = 0 ;
+	caught_up = 0 ;
+	memset(&tsreader->follow_stats, 0, sizeof(tsreader->follow_stats)) ;
+
+	follow = follow_new(tsreader->file, tsreader->follow_done, tsreader->follow_timeout) ;
+	if (!follow)
+	{
+		RETURN_TSREADER_ERROR(tsreader, ERR_MALLOC) ;
+	}
+
+	tsparse_dbg_prt(10, ("TS: ts_parse_follow() done=%s timeout=%u ms inotify=%d\n",
+			tsreader->follow_done ? tsreader->follow_done : "", tsreader->follow_timeout, follow->notify >= 0)) ;
+
+	// Opened before there was a whole packet (see tsreader_new_follow()), so the packet size was just a guess. Wait
+	// for enough data to work it out (or for the writer to finish)
+	if (!tsreader->tsstate->total_pkts)
+	{
+		while ((follow->last_size < (int64_t)TS_SYNC_PROBE_LEN) && follow_wait(follow))
+			++tsreader->follow_stats.waits ;
+
+		tsreader->packet_size = tsreader_probe_packet_size(tsreader->file) ;
+		tsreader->packet_prefix = (tsreader->packet_size == TS_M2TS_PACKET_LEN) ? TS_M2TS_HEADER_LEN : 0 ;
+		caught_up = 1 ;
+	}
+
+	// no end of file yet
+	tsreader->tsstate->total_pkts = 0 ;
+
+    // main loop
+    while (tsreader->buff_state.running > 0)
+    {
+		bytes_read = TS_BUFFSIZE_READ ;
+		getbuff(tsreader->file, buffer, &bytes_read) ;
+
+		// wait for more at the end of the file
+		if (bytes_read <= 0)
+		{
+			if (bytes_read < 0)
+				break ;
+
+			caught_up = 1 ;
+			++tsreader->follow_stats.waits ;
+			if (!follow_wait(follow))
+				break ;
+			continue ;
+		}
+
+		status = tsreader_data_add(tsreader, buffer, bytes_read) ;
+		if (status) break ;
+
+		// once reading new data as it arrives, time how long it took to get from the writer to the hooks
+		if (caught_up)
+		{
+			latency = follow_latency_us(follow) ;
+			++tsreader->follow_stats.latency_samples ;
+			tsreader->follow_stats.latency_total_us += latency ;
+			if (latency > tsreader->follow_stats.latency_max_us)
+				tsreader->follow_stats.latency_max_us = latency ;
+		}
+    }
+
+	follow_free(&follow) ;
+
+    return status;
+}
+
 /* ----------------------------------------------------------------------- */
 // Only called when a file is specified
 int ts_parse(struct TS_reader *tsreader)
@@ -1980,6 +3056,7 @@ int ts_parse(struct TS_reader *tsreader)
 uint8_t buffer[TS_BUFFSIZE];
 int bytes_read ;
 int status;
+struct stat64 file_stat ;
 
 	CHECK_TS_READER(tsreader) ;
 
@@ -1988,24 +3065,47 @@ int status;
 	// check file open
 	if (!tsreader->file)
 	{
-		RETURN_DVB_ERROR(ERR_FILE) ;
+		RETURN_TSREADER_ERROR(tsreader, ERR_FILE) ;
 	}
 
 	// initialise
 	status = tsreader_data_start(tsreader) ;
 	if (status) return (status) ;
 
-    // main loop
-    while (tsreader->buff_state.running > 0)
-    {
-		bytes_read = TS_BUFFSIZE_READ ;
-    	status = getbuff(tsreader->file, buffer, &bytes_read) ;
-
-    	// add packet and process
-    	status = tsreader_data_add(tsreader, buffer, bytes_read) ;
+	// Use memory mapped access if requested (only possible on regular files - pipes etc use the normal read() method)
+	if (tsreader->use_mmap && !tsreader->follow && (fstat64(tsreader->file, &file_stat) == 0) && S_ISREG(file_stat.st_mode))
+	{
+		status = ts_parse_mmap(tsreader, (off64_t)file_stat.st_size) ;
+    	if (status) return (status) ;
+	}
+	else if (tsreader->use_readahead && !tsreader->follow)
+	{
+		status = ts_parse_readahead(tsreader) ;
+    	if (status) return (status) ;
+	}
+	else if (tsreader->follow)
+	{
+		status = ts_parse_follow(tsreader) ;
     	if (status) return (status) ;
+	}
+	else
+	{
+		// main loop
+		while (tsreader->buff_state.running > 0)
+		{
+			bytes_read = TS_BUFFSIZE_READ ;
+			status = getbuff(tsreader->file, buffer, &bytes_read) ;
+
+			// stop at end of file (or on read error)
+			if (bytes_read <= 0)
+				break ;
 
-    } // while running
+			// add packet and process
+			status = tsreader_data_add(tsreader, buffer, bytes_read) ;
+			if (status) return (status) ;
+
+		} // while running
+	}
 
     // finish off
 	status = tsreader_data_end(tsreader) ;
@@ -2019,7 +3119,7 @@ int tsreader_data_start(struct TS_reader *tsreader)
 {
 	CHECK_TS_READER(tsreader) ;
 	tsparse_dbg_prt(10, ("TS: tsreader_data_start()\n")) ;
-	tsparse_dbg_prt(100, ("TS: # Total packets = %d\n", tsreader->tsstate->total_pkts)) ;
+	tsparse_dbg_prt(100, ("TS: # Total packets = %"PRIu64"\n", tsreader->tsstate->total_pkts)) ;
 
 	tsreader->buff_state.bptr = tsreader->buff_state.buffer ;
 	tsreader->buff_state.buffer_len = 0 ;
@@ -2027,6 +3127,22 @@ int tsreader_data_start(struct TS_reader *tsreader)
 	tsreader->buff_state.get_sync = 1 ;
 	tsreader->buff_state.pktnum = 0 ;
 	tsreader->buff_state.status = 0 ;
+	tsreader->buff_state.skipped = 0 ;
+
+	// where the data starts in the file (for end_pos and the PES start_pos)
+	tsreader->buff_state.start_pos = 0 ;
+	if (tsreader->file)
+	{
+		off64_t pos = lseek64(tsreader->file, 0, SEEK_CUR) ;
+		if (pos > 0)
+			tsreader->buff_state.start_pos = (uint64_t)pos ;
+	}
+
+	// packet layout
+	if ((tsreader->packet_size != TS_M2TS_PACKET_LEN) && (tsreader->packet_size != TS_RS_PACKET_LEN))
+		tsreader->packet_size = TS_PACKET_LEN ;
+	tsreader->packet_prefix = (tsreader->packet_size == TS_M2TS_PACKET_LEN) ? TS_M2TS_HEADER_LEN : 0 ;
+	tsreader->tsstate->pidinfo.arrival_ts = 0 ;
 
 
 	// Ensure libmpeg2 info is correct
@@ -2035,19 +3151,16 @@ int tsreader_data_start(struct TS_reader *tsreader)
 	// Ensure audio info is set up
 	tsreader_set_audio(tsreader) ;
 
+	// Use the fastest packet loop for the hooks that are set
+	tsreader_select_loop(tsreader) ;
+
 	// Progress required?
 	if (tsreader->progress_hook)
 	{
-		tsreader->progress_info.scale = 1 ;
-		if (tsreader->tsstate->total_pkts*100 > 0xffffffff)
-		{
-			tsreader->progress_info.scale = ( (tsreader->tsstate->total_pkts*100) / 0xffffffff) + 1 ;
-		}
-		tsreader->progress_info.step = tsreader->tsstate->total_pkts / (tsreader->progress_info.scale * 100) ;
-		tsreader->progress_info.total = tsreader->tsstate->total_pkts / tsreader->progress_info.scale ;
+		tsreader->progress_info.step = tsreader->tsstate->total_pkts / 100 ;
 		tsreader->progress_info.next_progress = tsreader->progress_info.step ;
 
-		tsreader->progress_hook(PROGRESS_START, 0, tsreader->progress_info.total, tsreader->user_data) ;
+		tsreader->progress_hook(PROGRESS_START, 0, tsreader->tsstate->total_pkts, tsreader->user_data) ;
 	}
 
 	return 0 ;
@@ -2058,7 +3171,6 @@ int tsreader_data_start(struct TS_reader *tsreader)
 /* ----------------------------------------------------------------------- */
 int tsreader_data_add(struct TS_reader *tsreader, uint8_t *data, unsigned data_len)
 {
-unsigned byte_num ;
 
 tsparse_dbg_prt(10, ("TS: tsreader_data_add() running=%d data_len=%d : Current size = %d\n", tsreader->buff_state.running, data_len, tsreader->buff_state.buffer_len)) ;
 
@@ -2072,12 +3184,18 @@ tsparse_dbg_prt(10, ("TS: tsreader_data_add() running=%d data_len=%d : Current s
 	if (data_len == 0)
 		return 0 ;
 
-	// add new data
-	if (tsreader->buff_state.buffer_len < TS_PACKET_LEN)
+	// add new data after any partial packet left over from the last call (data isn't always a whole number of
+	// packets, e.g. with M2TS/RS packet sizes)
+	if (tsreader->buff_state.buffer_len < tsreader->packet_size)
 	{
+		if (tsreader->buff_state.buffer_len + data_len > TS_BUFFSIZE)
+			tsreader->buff_state.buffer_len = 0 ;
+		if (tsreader->buff_state.buffer_len)
+			memmove(tsreader->buff_state.buffer, tsreader->buff_state.bptr, tsreader->buff_state.buffer_len) ;
+
     	tsreader->buff_state.bptr = tsreader->buff_state.buffer ;
-    	tsreader->buff_state.buffer_len = data_len ;
-    	memcpy(tsreader->buff_state.buffer, data, data_len*sizeof(uint8_t)) ;
+    	memcpy(&tsreader->buff_state.buffer[tsreader->buff_state.buffer_len], data, data_len*sizeof(uint8_t)) ;
+    	tsreader->buff_state.buffer_len += data_len ;
 
     	tsreader->buff_state.get_sync = 1 ;
 
@@ -2121,9 +3239,159 @@ fprintf(stderr, "\n**OVERFLOW**\n") ;
     			tsreader->buff_state.bptr[0], tsreader->buff_state.bptr, tsreader->buff_state.buffer_len)) ;
 	}
 
+	return tsreader_data_process(tsreader) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// As tsreader_data_add() but the packets are processed in place rather than being copied into the reader's buffer,
+// so the same (read-only) data can be shared between several readers. The data only needs to remain valid until
+// this returns. Any partial packet at the end is copied and completed from the start of the next call's data.
+int tsreader_data_add_shared(struct TS_reader *tsreader, const uint8_t *data, unsigned data_len)
+{
+unsigned need ;
+int status ;
+
+	tsparse_dbg_prt(10, ("TS: tsreader_data_add_shared() running=%d data_len=%d : leftover = %d\n", tsreader->buff_state.running, data_len, tsreader->buff_state.buffer_len)) ;
+
+	CHECK_TS_READER(tsreader) ;
+
+	// skip if stopped or no data
+	if (!tsreader->buff_state.running || !data_len)
+		return 0 ;
+
+	// complete the partial packet left over from the last call
+	if (tsreader->buff_state.buffer_len)
+	{
+		need = tsreader->packet_size - tsreader->buff_state.buffer_len ;
+		if (need > data_len)
+			need = data_len ;
+		memcpy(&tsreader->buff_state.buffer[tsreader->buff_state.buffer_len], data, need) ;
+		tsreader->buff_state.buffer_len += need ;
+		data += need ;
+		data_len -= need ;
+
+		if (tsreader->buff_state.buffer_len < (int)tsreader->packet_size)
+			return 0 ;
+
+		// only use it if it's a proper packet, otherwise drop it and re-sync in the new data
+		tsreader->buff_state.bptr = tsreader->buff_state.buffer ;
+		if (!tsreader->buff_state.get_sync && (tsreader->buff_state.buffer[tsreader->packet_prefix] == SYNC_BYTE))
+		{
+			status = tsreader_data_process(tsreader) ;
+			if (status) return (status) ;
+		}
+		else
+		{
+			tsreader->buff_state.get_sync = 1 ;
+		}
+		tsreader->buff_state.bptr = tsreader->buff_state.buffer ;
+		tsreader->buff_state.buffer_len = 0 ;
+	}
+
+	if (!tsreader->buff_state.running || !data_len)
+		return 0 ;
+
+	// process in place (the parser never writes to the packet data)
+	tsreader->buff_state.bptr = (uint8_t *)data ;
+	tsreader->buff_state.buffer_len = (int)data_len ;
+	status = tsreader_data_process(tsreader) ;
+
+	// keep a copy of any partial packet (always less than a packet) - mustn't point into the caller's data
+	if (!status && (tsreader->buff_state.buffer_len > 0) && (tsreader->buff_state.buffer_len < (int)tsreader->packet_size))
+		memmove(tsreader->buff_state.buffer, tsreader->buff_state.bptr, tsreader->buff_state.buffer_len) ;
+	else
+		tsreader->buff_state.buffer_len = 0 ;
+	tsreader->buff_state.bptr = tsreader->buff_state.buffer ;
+
+	return status ;
+}
+
+
+// debug that is only in the generic loop (the specialised loops are only used when debug is off)
+#define loop_dbg_prt(LVL, ARGS)	\
+		if (loop == TS_LOOP_GENERIC) tsparse_dbg_prt(LVL, ARGS)
+
+/* ----------------------------------------------------------------------- */
+// Has the next packet reached end_pos?
+static inline int tsreader_at_end_pos(struct TS_reader *tsreader)
+{
+	return tsreader->end_pos &&
+		(tsreader->buff_state.start_pos + tsreader->buff_state.skipped +
+			tsreader->buff_state.pktnum * tsreader->packet_size >= tsreader->end_pos) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Called after each packet has been parsed
+static inline void tsreader_packet_done(struct TS_reader *tsreader)
+{
+	// Progress required?
+	if (tsreader->progress_hook)
+	{
+		if (tsreader->buff_state.pktnum == tsreader->progress_info.next_progress)
+		{
+			tsreader->progress_hook(PROGRESS_RUNNING,
+					tsreader->buff_state.pktnum,
+					tsreader->tsstate->total_pkts,
+					tsreader->user_data) ;
+
+			tsreader->progress_info.next_progress += tsreader->progress_info.step ;
+		}
+	}
+
+	//== check for end ==
+	++tsreader->buff_state.pktnum ;
+	++tsreader->tsstate->pidinfo.pktnum ;
+
+	// only compare with total packets if it's been set!
+	if (tsreader->tsstate->total_pkts && (tsreader->buff_state.pktnum >= tsreader->tsstate->total_pkts) )
+	{
+		// reached end of file
+		tsreader->buff_state.running = 0 ;
+		tsparse_dbg_prt(100, ("TS: stop running total pkts (len=%d)\n", tsreader->buff_state.buffer_len)) ;
+	}
+
+	// check if max packets has been set
+	if (tsreader->num_pkts && (tsreader->buff_state.pktnum >= tsreader->num_pkts) )
+	{
+		// reached requested number of packets
+		tsreader->buff_state.running = 0 ;
+		tsparse_dbg_prt(100, ("TS: stop running num pkts> (len=%d)\n", tsreader->buff_state.buffer_len)) ;
+	}
+
+	// check if the end position has been set
+	if (tsreader_at_end_pos(tsreader))
+	{
+		// the next packet is for whoever reads on from end_pos
+		tsreader->buff_state.running = 0 ;
+		tsparse_dbg_prt(100, ("TS: stop running end pos (len=%d)\n", tsreader->buff_state.buffer_len)) ;
+	}
+
+	// check special STOP flag
+	if (tsreader->tsstate->stop_flag)
+	{
+		// stop request
+		tsreader->buff_state.running = 0 ;
+		tsparse_dbg_prt(100, ("TS: stop running flag (len=%d)\n", tsreader->buff_state.buffer_len)) ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Process all of the complete packets currently pointed at by buff_state.bptr (buff_state.buffer_len bytes). On
+// return, bptr/buffer_len are left pointing at any unused bytes (i.e. a partial packet)
+//
+// Always inlined with a constant 'loop' to create each of the specialised loops
+static inline __attribute__((always_inline)) int data_process_loop(struct TS_reader *tsreader, const enum TS_parse_loop loop)
+{
+const int stride = (int)tsreader->packet_size ;
+const unsigned prefix = tsreader->packet_prefix ;
+unsigned byte_num ;
+unsigned sync_ok ;
+
+	CHECK_TS_READER(tsreader) ;
+
 	while (tsreader->buff_state.running && (tsreader->buff_state.buffer_len > 0) )
 	{
-		tsparse_dbg_prt(100, ("TS: Loop start...(len=%d) running=%d, get sync=%d\n",
+		loop_dbg_prt(100, ("TS: Loop start...(len=%d) running=%d, get sync=%d\n",
 				tsreader->buff_state.buffer_len,
 				tsreader->buff_state.running,
 				tsreader->buff_state.get_sync)) ;
@@ -2131,149 +3399,165 @@ fprintf(stderr, "\n**OVERFLOW**\n") ;
 		// check for sync if required
 		if (tsreader->buff_state.get_sync)
 		{
-			tsparse_dbg_prt(10, ("TS: waiting for sync...\n")) ;
+			loop_dbg_prt(10, ("TS: waiting for sync...\n")) ;
+
+			// wait for sync byte, but abort if we've waited for at least 4 packets and not found it. Any packet
+			// prefix (M2TS header) is in front of the sync byte
+			byte_num = tsreader->buff_state.buffer_len ;
+			if (tsreader->buff_state.buffer_len > prefix)
+				byte_num = ts_sync_find(tsreader->buff_state.bptr + prefix, tsreader->buff_state.buffer_len - prefix,
+						4*stride+1, TS_SYNC_CONFIRM, stride) ;
+			if (byte_num > 4*stride)
+				byte_num = tsreader->buff_state.buffer_len ;
+			tsreader->buff_state.buffer_len -= byte_num ;
+			tsreader->buff_state.bptr += byte_num ;
+			tsreader->buff_state.skipped += byte_num ;
+			tsreader->buff_state.get_sync = 0 ;
 
-			// wait for sync byte, but abort if we've waited for at least 4 packets and not found it
-			byte_num=0;
-			while ( (tsreader->buff_state.buffer_len > 0) && (tsreader->buff_state.bptr[0] != SYNC_BYTE) && (byte_num < (4*TS_PACKET_LEN)) )
-			{
-				tsreader->buff_state.buffer_len-- ;
-				tsreader->buff_state.bptr++ ;
-				byte_num++ ;
+			loop_dbg_prt(10, ("TS:  + skipped %u bytes\n", byte_num)) ;
 
-				tsparse_dbg_prt(10, ("TS:  + byte[0]=0x%02x num=%d\n", tsreader->buff_state.bptr[0], byte_num)) ;
+			// skipped up to end_pos
+			if (tsreader_at_end_pos(tsreader))
+			{
+				tsreader->buff_state.running = 0 ;
+				break ;
 			}
-			tsreader->buff_state.get_sync = 0 ;
 
 			// did we find it?
-			if  ((tsreader->buff_state.buffer_len == 0) || (tsreader->buff_state.bptr[0] != SYNC_BYTE))
+			if  ((tsreader->buff_state.buffer_len <= (int)prefix) || (tsreader->buff_state.bptr[prefix] != SYNC_BYTE))
 			{
 				// clear buffer
 				tsreader->buff_state.get_sync = 1 ;
 				tsreader->buff_state.buffer_len = 0 ;
+				tsreader_batch_flush(tsreader) ;
 
 				// return error
-				RETURN_DVB_ERROR(ERR_NOSYNC) ;
+				RETURN_TSREADER_ERROR(tsreader, ERR_NOSYNC) ;
 			}
 		}
-		tsparse_dbg_prt(10, ("TS: handling TS packets...(buffer @ %p => 0x%02x)\n", tsreader->buff_state.buffer, tsreader->buff_state.bptr[0])) ;
+		loop_dbg_prt(10, ("TS: handling TS packets...(buffer @ %p => 0x%02x)\n", tsreader->buff_state.buffer, tsreader->buff_state.bptr[0])) ;
+
+		// validate the alignment of all of the complete packets in one go
+		sync_ok = ts_sync_check(tsreader->buff_state.bptr + prefix, tsreader->buff_state.buffer_len / stride, stride) ;
 
 		// handle rest of TS packet(s)
-		while ( tsreader->buff_state.running && !tsreader->buff_state.get_sync && (tsreader->buff_state.buffer_len >= TS_PACKET_LEN) )
+		while ( tsreader->buff_state.running && !tsreader->buff_state.get_sync && (tsreader->buff_state.buffer_len >= stride) )
 		{
-			tsparse_dbg_prt(10, ("TS: Start data of loop : 0x%02x (bptr @ %p) %d bytes left : local pkt count = %u\n",
+			loop_dbg_prt(10, ("TS: Start data of loop : 0x%02x (bptr @ %p) %d bytes left : local pkt count = %"PRIu64"\n",
 					tsreader->buff_state.bptr[0], tsreader->buff_state.bptr, tsreader->buff_state.buffer_len, tsreader->buff_state.pktnum)) ;
-			tsparse_dbg_prt(10, ("TS: # pkt count = %u\n", tsreader->buff_state.pktnum)) ;
+			loop_dbg_prt(10, ("TS: # pkt count = %"PRIu64"\n", tsreader->buff_state.pktnum)) ;
 
-			// check sync byte
-			if (tsreader->buff_state.bptr[0] != SYNC_BYTE)
+			// check sync byte (only needed once past the block already validated)
+			if (!sync_ok && (tsreader->buff_state.bptr[prefix] != SYNC_BYTE))
 			{
 				// re-sync
 				++tsreader->buff_state.get_sync ;
 
-				tsparse_dbg_prt(10, ("TS: ! Resync required : 0x%02x (bptr @ %p)\n", tsreader->buff_state.bptr[0], tsreader->buff_state.bptr)) ;
+				loop_dbg_prt(10, ("TS: ! Resync required : 0x%02x (bptr @ %p)\n", tsreader->buff_state.bptr[0], tsreader->buff_state.bptr)) ;
 			}
 			else
 			{
-				// Do something with the packet
-				parse_ts_packet(tsreader, tsreader->tsstate, tsreader->buff_state.bptr, TS_PACKET_LEN) ;
-
-				// Progress required?
-				if (tsreader->progress_hook)
-				{
-					if (tsreader->buff_state.pktnum == tsreader->progress_info.next_progress)
-					{
-						tsreader->progress_hook(PROGRESS_RUNNING,
-								(unsigned)(tsreader->buff_state.pktnum / tsreader->progress_info.scale),
-								tsreader->progress_info.total,
-								tsreader->user_data) ;
+				if (sync_ok)
+					--sync_ok ;
 
-						tsreader->progress_info.next_progress += tsreader->progress_info.step ;
-					}
-				}
-
-				//== check for end ==
-				++tsreader->buff_state.pktnum ;
-				++tsreader->tsstate->pidinfo.pktnum ;
-
-				// only compare with total packets if it's been set!
-				if (tsreader->tsstate->total_pkts && (tsreader->buff_state.pktnum >= tsreader->tsstate->total_pkts) )
-				{
-					// reached end of file
-					tsreader->buff_state.running = 0 ;
-					tsparse_dbg_prt(100, ("TS: stop running total pkts (len=%d)\n", tsreader->buff_state.buffer_len)) ;
-				}
-
-				// check if max packets has been set
-				if (tsreader->num_pkts && (tsreader->buff_state.pktnum >= tsreader->num_pkts) )
-				{
-					// reached requested number of packets
-					tsreader->buff_state.running = 0 ;
-					tsparse_dbg_prt(100, ("TS: stop running num pkts> (len=%d)\n", tsreader->buff_state.buffer_len)) ;
-				}
+				// Do something with the packet
+				if (prefix)
+					tsreader->tsstate->pidinfo.arrival_ts = TS_M2TS_ARRIVAL_TS(tsreader->buff_state.bptr) ;
+				parse_ts_packet_loop(tsreader, tsreader->tsstate, tsreader->buff_state.bptr + prefix, TS_PACKET_LEN, loop) ;
 
-				// check special STOP flag
-				if (tsreader->tsstate->stop_flag)
-				{
-					// stop request
-					tsreader->buff_state.running = 0 ;
-					tsparse_dbg_prt(100, ("TS: stop running flag (len=%d)\n", tsreader->buff_state.buffer_len)) ;
-				}
+				// Progress, packet count, end checks
+				tsreader_packet_done(tsreader) ;
 
 				// update buffer
-				tsreader->buff_state.buffer_len -= TS_PACKET_LEN ;
-				tsreader->buff_state.bptr += TS_PACKET_LEN ;
+				tsreader->buff_state.buffer_len -= stride ;
+				tsreader->buff_state.bptr += stride ;
 
 			} // if get_sync
 
-			tsparse_dbg_prt(10, ("TS: End of data loop : 0x%02x (bptr @ %p) %d bytes left\n",
+			loop_dbg_prt(10, ("TS: End of data loop : 0x%02x (bptr @ %p) %d bytes left\n",
 					tsreader->buff_state.bptr[0], tsreader->buff_state.bptr, tsreader->buff_state.buffer_len)) ;
 
-			tsparse_dbg_prt(10, ("TS: running=%d, get sync=%d, buff len=%d\n",
+			loop_dbg_prt(10, ("TS: running=%d, get sync=%d, buff len=%d\n",
 					tsreader->buff_state.running, tsreader->buff_state.get_sync, tsreader->buff_state.buffer_len)) ;
 
 		} // while in sync
 
 
 		// process other bytes if still got data
-		if ((tsreader->buff_state.buffer_len > 0) && (tsreader->buff_state.bptr[0] != SYNC_BYTE))
+		if ((tsreader->buff_state.buffer_len > (int)prefix) && (tsreader->buff_state.bptr[prefix] != SYNC_BYTE))
 		{
 			tsreader->buff_state.get_sync = 1 ;
 		}
 
-		tsparse_dbg_prt(100, ("TS: Loop end...(len=%d)\n", tsreader->buff_state.buffer_len)) ;
+		// in sync but only a partial packet left - wait for more data
+		if (!tsreader->buff_state.get_sync && (tsreader->buff_state.buffer_len < stride))
+		{
+			break ;
+		}
+
+		loop_dbg_prt(100, ("TS: Loop end...(len=%d)\n", tsreader->buff_state.buffer_len)) ;
 
 	} // while got data
 
+	// batched packets point into this buffer so pass them on now
+	tsreader_batch_flush(tsreader) ;
+
 	return 0 ;
 }
 
+/* ----------------------------------------------------------------------- */
+// The loop is chosen again for each block of data so that debug or hooks changed after tsreader_data_start() (e.g.
+// by a handler) take effect from the next block
+static int tsreader_data_process(struct TS_reader *tsreader)
+{
+	tsreader_select_loop(tsreader) ;
+
+	switch (tsreader->parse_loop)
+	{
+	case TS_LOOP_TS:
+		return data_process_loop(tsreader, TS_LOOP_TS) ;
+
+	case TS_LOOP_UNITS:
+		return data_process_loop(tsreader, TS_LOOP_UNITS) ;
+
+	default:
+		return data_process_loop(tsreader, TS_LOOP_GENERIC) ;
+	}
+}
+
 
 /* ----------------------------------------------------------------------- */
+// End of the data. Any PES/PSI that's complete but still buffered (i.e. not followed by another start on its pid) is
+// passed to the hooks/section handlers first
 int tsreader_data_end(struct TS_reader *tsreader)
 {
 	CHECK_TS_READER(tsreader) ;
 
+	// anything complete that's still buffered
+	if (!tsreader->tsstate->stop_flag)
+		units_flush(tsreader, 0) ;
+
 	// Progress required?
 	if (tsreader->progress_hook)
 	{
-		unsigned scaled_pktnum = (unsigned)(tsreader->buff_state.pktnum / tsreader->progress_info.scale) ;
-		if (scaled_pktnum > tsreader->progress_info.total) scaled_pktnum = tsreader->progress_info.total ;
+		uint64_t total = tsreader->tsstate->total_pkts ;
+		uint64_t pktnum = tsreader->buff_state.pktnum ;
+		if (pktnum > total) pktnum = total ;
 
 		if (tsreader->tsstate->stop_flag)
 		{
 			// premature stop
 			tsreader->progress_hook(PROGRESS_STOPPED,
-					scaled_pktnum,
-					tsreader->progress_info.total,
+					pktnum,
+					total,
 					tsreader->user_data) ;
 		}
 		else
 		{
 			// run to end
 			tsreader->progress_hook(PROGRESS_END,
-					tsreader->progress_info.total,
-					tsreader->progress_info.total,
+					total,
+					total,
 					tsreader->user_data) ;
 		}
 	}
@@ -2283,3 +3567,373 @@ int tsreader_data_end(struct TS_reader *tsreader)
     return 0;
 }
 
+
+
+/*=============================================================================================*/
+// Pull iterators
+//
+// Instead of calling ts_parse(), the file can be stepped through one packet/PES/section at a time
+// with tsreader_next_packet(), tsreader_next_pes() or tsreader_next_section(). Each call fills in a
+// view whose pointers refer to the reader's own buffers (nothing is copied) and which remains valid
+// until the next call on the reader. Any hooks that are set are still called as the packets are parsed.
+//
+// Each returns 1 if a view was filled in, 0 at the end of the data (or once stopped), or an error code (-ve).
+
+/* ----------------------------------------------------------------------- */
+static int iter_start(struct TS_reader *tsreader)
+{
+int status ;
+
+	if (tsreader->iter.started)
+		return 0 ;
+
+	// check file open
+	if (!tsreader->file)
+	{
+		RETURN_TSREADER_ERROR(tsreader, ERR_FILE) ;
+	}
+
+	if (!tsreader->iter.buff)
+	{
+		tsreader->iter.buff = (uint8_t *)malloc(TS_ITER_BUFFSIZE) ;
+		if (!tsreader->iter.buff)
+		{
+			RETURN_TSREADER_ERROR(tsreader, ERR_MALLOC) ;
+		}
+	}
+
+	status = tsreader_data_start(tsreader) ;
+	if (status) return (status) ;
+
+	tsreader->buff_state.bptr = tsreader->iter.buff ;
+	tsreader->iter.started = 1 ;
+	tsreader->iter.eof = 0 ;
+	tsreader->iter.ended = 0 ;
+
+	return 0 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Move any unused bytes to the start of the buffer and top it up from the file. Returns the number of bytes
+// read (0 at end of file)
+static int iter_fill(struct TS_reader *tsreader)
+{
+struct TS_buff_state *bs = &tsreader->buff_state ;
+int bytes_read ;
+
+	// batched packets point into the buffer so must be passed on before it changes
+	tsreader_batch_flush(tsreader) ;
+
+	if (bs->buffer_len && (bs->bptr != tsreader->iter.buff))
+		memmove(tsreader->iter.buff, bs->bptr, bs->buffer_len) ;
+	bs->bptr = tsreader->iter.buff ;
+
+	do
+	{
+		bytes_read = read(tsreader->file, &tsreader->iter.buff[bs->buffer_len], TS_ITER_BUFFSIZE - bs->buffer_len) ;
+	} while ((bytes_read < 0) && (errno == EINTR)) ;
+
+	if (bytes_read < 0)
+	{
+		RETURN_TSREADER_ERROR(tsreader, ERR_READ) ;
+	}
+	if (bytes_read == 0)
+		tsreader->iter.eof = 1 ;
+
+	bs->buffer_len += bytes_read ;
+	return bytes_read ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Get the next packet (re-syncing if necessary). Sets *packet to NULL at the end of the data
+static int iter_get_packet(struct TS_reader *tsreader, uint8_t **packet)
+{
+struct TS_buff_state *bs = &tsreader->buff_state ;
+const int stride = (int)tsreader->packet_size ;
+const unsigned prefix = tsreader->packet_prefix ;
+unsigned byte_num ;
+int need ;
+int status ;
+
+	*packet = NULL ;
+	while (bs->running)
+	{
+		// top up the buffer, making sure there's enough to find sync in if required
+		need = bs->get_sync ? 5*stride : stride ;
+		if ((bs->buffer_len < need) && !tsreader->iter.eof)
+		{
+			status = iter_fill(tsreader) ;
+			if (status < 0) return (status) ;
+			continue ;
+		}
+
+		// end of data
+		if (bs->buffer_len < stride)
+			break ;
+
+		if (bs->get_sync)
+		{
+			tsparse_dbg_prt(10, ("TS: iter waiting for sync...\n")) ;
+
+			// same rules as tsreader_data_process()
+			byte_num = ts_sync_find(bs->bptr + prefix, bs->buffer_len - prefix, 4*stride+1, TS_SYNC_CONFIRM, stride) ;
+			if (byte_num > 4*stride)
+				byte_num = bs->buffer_len ;
+			bs->buffer_len -= byte_num ;
+			bs->bptr += byte_num ;
+			bs->skipped += byte_num ;
+
+			// skipped up to end_pos
+			if (tsreader_at_end_pos(tsreader))
+			{
+				bs->running = 0 ;
+				break ;
+			}
+
+			if  ((bs->buffer_len <= (int)prefix) || (bs->bptr[prefix] != SYNC_BYTE))
+			{
+				bs->buffer_len = 0 ;
+				RETURN_TSREADER_ERROR(tsreader, ERR_NOSYNC) ;
+			}
+			bs->get_sync = 0 ;
+			continue ;
+		}
+
+		if (bs->bptr[prefix] != SYNC_BYTE)
+		{
+			tsparse_dbg_prt(10, ("TS: ! iter resync required : 0x%02x (bptr @ %p)\n", bs->bptr[prefix], bs->bptr)) ;
+			bs->get_sync = 1 ;
+			continue ;
+		}
+
+		if (prefix)
+			tsreader->tsstate->pidinfo.arrival_ts = TS_M2TS_ARRIVAL_TS(bs->bptr) ;
+		*packet = bs->bptr + prefix ;
+		bs->bptr += stride ;
+		bs->buffer_len -= stride ;
+		break ;
+	}
+
+	return 0 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Hand the last complete PES/PSI buffer back (kept as the spare to swap in next time)
+static void iter_release_unit(struct TS_reader *tsreader)
+{
+	if (tsreader->iter.unit_buff)
+	{
+		tsreader->iter.unit_buff->data_len = 0 ;
+		if (tsreader->iter.spare_buff)
+			buffer_free(&tsreader->iter.unit_buff) ;
+		else
+			tsreader->iter.spare_buff = tsreader->iter.unit_buff ;
+		tsreader->iter.unit_buff = NULL ;
+	}
+	tsreader->iter.sect_left = 0 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Called on a change of file position. Drops any buffered file data along with any partially reassembled PES/PSI
+static void iter_reset(struct TS_reader *tsreader)
+{
+struct list_head *item ;
+struct TS_pid *piditem ;
+
+	if (!tsreader->iter.started)
+		return ;
+
+	tsreader_batch_flush(tsreader) ;
+	iter_release_unit(tsreader) ;
+
+	tsreader->buff_state.bptr = tsreader->iter.buff ;
+	tsreader->buff_state.buffer_len = 0 ;
+	tsreader->buff_state.get_sync = 1 ;
+	tsreader->buff_state.running = 1 ;
+	tsreader->buff_state.pktnum = 0 ;
+	tsreader->buff_state.skipped = 0 ;
+	tsreader->iter.eof = 0 ;
+	tsreader->iter.ended = 0 ;
+
+	// wait for the next unit start on each pid
+	list_for_each(item, &tsreader->tsstate->pid_list)
+	{
+		piditem = list_entry(item, struct TS_pid, next) ;
+		piditem->pes_state = PES_SKIP ;
+		if (piditem->pes_buff)
+			piditem->pes_buff->data_len = 0 ;
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Parse the next packet. Returns 1 if a packet was parsed (view->packet is NULL if it was dropped), 0 at the
+// end of the data, or an error code
+static int iter_step(struct TS_reader *tsreader, struct TS_packet_view *view)
+{
+uint8_t *packet ;
+unsigned start ;
+int status ;
+
+	view->packet = NULL ;
+
+	status = iter_start(tsreader) ;
+	if (status) return (status) ;
+
+	status = iter_get_packet(tsreader, &packet) ;
+	if (status) return (status) ;
+
+	if (!packet)
+	{
+		// pass on anything complete that's still buffered - one at a time so that each can be returned
+		if (!tsreader->iter.ended && !tsreader->tsstate->stop_flag && units_flush(tsreader, 1))
+			return 1 ;
+
+		// finish off (once)
+		if (!tsreader->iter.ended)
+		{
+			tsreader_batch_flush(tsreader) ;
+			tsreader_data_end(tsreader) ;
+			tsreader->iter.ended = 1 ;
+		}
+		return 0 ;
+	}
+
+	if (parse_ts_packet(tsreader, tsreader->tsstate, packet, TS_PACKET_LEN))
+	{
+		// parse_ts_packet() only passes on packets that have a payload
+		start = 4 ;
+		if (tsreader->tsstate->pidinfo.afc == 3)
+			start += packet[4] + 1 ;
+
+		view->pidinfo = tsreader->tsstate->pidinfo ;
+		view->packet = packet ;
+		view->payload = &packet[start] ;
+		view->payload_len = TS_PACKET_LEN - start ;
+	}
+
+	tsreader_packet_done(tsreader) ;
+
+	return 1 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Parse packets until a complete PES (pes_psi=T_PES) or PSI (T_PSI) is available in iter.unit_buff
+static int iter_next_unit(struct TS_reader *tsreader, enum TS_pes_psi pes_psi)
+{
+struct TS_packet_view view ;
+int status ;
+
+	iter_release_unit(tsreader) ;
+	tsreader->iter.want |= (pes_psi == T_PES ? TS_ITER_PES : TS_ITER_SECTIONS) ;
+
+	for (;;)
+	{
+		status = iter_step(tsreader, &view) ;
+		if (status <= 0) return (status) ;
+
+		if (tsreader->iter.unit_buff)
+		{
+			if (tsreader->iter.pesinfo.pes_psi == pes_psi)
+				return 1 ;
+
+			// other type was wanted by an earlier call - drop it
+			iter_release_unit(tsreader) ;
+		}
+	}
+}
+
+/* ----------------------------------------------------------------------- */
+// Get the next TS packet that has a payload (i.e. the packets seen by the ts_hook)
+int tsreader_next_packet(struct TS_reader *tsreader, struct TS_packet_view *view)
+{
+int status ;
+
+	CHECK_TS_READER(tsreader) ;
+
+	do
+	{
+		status = iter_step(tsreader, view) ;
+	} while ((status > 0) && !view->packet) ;
+
+	return status ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Get the next complete PES packet
+int tsreader_next_pes(struct TS_reader *tsreader, struct TS_pes_view *view)
+{
+int status ;
+
+	CHECK_TS_READER(tsreader) ;
+
+	status = iter_next_unit(tsreader, T_PES) ;
+	if (status <= 0) return (status) ;
+
+	view->pidinfo = tsreader->iter.pidinfo ;
+	view->pesinfo = tsreader->iter.pesinfo ;
+	view->pes = tsreader->iter.unit_buff->buff ;
+	view->pes_len = tsreader->iter.unit_buff->data_len ;
+
+	return 1 ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Get the next SI section. Sections with the section_syntax_indicator set are only returned if the CRC is correct
+int tsreader_next_section(struct TS_reader *tsreader, struct TS_section_view *view)
+{
+uint8_t *section ;
+unsigned section_len ;
+unsigned ptr ;
+int status ;
+
+	CHECK_TS_READER(tsreader) ;
+
+	for (;;)
+	{
+		// return any sections left in the current PSI
+		while (tsreader->iter.sect_left >= SECTION_HEADER_LEN)
+		{
+			section = tsreader->iter.sect_ptr ;
+
+			// stuffing
+			if (section[0] == 0xff)
+				break ;
+
+			//	table_id 8 uimsbf
+			//	section_syntax_indicator 1 bslbf
+			//	indicator 1 bslbf
+			//	reserved 2 bslbf
+			//	section_length 12 uimsbf
+			section_len = SECTION_HEADER_LEN + (((section[1] & 0x0f) << 8) | section[2]) ;
+			if (section_len > tsreader->iter.sect_left)
+				break ;
+
+			tsreader->iter.sect_ptr += section_len ;
+			tsreader->iter.sect_left -= section_len ;
+
+			if ((section[1] & 0x80) && ts_crc32(section, section_len))
+			{
+				tsparse_dbg_prt(2, ("!!SI CRC FAIL!! - PID 0x%x table 0x%02x skipped\n", tsreader->iter.pidinfo.pid, section[0])) ;
+				continue ;
+			}
+
+			view->pidinfo = tsreader->iter.pidinfo ;
+			view->table_id = section[0] ;
+			view->section = section ;
+			view->section_len = section_len ;
+
+			return 1 ;
+		}
+
+		status = iter_next_unit(tsreader, T_PSI) ;
+		if (status <= 0) return (status) ;
+
+		//	pointer_field 8 uimsbf
+		ptr = tsreader->iter.unit_buff->buff[0] ;
+		if (ptr + 1 < tsreader->iter.unit_buff->data_len)
+		{
+			tsreader->iter.sect_ptr = &tsreader->iter.unit_buff->buff[ptr + 1] ;
+			tsreader->iter.sect_left = (int)(tsreader->iter.unit_buff->data_len - (ptr + 1)) ;
+		}
+	}
+}
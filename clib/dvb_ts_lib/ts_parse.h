@@ -33,20 +33,43 @@ void buffer_free(struct TS_buffer **buff);
 struct TS_buffer *buffer_new();
 void buffer_clear(struct TS_buffer *bp);
 uint8_t *buffer_data(struct TS_buffer **buff, const uint8_t *data, unsigned data_len);
+struct TS_buffer *buffer_new_pooled(struct TS_buffer_pool *pool);
+void buffer_pool_free(struct TS_buffer_pool *pool);
 
 // TS utils
 void ts_null_packet(uint8_t *packet, unsigned packet_len) ;
 
+// video
+unsigned mpeg2_frame_flags(struct TS_reader *tsreader, struct TS_state *tsstate, uint8_t *pesdata, unsigned pesdata_len) ;
+
 // SI table decoding
 int tsreader_register_section(struct TS_reader *tsreader,
 		unsigned table_id, unsigned mask,
 		Section_handler	handler, struct Section_decode_flags flags) ;
+int tsreader_register_section_view(struct TS_reader *tsreader,
+		unsigned table_id, unsigned mask,
+		Section_view_handler handler, struct Section_decode_flags flags) ;
+void tsreader_section_cache_clear(struct TS_reader *tsreader) ;
+struct TS_arena *tsreader_section_detach(struct TS_reader *tsreader) ;
+
+// PID filtering
+void tsreader_pid_filter_mode(struct TS_reader *tsreader, enum TS_pid_filter_mode mode) ;
+void tsreader_pid_filter_set(struct TS_reader *tsreader, unsigned pid) ;
+void tsreader_pid_filter_clear(struct TS_reader *tsreader, unsigned pid) ;
+void tsreader_pid_filter_invert(struct TS_reader *tsreader) ;
 
 // TS parsing
-int tsreader_setpos(struct TS_reader *tsreader, int skip_pkts, int origin, unsigned num_pkts) ;
+int tsreader_setpos(struct TS_reader *tsreader, int64_t skip_pkts, int origin, uint64_t num_pkts) ;
+int tsreader_setpos_byte(struct TS_reader *tsreader, uint64_t pos, uint64_t pktnum, uint64_t num_pkts) ;
 void tsreader_start_framenum(struct TS_reader *tsreader, unsigned framenum) ;
+void tsreader_set_timing(struct TS_reader *tsreader) ;
+const struct TS_pid_stats *tsreader_pid_stats(struct TS_reader *tsreader, unsigned pid) ;
+void tsreader_pid_stats_clear(struct TS_reader *tsreader) ;
+const struct TS_buffer_pool_stats *tsreader_buffer_pool_stats(struct TS_reader *tsreader) ;
+void tsreader_buffer_pool_limit(struct TS_reader *tsreader, uint64_t max_bytes) ;
 struct TS_reader *tsreader_new(char *filename) ;
 struct TS_reader *tsreader_new_nofile() ;
+struct TS_reader *tsreader_new_follow(char *filename) ;
 void tsreader_free(struct TS_reader *) ;
 int ts_parse(struct TS_reader *tsreader) ;
 void tsreader_stop(struct TS_reader *tsreader) ;
@@ -54,7 +77,13 @@ void tsreader_stop(struct TS_reader *tsreader) ;
 // "Live" parsing
 int tsreader_data_start(struct TS_reader *tsreader) ;
 int tsreader_data_add(struct TS_reader *tsreader, uint8_t *data, unsigned data_len) ;
+int tsreader_data_add_shared(struct TS_reader *tsreader, const uint8_t *data, unsigned data_len) ;
 int tsreader_data_end(struct TS_reader *tsreader) ;
 
+// Pull iterators
+int tsreader_next_packet(struct TS_reader *tsreader, struct TS_packet_view *view) ;
+int tsreader_next_pes(struct TS_reader *tsreader, struct TS_pes_view *view) ;
+int tsreader_next_section(struct TS_reader *tsreader, struct TS_section_view *view) ;
+
 
 #endif /* TS_PARSE_H_ */
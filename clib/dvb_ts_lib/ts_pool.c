@@ -0,0 +1,349 @@
+/*
+ * ts_pool.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * Process a list of files in parallel, one TS_reader per worker thread. Each thread takes the next file
+ * from the list until all have been processed. Nothing is shared between the readers, so the hooks are
+ * free to use their reader's state without locking (any data shared between files is up to the caller).
+ */
+
+// VERSION = 1.00
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "ts_parse.h"
+#include "ts_pool.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+// Returns the index of the next file to process, or num_files when there are none left
+static unsigned pool_next_file(struct TS_pool *pool)
+{
+unsigned index ;
+
+	pthread_mutex_lock(&pool->lock) ;
+	index = pool->next_file ;
+	if (pool->next_file < pool->num_files)
+		++pool->next_file ;
+	pthread_mutex_unlock(&pool->lock) ;
+
+	return index ;
+}
+
+/* ----------------------------------------------------------------------- */
+static void pool_error(struct TS_pool *pool)
+{
+	pthread_mutex_lock(&pool->lock) ;
+	++pool->num_errors ;
+	pthread_mutex_unlock(&pool->lock) ;
+}
+
+/* ----------------------------------------------------------------------- */
+static void *pool_thread(void *arg)
+{
+struct TS_pool *pool = (struct TS_pool *)arg ;
+struct TS_reader *tsreader ;
+unsigned index ;
+int status ;
+
+	while ((index = pool_next_file(pool)) < pool->num_files)
+	{
+		tsreader = tsreader_new(pool->files[index]) ;
+		if (!tsreader)
+		{
+			pool_error(pool) ;
+			if (pool->done_hook)
+				pool->done_hook(NULL, index, dvb_error_code, pool->user_data) ;
+			continue ;
+		}
+
+		status = 0 ;
+		if (pool->setup_hook)
+			status = pool->setup_hook(tsreader, index, pool->user_data) ;
+
+		if (!status)
+		{
+			status = ts_parse(tsreader) ;
+			if (status)
+				pool_error(pool) ;
+
+			if (pool->done_hook)
+				pool->done_hook(tsreader, index, status, pool->user_data) ;
+		}
+
+		tsreader_free(tsreader) ;
+	}
+
+	return NULL ;
+}
+
+/*=============================================================================================*/
+// PUBLIC
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+// Process all of the files using up to pool->num_threads threads (0 = one per file). Returns the number of
+// files that failed, or an error code if the threads couldn't be started
+int tspool_run(struct TS_pool *pool)
+{
+pthread_t threads[TS_POOL_MAX_THREADS] ;
+unsigned num_threads ;
+unsigned i ;
+
+	num_threads = pool->num_threads ? pool->num_threads : pool->num_files ;
+	if (num_threads > pool->num_files)
+		num_threads = pool->num_files ;
+	if (num_threads > TS_POOL_MAX_THREADS)
+		num_threads = TS_POOL_MAX_THREADS ;
+
+	pool->next_file = 0 ;
+	pool->num_errors = 0 ;
+	pthread_mutex_init(&pool->lock, NULL) ;
+
+	for (i=0; i < num_threads; ++i)
+	{
+		if (pthread_create(&threads[i], NULL, pool_thread, pool) != 0)
+			break ;
+	}
+
+	// couldn't start any threads
+	if (!i && num_threads)
+	{
+		pthread_mutex_destroy(&pool->lock) ;
+		RETURN_DVB_ERROR(ERR_GENERIC) ;
+	}
+
+	// any threads that did start share out all of the files between them
+	num_threads = i ;
+	for (i=0; i < num_threads; ++i)
+	{
+		pthread_join(threads[i], NULL) ;
+	}
+
+	pthread_mutex_destroy(&pool->lock) ;
+
+	return (int)pool->num_errors ;
+}
+
+
+//============================================================================================
+// Stress test: parses each file on its own to get the reference results, then repeatedly parses
+// them all at once in many threads (each file several times over) and checks every reader gets
+// exactly the same results.
+//
+//   ts_pool [-t threads] [-r rounds] [-c copies] file.ts ...
+//
+#ifdef TEST_MAIN
+
+#include "tables/parse_si_eit.h"
+
+struct Pool_test_result {
+	uint64_t	ts_pkts ;
+	uint64_t	ts_sum ;
+	uint64_t	pes_bytes ;
+	uint64_t	eit_events ;
+	int64_t		start_ts ;
+	int64_t		end_ts ;
+	int			status ;
+	int			error_code ;
+};
+
+struct Pool_test {
+	char					**files ;
+	unsigned				num_files ;
+	unsigned				num_ref_files ;
+	struct Pool_test_result	*results ;
+};
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_ts_hook(struct TS_pidinfo *pidinfo, uint8_t *packet, unsigned packet_len, void *user_data)
+{
+struct Pool_test_result *result = (struct Pool_test_result *)user_data ;
+
+	++result->ts_pkts ;
+	result->ts_sum += (pidinfo->pktnum ^ pidinfo->pid) + packet[3] ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_pes_hook(struct TS_pidinfo *pidinfo, struct TS_pesinfo *pesinfo, uint8_t *pes, unsigned pes_len, void *user_data)
+{
+struct Pool_test_result *result = (struct Pool_test_result *)user_data ;
+
+	result->pes_bytes += pes_len ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_eit_handler(struct TS_reader *tsreader, struct TS_state *tsstate, struct Section *section, void *user_data)
+{
+struct Pool_test_result *result = (struct Pool_test_result *)user_data ;
+struct Section_event_information *eit = (struct Section_event_information *)section ;
+struct list_head *item ;
+
+	list_for_each(item, &eit->eit_array)
+	{
+		struct EIT_entry *entry = list_entry(item, struct EIT_entry, next) ;
+		result->eit_events += entry->event_id ;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static int test_setup(struct TS_reader *tsreader, unsigned index, void *user_data)
+{
+struct Pool_test *test = (struct Pool_test *)user_data ;
+struct Pool_test_result *result = &test->results[index] ;
+struct Section_decode_flags flags = SECTION_DECODE_FLAGS_INIT ;
+
+	memset(result, 0, sizeof(*result)) ;
+
+	tsreader->user_data = result ;
+	tsreader->ts_hook = test_ts_hook ;
+	tsreader->pes_hook = test_pes_hook ;
+	tsreader_register_section(tsreader, SECTION_EIT_NOW_ACTUAL, 0xff, test_eit_handler, flags) ;
+
+	// use a mix of read methods (always the same one for any copy of a file)
+	tsreader->use_mmap = (index % test->num_ref_files) & 1 ;
+	tsreader->use_readahead = (index % test->num_ref_files) & 2 ;
+
+	return 0 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+static void test_done(struct TS_reader *tsreader, unsigned index, int status, void *user_data)
+{
+struct Pool_test *test = (struct Pool_test *)user_data ;
+struct Pool_test_result *result = &test->results[index] ;
+
+	result->status = status ;
+	if (tsreader)
+	{
+		tsreader_set_timing(tsreader) ;
+		result->start_ts = tsreader->tsstate->start_ts ;
+		result->end_ts = tsreader->tsstate->end_ts ;
+		result->error_code = tsreader->error_code ;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct Pool_test ref_test ;
+struct Pool_test test ;
+struct TS_pool pool ;
+unsigned num_threads = 8 ;
+unsigned rounds = 10 ;
+unsigned copies = 4 ;
+unsigned round, i, failed = 0 ;
+int c ;
+
+	while ((c = getopt (argc, argv, "t:r:c:")) != -1)
+	{
+		switch (c)
+		{
+		case 't':
+			num_threads = atoi(optarg) ;
+			break;
+
+		case 'r':
+			rounds = atoi(optarg) ;
+			break;
+
+		case 'c':
+			copies = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	if (optind >= argc)
+	{
+		printf("Error: Must specify input filename(s)\n") ;
+		abort() ;
+	}
+
+	// reference results - each file parsed on its own
+	ref_test.num_files = argc - optind ;
+	ref_test.num_ref_files = ref_test.num_files ;
+	ref_test.files = &argv[optind] ;
+	ref_test.results = (struct Pool_test_result *)calloc(ref_test.num_files, sizeof(struct Pool_test_result)) ;
+
+	memset(&pool, 0, sizeof(pool)) ;
+	pool.files = ref_test.files ;
+	pool.num_files = ref_test.num_files ;
+	pool.num_threads = 1 ;
+	pool.user_data = &ref_test ;
+	pool.setup_hook = test_setup ;
+	pool.done_hook = test_done ;
+	tspool_run(&pool) ;
+
+	// each file repeated 'copies' times, all run at once
+	test.num_files = ref_test.num_files * copies ;
+	test.num_ref_files = ref_test.num_files ;
+	test.files = (char **)calloc(test.num_files, sizeof(char *)) ;
+	test.results = (struct Pool_test_result *)calloc(test.num_files, sizeof(struct Pool_test_result)) ;
+	for (i=0; i < test.num_files; ++i)
+		test.files[i] = ref_test.files[i % ref_test.num_files] ;
+
+	pool.files = test.files ;
+	pool.num_files = test.num_files ;
+	pool.num_threads = num_threads ;
+	pool.user_data = &test ;
+
+	for (round=0; round < rounds; ++round)
+	{
+		tspool_run(&pool) ;
+
+		for (i=0; i < test.num_files; ++i)
+		{
+		struct Pool_test_result *ref = &ref_test.results[i % ref_test.num_files] ;
+		struct Pool_test_result *res = &test.results[i] ;
+
+			if (memcmp(ref, res, sizeof(*ref)) != 0)
+			{
+				printf("FAIL round %u : %s [%u] : pkts %"PRIu64"/%"PRIu64" pes %"PRIu64"/%"PRIu64" eit %"PRIu64"/%"PRIu64" status %d/%d\n",
+						round, test.files[i], i,
+						res->ts_pkts, ref->ts_pkts,
+						res->pes_bytes, ref->pes_bytes,
+						res->eit_events, ref->eit_events,
+						res->status, ref->status) ;
+				++failed ;
+			}
+		}
+	}
+
+	printf("%s : %u files x %u copies, %u threads, %u rounds : %u failures\n",
+			failed ? "FAIL" : "PASS",
+			ref_test.num_files, copies, num_threads, rounds, failed) ;
+
+	free(test.files) ;
+	free(test.results) ;
+	free(ref_test.results) ;
+
+	return failed ? 1 : 0 ;
+}
+#endif
@@ -0,0 +1,62 @@
+/*
+ * ts_pool.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef TS_POOL_H_
+#define TS_POOL_H_
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "ts_structs.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+// maximum number of worker threads
+#define TS_POOL_MAX_THREADS		64
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+// Called in the worker thread for each file: setup_hook after the reader is created (set the hooks/user_data here,
+// return non-zero to skip the file), done_hook once ts_parse() has finished (status is the ts_parse() result)
+typedef int (*tspool_setup_hook)(struct TS_reader *, unsigned, void *) ;
+typedef void (*tspool_done_hook)(struct TS_reader *, unsigned, int, void *) ;
+
+// Runs one TS_reader per thread over a list of files
+struct TS_pool {
+	// set by user
+	char					**files ;
+	unsigned				num_files ;
+	unsigned				num_threads ;
+	void					*user_data ;
+
+	tspool_setup_hook		setup_hook ;
+	tspool_done_hook		done_hook ;
+
+	// internally set
+	pthread_mutex_t			lock ;
+	unsigned				next_file ;		// next file to be handed out (protected by lock)
+	unsigned				num_errors ;	// files that failed to open or parse (protected by lock)
+};
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+int tspool_run(struct TS_pool *pool) ;
+
+#endif /* TS_POOL_H_ */
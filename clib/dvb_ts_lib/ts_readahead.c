@@ -0,0 +1,232 @@
+/*
+ * ts_readahead.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * Background file reader. A dedicated thread keeps a ring of large buffers filled from the file
+ * so that the disk can be reading the next chunk while the parser works on the current one.
+ */
+
+// VERSION = 1.00
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "ts_readahead.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+uint64_t readahead_time_us(void)
+{
+struct timespec ts ;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts) ;
+	return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)(ts.tv_nsec / 1000) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Fill the buffer as far as possible (a single read() may return less than requested)
+int readahead_fill(int file, uint8_t *buff, unsigned buff_size)
+{
+int total = 0 ;
+int rc ;
+
+	while (total < (int)buff_size)
+	{
+		rc = read(file, &buff[total], buff_size - total) ;
+		if (rc < 0)
+		{
+			if (errno == EINTR)
+				continue ;
+			return total ? total : -1 ;
+		}
+		if (rc == 0)
+			break ;
+
+		total += rc ;
+	}
+	return total ;
+}
+
+/* ----------------------------------------------------------------------- */
+static void *readahead_thread(void *arg)
+{
+struct TS_readahead *ra = (struct TS_readahead *)arg ;
+unsigned idx ;
+int len ;
+
+	for (;;)
+	{
+		// wait for a free buffer
+		pthread_mutex_lock(&ra->lock) ;
+		while (!ra->stop && (ra->count == ra->num_buffs))
+			pthread_cond_wait(&ra->emptied, &ra->lock) ;
+
+		if (ra->stop)
+		{
+			pthread_mutex_unlock(&ra->lock) ;
+			break ;
+		}
+		idx = ra->tail ;
+		pthread_mutex_unlock(&ra->lock) ;
+
+		// buffer is owned by this thread until it's counted as filled
+		len = readahead_fill(ra->file, &ra->buffs[idx][ra->headroom], ra->buff_size) ;
+
+		pthread_mutex_lock(&ra->lock) ;
+		ra->buff_len[idx] = len ;
+		ra->tail = (ra->tail + 1) % ra->num_buffs ;
+		++ra->count ;
+		pthread_cond_signal(&ra->filled) ;
+		pthread_mutex_unlock(&ra->lock) ;
+
+		// end of file / error is passed on as a zero/negative length buffer
+		if (len <= 0)
+			break ;
+	}
+
+	return NULL ;
+}
+
+/* ----------------------------------------------------------------------- */
+void readahead_free(struct TS_readahead **ra_ptr)
+{
+struct TS_readahead *ra = *ra_ptr ;
+unsigned i ;
+
+	if (ra)
+	{
+		// stop the thread
+		if (ra->thread_running)
+		{
+			pthread_mutex_lock(&ra->lock) ;
+			ra->stop = 1 ;
+			pthread_cond_signal(&ra->emptied) ;
+			pthread_mutex_unlock(&ra->lock) ;
+
+			pthread_join(ra->thread, NULL) ;
+		}
+
+		pthread_cond_destroy(&ra->emptied) ;
+		pthread_cond_destroy(&ra->filled) ;
+		pthread_mutex_destroy(&ra->lock) ;
+
+		if (ra->buffs)
+		{
+			for (i=0; i < ra->num_buffs; ++i)
+			{
+				free(ra->buffs[i]) ;
+			}
+			free(ra->buffs) ;
+		}
+		free(ra->buff_len) ;
+		free(ra) ;
+	}
+	*ra_ptr = NULL ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Create the buffers and start reading the file from its current position
+struct TS_readahead *readahead_new(int file, unsigned num_buffs, unsigned buff_size, unsigned headroom)
+{
+struct TS_readahead *ra ;
+unsigned i ;
+
+	ra = (struct TS_readahead *)malloc(sizeof(struct TS_readahead)) ;
+	if (!ra)
+		return NULL ;
+	memset(ra, 0, sizeof(*ra));
+
+	ra->file = file ;
+	ra->num_buffs = num_buffs ;
+	ra->buff_size = buff_size ;
+	ra->headroom = headroom ;
+
+	pthread_mutex_init(&ra->lock, NULL) ;
+	pthread_cond_init(&ra->filled, NULL) ;
+	pthread_cond_init(&ra->emptied, NULL) ;
+
+	ra->buff_len = (int *)calloc(num_buffs, sizeof(int)) ;
+	ra->buffs = (uint8_t **)calloc(num_buffs, sizeof(uint8_t *)) ;
+	if (!ra->buff_len || !ra->buffs)
+	{
+		readahead_free(&ra) ;
+		return NULL ;
+	}
+
+	for (i=0; i < num_buffs; ++i)
+	{
+		ra->buffs[i] = (uint8_t *)malloc(headroom + buff_size) ;
+		if (!ra->buffs[i])
+		{
+			readahead_free(&ra) ;
+			return NULL ;
+		}
+	}
+
+	if (pthread_create(&ra->thread, NULL, readahead_thread, ra) != 0)
+	{
+		readahead_free(&ra) ;
+		return NULL ;
+	}
+	ra->thread_running = 1 ;
+
+	return ra ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Get the next filled buffer (blocks until available). Sets *data to the start of the file data
+// (there are ra->headroom bytes available before this pointer) and *data_len to the number of bytes
+// (0 at end of file, -1 on read error). The buffer must be handed back with readahead_release()
+int readahead_get(struct TS_readahead *ra, uint8_t **data, int *data_len)
+{
+uint64_t start ;
+
+	pthread_mutex_lock(&ra->lock) ;
+	if (!ra->count)
+	{
+		start = readahead_time_us() ;
+		while (!ra->count)
+			pthread_cond_wait(&ra->filled, &ra->lock) ;
+		ra->wait_us += readahead_time_us() - start ;
+	}
+
+	*data = &ra->buffs[ra->head][ra->headroom] ;
+	*data_len = ra->buff_len[ra->head] ;
+	pthread_mutex_unlock(&ra->lock) ;
+
+	return *data_len ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Finished with the buffer returned by readahead_get()
+void readahead_release(struct TS_readahead *ra)
+{
+	pthread_mutex_lock(&ra->lock) ;
+	ra->head = (ra->head + 1) % ra->num_buffs ;
+	--ra->count ;
+	pthread_cond_signal(&ra->emptied) ;
+	pthread_mutex_unlock(&ra->lock) ;
+}
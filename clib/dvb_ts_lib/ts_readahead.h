@@ -0,0 +1,70 @@
+/*
+ * ts_readahead.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef TS_READAHEAD_H_
+#define TS_READAHEAD_H_
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+#include <inttypes.h>
+#include <pthread.h>
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+// Ring of large buffers filled by a background reader thread. Each buffer has 'headroom' spare bytes
+// in front of the data so that the consumer can prepend any partial packet left over from the
+// previous buffer without copying the whole thing.
+struct TS_readahead {
+	int					file ;
+	unsigned			num_buffs ;
+	unsigned			buff_size ;
+	unsigned			headroom ;
+
+	uint8_t				**buffs ;
+	int					*buff_len ;
+
+	// ring indices (protected by lock)
+	unsigned			head ;			// next buffer to be consumed
+	unsigned			tail ;			// next buffer to be filled
+	unsigned			count ;			// number of filled buffers
+	unsigned			stop ;			// consumer has finished
+
+	pthread_mutex_t		lock ;
+	pthread_cond_t		filled ;
+	pthread_cond_t		emptied ;
+	pthread_t			thread ;
+	unsigned			thread_running ;
+
+	// time (in usecs) the consumer spent blocked waiting for data
+	uint64_t			wait_us ;
+};
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+uint64_t readahead_time_us(void) ;
+int readahead_fill(int file, uint8_t *buff, unsigned buff_size) ;
+
+struct TS_readahead *readahead_new(int file, unsigned num_buffs, unsigned buff_size, unsigned headroom) ;
+void readahead_free(struct TS_readahead **ra) ;
+
+int readahead_get(struct TS_readahead *ra, uint8_t **data, int *data_len) ;
+void readahead_release(struct TS_readahead *ra) ;
+
+#endif /* TS_READAHEAD_H_ */
@@ -12,7 +12,7 @@
 //========================================================================================================
 
 //---------------------------------------------------------------------------------------------------------
-void add_cut(struct list_head *cut_list, unsigned start, unsigned end)
+void add_cut(struct list_head *cut_list, uint64_t start, uint64_t end)
 {
 struct TS_cut   *cutitem;
 
@@ -36,7 +36,7 @@ printf("\n\n--- print_cut_list(%s, cut_list @ %p) ---\n", fn, cut_list) ;
 list_for_each_safe(item,safe,cut_list)
 {
 	cutitem = list_entry(item, struct TS_cut, next);
-	printf(" + item @ %p start=%u, end=%u magic=0x%08x {list @ %p => next %p, prev %p}\n",
+	printf(" + item @ %p start=%"PRIu64", end=%"PRIu64" magic=0x%08x {list @ %p => next %p, prev %p}\n",
 			cutitem,
 			cutitem->start, cutitem->end, cutitem->magic,
 			cutitem->next, cutitem->next.next, cutitem->next.prev) ;
@@ -84,3 +84,54 @@ char *p ;
 
 	if (*p == '.') *p = 0 ;
 }
+
+
+//---------------------------------------------------------------------------------------------------------
+// Add a packet to the list of blocks to be written (packets that follow on in memory are merged into one block)
+void cut_iov_add(struct iovec *iov, unsigned *num_iov, uint8_t *packet, unsigned packet_len)
+{
+	if (*num_iov && ((uint8_t *)iov[*num_iov-1].iov_base + iov[*num_iov-1].iov_len == packet))
+	{
+		iov[*num_iov-1].iov_len += packet_len ;
+	}
+	else
+	{
+		iov[*num_iov].iov_base = packet ;
+		iov[*num_iov].iov_len = packet_len ;
+		++*num_iov ;
+	}
+}
+
+//---------------------------------------------------------------------------------------------------------
+// Write out all of the blocks and empty the list
+void cut_iov_write(int fd, struct iovec *iov, unsigned *num_iov)
+{
+struct iovec *vp = iov ;
+unsigned num = *num_iov ;
+ssize_t rc ;
+
+	*num_iov = 0 ;
+	while (num)
+	{
+		rc = writev(fd, vp, (int)num) ;
+		if (rc < 0)
+		{
+			if (errno == EINTR)
+				continue ;
+			return ;
+		}
+
+		// skip over whatever has been written (normally everything)
+		while (num && ((size_t)rc >= vp->iov_len))
+		{
+			rc -= vp->iov_len ;
+			++vp ;
+			--num ;
+		}
+		if (num)
+		{
+			vp->iov_base = (uint8_t *)vp->iov_base + rc ;
+			vp->iov_len -= rc ;
+		}
+	}
+}
@@ -16,6 +16,7 @@
 #include <ctype.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <sys/uio.h>
 
 #include "list.h"
 
@@ -38,8 +39,8 @@
 // Linked list of cut regions
 struct TS_cut {
     struct list_head    next;
-	unsigned 			start ;
-	unsigned 			end ;
+	uint64_t 			start ;
+	uint64_t 			end ;
 	unsigned			magic ;
 };
 #define UNSET_CUT_LIST	(struct TS_cut *)-1
@@ -55,7 +56,7 @@ struct TS_cut_data {
 	int debug ;
 
 	int split_count ;
-	unsigned split_pkt ;
+	uint64_t split_pkt ;
 
 	char fname[256] ;
 	char ofname[256] ;
@@ -66,6 +67,7 @@ struct TS_cut_data {
 
     // current cut entry
     struct TS_cut		*current_cut ;
+    unsigned			prev_ok ;
 
     // pointer to the reader
     struct TS_reader *tsreader ;
@@ -73,10 +75,14 @@ struct TS_cut_data {
 
 
 //---------------------------------------------------------------------------------------------------------
-void add_cut(struct list_head *cut_list, unsigned start, unsigned end) ;
+void add_cut(struct list_head *cut_list, uint64_t start, uint64_t end) ;
 void _print_cut_list(char *fn, struct list_head *cut_list) ;
 void free_cut_list(struct list_head *cut_list) ;
 void remove_ext(char *src, char *dest) ;
 
+// batched writes
+void cut_iov_add(struct iovec *iov, unsigned *num_iov, uint8_t *packet, unsigned packet_len) ;
+void cut_iov_write(int fd, struct iovec *iov, unsigned *num_iov) ;
+
 
 #endif /* TS_SKIP_H_ */
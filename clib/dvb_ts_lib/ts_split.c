@@ -12,7 +12,7 @@
 
 //---------------------------------------------------------------------------------------------------------
 //
-static void next_split_file(struct TS_cut_data *hook_data, unsigned pktnum)
+static void next_split_file(struct TS_cut_data *hook_data, uint64_t pktnum)
 {
 	// close currently open
 	if (hook_data->cut_file)
@@ -34,7 +34,7 @@ static void next_split_file(struct TS_cut_data *hook_data, unsigned pktnum)
 		sprintf(cutname, "%s-%04u.ts",
 				hook_data->ofname, ++hook_data->split_count) ;
 
-		if (hook_data->debug) printf("New split file %s at pkt %d\n", cutname, pktnum) ;
+		if (hook_data->debug) printf("New split file %s at pkt %"PRIu64"\n", cutname, pktnum) ;
 
 
 		hook_data->cut_file = open(cutname, O_CREAT | O_TRUNC | O_WRONLY | O_LARGEFILE, 0666);
@@ -45,22 +45,10 @@ static void next_split_file(struct TS_cut_data *hook_data, unsigned pktnum)
 }
 
 //---------------------------------------------------------------------------------------------------------
-// void (*tsparse_ts_hook)(unsigned long, unsigned, const uint8_t *, unsigned, unsigned, unsigned) ;
-static void ts_split_hook(struct TS_pidinfo *pidinfo, uint8_t *packet, unsigned packet_len, void *user_data)
+// Step through the cut list, starting a new file where required. Any packets waiting to be written are
+// flushed to the current file before it's changed
+static void split_pkt(struct TS_cut_data *hook_data, uint64_t pktnum, struct iovec *iov, unsigned *num_iov)
 {
-struct TS_cut_data *hook_data = (struct TS_cut_data *)user_data ;
-//static unsigned prev_ok=1;
-//unsigned ok = 1 ;
-
-	if (hook_data->debug >= 10)
-	{
-		printf("-> TS PID 0x%x (%u) [%u] :: start=%d err=%d\n",
-				pidinfo->pid, pidinfo->pid,
-				pidinfo->pktnum,
-				pidinfo->pes_start ? 1 : 0,
-				pidinfo->pid_error ? 1 : 0) ;
-	}
-
 	// check cut
 	if (hook_data->current_cut == UNSET_CUT_LIST)
 	{
@@ -69,8 +57,6 @@ struct TS_cut_data *hook_data = (struct TS_cut_data *)user_data ;
 		list_for_each(item, hook_data->cut_list)
 		{
 			hook_data->current_cut = list_entry(item, struct TS_cut, next);
-//			next_split_file(hook_data) ;
-//			if (hook_data->debug) printf("New split file %04d at pkt %d\n", hook_data->split_count, pidinfo->pktnum) ;
 			break;
 		}
 	}
@@ -78,7 +64,7 @@ struct TS_cut_data *hook_data = (struct TS_cut_data *)user_data ;
 	if (hook_data->current_cut != END_CUT_LIST)
 	{
 		// check current
-		if (pidinfo->pktnum < hook_data->current_cut->start)
+		if (pktnum < hook_data->current_cut->start)
 		{
 			// still before start of next band
 		}
@@ -87,22 +73,16 @@ struct TS_cut_data *hook_data = (struct TS_cut_data *)user_data ;
 			// Now >= start
 
 			// New file at start of region
-			if ( pidinfo->pktnum == hook_data->current_cut->start )
+			if ( pktnum == hook_data->current_cut->start )
 			{
 				// save next band into new file
-				next_split_file(hook_data, pidinfo->pktnum) ;
+				cut_iov_write(hook_data->cut_file, iov, num_iov) ;
+				next_split_file(hook_data, pktnum) ;
 			}
 
 			// writing : start -> end
-			else if (pidinfo->pktnum < hook_data->current_cut->end)
-			{
-			}
-
-			// writing : end
-			else if (pidinfo->pktnum == hook_data->current_cut->end)
+			else if (pktnum <= hook_data->current_cut->end)
 			{
-//				// save next band into new file
-//				next_split_file(hook_data, pidinfo->pktnum) ;
 			}
 
 			// beyond end
@@ -118,74 +98,136 @@ struct TS_cut_data *hook_data = (struct TS_cut_data *)user_data ;
 						hook_data->current_cut = list_entry(item, struct TS_cut, next);
 						break;
 					}
-				} while ( (hook_data->current_cut != END_CUT_LIST) && (pidinfo->pktnum > hook_data->current_cut->start) ) ;
-
-//				prev_ok=1;
+				} while ( (hook_data->current_cut != END_CUT_LIST) && (pktnum > hook_data->current_cut->start) ) ;
 
-//				// save next band into new file
-				next_split_file(hook_data, pidinfo->pktnum) ;
-//				if (hook_data->debug) printf("New split file %04d at pkt %d\n", hook_data->split_count, pidinfo->pktnum) ;
+				// save next band into new file
+				cut_iov_write(hook_data->cut_file, iov, num_iov) ;
+				next_split_file(hook_data, pktnum) ;
 			}
 		}
 	}
+}
+
+//---------------------------------------------------------------------------------------------------------
+// void (*tsparse_batch_hook)(struct TS_pkt_desc *, unsigned, void *) ;
+static void ts_split_hook(struct TS_pkt_desc *pkts, unsigned num_pkts, void *user_data)
+{
+struct TS_cut_data *hook_data = (struct TS_cut_data *)user_data ;
+struct iovec iov[TS_BATCH_MAX] ;
+unsigned num_iov = 0 ;
+unsigned i ;
 
-	if (hook_data->debug >= 10)
+	for (i=0; i < num_pkts; ++i)
 	{
-		printf("-> TS PID 0x%x (%u) [%u]\n",
-				pidinfo->pid, pidinfo->pid,
-				pidinfo->pktnum) ;
+		if (hook_data->debug >= 10)
+		{
+			printf("-> TS PID 0x%x (%u) [%"PRIu64"] :: start=%d err=%d\n",
+					pkts[i].pid, pkts[i].pid,
+					pkts[i].pktnum,
+					pkts[i].flags & TS_PKT_FLAG_START ? 1 : 0,
+					pkts[i].flags & TS_PKT_FLAG_ERROR ? 1 : 0) ;
+		}
+
+		split_pkt(hook_data, pkts[i].pktnum, iov, &num_iov) ;
+
+		if (hook_data->debug >= 10)
+		{
+			printf("-> TS PID 0x%x (%u) [%"PRIu64"]\n",
+					pkts[i].pid, pkts[i].pid,
+					pkts[i].pktnum) ;
+		}
+
+		// write if allowed to
+		if (hook_data->cut_file)
+		{
+			cut_iov_add(iov, &num_iov, pkts[i].packet - hook_data->tsreader->packet_prefix, hook_data->tsreader->packet_size) ;
+		}
 	}
 
-	// write if allowed to
+	// write out the rest of the batch in one go
 	if (hook_data->cut_file)
 	{
-		write(hook_data->cut_file, packet, packet_len);
+		cut_iov_write(hook_data->cut_file, iov, &num_iov) ;
 	}
 }
 
 
 
 //---------------------------------------------------------------------------------------------------------
-int ts_split(char *filename, char *ofilename, struct list_head *cuts_array, unsigned debug)
+// tsfanout_end_hook
+static int ts_split_end(struct TS_reader *tsreader, void *user_data)
+{
+struct TS_cut_data *hook_data = (struct TS_cut_data *)user_data ;
+
+	if (hook_data->cut_file)
+		close(hook_data->cut_file) ;
+
+	free_cut_list(hook_data->cut_list) ;
+	free(hook_data) ;
+
+	return 0 ;
+}
+
+//---------------------------------------------------------------------------------------------------------
+// Add splitting the file to a single pass of the file. The cut list is freed once done
+int ts_split_fanout(struct TS_fanout *fanout, char *ofilename, struct list_head *cuts_array, unsigned debug)
 {
-int file;
-struct TS_cut_data hook_data ;
+struct TS_cut_data *hook_data ;
 struct TS_reader *tsreader ;
 
-	hook_data.cut_list = cuts_array ;
+	hook_data = (struct TS_cut_data *)malloc(sizeof(struct TS_cut_data)) ;
+	if (!hook_data)
+	{
+		RETURN_DVB_ERROR(ERR_MALLOC);
+	}
+	CLEAR_MEM(hook_data) ;
 
-	hook_data.current_cut = UNSET_CUT_LIST ;
-	hook_data.debug = debug ;
-	hook_data.ofile = 0 ;
-	hook_data.split_count = 0 ;
-	hook_data.cut_file = 0 ;
-    hook_data.ofile = 0 ;
+	hook_data->cut_list = cuts_array ;
 
-	tsreader = tsreader_new(filename) ;
+	hook_data->current_cut = UNSET_CUT_LIST ;
+	hook_data->debug = debug ;
+	hook_data->ofile = 0 ;
+	hook_data->split_count = 0 ;
+	hook_data->cut_file = 0 ;
+
+	tsreader = tsfanout_add(fanout, ts_split_end, hook_data) ;
     if (!tsreader)
     {
+    	free(hook_data) ;
     	return(dvb_error_code);
     }
-	tsreader->ts_hook = ts_split_hook ;
-	tsreader->user_data = &hook_data ;
+	tsreader->batch_hook = ts_split_hook ;
+	hook_data->tsreader = tsreader ;
 	tsreader->debug = debug ;
 
-	remove_ext(filename, hook_data.fname) ;
-	remove_ext(ofilename, hook_data.ofname) ;
+	remove_ext(fanout->filename, hook_data->fname) ;
+	remove_ext(ofilename, hook_data->ofname) ;
 
 	// start first file
-	next_split_file(&hook_data, 0) ;
+	next_split_file(hook_data, 0) ;
 
-	// parse data
-    ts_parse(tsreader) ;
+	return 0 ;
+}
 
-    if (hook_data.cut_file)
-    	close(hook_data.cut_file) ;
+//---------------------------------------------------------------------------------------------------------
+int ts_split(char *filename, char *ofilename, struct list_head *cuts_array, unsigned debug)
+{
+struct TS_fanout *fanout ;
+int status ;
 
-	tsreader_free(tsreader) ;
-	free_cut_list(hook_data.cut_list) ;
+	fanout = tsfanout_new(filename) ;
+    if (!fanout)
+    {
+    	return(dvb_error_code);
+    }
+
+	// parse data
+	status = ts_split_fanout(fanout, ofilename, cuts_array, debug) ;
+	if (!status)
+		status = tsfanout_run(fanout) ;
+	tsfanout_free(fanout) ;
 
-	return(dvb_error_code) ;
+	return(status) ;
 }
 
 
@@ -9,9 +9,11 @@
 #define TS_SPLIT_H_
 
 #include "ts_skip.h"
+#include "ts_fanout.h"
 
 //---------------------------------------------------------------------------------------------------------
 int ts_split(char *filename, char *ofilename, struct list_head *cuts_array, unsigned debug);
+int ts_split_fanout(struct TS_fanout *fanout, char *ofilename, struct list_head *cuts_array, unsigned debug);
 
 
 #endif /* TS_SPLIT_H_ */
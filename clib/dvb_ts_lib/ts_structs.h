@@ -25,6 +25,7 @@
 
 // SI tables
 #include "tables/si_structs.h"
+#include "ts_arena.h"
 
 /*=============================================================================================*/
 // CONSTANTS
@@ -34,9 +35,22 @@
 #define MAX_PID			NULL_PID
 #define ALL_PID			(MAX_PID+1)
 
+// Bitmap with one bit per pid
+#define PID_BITMAP_WORDS			(ALL_PID / 32)
+#define PID_BITMAP_SET(map, pid)	((map)[(pid) >> 5] |= (1U << ((pid) & 31)))
+#define PID_BITMAP_CLR(map, pid)	((map)[(pid) >> 5] &= ~(1U << ((pid) & 31)))
+#define PID_BITMAP_TEST(map, pid)	(((map)[(pid) >> 5] >> ((pid) & 31)) & 1)
+
 // ISO 13818-1
 #define SYNC_BYTE			0x47
 #define TS_PACKET_LEN		188
+
+// Other packet sizes found in files: M2TS/BDAV (4 byte arrival timestamp in front of each packet) and packets
+// followed by 16 bytes of Reed-Solomon parity
+#define TS_M2TS_PACKET_LEN	192
+#define TS_M2TS_HEADER_LEN	4
+#define TS_RS_PACKET_LEN	204
+#define TS_MAX_PACKET_LEN	TS_RS_PACKET_LEN
 //#define MAX_SECTION_LEN 	1021
 #define TS_FREQ				90000
 
@@ -47,6 +61,13 @@
 // Read in 1-2 packets less than the full buffer size to allow for "unused" spare bytes
 #define TS_BUFFSIZE_READ		(TS_BUFFSIZE - (2 * TS_PACKET_LEN))
 
+// Default amount of file mapped at any one time when using memory mapped access
+#define TS_MMAP_WINDOW			(64 * 1024 * 1024)
+
+// Default number/size of buffers used by the background read-ahead (size must be a multiple of the packet length)
+#define TS_READAHEAD_BUFFS		4
+#define TS_READAHEAD_SIZE		(8192 * TS_PACKET_LEN)
+
 
 // clear memory
 #define CLEAR_MEM(mem)	memset(mem, 0, sizeof(*mem))
@@ -57,16 +78,49 @@
 #define FPS					25
 #define VIDEO_PTS_DELTA		(TS_FREQ / FPS)
 
+// Check for PTS/DTS wrap
+#define MAX_TS_DIFF			(60 * TS_FREQ)
+#define TS_WRAP				(1LL << 33)
+
+// Per-pid statistics bitrate window (90kHz PCR units). Gaps of more than TS_STATS_MAX_WINDOW (e.g. a PCR
+// discontinuity) restart the window without updating the bitrate
+#define TS_STATS_WINDOW			TS_FREQ
+#define TS_STATS_MAX_WINDOW		(10 * TS_STATS_WINDOW)
+
 
 /*=============================================================================================*/
 // MACROS
 /*=============================================================================================*/
 
-// print debug if debug setting is high enough
+// M2TS arrival timestamp (27MHz, 30 bits) from the 4 byte header in front of a packet
+#define TS_M2TS_ARRIVAL_TS(p)	( (((uint32_t)(p)[0] & 0x3f) << 24) | ((uint32_t)(p)[1] << 16) | ((uint32_t)(p)[2] << 8) | (p)[3] )
+
+// print debug if debug setting is high enough (compiled out in a production build)
+#ifdef TS_PRODUCTION
+#define tsparse_dbg_on(LVL)			0
+#define tsparse_dbg_prt(LVL, ARGS)
+#else
+#define tsparse_dbg_on(LVL)			(tsreader->debug >= (LVL))
 #define tsparse_dbg_prt(LVL, ARGS)	\
-		if (tsreader->debug >= LVL)	{ printf ARGS ; fflush(stdout) ; }
+		if (tsparse_dbg_on(LVL))	{ printf ARGS ; fflush(stdout) ; }
+#endif
 
+// Set the error code on the reader as well as the (per thread) dvb_error_code
+#define SET_TSREADER_ERROR(tsreader, err)	\
+{ \
+	SET_DVB_ERROR(err) ; \
+	(tsreader)->error_code = dvb_error_code ; \
+	(tsreader)->error_errno = dvb_errno ; \
+}
+
+// set reader error code then return value
+#define RETURN_TSREADER_ERROR(tsreader, err)	\
+SET_TSREADER_ERROR(tsreader, err); \
+return ((tsreader)->error_code) ;
+
+#ifndef TS_PRODUCTION
 #define DO_CHECK_MAGIC
+#endif
 
 #ifdef DO_CHECK_MAGIC
 #define CHECK_TS_MAGIC(b, magic, type)	\
@@ -164,6 +218,13 @@ enum TS_progress_state {
 	PROGRESS_STOPPED
 };
 
+// PID filter modes
+enum TS_pid_filter_mode {
+	PID_FILTER_OFF,			// all pids passed to the pid_hook (if set)
+	PID_FILTER_ON,			// only pids set in the filter are processed (pid_hook not called)
+	PID_FILTER_LEARN		// pid_hook called on the first packet of each pid; the result is cached in the filter
+};
+
 
 
 //----------------------------------------------------------------------------------------------
@@ -171,6 +232,7 @@ enum TS_progress_state {
 
 struct TS_state ;
 struct TS_buffer ;
+struct TS_buffer_pool ;
 struct TS_pidinfo ;
 struct TS_pesinfo ;
 struct TS_frame_info ;
@@ -181,11 +243,45 @@ typedef void (*tsparse_payload_hook)(struct TS_pidinfo *, uint8_t *, unsigned, v
 typedef void (*tsparse_ts_hook)(struct TS_pidinfo *, uint8_t *, unsigned, void *) ;
 typedef void (*tsparse_pes_hook)(struct TS_pidinfo *, struct TS_pesinfo *, uint8_t *, unsigned, void *) ;
 typedef void (*tsparse_pes_data_hook)(struct TS_pidinfo *, struct TS_pesinfo *, uint8_t *, unsigned, void *) ;
-typedef void (*tsparse_progress_hook)(enum TS_progress_state state, unsigned progress, unsigned total, void *) ;
+typedef void (*tsparse_progress_hook)(enum TS_progress_state state, uint64_t progress, uint64_t total, void *) ;
 typedef void (*tsparse_mpeg2_hook)(struct TS_pidinfo *, struct TS_frame_info *, const mpeg2_info_t *, void *) ;
 typedef void (*tsparse_mpeg2_rgb_hook)(struct TS_pidinfo *, struct TS_frame_info *, const mpeg2_info_t *, void *) ;
 typedef void (*tsparse_audio_hook)(struct TS_pidinfo *, struct TS_pesinfo *, const mpeg2_audio_t *, void *) ;
 
+// PCR base (90kHz, 33 bits) and extension (27MHz, 0..299)
+typedef void (*tsparse_pcr_hook)(struct TS_pidinfo *, int64_t, unsigned, void *) ;
+
+// Batched packets
+#define TS_BATCH_MAX			1024		// maximum number of packets passed to the batch hook in one call
+
+#define TS_PKT_FLAG_START		0x01		// payload_unit_start_indicator set
+#define TS_PKT_FLAG_ERROR		0x02		// transport error indicator set, or bad sync byte
+
+struct TS_pkt_desc {
+	uint8_t			*packet ;
+	unsigned		pid ;
+	uint64_t		pktnum ;
+	unsigned		flags ;
+	uint32_t		arrival_ts ;		// as TS_pidinfo
+};
+
+typedef void (*tsparse_batch_hook)(struct TS_pkt_desc *, unsigned, void *) ;
+
+// Packet loop used by ts_parse()/tsreader_data_add() - chosen from debug and the hooks that are set, at
+// tsreader_data_start() and again for each block of data. Set them before starting: a change made part way through a
+// block (including by tsreader_pid_filter_mode()) only takes effect from the next block
+enum TS_parse_loop {
+	TS_LOOP_GENERIC,		// any hooks, or debug
+	TS_LOOP_TS,				// ts_hook/batch_hook are the only per-packet hooks (no pid filter/pid_hook/error_hook/payload_hook/pcr_hook)
+	TS_LOOP_UNITS,			// no per-packet hooks - just the PES/PSI handling (e.g. SI only, PES + mpeg2, timing)
+};
+
+// Pull iterators (tsreader_next_*)
+#define TS_ITER_BUFFSIZE		(1024 * TS_PACKET_LEN)	// file data is read into a buffer of this size
+
+#define TS_ITER_PES				0x01
+#define TS_ITER_SECTIONS		0x02
+
 
 //----------------------------------------------------------------------------------------------
 // Generic buffer
@@ -196,10 +292,39 @@ struct TS_buffer {
 	unsigned	buff_size ;
 	unsigned	data_len ;
 	uint8_t *	buff ;
+
+	// pool the buffer memory comes from (NULL = plain malloc)
+	struct TS_buffer_pool *pool ;
 };
 
 #define CHECK_TS_BUFF(b)	CHECK_TS_MAGIC(b, MAGIC_BUFF, "TS_buffer")
 
+//----------------------------------------------------------------------------------------------
+// Pool of buffer memory in power of 2 size classes (TS_POOL_MIN_SIZE << class). Released blocks are kept on a
+// free list per class for reuse; requests larger than the biggest class are malloc'd directly.
+// Memory allocated from the system can be capped with mem_limit: when a miss would go over the limit the free lists
+// are released first, and if that isn't enough the request fails.
+
+#define TS_POOL_MIN_SIZE		(4*1024)
+#define TS_POOL_CLASSES			16
+
+struct TS_buffer_pool_stats {
+	// bytes
+	uint64_t	mem_in_use ;		// currently attached to buffers
+	uint64_t	mem_peak ;			// peak of mem_in_use
+	uint64_t	mem_allocated ;		// currently allocated from the system (in use + free lists)
+	uint64_t	mem_total ;			// total ever allocated from the system
+	unsigned	num_mallocs ;
+	unsigned	num_fails ;			// requests refused because of mem_limit
+};
+
+struct TS_buffer_pool {
+	uint8_t		*free_list[TS_POOL_CLASSES] ;
+	uint64_t	mem_limit ;			// max bytes allocated from the system (0 = no limit)
+
+	struct TS_buffer_pool_stats	stats ;
+};
+
 //----------------------------------------------------------------------------------------------
 // PID information
 
@@ -210,7 +335,10 @@ struct TS_pidinfo {
 	unsigned afc ;
 	unsigned pid_error ;
 
-	unsigned pktnum ;
+	uint64_t pktnum ;
+
+	// arrival timestamp of the packet (M2TS files only, otherwise 0)
+	uint32_t arrival_ts ;
 };
 
 //----------------------------------------------------------------------------------------------
@@ -224,8 +352,9 @@ enum TS_pes_psi {
 struct TS_pesinfo {
 	unsigned code ;
 
-	unsigned start_pkt ;
-	unsigned end_pkt ;
+	uint64_t start_pkt ;
+	uint64_t end_pkt ;
+	uint64_t start_pos ;		// byte offset in the file of the packet that starts the PES
 
 	int64_t start_dts ;
 	int64_t start_pts ;
@@ -246,12 +375,38 @@ struct TS_pesinfo {
 };
 
 
+//----------------------------------------------------------------------------------------------
+// Views returned by the tsreader_next_*() iterators. The data pointers are borrowed from the reader and are
+// only valid until the next call on that reader
+
+struct TS_packet_view {
+	struct TS_pidinfo	pidinfo ;
+	uint8_t				*packet ;			// complete TS packet
+	uint8_t				*payload ;
+	unsigned			payload_len ;
+};
+
+struct TS_pes_view {
+	struct TS_pidinfo	pidinfo ;
+	struct TS_pesinfo	pesinfo ;			// pesdata_p/pesdata_len point at just the PES data
+	uint8_t				*pes ;				// complete PES packet (header + data)
+	unsigned			pes_len ;
+};
+
+struct TS_section_view {
+	struct TS_pidinfo	pidinfo ;
+	unsigned			table_id ;
+	uint8_t				*section ;			// from table_id to the end of the section (including any CRC)
+	unsigned			section_len ;
+};
+
+
 //----------------------------------------------------------------------------------------------
 // Information relating to the current video frame
 
 struct TS_frame_info {
 	unsigned framenum ;
-	unsigned gop_pkt ;
+	uint64_t gop_pkt ;
 
 	// copy of PES info for this frame
 	struct TS_pesinfo pesinfo ;
@@ -305,6 +460,61 @@ struct TS_pkt {
 };
 #endif
 
+//----------------------------------------------------------------------------------------------
+// Transport statistics for a pid. Kept for every packet read (including adaptation field only packets, and pids
+// dropped by the pid filter), whatever hooks are set. See tsreader_pid_stats()
+
+// next_cc value before the first packet has been seen
+#define TS_STATS_CC_UNSET		0x10
+
+struct TS_pid_stats {
+	uint64_t	pkts ;
+	uint64_t	payload_bytes ;		// excludes the TS header and any adaptation field
+	unsigned	cc_errors ;			// continuity counter errors (i.e. missing packets)
+	unsigned	tei ;				// packets with transport_error_indicator set
+	unsigned	scrambled ;			// packets with transport_scrambling_control set
+	unsigned	pcrs ;				// packets carrying a PCR
+	unsigned	bitrate ;			// bits/s over the last complete TS_STATS_WINDOW (0 until one has been seen)
+
+	// internal
+	uint8_t		next_cc ;
+	uint64_t	window_pkts ;		// value of pkts at the start of the current window
+};
+
+//----------------------------------------------------------------------------------------------
+// Cache of the last CRC checked copy of each long form SI section, keyed by pid/table_id/table_id_extension/
+// section_number. A section received again with the same version and bytes skips its CRC check, and is only decoded
+// if the table's handler was registered to see every occurrence (see Section_decode_flags). Only the tables with a
+// registered handler are cached, so a reader with none holds no section data
+
+#define TS_SECTION_CACHE_BUCKETS	1024				// hash table size (power of 2)
+#define TS_SECTION_CACHE_BYTES		(1024*1024)			// default for TS_reader.section_cache_bytes
+
+struct TS_section_entry {
+	struct TS_section_entry	*next ;			// hash chain
+	unsigned		pid ;
+	unsigned		table_id ;
+	unsigned		table_id_extension ;
+	unsigned		section_number ;
+	unsigned		version_number ;
+	unsigned		current_next_indicator ;
+
+	// whole section (table_id to CRC)
+	uint8_t			*data ;
+	unsigned		data_len ;
+};
+
+struct TS_section_cache {
+	struct TS_section_entry	*buckets[TS_SECTION_CACHE_BUCKETS] ;
+	unsigned		num_entries ;
+	uint64_t		data_bytes ;
+
+	// stats
+	uint64_t		checked ;			// sections CRC checked
+	uint64_t		repeats ;			// sections found unchanged (not CRC checked)
+	uint64_t		skipped ;			// repeats not decoded (handler only wants changes)
+};
+
 //----------------------------------------------------------------------------------------------
 // Current parse state
 #define MAGIC_STATE		0x53445002
@@ -313,11 +523,34 @@ struct TS_state {
 	struct TS_pidinfo 	pidinfo ;
 	struct TS_pid		*pid_item ;
 
-	// list of TS_pid
+	// list of TS_pid (in order of creation)
     struct list_head    pid_list;
 
+    // direct lookup of TS_pid by pid (NULL until first packet seen on that pid)
+    struct TS_pid		*pid_table[ALL_PID] ;
+
+    // memory for PES/PSI reassembly buffers
+    struct TS_buffer_pool	buff_pool ;
+
+    // pids that may carry an SI table with a registered section handler (i.e. PSI that needs reassembling)
+    uint32_t			psi_pids[PID_BITMAP_WORDS] ;
+
+    // SI sections already seen
+    struct TS_section_cache	section_cache ;
+
+    // memory for the decoded SI tables (reset after each section's handler call)
+    struct TS_arena		si_arena ;
+
     // Set to total number of packets
-    unsigned			total_pkts ;
+    uint64_t			total_pkts ;
+
+    // per-pid statistics (NULL until first packet seen on that pid), and the list of pids that have any. Bitrates
+    // are timed by the PCR on the first pid seen carrying one (ALL_PID until then)
+    struct TS_pid_stats	*pid_stats[ALL_PID] ;
+    uint16_t			stats_pids[ALL_PID] ;
+    unsigned			num_stats_pids ;
+    unsigned			stats_pcr_pid ;
+    int64_t				stats_window_start ;
 
     // set to min/max pts/dts times
 	int64_t 			start_ts ;
@@ -347,7 +580,12 @@ struct TS_buff_state {
 	unsigned get_sync ;
 	int running ;
 
-	unsigned pktnum ;
+	uint64_t pktnum ;
+
+	// byte offset of the data in the file, and the bytes skipped to re-sync (so the next packet starts at
+	// start_pos + skipped + pktnum * packet_size)
+	uint64_t start_pos ;
+	uint64_t skipped ;
 };
 
 
@@ -359,10 +597,26 @@ typedef struct TS_reader {
 	// set by user
 	int						file ;
 	unsigned 				debug ;
-	unsigned				num_pkts ;
+	uint64_t				num_pkts ;
 	int64_t					skip ;
 	int						origin ;
+	uint64_t				end_pos ;			// stop at the first packet that starts at or after this byte offset in the
+												// file (0 = no limit)
 	void 					*user_data ;
+	unsigned				use_mmap ;			// set to use memory mapped file access (regular files only)
+	unsigned				mmap_window ;		// size of mapped window (0 = use default)
+	unsigned				use_readahead ;		// set to read the file in a background thread
+	unsigned				readahead_buffs ;	// number of read-ahead buffers (0 = use default)
+	unsigned				readahead_size ;	// size of each read-ahead buffer (0 = use default)
+	unsigned				packet_size ;		// bytes per packet in the data: TS_PACKET_LEN, TS_M2TS_PACKET_LEN or
+												// TS_RS_PACKET_LEN (probed from the file by tsreader_new())
+	unsigned				follow ;			// set to keep reading a file that's still being written (uses read(), not
+												// mmap/readahead) until follow_done exists or follow_timeout expires
+	const char				*follow_done ;		// "writer finished" sentinel file (NULL = not used)
+	unsigned				follow_timeout ;	// msecs without new data before stopping (0 = wait until follow_done)
+	unsigned				section_cache_bytes ;	// no new SI sections are cached once this much data is held (0 = no
+												// cache, so every section is CRC checked). Set to TS_SECTION_CACHE_BYTES
+												// by tsreader_new()
 
 	tsparse_pid_hook		pid_hook ;
 	tsparse_error_hook		error_hook ;
@@ -374,26 +628,82 @@ typedef struct TS_reader {
 	tsparse_mpeg2_rgb_hook	mpeg2_rgb_hook ;
 	tsparse_audio_hook		audio_hook ;
 	tsparse_progress_hook	progress_hook ;
+	tsparse_batch_hook		batch_hook ;		// same packets as ts_hook, but passed in batches of up to TS_BATCH_MAX
+	tsparse_pcr_hook		pcr_hook ;			// any packet carrying a PCR (including adaptation field only packets)
 
 	// internally set
 	struct TS_state			*tsstate ;
 	struct TS_buff_state	buff_state ;
 	unsigned				MAGIC ;
 
+	// last error on this reader
+	enum DVB_error			error_code ;
+	int						error_errno ;
+
+	// packet loop for the current hooks
+	enum TS_parse_loop		parse_loop ;
+
+	// bytes in front of each TS packet (i.e. the M2TS header) - set from packet_size
+	unsigned				packet_prefix ;
+
+	// pid filter - use tsreader_pid_filter_*() to change
+	enum TS_pid_filter_mode	pid_filter_mode ;
+	uint32_t				pid_filter[PID_BITMAP_WORDS] ;
+	uint32_t				pid_filter_known[PID_BITMAP_WORDS] ;
+
+	// packets waiting to be passed to the batch_hook (pointers into the current input buffer)
+	struct TS_pkt_desc		batch[TS_BATCH_MAX] ;
+	unsigned				batch_len ;
+
+	// pull iterator state
+	struct {
+		uint8_t					*buff ;			// TS_ITER_BUFFSIZE bytes of file data
+		unsigned				started ;
+		unsigned				eof ;
+		unsigned				ended ;
+		unsigned				want ;			// TS_ITER_PES / TS_ITER_SECTIONS
+
+		// last complete PES/PSI - taken from the pid so that it isn't overwritten before the next call
+		struct TS_buffer		*unit_buff ;
+		struct TS_buffer		*spare_buff ;
+		struct TS_pidinfo		pidinfo ;
+		struct TS_pesinfo		pesinfo ;
+
+		// sections still to be returned from a PSI unit
+		uint8_t					*sect_ptr ;
+		int						sect_left ;
+	}						iter ;
+
 	struct {
-		unsigned				step ;
-		unsigned				scale ;
-		unsigned				next_progress ;
-		unsigned				total ;
+		uint64_t				step ;
+		uint64_t				next_progress ;
 	}						progress_info ;
 
+	// Read-ahead timing (usecs)
+	struct {
+		uint64_t				io_wait_us ;
+		uint64_t				parse_us ;
+		uint64_t				bytes_read ;
+		unsigned				buffs_read ;
+	}						io_stats ;
+
+	// Follow mode: waits at the end of the file, and the delay (usecs) from the latest write to the file to that
+	// data having been passed to the hooks - one sample per read once the reader has caught up with the writer
+	struct {
+		uint64_t				waits ;
+		uint64_t				latency_samples ;
+		uint64_t				latency_total_us ;
+		uint64_t				latency_max_us ;
+	}						follow_stats ;
+
 	// Optional libmpeg2
 	struct {
 		mpeg2dec_t 				*decoder;
 		const mpeg2_info_t 		*info;
 		unsigned				start_framenum;
 		unsigned				framenum;
-		unsigned				gop_pktnum;
+		uint64_t				gop_pktnum;
+		int						total_offset ;		// total PES data passed to the decoder (for debug)
 		uint8_t 				*video_buffer ;
 		unsigned				convert_rgb ;
 
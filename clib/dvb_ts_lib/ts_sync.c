@@ -0,0 +1,220 @@
+/*
+ * ts_sync.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * Transport stream sync byte search. On x86 the search uses SSE2/AVX2 (selected at run time) to test
+ * 16/32 candidate positions at a time, ANDing together the compare results at each packet stride so
+ * that a position is only accepted once the following packets also line up.
+ */
+
+// VERSION = 1.00
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "ts_structs.h"
+#include "ts_sync.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TS_SYNC_X86
+#include <immintrin.h>
+#endif
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+// Check for sync bytes at packet stride starting at offset. Only checks as far as the buffer allows.
+static inline int sync_confirmed(const uint8_t *buff, unsigned buff_len, unsigned offset, unsigned confirm, unsigned stride)
+{
+unsigned pkt ;
+
+	for (pkt=0; (pkt < confirm) && (offset < buff_len); ++pkt, offset += stride)
+	{
+		if (buff[offset] != SYNC_BYTE)
+			return 0 ;
+	}
+	return 1 ;
+}
+
+/* ----------------------------------------------------------------------- */
+static unsigned sync_find_scalar(const uint8_t *buff, unsigned buff_len, unsigned start, unsigned max_offset, unsigned confirm,
+		unsigned stride)
+{
+unsigned offset ;
+
+	for (offset=start; offset < max_offset; ++offset)
+	{
+		if ((buff[offset] == SYNC_BYTE) && sync_confirmed(buff, buff_len, offset, confirm, stride))
+			return offset ;
+	}
+	return buff_len ;
+}
+
+#ifdef TS_SYNC_X86
+
+/* ----------------------------------------------------------------------- */
+__attribute__((target("sse2")))
+static unsigned sync_find_sse2(const uint8_t *buff, unsigned buff_len, unsigned max_offset, unsigned confirm, unsigned stride)
+{
+const __m128i sync = _mm_set1_epi8((char)SYNC_BYTE) ;
+unsigned span = (confirm-1) * stride + 16 ;
+unsigned offset ;
+unsigned pkt ;
+unsigned mask ;
+
+	// whole vector (plus all of the confirming packets) must be in the buffer
+	for (offset=0; (offset < max_offset) && (offset + span <= buff_len); offset += 16)
+	{
+		mask = 0xffff ;
+		for (pkt=0; (pkt < confirm) && mask; ++pkt)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i *)&buff[offset + pkt*stride]) ;
+			mask &= (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, sync)) ;
+		}
+		if (mask)
+		{
+			offset += (unsigned)__builtin_ctz(mask) ;
+			return offset < max_offset ? offset : buff_len ;
+		}
+	}
+
+	return sync_find_scalar(buff, buff_len, offset, max_offset, confirm, stride) ;
+}
+
+/* ----------------------------------------------------------------------- */
+__attribute__((target("avx2")))
+static unsigned sync_find_avx2(const uint8_t *buff, unsigned buff_len, unsigned max_offset, unsigned confirm, unsigned stride)
+{
+const __m256i sync = _mm256_set1_epi8((char)SYNC_BYTE) ;
+unsigned span = (confirm-1) * stride + 32 ;
+unsigned offset ;
+unsigned pkt ;
+unsigned mask ;
+
+	for (offset=0; (offset < max_offset) && (offset + span <= buff_len); offset += 32)
+	{
+		mask = 0xffffffff ;
+		for (pkt=0; (pkt < confirm) && mask; ++pkt)
+		{
+			__m256i v = _mm256_loadu_si256((const __m256i *)&buff[offset + pkt*stride]) ;
+			mask &= (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, sync)) ;
+		}
+		if (mask)
+		{
+			offset += (unsigned)__builtin_ctz(mask) ;
+			return offset < max_offset ? offset : buff_len ;
+		}
+	}
+
+	return sync_find_scalar(buff, buff_len, offset, max_offset, confirm, stride) ;
+}
+
+/* ----------------------------------------------------------------------- */
+__attribute__((target("avx2")))
+static unsigned sync_check_avx2(const uint8_t *buff, unsigned num_pkts, unsigned stride)
+{
+const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int)stride)) ;
+const __m256i sync = _mm256_set1_epi32(SYNC_BYTE) ;
+const __m256i byte_mask = _mm256_set1_epi32(0xff) ;
+unsigned pkt ;
+unsigned mask ;
+
+	// gather the first 4 bytes of 8 packets at a time and compare the sync bytes
+	for (pkt=0; pkt + 8 <= num_pkts; pkt += 8)
+	{
+		__m256i v = _mm256_i32gather_epi32((const int *)&buff[pkt*stride], offsets, 1) ;
+		v = _mm256_cmpeq_epi32(_mm256_and_si256(v, byte_mask), sync) ;
+		mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(v)) ;
+		if (mask != 0xff)
+			return pkt + (unsigned)__builtin_ctz(~mask) ;
+	}
+
+	for (; pkt < num_pkts; ++pkt)
+	{
+		if (buff[pkt*stride] != SYNC_BYTE)
+			break ;
+	}
+	return pkt ;
+}
+
+#endif
+
+/* ----------------------------------------------------------------------- */
+// Search the first max_offset bytes of the buffer for the start of a packet. A position is accepted if it
+// contains the sync byte, and so do the next (confirm-1) packets at 'stride' bytes apart (or as many of them as
+// are in the buffer). Returns the offset, or buff_len if not found.
+unsigned ts_sync_find(const uint8_t *buff, unsigned buff_len, unsigned max_offset, unsigned confirm, unsigned stride)
+{
+	if (max_offset > buff_len)
+		max_offset = buff_len ;
+	if (!confirm)
+		confirm = 1 ;
+
+#ifdef TS_SYNC_X86
+	if (__builtin_cpu_supports("avx2"))
+		return sync_find_avx2(buff, buff_len, max_offset, confirm, stride) ;
+	if (__builtin_cpu_supports("sse2"))
+		return sync_find_sse2(buff, buff_len, max_offset, confirm, stride) ;
+#endif
+
+	return sync_find_scalar(buff, buff_len, 0, max_offset, confirm, stride) ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Validate a block of num_pkts packets, 'stride' bytes apart (all of which must be in the buffer). Returns the number
+// of packets from the start of the buffer which begin with the sync byte (i.e. num_pkts if all are aligned)
+unsigned ts_sync_check(const uint8_t *buff, unsigned num_pkts, unsigned stride)
+{
+unsigned pkt ;
+
+#ifdef TS_SYNC_X86
+	if (__builtin_cpu_supports("avx2"))
+		return sync_check_avx2(buff, num_pkts, stride) ;
+#endif
+
+	for (pkt=0; pkt < num_pkts; ++pkt)
+	{
+		if (buff[pkt*stride] != SYNC_BYTE)
+			break ;
+	}
+	return pkt ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Work out the size of the packets in a buffer of data from the start of a file: TS_PACKET_LEN,
+// TS_M2TS_PACKET_LEN or TS_RS_PACKET_LEN. A size is accepted if TS_SYNC_PROBE consecutive packets of that
+// size line up within the buffer. Returns 0 if none of them do
+unsigned ts_sync_packet_size(const uint8_t *buff, unsigned buff_len)
+{
+static const unsigned sizes[] = { TS_PACKET_LEN, TS_M2TS_PACKET_LEN, TS_RS_PACKET_LEN } ;
+unsigned i ;
+unsigned offset ;
+
+	for (i=0; i < sizeof(sizes)/sizeof(sizes[0]); ++i)
+	{
+		offset = ts_sync_find(buff, buff_len, sizes[i], TS_SYNC_PROBE, sizes[i]) ;
+
+		// all of the probe packets must actually be in the buffer
+		if ((offset < sizes[i]) && (offset + (TS_SYNC_PROBE-1)*sizes[i] < buff_len))
+			return sizes[i] ;
+	}
+	return 0 ;
+}
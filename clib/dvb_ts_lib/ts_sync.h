@@ -0,0 +1,44 @@
+/*
+ * ts_sync.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef TS_SYNC_H_
+#define TS_SYNC_H_
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+#include <inttypes.h>
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+// Number of consecutive packets that must start with the sync byte before a new sync position is accepted
+// (fewer are used if the buffer doesn't hold that many)
+#define TS_SYNC_CONFIRM		3
+
+// Number of consecutive packets used to decide the packet size of a file, and the amount of data needed
+#define TS_SYNC_PROBE		8
+#define TS_SYNC_PROBE_LEN	((TS_SYNC_PROBE+1) * TS_MAX_PACKET_LEN)
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+unsigned ts_sync_find(const uint8_t *buff, unsigned buff_len, unsigned max_offset, unsigned confirm, unsigned stride) ;
+unsigned ts_sync_check(const uint8_t *buff, unsigned num_pkts, unsigned stride) ;
+unsigned ts_sync_packet_size(const uint8_t *buff, unsigned buff_len) ;
+
+#endif /* TS_SYNC_H_ */
@@ -0,0 +1,436 @@
+/*
+ * ts_timing.c
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ *
+ * Get the start/end times of a recording without parsing the whole file. Only a window of packets at
+ * the start of the file, and another at the end, are parsed (the end window is positioned with
+ * tsreader_setpos() relative to SEEK_END). Both windows are parsed by the same reader so the times from the
+ * end window are wrap adjusted against the start times, in the same way as for a full parse.
+ *
+ * As with a full parse, this relies on the recording being less than 26 hours long (the PTS range).
+ */
+
+// VERSION = 1.00
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "ts_parse.h"
+#include "ts_timing.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+static struct TS_pid_timing *timing_pid_get(struct TS_timing *timing, unsigned pid)
+{
+struct TS_pid_timing *pid_timing ;
+
+	pid_timing = timing->pids[pid & MAX_PID] ;
+	if (pid_timing)
+		return pid_timing ;
+
+	pid_timing = (struct TS_pid_timing *)malloc(sizeof(*pid_timing)) ;
+	if (!pid_timing)
+	{
+		SET_DVB_ERROR(ERR_MALLOC) ;
+		return NULL ;
+	}
+	CLEAR_MEM(pid_timing) ;
+	pid_timing->pid = pid & MAX_PID ;
+	pid_timing->start_pts = UNSET_TS ;
+	pid_timing->end_pts = UNSET_TS ;
+	pid_timing->start_dts = UNSET_TS ;
+	pid_timing->end_dts = UNSET_TS ;
+	pid_timing->start_pcr = UNSET_TS ;
+	pid_timing->end_pcr = UNSET_TS ;
+
+	timing->pids[pid & MAX_PID] = pid_timing ;
+	++timing->num_pids ;
+
+	return pid_timing ;
+}
+
+//---------------------------------------------------------------------------------------------------------
+// void (*tsparse_pcr_hook)(struct TS_pidinfo *, int64_t, unsigned, void *) ;
+static void timing_pcr_hook(struct TS_pidinfo *pidinfo, int64_t pcr_base, unsigned pcr_ext, void *user_data)
+{
+struct TS_pid_timing *pid_timing = timing_pid_get((struct TS_timing *)user_data, pidinfo->pid) ;
+
+	if (!pid_timing)
+		return ;
+
+	if (pid_timing->start_pcr == UNSET_TS)
+	{
+		pid_timing->start_pcr = pcr_base ;
+	}
+	else
+	{
+		// check for wrap
+		if (pcr_base+MAX_TS_DIFF < pid_timing->start_pcr)
+		{
+			// wrapped, so adjust
+			pcr_base += TS_WRAP ;
+		}
+	}
+
+	if ((pid_timing->end_pcr == UNSET_TS) || (pid_timing->end_pcr < pcr_base))
+		pid_timing->end_pcr = pcr_base ;
+}
+
+/* ----------------------------------------------------------------------- */
+// Copy the PTS/DTS ranges out of the reader and set the overall times
+static void timing_set(struct TS_timing *timing, struct TS_reader *tsreader)
+{
+struct list_head  *item;
+struct TS_pid    *piditem;
+struct TS_pid_timing *pid_timing ;
+unsigned pid ;
+
+	tsreader_set_timing(tsreader) ;
+	timing->start_ts = tsreader->tsstate->start_ts ;
+	timing->end_ts = tsreader->tsstate->end_ts ;
+
+	list_for_each(item,&tsreader->tsstate->pid_list)
+	{
+		piditem = list_entry(item, struct TS_pid, next);
+
+		if ((piditem->pesinfo.start_pts == UNSET_TS) && (piditem->pesinfo.start_dts == UNSET_TS))
+			continue ;
+
+		pid_timing = timing_pid_get(timing, piditem->pidinfo.pid) ;
+		if (!pid_timing)
+			continue ;
+
+		pid_timing->start_pts = piditem->pesinfo.start_pts ;
+		pid_timing->end_pts = piditem->pesinfo.end_pts ;
+		pid_timing->start_dts = piditem->pesinfo.start_dts ;
+		pid_timing->end_dts = piditem->pesinfo.end_dts ;
+	}
+
+	// no PES times, so fall back to the PCR
+	if (timing->start_ts == UNSET_TS)
+	{
+		for (pid=0; pid < ALL_PID; ++pid)
+		{
+			pid_timing = timing->pids[pid] ;
+			if (!pid_timing || (pid_timing->start_pcr == UNSET_TS))
+				continue ;
+
+			if ((timing->start_ts == UNSET_TS) || (pid_timing->start_pcr < timing->start_ts))
+				timing->start_ts = pid_timing->start_pcr ;
+			if ((timing->end_ts == UNSET_TS) || (pid_timing->end_pcr > timing->end_ts))
+				timing->end_ts = pid_timing->end_pcr ;
+		}
+	}
+
+	if (timing->start_ts != UNSET_TS)
+		timing->duration = timing->end_ts - timing->start_ts ;
+}
+
+/*=============================================================================================*/
+// PUBLIC
+/*=============================================================================================*/
+
+/* ----------------------------------------------------------------------- */
+// Get the start/end times of the file by parsing window_pkts packets at each end of it (0 = use default
+// window). Returns the times (free with tstiming_free()), or NULL on error.
+struct TS_timing *ts_fast_timing(char *filename, unsigned window_pkts, unsigned debug)
+{
+struct TS_timing *timing ;
+struct TS_reader *tsreader ;
+uint64_t total_pkts ;
+unsigned tail_pkts ;
+int status ;
+
+	timing = (struct TS_timing *)malloc(sizeof(struct TS_timing)) ;
+	if (!timing)
+	{
+		SET_DVB_ERROR(ERR_MALLOC) ;
+		return NULL ;
+	}
+	CLEAR_MEM(timing) ;
+	timing->start_ts = UNSET_TS ;
+	timing->end_ts = UNSET_TS ;
+	timing->duration = UNSET_TS ;
+
+	tsreader = tsreader_new(filename) ;
+	if (!tsreader)
+	{
+		free(timing) ;
+		return NULL ;
+	}
+	tsreader->debug = debug ;
+	tsreader->user_data = timing ;
+	tsreader->pcr_hook = timing_pcr_hook ;
+	tsreader->use_mmap = 1 ;
+
+	if (!window_pkts)
+		window_pkts = TS_TIMING_WINDOW ;
+	total_pkts = tsreader->tsstate->total_pkts ;
+
+	// start of file
+	status = tsreader_setpos(tsreader, 0, SEEK_SET, window_pkts) ;
+	if (!status)
+		status = ts_parse(tsreader) ;
+
+	// end of file (not overlapping the start)
+	if (!status && (total_pkts > window_pkts))
+	{
+		tail_pkts = window_pkts ;
+		if (total_pkts - window_pkts < window_pkts)
+			tail_pkts = (unsigned)(total_pkts - window_pkts) ;
+
+		if (debug)
+			printf("Fast timing %s : %"PRIu64" pkts : start window %u pkts, end window %u pkts\n",
+					filename, total_pkts, window_pkts, tail_pkts) ;
+
+		status = tsreader_setpos(tsreader, -(int64_t)tail_pkts, SEEK_END, tail_pkts) ;
+		if (!status)
+			status = ts_parse(tsreader) ;
+	}
+
+	if (status)
+	{
+		tsreader_free(tsreader) ;
+		tstiming_free(timing) ;
+		return NULL ;
+	}
+
+	timing_set(timing, tsreader) ;
+	tsreader_free(tsreader) ;
+
+	return timing ;
+}
+
+/* ----------------------------------------------------------------------- */
+void tstiming_free(struct TS_timing *timing)
+{
+unsigned pid ;
+
+	if (timing)
+	{
+		for (pid=0; pid < ALL_PID; ++pid)
+		{
+			if (timing->pids[pid])
+				free(timing->pids[pid]) ;
+		}
+		free(timing) ;
+	}
+}
+
+
+//============================================================================================
+// Test: gets the times with the fast method and compares them with a full parse of the file. Also checks the start time
+// of a generated stream whose PTS is ahead of its DTS (start_dts used to be set from the first PTS).
+//
+//   ts_timing [-w window_pkts] [-d debug] file.ts
+//
+#ifdef TEST_MAIN
+
+#include <sys/time.h>
+
+#define TEST_PID			0x200
+#define TEST_PES			4
+#define TEST_DTS			900000
+#define TEST_PTS_DELAY		(2 * VIDEO_PTS_DELTA)
+
+//---------------------------------------------------------------------------------------------------------------------------
+static double test_time(void)
+{
+struct timeval tv ;
+
+	gettimeofday(&tv, NULL) ;
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1e6 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Write a 33 bit timestamp with its 4 bit prefix and marker bits
+static void test_ts_bytes(uint8_t *bytes, unsigned prefix, int64_t ts)
+{
+	bytes[0] = (prefix << 4) | (((ts >> 30) & 0x07) << 1) | 1 ;
+	bytes[1] = (ts >> 22) & 0xff ;
+	bytes[2] = (((ts >> 15) & 0x7f) << 1) | 1 ;
+	bytes[3] = (ts >> 7) & 0xff ;
+	bytes[4] = ((ts & 0x7f) << 1) | 1 ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+// Write a file of single packet video PES with the PTS TEST_PTS_DELAY ahead of the DTS, then check that the start time
+// and the DTS range come from the DTS. Returns the number of failures
+static unsigned test_dts(void)
+{
+char filename[] = "/tmp/ts_timing_XXXXXX" ;
+uint8_t packet[TS_PACKET_LEN] ;
+struct TS_reader *tsreader ;
+struct TS_timing *timing ;
+struct TS_pid_timing *pid_timing ;
+int64_t dts ;
+int64_t start_ts = UNSET_TS ;
+unsigned pes_len = TS_PACKET_LEN - 4 ;
+unsigned failed = 0 ;
+unsigned i ;
+int fd ;
+
+	fd = mkstemp(filename) ;
+	if (fd < 0)
+	{
+		printf("DTS : unable to write %s\n", filename) ;
+		return 1 ;
+	}
+	for (i=0; i < TEST_PES; ++i)
+	{
+		dts = TEST_DTS + i*VIDEO_PTS_DELTA ;
+		memset(packet, 0, sizeof(packet)) ;
+		packet[0] = SYNC_BYTE ;
+		packet[1] = 0x40 | ((TEST_PID >> 8) & 0x1f) ;
+		packet[2] = TEST_PID & 0xff ;
+		packet[3] = 0x10 | (i & 0xf) ;
+		packet[4+0] = 0x00 ;
+		packet[4+1] = 0x00 ;
+		packet[4+2] = 0x01 ;
+		packet[4+3] = 0xe0 ;
+		packet[4+4] = (pes_len - 6) >> 8 ;
+		packet[4+5] = (pes_len - 6) & 0xff ;
+		packet[4+6] = 0x80 ;
+		packet[4+7] = 0xc0 ;
+		packet[4+8] = 10 ;
+		test_ts_bytes(&packet[4+9], 3, dts + TEST_PTS_DELAY) ;
+		test_ts_bytes(&packet[4+14], 1, dts) ;
+		if (write(fd, packet, sizeof(packet)) != sizeof(packet))
+		{
+			printf("DTS : unable to write %s\n", filename) ;
+			close(fd) ;
+			unlink(filename) ;
+			return 1 ;
+		}
+	}
+	close(fd) ;
+
+	tsreader = tsreader_new(filename) ;
+	if (tsreader)
+	{
+		ts_parse(tsreader) ;
+		tsreader_set_timing(tsreader) ;
+		start_ts = tsreader->tsstate->start_ts ;
+		tsreader_free(tsreader) ;
+	}
+	timing = ts_fast_timing(filename, 0, 0) ;
+	unlink(filename) ;
+
+	pid_timing = timing ? timing->pids[TEST_PID] : NULL ;
+	printf("DTS : start %"PRId64" (first PTS %d, first DTS %d) : DTS %"PRId64" .. %"PRId64" (expected %d .. %d)\n",
+			start_ts, TEST_DTS + TEST_PTS_DELAY, TEST_DTS,
+			pid_timing ? pid_timing->start_dts : UNSET_TS, pid_timing ? pid_timing->end_dts : UNSET_TS,
+			TEST_DTS, TEST_DTS + (TEST_PES-1)*VIDEO_PTS_DELTA) ;
+	if (start_ts != TEST_DTS)
+		++failed ;
+	if (!pid_timing || (pid_timing->start_dts != TEST_DTS) || (pid_timing->end_dts != TEST_DTS + (TEST_PES-1)*VIDEO_PTS_DELTA))
+		++failed ;
+
+	tstiming_free(timing) ;
+	return failed ;
+}
+
+//---------------------------------------------------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+struct TS_timing *timing ;
+struct TS_reader *tsreader ;
+unsigned window_pkts = 0 ;
+unsigned debug = 0 ;
+unsigned pid ;
+unsigned failed = 0 ;
+double start, fast_time, full_time ;
+int c ;
+
+	while ((c = getopt (argc, argv, "w:d:")) != -1)
+	{
+		switch (c)
+		{
+		case 'w':
+			window_pkts = atoi(optarg) ;
+			break;
+
+		case 'd':
+			debug = atoi(optarg) ;
+			break;
+
+		default:
+			printf("Error: invalid option %c\n", c) ;
+			abort ();
+		}
+	}
+
+	if (optind >= argc)
+	{
+		printf("Error: Must specify input filename\n") ;
+		abort() ;
+	}
+
+	start = test_time() ;
+	timing = ts_fast_timing(argv[optind], window_pkts, debug) ;
+	fast_time = test_time() - start ;
+	if (!timing)
+	{
+		printf("FAIL : error %d : %s\n", dvb_error_code, dvb_error_str(dvb_error_code)) ;
+		return 1 ;
+	}
+
+	for (pid=0; pid < ALL_PID; ++pid)
+	{
+	struct TS_pid_timing *pid_timing = timing->pids[pid] ;
+
+		if (!pid_timing)
+			continue ;
+		printf("PID %4u : PTS %"PRId64" .. %"PRId64" : DTS %"PRId64" .. %"PRId64" : PCR %"PRId64" .. %"PRId64"\n",
+				pid,
+				pid_timing->start_pts, pid_timing->end_pts,
+				pid_timing->start_dts, pid_timing->end_dts,
+				pid_timing->start_pcr, pid_timing->end_pcr) ;
+	}
+
+	// full parse for comparison
+	start = test_time() ;
+	tsreader = tsreader_new(argv[optind]) ;
+	tsreader->use_mmap = 1 ;
+	ts_parse(tsreader) ;
+	tsreader_set_timing(tsreader) ;
+	full_time = test_time() - start ;
+
+	if ((timing->start_ts != tsreader->tsstate->start_ts) || (timing->end_ts != tsreader->tsstate->end_ts))
+		++failed ;
+	printf("%s : start %"PRId64" end %"PRId64" duration %.3f s : fast %.4f s, full parse %.4f s\n",
+			failed ? "FAIL" : "PASS",
+			timing->start_ts, timing->end_ts, (double)timing->duration / TS_FREQ,
+			fast_time, full_time) ;
+
+	tsreader_free(tsreader) ;
+	tstiming_free(timing) ;
+
+	failed += test_dts() ;
+	printf("%s\n", failed ? "FAIL" : "PASS") ;
+
+	return failed ? 1 : 0 ;
+}
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * ts_timing.h
+ *
+ *  Created on: 17 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef TS_TIMING_H_
+#define TS_TIMING_H_
+
+/*=============================================================================================*/
+// USES
+/*=============================================================================================*/
+#include <inttypes.h>
+
+#include "ts_structs.h"
+
+/*=============================================================================================*/
+// CONSTANTS
+/*=============================================================================================*/
+
+// default number of packets parsed at each end of the file (approx 3MB)
+#define TS_TIMING_WINDOW	(16 * 1024)
+
+/*=============================================================================================*/
+// MACROS
+/*=============================================================================================*/
+
+/*=============================================================================================*/
+// STRUCTS
+/*=============================================================================================*/
+
+// First/last times seen on a pid (UNSET_TS if none). All in 90kHz units, with any wrap removed (i.e. the last
+// time may be more than 33 bits)
+struct TS_pid_timing {
+	unsigned	pid ;
+
+	int64_t		start_pts ;
+	int64_t		end_pts ;
+	int64_t		start_dts ;
+	int64_t		end_dts ;
+
+	// PCR base only
+	int64_t		start_pcr ;
+	int64_t		end_pcr ;
+};
+
+struct TS_timing {
+	// as TS_state start/end (from the PTS/DTS, or from the PCR if there are none)
+	int64_t					start_ts ;
+	int64_t					end_ts ;
+	int64_t					duration ;
+
+	unsigned				num_pids ;
+
+	// direct lookup by pid (NULL if no times seen on that pid)
+	struct TS_pid_timing	*pids[ALL_PID] ;
+};
+
+/*=============================================================================================*/
+// FUNCTIONS
+/*=============================================================================================*/
+
+struct TS_timing *ts_fast_timing(char *filename, unsigned window_pkts, unsigned debug) ;
+void tstiming_free(struct TS_timing *timing) ;
+
+#endif /* TS_TIMING_H_ */
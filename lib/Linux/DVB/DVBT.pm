@@ -1234,6 +1234,44 @@ sub is_error
 	return $error_str ;
 }
 
+#----------------------------------------------------------------------------
+
+=item B<ts_pid_stats($file [, $num_pkts])>
+
+Parse a recorded transport stream file (or just its first $num_pkts packets) and return the transport
+statistics of every pid seen. Returns a HASH ref keyed by pid, where each entry is a HASH ref of:
+
+=over 4
+
+=item B<pkts> - number of packets
+
+=item B<payload_bytes> - bytes of payload (i.e. excluding the TS header and any adaptation field)
+
+=item B<cc_errors> - number of continuity counter errors (i.e. missing packets)
+
+=item B<tei> - number of packets with the transport error indicator set
+
+=item B<scrambled> - number of scrambled packets
+
+=item B<pcrs> - number of packets carrying a PCR
+
+=item B<bitrate> - bits/s over the last complete second of the stream's PCR (0 if there isn't one)
+
+=back
+
+The pkts and payload_bytes counts are returned as strings so that they aren't limited to 32 bits.
+
+Returns an empty HASH if the file can't be read (see L</is_error()>).
+
+=cut
+
+sub ts_pid_stats
+{
+	my ($class, $file, $num_pkts) = @_ ;
+
+	return dvb_ts_pid_stats($file, $num_pkts) ;
+}
+
 
 #============================================================================================
 
@@ -240,6 +240,18 @@ sub get_makeopts
 		$ModuleInfo{'OPTIMIZE'} = '-ggdb -O0' ;
 	} 
 	
+	## -P = production build (TS parser debug tracing and struct checks compiled out)
+	if ( 
+		grep $_ eq '-P', @main::ARGV
+	) 
+	{
+		@main::ARGV = grep $_ ne '-P', @main::ARGV;
+		warn "Building production version (no TS parser debug)...\n";
+		add_defines({
+			'TS_PRODUCTION'		=> 1,
+		}) ;
+	} 
+	
 	## -M = udpate MANIFEST 
 	$Makeutils::UPDATE_MANIFEST = 0 ;
 	if ( 
@@ -0,0 +1,85 @@
+#!perl
+
+use strict;
+use warnings;
+use Test::More ;
+
+use Linux::DVB::DVBT ;
+
+# t/ts/pid-stats.ts is 45 packets:
+#
+#	for 20 times :
+#		pid 256 : adaptation field with a PCR (0.1s apart) and 176 bytes of payload. The continuity counter
+#		          jumps on the 11th packet
+#		pid 257 : 184 bytes of payload. The 6th packet has the TEI set, the 8th and 14th are scrambled
+#		every 4th time : null packet
+#
+# The bitrate is over the 1s from the first PCR to the 11th (10 packets of pid 256, 10 of pid 257, 3 null)
+#
+my %expected = (
+	256		=> {
+		pkts			=> 20,
+		payload_bytes	=> 20 * 176,
+		cc_errors		=> 1,
+		tei				=> 0,
+		scrambled		=> 0,
+		pcrs			=> 20,
+		bitrate			=> 10 * 188 * 8,
+	},
+	257		=> {
+		pkts			=> 20,
+		payload_bytes	=> 20 * 184,
+		cc_errors		=> 0,
+		tei				=> 1,
+		scrambled		=> 2,
+		pcrs			=> 0,
+		bitrate			=> 10 * 188 * 8,
+	},
+	8191	=> {
+		pkts			=> 5,
+		payload_bytes	=> 5 * 184,
+		cc_errors		=> 0,
+		tei				=> 0,
+		scrambled		=> 0,
+		pcrs			=> 0,
+		bitrate			=> 3 * 188 * 8,
+	},
+) ;
+
+# Just the first 10 packets (4 times round)
+my %expected_10 = (
+	256		=> 5,
+	257		=> 4,
+	8191	=> 1,
+) ;
+
+my $file = './t/ts/pid-stats.ts' ;
+
+plan tests => 3 + (scalar(keys %expected) * 7) + 1 + scalar(keys %expected_10) + 1 ;
+
+## Whole file
+my $stats_href = Linux::DVB::DVBT->ts_pid_stats($file) ;
+is(ref($stats_href), 'HASH', "stats") ;
+is_deeply([sort { $a <=> $b } keys %$stats_href], [sort { $a <=> $b } keys %expected], "pids") ;
+is(Linux::DVB::DVBT->is_error(), "", "no error") ;
+
+foreach my $pid (sort { $a <=> $b } keys %expected)
+{
+	foreach my $field (qw/pkts payload_bytes cc_errors tei scrambled pcrs bitrate/)
+	{
+		is($stats_href->{$pid}{$field}, $expected{$pid}{$field}, "pid $pid $field") ;
+	}
+}
+
+## Start of the file
+$stats_href = Linux::DVB::DVBT->ts_pid_stats($file, 10) ;
+is_deeply([sort { $a <=> $b } keys %$stats_href], [sort { $a <=> $b } keys %expected_10], "pids in 10 packets") ;
+foreach my $pid (sort { $a <=> $b } keys %expected_10)
+{
+	is($stats_href->{$pid}{pkts}, $expected_10{$pid}, "pid $pid pkts in 10 packets") ;
+}
+
+## No file
+$stats_href = Linux::DVB::DVBT->ts_pid_stats('./t/ts/no-such-file.ts') ;
+is_deeply($stats_href, {}, "missing file") ;
+
@@ -0,0 +1,64 @@
+#!perl
+
+use strict;
+use warnings;
+use Test::More ;
+
+use File::Temp qw/tempdir/ ;
+use File::Copy ;
+
+# Runs the C library self tests built by "make ctest" (the TEST_MAIN code in the library sources). Each one exits
+# with 0 only if all of its checks pass, or reports SKIP if it can't be run here.
+#
+# t/ts/mux.ts is 1 MB (5845 packets, just under 2 s) of a generated mux:
+#
+#	every 5th frame : PAT (pid 0x000), PMT (pid 0x100), EIT present/following (pid 0x012) and TDT (pid 0x014)
+#	pid 0x200 : video, 1 PES per frame at 25 fps with PTS = DTS + 7200, a sequence and GOP header every 12 frames,
+#	            PCR in the first packet of each PES
+#	pid 0x201 .. 0x21e : 30 audio pids, 1 PES every 2 frames
+#	pid 0x1fff : 1 null packet per frame
+#
+my $bin = './clib/test' ;
+my $dir = tempdir(CLEANUP => 1) ;
+
+# (ts_index writes the index alongside the file)
+my $file = "$dir/mux.ts" ;
+copy('./t/ts/mux.ts', $file) or die "Unable to copy t/ts/mux.ts : $!" ;
+
+my @tests = (
+	# reference, slicing-by-8 and (where the CPU has it) carry-less multiply CRCs of random data and sections
+	[ 'ts_crc32',		'-n', 0 ],
+
+	[ 'ts_pool',		'-t', 4, '-r', 2, $file ],
+	[ 'ts_parallel',	$file ],
+	[ 'ts_timing',		$file ],
+	[ 'ts_index',		$file ],
+	[ 'ts_follow',		$file, "$dir/follow.ts" ],
+	[ 'ts_fanout',		$file, $dir ],
+
+	# sparse file of 820 GB to get past packet 2^32 (807 GB) : packet numbers and progress either side of it
+	[ 'ts_cut',			'-s', 820, $file, "$dir/sparse.ts" ],
+
+	[ 'ts_bits',		'-n', 1, $file ],
+	[ 'ts_arena',		'-n', 1, $file ],
+	[ 'parse_si',		'-n', 1, $file ],
+	[ 'si_view',		'-n', 1, $file ],
+	[ 'parse_desc',		'-n', 1, $file ],
+) ;
+
+plan tests => scalar(@tests) ;
+
+foreach my $test (@tests)
+{
+	my ($prog, @args) = @$test ;
+
+	SKIP: {
+		skip "$bin/$prog not built (make ctest)", 1 unless -x "$bin/$prog" ;
+
+		my $output = `$bin/$prog @args 2>&1` ;
+		skip "$prog : $1", 1 if ($? == 0) && ($output =~ /\ASKIP : (.*)$/m) ;
+
+		is($?, 0, "$prog") or diag($output) ;
+	}
+}
+
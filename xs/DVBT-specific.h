@@ -4,6 +4,7 @@
 
 #include "dvb_lib.h"
 #include "ts_structs.h"
+#include "ts_parse.h"
 
 #define DEFAULT_TIMEOUT		900
 
@@ -0,0 +1,78 @@
+
+ # /*---------------------------------------------------------------------------------------------------*/
+ # /* Parse a transport stream file (or just the first num_pkts packets of it) and return the transport
+ #    statistics for each pid seen, as a HASH keyed by pid. Returns an empty HASH if the file can't be read.
+ #    num_pkts may be given as a string so that counts beyond 32 bits can be passed on any perl */
+ #
+ #	struct TS_pid_stats {
+ #		uint64_t	pkts ;
+ #		uint64_t	payload_bytes ;
+ #		unsigned	cc_errors ;
+ #		unsigned	tei ;
+ #		unsigned	scrambled ;
+ #		unsigned	pcrs ;
+ #		unsigned	bitrate ;
+ #	} ;
+ #
+SV *
+dvb_ts_pid_stats(char *filename, SV *num_pkts=NULL)
+
+  INIT:
+	HV * results ;
+	HV * rh ;
+	struct TS_reader *tsreader ;
+	const struct TS_pid_stats *stats ;
+	unsigned pid ;
+	uint64_t max_pkts = 0 ;
+	char *str ;
+    char key[256] ;
+    char string[256] ;
+
+	results = (HV *)sv_2mortal((SV *)newHV());
+
+  CODE:
+	tsreader = tsreader_new(filename) ;
+	if (tsreader)
+	{
+		tsreader->use_mmap = 1 ;
+		if (num_pkts && SvOK(num_pkts))
+		{
+			str = SvPV_nolen(num_pkts) ;
+			if (*str != '-')
+				max_pkts = strtoull(str, NULL, 10) ;
+		}
+		if (max_pkts)
+			tsreader_setpos(tsreader, 0, SEEK_SET, max_pkts) ;
+		ts_parse(tsreader) ;
+
+		for (pid=0; pid < ALL_PID; ++pid)
+		{
+			stats = tsreader_pid_stats(tsreader, pid) ;
+			if (!stats->pkts)
+				continue ;
+
+			rh = (HV *)sv_2mortal((SV *)newHV());
+
+			// save 64 bit values as strings
+			sprintf(string, "%"PRIu64, stats->pkts) ;
+			HVS_STR(rh, pkts, string) ;
+			sprintf(string, "%"PRIu64, stats->payload_bytes) ;
+			HVS_STR(rh, payload_bytes, string) ;
+
+			HVS_I(rh, stats, cc_errors) ;
+			HVS_I(rh, stats, tei) ;
+			HVS_I(rh, stats, scrambled) ;
+			HVS_I(rh, stats, pcrs) ;
+			HVS_I(rh, stats, bitrate) ;
+
+			sprintf(key, "%u", pid) ;
+			hv_store(results, key, strlen(key), newRV((SV *)rh), 0) ;
+		}
+
+		tsreader_free(tsreader) ;
+	}
+
+   	RETVAL = newRV((SV *)results);
+  OUTPUT:
+    RETVAL
+